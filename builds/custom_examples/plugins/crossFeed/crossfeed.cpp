@@ -0,0 +1,19 @@
+/**
+ * Example of a plugin with an audio stage.
+ * To connect the plugin, copy its folder to the src/plugins directory.
+ */
+
+#include "crossfeed.h"
+#include "../../core/options.h"
+
+crossFeed crossfeed;
+
+crossFeed::crossFeed() {
+  registerPlugin();
+  registerStage(&_stage);
+}
+
+void crossFeed::on_end_setup(){
+  _stage.enable(true);
+  log_i("%s on, order %d, latency %u frames", _stage.name(), _stage.order(), _stage.latency());
+}
@@ -0,0 +1,23 @@
+/**
+ * Example of a plugin with an audio stage.
+ * To connect the plugin, copy its folder to the src/plugins directory.
+ */
+#ifndef CROSSFEED_H
+#define CROSSFEED_H
+
+#include "../../pluginsManager/pluginsManager.h"
+#include "crossfeedstage.h"
+
+class crossFeed : public Plugin {
+public:
+  crossFeed();
+/**
+ * See src/pluginsManager/pluginsManager.h for available events
+ */
+  void on_end_setup();
+  CrossfeedStage &stage() { return _stage; }   /* crossfeed.stage().enable(false) switches it off */
+private:
+  CrossfeedStage _stage;
+};
+
+#endif // CROSSFEED_H
@@ -0,0 +1,43 @@
+/**
+ * Crossfeed for headphones: each ear also gets the other channel, low passed and attenuated,
+ * as it would from a pair of speakers. The direct and the crossed part add up to one, it cannot clip.
+ * Plain C++, see src/pluginsManager/audiochain.h.
+ */
+#ifndef CROSSFEEDSTAGE_H
+#define CROSSFEEDSTAGE_H
+
+#include <math.h>
+#include "../../pluginsManager/audiochain.h"
+
+class CrossfeedStage : public AudioStage {
+public:
+  CrossfeedStage(uint16_t cutoffHz = 700, uint8_t feedDb = 6) : AudioStage("crossfeed", 100), _cutoff(cutoffHz), _feedDb(feedDb) {}
+
+  void on_format(const audioFormat_t &format) override {
+    uint32_t rate = format.sampleRate ? format.sampleRate : 44100;
+    float g = powf(10.0f, -_feedDb / 20.0f);
+    _a = lroundf(32768 * (1 - expf(-2 * (float)M_PI * _cutoff / rate)));
+    _direct = lroundf(32768 / (1 + g));
+    _cross = 32768 - _direct;
+    _lpL = _lpR = 0;
+  }
+
+  void process(int16_t *frames, uint16_t count) override {
+    for (uint16_t i = 0; i < count; i++, frames += 2) {
+      int32_t l = frames[0], r = frames[1];
+      _lpL += (int32_t)(((int64_t)(l * 256 - _lpL) * _a) >> 15);   /* one pole, state in Q8 */
+      _lpR += (int32_t)(((int64_t)(r * 256 - _lpR) * _a) >> 15);
+      frames[0] = _sat((l * _direct + (_lpR >> 8) * _cross) >> 15);
+      frames[1] = _sat((r * _direct + (_lpL >> 8) * _cross) >> 15);
+    }
+  }
+
+private:
+  uint16_t _cutoff;
+  uint8_t  _feedDb;
+  int32_t  _a = 0, _direct = 32768, _cross = 0, _lpL = 0, _lpR = 0;
+
+  static int16_t _sat(int32_t v) { return v > 32767 ? 32767 : v < -32768 ? -32768 : v; }
+};
+
+#endif // CROSSFEEDSTAGE_H
@@ -112,7 +112,8 @@ function onMessage(event) {
     if(typeof data.playermode !== 'undefined') { //Web, SD
       modesd = data.playermode=='modesd';
       classEach('modeitem', function(el){ el.classList.add('hidden') });
-      if(modesd) showById(['modesd', 'sdsvg'],['plsvg']); else showById(['modeweb','plsvg','bitinfo'],['sdsvg','shuffle']);
+      if(modesd) showById(['modesd', 'sdsvg'],['plsvg','recording']); else showById(['modeweb','plsvg','bitinfo'],['sdsvg','shuffle']);
+      if(!modesd && getId('recording').dataset.rec) getId('recording').classList.remove('hidden');
       showById(['volslider'],['sdslider']);
       getId('toggleplaylist').classList.remove('active');
       generatePlaylist(`http://${hostname}/data/playlist.csv`+"?"+new Date().getTime());
@@ -154,6 +155,37 @@ function onMessage(event) {
       }
       return;
     }
+    if(typeof data.recording!== 'undefined'){
+      const el = getId("recording");
+      el.dataset.rec = 1;
+      if(!modesd) el.classList.remove("hidden");
+      if(data.recording==1) el.classList.add("active"); else el.classList.remove("active");
+      el.title = data.recording==1?`recording, ${Math.round(data.recwritten/1024)}kB, ${data.recrate}kB/s`:"record to SD";
+      return;
+    }
+    if(typeof data.ttfs !== 'undefined'){
+      const el = getId("ttfsinfo");
+      getId("ttfsms").innerText = data.ttfs;
+      el.title = `time to first sound: ${data.ttfsinfo}`;
+      el.classList.remove("hidden");
+      return;
+    }
+    if(typeof data.dmalat !== 'undefined'){
+      const el = getId("dmainfo");
+      getId("dmalat").innerText = data.dmalat;
+      getId("dmamargin").innerText = data.dmamargin;
+      el.title = `DMA ${data.dmadesc} x ${data.dmaframes} frames, learned ${data.dmatarget}ms for this rate (taken at the next rate change), ${data.dmaunder} underruns`;
+      el.classList.remove("hidden");
+      return;
+    }
+    if(typeof data.nightgr !== 'undefined'){
+      const el = getId("nightinfo");
+      if(el){
+        getId("nightred").innerText = (data.nightgr/10).toFixed(1);
+        if(data.nightmode==1) el.classList.remove("hidden"); else el.classList.add("hidden");
+      }
+      /* no return, the preset is set up in the settings below */
+    }
     if(typeof data.tz_name !== 'undefined'){
       const select = document.getElementById("tz_name");
       const input = document.getElementById("tzposix");
@@ -1013,6 +1045,7 @@ function continueLoading(mode){
           getWiFi(`http://${hostname}/data/wifi.csv`+"?"+new Date().getTime());
           websocket.send('getactive=1');
           websocket.send('getbattery=1');
+          websocket.send('getnight=1');
           classEach("reset", function(el){ el.innerHTML='<svg viewBox="0 0 16 16" class="fill"><path d="M8 3v5a36.973 36.973 0 0 1-2.324-1.166A44.09 44.09 0 0 1 3.417 5.5a52.149 52.149 0 0 1 2.26-1.32A43.18 43.18 0 0 1 8 3z"/><path d="M7 5v1h4.5C12.894 6 14 7.106 14 8.5S12.894 11 11.5 11H1v1h10.5c1.93 0 3.5-1.57 3.5-3.5S13.43 5 11.5 5h-4z"/></svg>'; });
           initDangerZone();
         });
@@ -1100,6 +1133,7 @@ function continueLoading(mode){
           case "format": websocket.send("format=1"); rebootSystem('Format SPIFFS. Rebooting...'); break;
           case "reset":  websocket.send("reset=1");  rebootSystem('Reset settings. Rebooting...'); break;
           case "shuffle": toggleShuffle(); break;
+          case "record": websocket.send("record="+(target.classList.contains('active')?0:1)); break;
           case "rebootmdns": websocket.send(`mdnsname=${getId('mdns').value}`); websocket.send("rebootmdns=1"); break;
           case "savebattref": websocket.send(`battref=${getId('battref').value}`); break;
           default: break;
@@ -69,6 +69,12 @@ void audio_showstreamtitle(const char *info) {
   #else
     config.setTitle(p?info:config.station.name);
   #endif
+  #if TITLE_HISTORY>0
+    if (p && config.getMode()==PM_WEB) titlelog.add(config.lastStation(), info);
+  #endif
+  #ifdef USE_SD
+    if (p) recorder.title(info);
+  #endif
 }
 
 void audio_error(const char *info) {
@@ -131,6 +137,61 @@ void audio_eof_stream(const char *info) {
   }
 }
 
+#if I2S_DOUT!=255 || I2S_INTERNAL
+void audio_prebuffer(uint16_t startMs, uint16_t resumeMs, bool stable) {
+  player.sendCommand({stable ? PR_PREBUF_STABLE : PR_PREBUF, (int)((uint32_t)startMs << 16 | resumeMs), 0, player.stationHash()});
+}
+
+void audio_reconnect(uint8_t outcome, uint8_t attempts, uint32_t ms) {
+  player.sendCommand({PR_HEALTH, outcome, 0, player.stationHash()});
+  if (outcome == Reconnect::FAILED && attempts) network.retryStream();   /* gave up behind the buffer, retry the station from scratch */
+}
+
+void audio_watch(uint8_t reason) {
+  player.sendCommand({PR_WATCH, reason});   /* the player climbs its ladder of actions */
+}
+
+void audio_process_pcm(const int16_t *frames, uint16_t count, uint32_t sampleRate) {
+  pcmtap.write(frames, count, sampleRate);
+}
+
+void audio_process_block(int16_t *frames, uint16_t count, uint32_t sampleRate) {
+  pm.process_audio(frames, count, sampleRate);
+}
+#endif
+
+#if DNS_CACHE_SIZE>0
+uint8_t audio_resolve(const char *host, uint32_t *ips, uint8_t max, bool wait) {
+  uint8_t n = dnscache.resolve(host, ips, max, wait);
+  return n || wait || !dnscache.pending(host) ? n : ConnRace::RESOLVING;
+}
+#endif
+
+#if (I2S_DOUT!=255 || I2S_INTERNAL) && PREFETCH_STATIONS>0
+WiFiClient *audio_warm_client(const char *url) {
+  return prefetch.take(url);
+}
+#endif
+
+#if TTFS_HISTORY>0
+void audio_ttfs(const Ttfs &t) {
+  ttfslog.add(config.lastStation(), t);
+  char line[160];
+  t.format(line, sizeof(line));
+  telnet.printf("##AUDIO.TTFS#: %s\r\n", line);
+  netserver.requestOnChange(GETTTFS, 0);
+}
+#endif
+
+void audio_process_stream(const uint8_t *data, size_t len) {
+  #ifdef USE_SD
+    recorder.feed(data, len);
+  #endif
+  #if RELAY_MAX_CLIENTS>0
+    relay.feed(data, len);
+  #endif
+}
+
 void audio_progress(uint32_t startpos, uint32_t endpos) {
   player.sd_min = startpos;
   player.sd_max = endpos;
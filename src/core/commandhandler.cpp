@@ -9,6 +9,9 @@
 #include "network.h"
 #include "mqtt.h"
 #include "core/battery.h"
+#ifdef USE_SD
+  #include "recorder.h"
+#endif
 #if DSP_MODEL==DSP_DUMMY
   #define DUMMYDISPLAY
 #endif
@@ -21,10 +24,23 @@ bool CommandHandler::exec(const char *command, const char *value, uint8_t cid) {
   if (strEquals(command, "toggle"))   { player.toggle(); return true; }
   if (strEquals(command, "prev"))     { player.prev(); return true; }
   if (strEquals(command, "next"))     { player.next(); return true; }
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    if (strEquals(command, "pause"))    { player.sendCommand({PR_TSPAUSE, 0}); return true; }
+    if (strEquals(command, "rewind"))   { int s = atoi(value); player.sendCommand({PR_TSJUMP, s > 0 ? s : 10}); return true; }
+    if (strEquals(command, "golive"))   { player.sendCommand({PR_TSJUMP, 0}); return true; }
+    if (strEquals(command, "getnight"))    { netserver.requestOnChange(GETNIGHT, cid); return true; }
+    if (strEquals(command, "nightmode"))   { config.setNightMode(atoi(value) != 0); return true; }
+    if (strEquals(command, "nightthr"))    { config.setNightPreset(atoi(value), config.store.nightratio, config.store.nightatk, config.store.nightrel, config.store.nightmakeup); return true; }
+    if (strEquals(command, "nightratio"))  { config.setNightPreset(config.store.nightthr, atoi(value), config.store.nightatk, config.store.nightrel, config.store.nightmakeup); return true; }
+    if (strEquals(command, "nightatk"))    { config.setNightPreset(config.store.nightthr, config.store.nightratio, atoi(value), config.store.nightrel, config.store.nightmakeup); return true; }
+    if (strEquals(command, "nightrel"))    { config.setNightPreset(config.store.nightthr, config.store.nightratio, config.store.nightatk, atoi(value), config.store.nightmakeup); return true; }
+    if (strEquals(command, "nightmakeup")) { config.setNightPreset(config.store.nightthr, config.store.nightratio, config.store.nightatk, config.store.nightrel, atoi(value)); return true; }
+  #endif
   if (strEquals(command, "volm"))     { player.stepVol(false); return true; }
   if (strEquals(command, "volp"))     { player.stepVol(true); return true; }
   #ifdef USE_SD
     if (strEquals(command, "mode"))     { config.changeMode(atoi(value)); return true; }
+    if (strEquals(command, "record"))   { if (atoi(value)) recorder.start(); else recorder.stop(); netserver.requestOnChange(GETRECORD, cid); return true; }
   #endif
   if (strEquals(command, "reset") && cid==0)    { config.reset(); return true; }
   if (strEquals(command, "ballance")) { config.setBalance(atoi(value)); return true; }
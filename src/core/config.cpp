@@ -165,7 +165,7 @@ void Config::changeMode(int newmode) {
     bool pir = player.isRunning();
     if (SDC_CS==255) return;
     if (getMode()==PM_SDCARD) {
-      sdResumePos = player.getFilePos();
+      sdResumePos = player.inTask() ? player.getFilePos() : player.sdPos().pos;
     }
     if (network.status==SOFT_AP || display.mode()==LOST) {
       saveValue(&store.play_mode, static_cast<uint8_t>(PM_SDCARD));
@@ -422,7 +422,7 @@ void Config::setSDpos(uint32_t val) {
       player.setResumeFilePos(val-player.sd_min);
       player.sendCommand({PR_PLAY, config.store.lastSdStation});
     } else {
-      player.setFilePos(val-player.sd_min);
+      player.sendCommand({PR_SEEK, (int)(val-player.sd_min)});
     }
   }
 }
@@ -444,6 +444,8 @@ void Config::resetSystem(const char *val, uint8_t clientId) {
     saveValue(&store.vumeter, SHOW_VU_METER, false);
     saveValue(&store.wifiscanbest, WIFI_SCAN_BEST_RSSI, false);
     saveValue(&store.softapdelay, (uint8_t)SOFTAP_REBOOT_DELAY, false);
+    setNightPreset(NIGHT_THRESHOLD, NIGHT_RATIO, NIGHT_ATTACK, NIGHT_RELEASE, NIGHT_MAKEUP);
+    setNightMode(NIGHT_MODE);
     snprintf(store.mdnsname, MDNS_LENGTH, "ehradio-%x", getChipId());
     saveValue(store.mdnsname, store.mdnsname, MDNS_LENGTH, true, true);
     display.putRequest(NEWMODE, CLEAR); display.putRequest(NEWMODE, PLAYER);
@@ -557,17 +559,37 @@ void Config::setTone(int8_t bass, int8_t middle, int8_t treble) {
   saveValue(&store.bass, bass, false);
   saveValue(&store.middle, middle, false);
   saveValue(&store.treble, treble);
-  player.setTone(store.bass, store.middle, store.treble);
+  player.sendCommand({PR_TONE, 0});
   netserver.requestOnChange(EQUALIZER, 0);
 }
 
+void Config::setNightMode(bool on) {
+  saveValue(&store.nightmode, on);
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    player.sendCommand({PR_NIGHT, 0});
+    netserver.requestOnChange(GETNIGHT, 0);
+  #endif
+}
+
+void Config::setNightPreset(int8_t threshold, uint8_t ratio, uint8_t attack, uint16_t release, uint8_t makeup) {
+  saveValue(&store.nightthr, (int8_t)constrain(threshold, -60, 0), false);
+  saveValue(&store.nightratio, (uint8_t)constrain(ratio, 1, 20), false);
+  saveValue(&store.nightatk, (uint8_t)constrain(attack, 1, 200), false);
+  saveValue(&store.nightrel, (uint16_t)constrain(release, 10, 5000), false);
+  saveValue(&store.nightmakeup, (uint8_t)constrain(makeup, 0, 18));
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    player.sendCommand({PR_NIGHT, 0});
+    netserver.requestOnChange(GETNIGHT, 0);
+  #endif
+}
+
 void Config::setSmartStart(bool ss) {
   saveValue(&store.smartstart, ss);
 }
 
 void Config::setBalance(int8_t balance) {
   saveValue(&store.balance, balance);
-  player.setBalance(store.balance);
+  player.sendCommand({PR_BALANCE, 0});
   netserver.requestOnChange(BALANCE, 0);
 }
 
@@ -592,7 +614,9 @@ void Config::setTitle(const char* title) {
   strlcpy(config.station.title, title, BUFLEN);
   u8fix(config.station.title);
   netserver.requestOnChange(TITLE, 0);
-  netserver.loop();
+  #if !PLAYER_TASK
+    netserver.loop();   /* titles come from the player task too, it leaves the request to loop() */
+  #endif
   display.putRequest(NEWTITLE);
 }
 
@@ -687,6 +711,23 @@ char * Config::stationByNum(uint16_t num) {
   return _stationBuf;
 }
 
+bool Config::stationUrlByNum(uint16_t num, char *url) {  /* url: BUFLEN */
+  if (num == 0 || num > playlistLength()) return false;
+  File playlist = SDPLFS()->open(REAL_PLAYL, "r");
+  File index = SDPLFS()->open(REAL_INDEX, "r");
+  if (!playlist || !index) return false;
+  index.seek((num - 1) * 4, SeekSet);
+  uint32_t pos;
+  index.readBytes((char *) &pos, 4);
+  index.close();
+  playlist.seek(pos, SeekSet);
+  char sName[BUFLEN];
+  int sOvol;
+  bool res = parseCSV(playlist.readStringUntil('\n').c_str(), sName, url, sOvol);
+  playlist.close();
+  return res;
+}
+
 void Config::escapeQuotes(const char* input, char* output, size_t maxLen) {
   size_t j = 0;
   for (size_t i = 0; input[i] != '\0' && j < maxLen - 1; ++i) {
@@ -1207,6 +1248,12 @@ const configKeyMap Config::keyMap[] = {
   CONFIG_KEY_ENTRY(treble, "treb"),
   CONFIG_KEY_ENTRY(middle, "mid"),
   CONFIG_KEY_ENTRY(bass, "bass"),
+  CONFIG_KEY_ENTRY(nightmode, "nightmode"),
+  CONFIG_KEY_ENTRY(nightthr, "nightthr"),
+  CONFIG_KEY_ENTRY(nightratio, "nightratio"),
+  CONFIG_KEY_ENTRY(nightatk, "nightatk"),
+  CONFIG_KEY_ENTRY(nightrel, "nightrel"),
+  CONFIG_KEY_ENTRY(nightmakeup, "nightmakeup"),
   CONFIG_KEY_ENTRY(sdshuffle, "sdshuffle"),
   CONFIG_KEY_ENTRY(smartstart, "smartstartx"),
   CONFIG_KEY_ENTRY(autoupdate, "autoupdate"),
@@ -85,6 +85,12 @@ struct config_t // specify defaults here (and macros in options.h) (defaults are
   int8_t    treble = EQ_TREBLE;
   int8_t    middle = EQ_MIDDLE;
   int8_t    bass = EQ_BASS;
+  bool      nightmode = NIGHT_MODE;
+  int8_t    nightthr = NIGHT_THRESHOLD;
+  uint8_t   nightratio = NIGHT_RATIO;
+  uint8_t   nightatk = NIGHT_ATTACK;
+  uint16_t  nightrel = NIGHT_RELEASE;
+  uint8_t   nightmakeup = NIGHT_MAKEUP;
   bool      sdshuffle = SD_SHUFFLE;
   bool      smartstart = SMART_START;
   bool      autoupdate = false;
@@ -218,6 +224,8 @@ class Config {
     void setTone(int8_t bass, int8_t middle, int8_t treble);
     void setSmartStart(bool ss);
     void setBalance(int8_t balance);
+    void setNightMode(bool on);
+    void setNightPreset(int8_t threshold, uint8_t ratio, uint8_t attack, uint16_t release, uint8_t makeup);
     uint8_t setLastStation(uint16_t val);
     uint8_t setCountStation(uint16_t val);
     uint8_t setLastSSID(uint8_t val);
@@ -228,6 +236,7 @@ class Config {
     uint16_t playlistLength();
     bool loadStation(uint16_t station);
     char * stationByNum(uint16_t num);
+    bool stationUrlByNum(uint16_t num, char *url);
     void escapeQuotes(const char* input, char* output, size_t maxLen);
     bool parseCSV(const char* line, char* name, char* url, int &ovol);
     bool parseWsCommand(const char* line, char* cmd, char* val, uint8_t cSize);
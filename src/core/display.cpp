@@ -181,7 +181,11 @@ void Display::_buildPager() {
     //_metabackground = new FillWidget(metaBGConf, 1);
   #endif
   #ifndef HIDE_VU
-    _vuwidget = new VuWidget(vuConf, bandsConf, config.theme.vumax, config.theme.vumin, config.theme.background);
+    #if VU_SPECTRUM && defined(SPECTRUM_CONF) && (I2S_DOUT!=255 || I2S_INTERNAL)
+      _vuwidget = new SpectrumWidget(vuConf, spectrumConf, config.theme.vumax, config.theme.vumin, config.theme.background);
+    #else
+      _vuwidget = new VuWidget(vuConf, bandsConf, config.theme.vumax, config.theme.vumin, config.theme.background);
+    #endif
   #endif
   #ifndef HIDE_VOLBAR
     _volbar = new SliderWidget(volbarConf, config.theme.volbarin, config.theme.background, 254, config.theme.volbarout);
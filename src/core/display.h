@@ -15,6 +15,7 @@ class FillWidget;
 class SliderWidget;
 class Pager;
 class Page;
+class Widget;
 class VuWidget;
 class NumWidget;
 class ClockWidget;
@@ -71,7 +72,7 @@ class Display {
     SliderWidget *_volbar, *_heapbar;
     Pager *_pager;
     Page *_footer;
-    VuWidget *_vuwidget;
+    Widget *_vuwidget;
     NumWidget *_nums;
     ClockWidget *_clock;
     Page *_boot;
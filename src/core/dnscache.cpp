@@ -0,0 +1,312 @@
+#include "options.h"
+#if DNS_CACHE_SIZE>0 // ============================== Everything ignored if not defined ==============================
+#include <WiFi.h>
+#include <Preferences.h>
+#include <lwip/sockets.h>
+#include "dnscache.h"
+
+#define DNS_QUERY_MS   1500
+
+DnsCache dnscache;
+
+struct dnsSaved_t
+{
+  char              host[DNS_CACHE_HOST];
+  uint32_t          ips[DNS_CACHE_ADDRS];
+  uint8_t           count;
+};
+
+/* skip a (possibly compressed) name in a DNS message */
+static int _skipName(const uint8_t *p, int pos, int len) {
+  while (pos < len) {
+    uint8_t b = p[pos];
+    if ((b & 0xC0) == 0xC0) return pos + 2;
+    if (b == 0) return pos + 1;
+    pos += b + 1;
+  }
+  return -1;
+}
+
+/* the A records of msg if it answers query (same ID, the same single question; the name in any case), -1 if it
+   does not, 0 if it has no address (truncated, error rcode); ttl: the lowest of the answer */
+int8_t DnsCache::parse(const uint8_t *msg, int n, const uint8_t *query, int qlen, uint32_t *ips, uint8_t max, uint32_t *ttl) {
+  if (n < 12 || qlen < 17 || msg[0] != query[0] || msg[1] != query[1] || !(msg[2] & 0x80)) return -1;
+  if ((msg[4] << 8 | msg[5]) != 1 || n < qlen) return (msg[2] & 0x02) ? 0 : -1;   /* a truncated answer may drop the question */
+  for (int i = 12; i < qlen; i++) if (tolower(msg[i]) != tolower(query[i])) return -1;   /* QNAME, QTYPE, QCLASS */
+  if ((msg[2] & 0x02) || (msg[3] & 0x0F)) return 0;
+
+  uint16_t an = msg[6] << 8 | msg[7];
+  int pos = qlen;
+  uint8_t count = 0;
+  uint32_t minTtl = 0xFFFFFFFF;
+  for (uint16_t i = 0; i < an && pos >= 0 && pos + 10 <= n; i++) {
+    pos = _skipName(msg, pos, n);
+    if (pos < 0 || pos + 10 > n) break;
+    uint16_t type = msg[pos] << 8 | msg[pos + 1], cls = msg[pos + 2] << 8 | msg[pos + 3];
+    uint32_t t = (uint32_t)msg[pos + 4] << 24 | (uint32_t)msg[pos + 5] << 16 | msg[pos + 6] << 8 | msg[pos + 7];
+    uint16_t rdlen = msg[pos + 8] << 8 | msg[pos + 9];
+    pos += 10;
+    if (pos + rdlen > n) break;
+    if (t < minTtl) minTtl = t;                           /* CNAMEs in the chain count too */
+    if (type == 1 && cls == 1 && rdlen == 4 && count < max) memcpy(&ips[count++], msg + pos, 4);
+    pos += rdlen;
+  }
+  if (count) *ttl = minTtl;
+  return count;
+}
+
+/* one A query to one server, collects every A record of the answer and the lowest TTL */
+static uint8_t _query(IPAddress server, const char *host, uint32_t *ips, uint8_t max, uint32_t *ttl) {
+  uint8_t q[272], p[512];
+  uint16_t id = esp_random();
+  int len = 12;
+  memset(q, 0, 12);
+  q[0] = id >> 8; q[1] = id; q[2] = 0x01; q[5] = 1;       /* recursion desired, one question */
+  for (const char *l = host; *l; ) {
+    const char *dot = strchr(l, '.');
+    int n = dot ? dot - l : strlen(l);
+    if (n == 0 || n > 63 || len + n + 6 > (int)sizeof(q)) return 0;
+    q[len++] = n;
+    memcpy(q + len, l, n); len += n;
+    l += n + (dot ? 1 : 0);
+  }
+  q[len++] = 0;
+  q[len++] = 0; q[len++] = 1;                             /* type A */
+  q[len++] = 0; q[len++] = 1;                             /* class IN */
+
+  int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s < 0) return 0;
+  struct timeval tv = { DNS_QUERY_MS / 1000, (DNS_QUERY_MS % 1000) * 1000 };
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  struct sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(53);
+  sa.sin_addr.s_addr = (uint32_t)server;
+  int8_t r = -1;
+  if (sendto(s, q, len, 0, (struct sockaddr*)&sa, sizeof(sa)) == len) {
+    int n;                                                /* whatever does not answer this question is ignored */
+    do { n = recv(s, p, sizeof(p), 0); } while (n >= 0 && (r = DnsCache::parse(p, n, q, len, ips, max, ttl)) < 0);
+  }
+  close(s);
+  return r > 0 ? r : 0;
+}
+
+static uint8_t _dnsResolve(const char *host, uint32_t *ips, uint8_t max, uint32_t *ttl) {
+  for (uint8_t i = 0; i < 2; i++) {
+    IPAddress server = WiFi.dnsIP(i);
+    if ((uint32_t)server == 0) continue;
+    uint8_t n = _query(server, host, ips, max, ttl);
+    if (n) return n;
+  }
+  /* not answered directly (DNS over something else, truncated answer ...), lwIP does not tell the TTL */
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip) || (uint32_t)ip == 0) return 0;
+  ips[0] = (uint32_t)ip;
+  *ttl = DNS_CACHE_MIN_TTL;
+  return 1;
+}
+
+static uint32_t _hash(const void *data, size_t len) {   /* FNV-1a */
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) { h ^= ((const uint8_t*)data)[i]; h *= 16777619u; }
+  return h;
+}
+
+void DnsCache::begin() {
+  if (!_lock) _lock = xSemaphoreCreateMutex();
+  Preferences prefs;
+  if (!prefs.begin("dnscache", true)) return;
+  dnsSaved_t saved[DNS_CACHE_PERSIST];
+  size_t len = prefs.getBytesLength("hot");
+  if (len > 0 && len <= sizeof(saved) && len % sizeof(dnsSaved_t) == 0) {
+    prefs.getBytes("hot", saved, len);
+    _savedHash = _hash(saved, len);
+    uint32_t now = millis();
+    /* no clock to tell how old they are: stale right away, refreshed on first use */
+    for (uint8_t i = 0; i < len / sizeof(dnsSaved_t) && i < DNS_CACHE_SIZE; i++) {
+      if (!saved[i].host[0] || !saved[i].count || saved[i].count > DNS_CACHE_ADDRS) continue;
+      dnsEntry_t &e = _e[i];
+      strlcpy(e.host, saved[i].host, DNS_CACHE_HOST);
+      memcpy(e.ips, saved[i].ips, sizeof(e.ips));
+      e.count = saved[i].count;
+      e.expires = now;
+      e.used = now;
+      e.hits = DNS_CACHE_PERSIST - i;
+    }
+  }
+  prefs.end();
+}
+
+int8_t DnsCache::_find(const char *host) {
+  for (uint8_t i = 0; i < DNS_CACHE_SIZE; i++) if (_e[i].host[0] && strcasecmp(_e[i].host, host) == 0) return i;
+  return -1;
+}
+
+/* entry of host, or the least recently used one */
+dnsEntry_t *DnsCache::_slot(const char *host) {
+  int8_t i = _find(host);
+  if (i >= 0) return &_e[i];
+  uint8_t lru = 0;
+  for (uint8_t j = 0; j < DNS_CACHE_SIZE; j++) {
+    if (!_e[j].host[0]) { lru = j; break; }
+    if ((int32_t)(_e[j].used - _e[lru].used) < 0) lru = j;
+  }
+  memset(&_e[lru], 0, sizeof(dnsEntry_t));
+  strlcpy(_e[lru].host, host, DNS_CACHE_HOST);
+  _e[lru].used = millis();
+  return &_e[lru];
+}
+
+uint8_t DnsCache::_lookup(const char *host, uint32_t *ips, uint8_t max, uint32_t *ttl) {
+  uint8_t n = (_resolver ? _resolver : _dnsResolve)(host, ips, max, ttl);
+  if (!n) _failures++;
+  return n;
+}
+
+void DnsCache::_store(const char *host, const uint32_t *ips, uint8_t count, uint32_t ttl) {
+  if (count) ttl = constrain(ttl, (uint32_t)DNS_CACHE_MIN_TTL, (uint32_t)DNS_CACHE_MAX_TTL);
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  dnsEntry_t *e = _slot(host);
+  if (count || !e->count || (int32_t)(millis() - e->expires) >= DNS_CACHE_STALE_S * 1000) {
+    /* a failed refresh keeps serving the stale answer */
+    bool changed = e->count != count || memcmp(e->ips, ips, count * 4) != 0;
+    memcpy(e->ips, ips, count * 4);
+    e->count = count;
+    e->expires = millis() + (count ? ttl : DNS_CACHE_NEG_TTL) * 1000;
+    if (changed && count) _dirty = true;
+  }
+  e->refresh = false;
+  xSemaphoreGive(_lock);
+}
+
+uint8_t DnsCache::resolve(const char *host, uint32_t *ips, uint8_t max, bool wait) {
+  if (!host || !*host || !max) return 0;
+  IPAddress literal;
+  if (literal.fromString(host)) { ips[0] = (uint32_t)literal; return 1; }
+  if (strlen(host) >= DNS_CACHE_HOST || !_lock) {
+    uint32_t ttl;
+    return _lookup(host, ips, max, &ttl);
+  }
+  uint8_t n = 0;
+  bool kick = false, found = false;
+  uint32_t now = millis();
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  int8_t i = _find(host);
+  if (i >= 0) {
+    dnsEntry_t &e = _e[i];
+    int32_t age = now - e.expires;                        /* > 0: expired this long ago */
+    if (age < 0 || (e.count && age < DNS_CACHE_STALE_S * 1000)) {
+      found = true;
+      n = min(e.count, max);
+      memcpy(ips, e.ips, n * 4);
+      e.used = now;
+      if (e.hits < 0xFFFF) e.hits++;
+      if (age < 0) _hits++;
+      else {
+        _stale++;
+        if (!e.refresh) { e.refresh = true; kick = true; }
+      }
+    }
+  }
+  if (!found) {
+    _misses++;
+    if (!wait) {
+      dnsEntry_t *e = _slot(host);
+      if (!e->refresh) { e->refresh = true; kick = true; }
+    }
+  }
+  if (kick) _kick();
+  xSemaphoreGive(_lock);
+  if (found || !wait) return n;
+
+  /* miss: resolve now, outside the lock */
+  uint32_t res[DNS_CACHE_ADDRS], ttl = 0;
+  uint8_t count = _lookup(host, res, DNS_CACHE_ADDRS, &ttl);
+  _store(host, res, count, ttl);
+  if (count) {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    int8_t j = _find(host);
+    if (j >= 0) _e[j].hits++;
+    if (_dirty) _kick();
+    xSemaphoreGive(_lock);
+  }
+  n = min(count, max);
+  memcpy(ips, res, n * 4);
+  return n;
+}
+
+bool DnsCache::resolve(const char *host, IPAddress &ip, bool wait) {
+  uint32_t a;
+  if (!resolve(host, &a, 1, wait)) return false;
+  ip = IPAddress(a);
+  return true;
+}
+
+bool DnsCache::pending(const char *host) {
+  if (!_lock) return false;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  int8_t i = _find(host);
+  bool p = i >= 0 && _e[i].refresh && !_e[i].count;
+  xSemaphoreGive(_lock);
+  return p;
+}
+
+void DnsCache::_kick() {   /* with _lock taken */
+  if (_task) return;
+  xTaskCreate(_refreshTask, "dnsRefresh", 4096, this, 1, &_task);
+}
+
+void DnsCache::_refreshTask(void *param) {
+  DnsCache *c = static_cast<DnsCache*>(param);
+  while (true) {
+    char host[DNS_CACHE_HOST] = {0};
+    xSemaphoreTake(c->_lock, portMAX_DELAY);
+    for (uint8_t i = 0; i < DNS_CACHE_SIZE; i++) if (c->_e[i].host[0] && c->_e[i].refresh) { strlcpy(host, c->_e[i].host, DNS_CACHE_HOST); break; }
+    if (!host[0] && !c->_dirty) {
+      c->_task = NULL;
+      xSemaphoreGive(c->_lock);
+      break;
+    }
+    xSemaphoreGive(c->_lock);
+    if (!host[0]) { c->_save(); continue; }
+    uint32_t ips[DNS_CACHE_ADDRS], ttl = 0;
+    uint8_t n = c->_lookup(host, ips, DNS_CACHE_ADDRS, &ttl);
+    c->_store(host, ips, n, ttl);
+    c->_refreshes++;
+  }
+  vTaskDelete(NULL);
+}
+
+/* the DNS_CACHE_PERSIST busiest positive entries, only written when they changed */
+void DnsCache::_save() {
+  dnsSaved_t saved[DNS_CACHE_PERSIST];
+  memset(saved, 0, sizeof(saved));
+  uint8_t n = 0;
+  bool taken[DNS_CACHE_SIZE] = {false};
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  _dirty = false;
+  while (n < DNS_CACHE_PERSIST) {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < DNS_CACHE_SIZE; i++) {
+      if (taken[i] || !_e[i].host[0] || !_e[i].count) continue;
+      if (best < 0 || _e[i].hits > _e[best].hits) best = i;
+    }
+    if (best < 0) break;
+    taken[best] = true;
+    strlcpy(saved[n].host, _e[best].host, DNS_CACHE_HOST);
+    memcpy(saved[n].ips, _e[best].ips, sizeof(saved[n].ips));
+    saved[n].count = _e[best].count;
+    n++;
+  }
+  xSemaphoreGive(_lock);
+  uint32_t h = _hash(saved, n * sizeof(dnsSaved_t));
+  if (n == 0 || h == _savedHash) return;
+  Preferences prefs;
+  if (!prefs.begin("dnscache", false)) return;
+  prefs.putBytes("hot", saved, n * sizeof(dnsSaved_t));
+  prefs.end();
+  _savedHash = h;
+}
+
+#endif // #if DNS_CACHE_SIZE>0
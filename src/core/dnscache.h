@@ -0,0 +1,67 @@
+#ifndef dnscache_h
+#define dnscache_h
+#include "options.h"
+
+#if DNS_CACHE_SIZE>0 // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+
+#define DNS_CACHE_ADDRS 4
+#define DNS_CACHE_HOST  64
+
+struct dnsEntry_t
+{
+  char              host[DNS_CACHE_HOST];
+  uint32_t          ips[DNS_CACHE_ADDRS];   /* network order */
+  uint8_t           count;                  /* 0 = name did not resolve (negative entry) */
+  bool              refresh;                /* queued for the background task */
+  uint32_t          expires;                /* millis() */
+  uint32_t          used;                   /* millis() of the last lookup, for eviction */
+  uint16_t          hits;                   /* lookups, the busiest entries are saved */
+};
+
+/* returns the number of addresses and the TTL of the answer in seconds, 0 if the name does not resolve */
+typedef uint8_t (*dnsResolver_t)(const char *host, uint32_t *ips, uint8_t max, uint32_t *ttl);
+
+/* Resolver cache shared by the stream connections, weather and MQTT.
+   Answers are kept for their TTL (asked from the DNS server directly, lwIP does not pass TTLs on).
+   An expired answer is still served for up to DNS_CACHE_STALE_S while a background task asks again,
+   so a slow or failing upstream resolver does not hold up a connect. The busiest entries are kept
+   in NVS and come back as stale after a reboot. */
+class DnsCache {
+  public:
+    DnsCache() {};
+    void begin();
+    uint8_t resolve(const char *host, uint32_t *ips, uint8_t max, bool wait = true);   /* wait = false: cache only, a miss is resolved in the background */
+    bool resolve(const char *host, IPAddress &ip, bool wait = true);
+    bool pending(const char *host);     /* a lookup is under way and there is no answer to serve meanwhile */
+    void setResolver(dnsResolver_t resolver) { _resolver = resolver; }
+    const dnsEntry_t *entry(uint8_t i) { return i < DNS_CACHE_SIZE && _e[i].host[0] ? &_e[i] : NULL; }
+    uint32_t hits()      { return _hits; }
+    uint32_t staleHits() { return _stale; }
+    uint32_t misses()    { return _misses; }
+    uint32_t failures()  { return _failures; }
+    uint32_t refreshes() { return _refreshes; }
+    static int8_t parse(const uint8_t *msg, int len, const uint8_t *query, int qlen, uint32_t *ips, uint8_t max, uint32_t *ttl);
+  private:
+    dnsEntry_t _e[DNS_CACHE_SIZE] = {};
+    SemaphoreHandle_t _lock = NULL;
+    TaskHandle_t _task = NULL;
+    dnsResolver_t _resolver = NULL;
+    bool _dirty = false;
+    uint32_t _savedHash = 0;
+    uint32_t _hits = 0, _stale = 0, _misses = 0, _failures = 0, _refreshes = 0;
+
+    int8_t _find(const char *host);
+    dnsEntry_t *_slot(const char *host);
+    uint8_t _lookup(const char *host, uint32_t *ips, uint8_t max, uint32_t *ttl);
+    void _store(const char *host, const uint32_t *ips, uint8_t count, uint32_t ttl);
+    void _kick();
+    void _save();
+    static void _refreshTask(void *param);
+};
+
+extern DnsCache dnscache;
+
+#endif // #if DNS_CACHE_SIZE>0
+
+#endif
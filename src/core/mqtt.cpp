@@ -5,6 +5,12 @@
 #include "mqtt.h"
 #include <WiFi.h>
 #include "player.h"
+#include "dnscache.h"
+#include "titlelog.h"
+#include "ttfslog.h"
+#ifdef USE_SD
+  #include "recorder.h"
+#endif
 
 AsyncMqttClient mqttClient;
 TimerHandle_t mqttReconnectTimer;
@@ -12,6 +18,11 @@ char topic[100], status[BUFLEN+50];
 
 void connectToMqtt() {
   //config.waitConnection();
+  #if DNS_CACHE_SIZE>0
+    IPAddress ip;   /* runs in the timer task, never wait for DNS here; a miss is resolved for the next try */
+    if (dnscache.resolve(config.store.mqtthost, ip, false)) mqttClient.setServer(ip, config.store.mqttport);
+    else mqttClient.setServer(config.store.mqtthost, config.store.mqttport);
+  #endif
   mqttClient.connect();
 }
 
@@ -34,6 +45,12 @@ void onMqttConnect(bool sessionPresent) {
   mqttPublishStatus();
   mqttPublishVolume();
   mqttPublishPlaylist();
+  #if TITLE_HISTORY>0
+    mqttPublishTitles();
+  #endif
+  #if TTFS_HISTORY>0
+    mqttPublishTtfs();
+  #endif
 }
 
 void mqttPublishStatus() {
@@ -69,6 +86,42 @@ void mqttPublishVolume() {
   }
 }
 
+#if TITLE_HISTORY>0
+void mqttPublishTitles() {
+  if (mqttClient.connected()) {
+    zeroBuffer();
+    sprintf(topic, "%s%s", config.store.mqtttopic, "titles");
+    String json;
+    titlelog.json(config.lastStation(), json);
+    mqttClient.publish(topic, 0, true, json.c_str());
+  }
+}
+#endif
+
+#if TTFS_HISTORY>0
+void mqttPublishTtfs() {
+  if (mqttClient.connected()) {
+    zeroBuffer();
+    sprintf(topic, "%s%s", config.store.mqtttopic, "ttfs");
+    String json;
+    ttfslog.json(config.lastStation(), json);
+    mqttClient.publish(topic, 0, true, json.c_str());
+  }
+}
+#endif
+
+#if I2S_DOUT!=255 || I2S_INTERNAL
+void mqttPublishWatch(uint8_t reason, uint8_t strike, uint8_t action) {   /* from the player task: own buffers, not retained */
+  if (!mqttClient.connected()) return;
+  char wtopic[100], name[BUFLEN/2], alert[BUFLEN];
+  snprintf(wtopic, sizeof(wtopic), "%s%s", config.store.mqtttopic, "watch");
+  config.escapeQuotes(config.station.name, name, sizeof(name)-10);
+  snprintf(alert, sizeof(alert), "{\"station\": %d, \"name\": \"%s\", \"reason\": \"%s\", \"strike\": %u, \"action\": \"%s\"}",
+           config.lastStation(), name, StreamWatch::name(reason), strike, StreamWatch::actionName(action));
+  mqttClient.publish(wtopic, 0, false, alert);
+}
+#endif
+
 void onMqttDisconnect(AsyncMqttClientDisconnectReason reason) {
   if (WiFi.isConnected()) {
     xTimerStart(mqttReconnectTimer, 0);
@@ -87,6 +140,10 @@ void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties
     if (strcmp(buf, "stop") == 0) { player.sendCommand({PR_STOP, 0}); return; }
     if (strcmp(buf, "start") == 0 || strcmp(buf, "play") == 0) { player.sendCommand({PR_PLAY, config.lastStation()}); return; }
     if (strcmp(buf, "boot") == 0 || strcmp(buf, "reboot") == 0) { ESP.restart(); return; }
+    #ifdef USE_SD
+      if (strcmp(buf, "recstart") == 0) { recorder.start(); return; }
+      if (strcmp(buf, "recstop") == 0) { recorder.stop(); return; }
+    #endif
     if (strcmp(buf, "volm") == 0) {
       player.stepVol(false);
       return;
@@ -11,6 +11,15 @@ void onMqttConnect(bool sessionPresent);
 void mqttPublishStatus();
 void mqttPublishPlaylist();
 void mqttPublishVolume();
+#if TITLE_HISTORY>0
+void mqttPublishTitles();
+#endif
+#if TTFS_HISTORY>0
+void mqttPublishTtfs();
+#endif
+#if I2S_DOUT!=255 || I2S_INTERNAL
+void mqttPublishWatch(uint8_t reason, uint8_t strike, uint8_t action);
+#endif
 void onMqttDisconnect(AsyncMqttClientDisconnectReason reason);
 void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total);
 
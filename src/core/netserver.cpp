@@ -42,7 +42,12 @@
 #include <freertos/FreeRTOS.h>
 #ifdef USE_SD
   #include "sdmanager.h"
+  #include "recorder.h"
 #endif
+#include "relay.h"
+#include "titlelog.h"
+#include "ttfslog.h"
+#include "../libraries/I2S_Audio/httpparser.h"
 #ifndef MIN_MALLOC
   #define MIN_MALLOC 24112
 #endif
@@ -203,6 +208,15 @@ bool NetServer::begin(bool quiet) {
   webserver.on("/", HTTP_ANY, handleIndex);
   webserver.on("/search", HTTP_GET, handleSearch);
   webserver.on("/search", HTTP_POST, handleSearchPost);
+  #if RELAY_MAX_CLIENTS>0
+    webserver.on("/relay", HTTP_GET, [](AsyncWebServerRequest *request) { relay.handle(request); });
+  #endif
+  #if TITLE_HISTORY>0
+    webserver.on("/titles", HTTP_GET, [](AsyncWebServerRequest *request) { titlelog.handle(request); });
+  #endif
+  #if TTFS_HISTORY>0
+    webserver.on("/ttfs", HTTP_GET, [](AsyncWebServerRequest *request) { ttfslog.handle(request); });
+  #endif
   webserver.onNotFound(handleNotFound);
   webserver.onFileUpload(handleUpload);
 
@@ -362,6 +376,9 @@ void NetServer::processQueue() {
                                                               #ifndef HIDE_VU
                                                                 act += F("\"group_vu\",");
                                                               #endif
+                                                              #if I2S_DOUT!=255 || I2S_INTERNAL
+                                                                act += F("\"group_night\",");
+                                                              #endif
             if (BRIGHTNESS_PIN != 255 || nxtn || dbgact)                act += F("\"group_brightness\",");
             if (DSP_CAN_FLIPPED || dbgact)                      act += F("\"group_tft\",");
             if (TS_MODEL != TS_MODEL_UNDEFINED || dbgact)       act += F("\"group_touch\",");
@@ -388,6 +405,10 @@ void NetServer::processQueue() {
           requestOnChange(SDINIT, clientId);
           requestOnChange(GETPLAYERMODE, clientId);
           requestOnChange(GETBATTERY, clientId); 
+          requestOnChange(GETRECORD, clientId);
+          requestOnChange(GETI2S, clientId);
+          requestOnChange(GETTTFS, clientId);
+          requestOnChange(GETNIGHT, clientId);
           if (config.getMode()==PM_SDCARD) { requestOnChange(SDPOS, clientId); requestOnChange(SDLEN, clientId); requestOnChange(SDSHUFFLE, clientId); } 
           return; 
           break;
@@ -453,12 +474,14 @@ void NetServer::processQueue() {
       case TITLE:         sprintf (wsbuf, "{\"payload\":[{\"id\":\"meta\", \"value\": \"%s\"}]}", config.station.title); telnet.printf("##CLI.META#: %s\r\n> ", config.station.title); break;
       case VOLUME:        sprintf (wsbuf, "{\"payload\":[{\"id\":\"volume\", \"value\": %d}]}", config.store.volume); telnet.printf("##CLI.VOL#: %d\r\n", config.store.volume); break;
       case NRSSI:         sprintf (wsbuf, "{\"payload\":[{\"id\":\"rssi\", \"value\": %d}]}", rssi); /*rssi = 255;*/ break;
-      case SDPOS:         sprintf (wsbuf, "{\"sdpos\": %d,\"sdend\": %d,\"sdtpos\": %d,\"sdtend\": %d}",
-                                  player.getFilePos(),
-                                  player.getFileSize(),
-                                  player.getAudioCurrentTime(),
-                                  player.getAudioFileDuration()); 
-                                  break;
+      case SDPOS: {       sdPos_t sp = player.sdPos();
+                          sprintf (wsbuf, "{\"sdpos\": %d,\"sdend\": %d,\"sdtpos\": %d,\"sdtend\": %d}",
+                                  sp.pos,
+                                  sp.size,
+                                  sp.time,
+                                  sp.duration); 
+                          break;
+                        }
       case SDLEN:         sprintf (wsbuf, "{\"sdmin\": %d,\"sdmax\": %d}", player.sd_min, player.sd_max); break;
       case SDSHUFFLE:     sprintf (wsbuf, "{\"shuffle\": %d}", config.store.sdshuffle); break;
       case BITRATE:       sprintf (wsbuf, "{\"payload\":[{\"id\":\"bitrate\", \"value\": %d}, {\"id\":\"fmt\", \"value\": \"%s\"}]}", config.station.bitrate, getFormat(config.configFmt)); break;
@@ -484,6 +507,23 @@ void NetServer::processQueue() {
       case EQUALIZER:     sprintf (wsbuf, "{\"payload\":[{\"id\":\"bass\", \"value\": %d}, {\"id\": \"middle\", \"value\": %d}, {\"id\": \"treble\", \"value\": %d}]}", config.store.bass, config.store.middle, config.store.treble); break;
       case BALANCE:       sprintf (wsbuf, "{\"payload\":[{\"id\": \"balance\", \"value\": %d}]}", config.store.balance); break;
       case SDINIT:        sprintf (wsbuf, "{\"sdinit\": %d}", SDC_CS!=255); break;
+      #ifdef USE_SD
+        case GETRECORD:     sprintf (wsbuf, "{\"recording\": %d,\"recwritten\": %u,\"recdropped\": %u,\"recrate\": %u}", recorder.isRecording(), recorder.bytesWritten(), recorder.bytesDropped(), recorder.writeRate()); break;
+      #endif
+      #if I2S_DOUT!=255 || I2S_INTERNAL
+        case GETI2S:        sprintf (wsbuf, "{\"dmalat\": %u,\"dmatarget\": %u,\"dmamargin\": %u,\"dmaunder\": %u,\"dmadesc\": %u,\"dmaframes\": %u}", player.getI2SLatency(), player.getI2STarget(), player.getI2SMargin(), player.getI2SUnderruns(), player.getI2SDesc(), player.getI2SFrames()); break;
+        case GETNIGHT:      sprintf (wsbuf, "{\"nightgr\": %u,\"nightmode\": %d,\"nightthr\": %d,\"nightratio\": %u,\"nightatk\": %u,\"nightrel\": %u,\"nightmakeup\": %u}", player.getNightMode() ? player.getNightReduction() : 0, config.store.nightmode, config.store.nightthr, config.store.nightratio, config.store.nightatk, config.store.nightrel, config.store.nightmakeup); break;
+      #endif
+      #if TTFS_HISTORY>0
+        case GETTTFS: {   /* the last tune of the station, the breakdown in the tooltip */
+          ttfsEntry_t e;
+          if (!ttfslog.entry(config.lastStation(), 0, e)) break;
+          char line[160];
+          e.ttfs.format(line, sizeof(line));
+          snprintf(wsbuf, sizeof(wsbuf), "{\"ttfs\": %u,\"ttfsinfo\": \"%s\"}", e.ttfs.total(), line);
+          break;
+        }
+      #endif
       case GETPLAYERMODE: sprintf (wsbuf, "{\"playermode\": \"%s\"}", config.getMode()==PM_SDCARD?"modesd":"modeweb"); break;
       case SEARCH_DONE:   sprintf (wsbuf, "{\"search_done\":true}"); break;
       case SEARCH_FAILED: sprintf (wsbuf, "{\"search_failed\":true}"); break;
@@ -501,6 +541,12 @@ void NetServer::processQueue() {
         if (config.store.mqttenable) {
           if (clientId == 0 && (request.type == STATION || request.type == ITEM || request.type == TITLE || request.type == MODE)) mqttPublishStatus();
           if (clientId == 0 && request.type == VOLUME) mqttPublishVolume();
+          #if TITLE_HISTORY>0
+            if (clientId == 0 && request.type == TITLE && titlelog.changed()) mqttPublishTitles();
+          #endif
+          #if TTFS_HISTORY>0
+            if (clientId == 0 && request.type == GETTTFS) mqttPublishTtfs();
+          #endif
         }
       #endif
     }
@@ -1018,6 +1064,28 @@ void launchPlaybackTask(const String& url, const String& name) {
   }
 }
 
+#if defined(RADIO_BROWSER_SEND_CLICKS) || defined(UPDATEURL)
+  /* HTTPClient::getStreamPtr() hands out the connection as it is, chunked framing included if the server
+     answers that way. httpBodyBegin() sets up the parser from the response header (collected with
+     httpFramingHeaders before GET), httpBodyRead() returns the next block of the body without the framing:
+     0 if nothing came yet, -1 at the end of the body or if the framing is broken */
+  static const char *httpFramingHeaders[] = {"Transfer-Encoding"};
+
+  static void httpBodyBegin(HTTPClient &http, HttpParser &body) {
+    String te = http.header("Transfer-Encoding");
+    te.toLowerCase();
+    body.framing(te.indexOf("chunked") >= 0, http.getSize());
+  }
+
+  static int httpBodyRead(WiFiClient *stream, HttpParser &body, uint8_t *buf, size_t size) {
+    if (body.done() || body.failed()) return -1;
+    size = body.want(size);
+    int n = stream->available() ? stream->read(buf, size) : 0;
+    if (n <= 0) return (!stream->connected() && !stream->available()) ? -1 : 0;
+    return body.body(buf, n);
+  }
+#endif
+
 #ifdef RADIO_BROWSER_SEND_CLICKS
   // Global state for click tracking
   static unsigned long clickDelayStart = 0;
@@ -1033,6 +1101,7 @@ void launchPlaybackTask(const String& url, const String& name) {
     http.setTimeout(10000);  // 10 second timeout for server response
     http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
     http.addHeader("User-Agent", ESPFILEUPDATER_USERAGENT);
+    http.collectHeaders(httpFramingHeaders, 1);
     int httpCode = http.GET();
     if (httpCode != HTTP_CODE_OK) {
       Serial.printf("[RB Click] HTTP error %d\n", httpCode);
@@ -1040,6 +1109,11 @@ void launchPlaybackTask(const String& url, const String& name) {
       return "";
     }
     WiFiClient* stream = http.getStreamPtr();
+    HttpParser body;
+    httpBodyBegin(http, body);
+    uint8_t block[128];
+    int blockLen = 0, blockPos = 0;
+    bool escaped = false;
     String keyPattern = String("\"") + key + "\"";
     String buffer;
     String value;
@@ -1048,18 +1122,28 @@ void launchPlaybackTask(const String& url, const String& name) {
     bool isStringValue = false;
     unsigned long loopStart = millis();
     const unsigned long loopTimeout = 15000; // 15 second max loop time
-    while (stream->connected() || stream->available()) {
+    while (true) {
       // Check for loop timeout
       if (millis() - loopStart > loopTimeout) {
         Serial.println("[RB Click] Stream parsing timeout");
         http.end();
         return "";
       }
-      if (!stream->available()) {
-        delay(1);
+      if (blockPos == blockLen) {
+        blockLen = httpBodyRead(stream, body, block, sizeof(block));
+        blockPos = 0;
+        if (blockLen < 0) break;
+        if (blockLen == 0) {
+          delay(1);
+          continue;
+        }
+      }
+      char c = block[blockPos++];
+      if (escaped) {
+        escaped = false;
+        value += c;
         continue;
       }
-      char c = stream->read();
       buffer += c;
       if (buffer.length() > 512) buffer = buffer.substring(buffer.length() - 256); // Keep buffer manageable
       if (!foundKey && c == ']') {
@@ -1095,10 +1179,8 @@ void launchPlaybackTask(const String& url, const String& name) {
             http.end();
             return value;
           } else if (c == '\\') {
-            // Handle escaped characters - read next char
-            if (stream->available()) {
-              value += (char)stream->read();
-            }
+            // Handle escaped characters - take the next char as it is
+            escaped = true;
           } else {
             value += c;
           }
@@ -1193,14 +1275,19 @@ void checkForOnlineUpdate() {
     http.begin(client, versionUrl);
     http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
     http.addHeader("User-Agent", ESPFILEUPDATER_USERAGENT);
+    http.collectHeaders(httpFramingHeaders, 1);
     int httpCode = http.GET();
     if (httpCode == HTTP_CODE_OK) {
       WiFiClient* stream = http.getStreamPtr();
+      HttpParser body;
+      httpBodyBegin(http, body);
+      uint8_t block[128];
       String line;
       String remoteVer;
-      while (stream->connected() || stream->available()) {
-        if (stream->available()) {
-          char c = stream->read();
+      int n;
+      while (remoteVer.length() == 0 && (n = httpBodyRead(stream, body, block, sizeof(block))) >= 0) {
+        for (int i = 0; i < n; i++) {
+          char c = block[i];
           if (c == '\n') {
             if (line.startsWith(VERSIONSTRING)) {
               int q1 = line.indexOf('"');
@@ -1215,6 +1302,7 @@ void checkForOnlineUpdate() {
             line += c;
           }
         }
+        if (n == 0) vTaskDelay(1);
       }
       http.end();
       if (remoteVer.length() == 0) {
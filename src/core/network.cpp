@@ -13,6 +13,8 @@
 #include <DNSServer.h>
 #include "../displays/tools/l10n.h"
 #include <ImprovWiFiLibrary.h>
+#include "dnscache.h"
+#include "../libraries/I2S_Audio/reconnect.h"
 
 #ifndef WIFI_ATTEMPTS
   #define WIFI_ATTEMPTS  16
@@ -104,6 +106,10 @@ void ticks() {
       netserver.setRSSI(WiFi.RSSI());
       netserver.requestOnChange(NRSSI, 0);
       display.putRequest(DSPRSSI, netserver.getRSSI());
+      #if I2S_DOUT!=255 || I2S_INTERNAL
+        if (player.isRunning()) netserver.requestOnChange(GETI2S, 0);
+        if (player.isRunning() && player.getNightMode()) netserver.requestOnChange(GETNIGHT, 0);
+      #endif
     }
     #ifdef USE_SD
       if (display.mode()!=SDCHANGE) player.sendCommand({PR_CHECKSD, 0});
@@ -113,41 +119,53 @@ void ticks() {
 }
 
 void retryStreamConnection(void * pvParameters) {
-  const uint8_t maxAttempts = 40;  // 40 attempts * 15 seconds = 10 minutes
-  uint8_t attemptCount = 0;
-  while (attemptCount < maxAttempts) {
-    delay(15000);  // Wait 15 seconds between attempts
-    // Check if we should still be retrying
-    if (network.lostPlaying && WiFi.status() == WL_CONNECTED && !player.isRunning()) {
-      attemptCount++;
-      Serial.printf("Stream reconnect attempt %d/%d\n", attemptCount, maxAttempts);
-      player.sendCommand({PR_PLAY, config.lastStation()});
-      delay(3000);  // Give it a moment to try connecting
-      // Check if it worked
-      if (player.isRunning()) {
-        Serial.println("Stream reconnected successfully!");
-        network.lostPlaying = false;
-        streamRetryTaskHandle = NULL;
-        vTaskDelete(NULL);
-        return;
-      }
-    } else {
-      // Conditions changed (user pressed stop, or already playing, or WiFi lost again)
-      if (!network.lostPlaying || player.isRunning()) {
-        network.lostPlaying = false;
-      }
+  /* first attempt at once, then jittered waits growing from STREAM_RETRY_MIN_MS to STREAM_RETRY_MAX_MS */
+  Reconnect backoff;
+  backoff.setLimits(STREAM_RETRY_MIN_MS, STREAM_RETRY_MAX_MS, STREAM_RETRY_GIVEUP_S * 1000);
+  backoff.begin(millis(), esp_random());
+  do {
+    delay(backoff.waitMs(millis()));
+    // Conditions changed (user pressed stop or play, or WiFi lost again)
+    if (!network.lostPlaying || WiFi.status() != WL_CONNECTED) {
       streamRetryTaskHandle = NULL;
       vTaskDelete(NULL);
       return;
     }
-  }
-  // Max attempts reached - give up
-  Serial.println("Stream reconnection failed after 10 minutes. User intervention required.");
+    backoff.attempt();
+    Serial.printf("Stream reconnect attempt %d\n", backoff.attempts());
+    player.sendCommand({PR_PLAY, config.lastStation()});
+    // connecting runs in the player loop: wait for the first data or for the player to give up
+    uint32_t t0 = millis();
+    bool ok = false;
+    while (millis() - t0 < 20000) {
+      delay(250);
+      if ((ok = player.isRunning() && player.inBufferFilled() > 0)) break;
+      if (!player.isRunning() && millis() - t0 > 1000) break;
+    }
+    if (ok) {
+      Serial.println("Stream reconnected successfully!");
+      network.lostPlaying = false;
+      streamRetryTaskHandle = NULL;
+      vTaskDelete(NULL);
+      return;
+    }
+    network.lostPlaying = true;   /* _play() cleared it */
+  } while (backoff.retry(millis()));
+  // Time is up - give up
+  Serial.printf("Stream reconnection failed after %d attempts in %lu s. User intervention required.\n", backoff.attempts(), backoff.elapsed(millis()) / 1000);
   network.lostPlaying = false;
   streamRetryTaskHandle = NULL;
   vTaskDelete(NULL);
 }
 
+void MyNetwork::retryStream() {
+  lostPlaying = true;
+  if (WiFi.status() != WL_CONNECTED) return;   /* WiFiReconnected() starts it */
+  if (streamRetryTaskHandle == NULL) {
+    xTaskCreatePinnedToCore(retryStreamConnection, "streamRetry", 1024 * 4, NULL, 1, &streamRetryTaskHandle, 0);
+  }
+}
+
 void MyNetwork::WiFiReconnected(WiFiEvent_t event, WiFiEventInfo_t info) {
   network.beginReconnect = false;
   player.lockOutput = false;
@@ -158,13 +176,7 @@ void MyNetwork::WiFiReconnected(WiFiEvent_t event, WiFiEventInfo_t info) {
     display.putRequest(NEWIP, 0);
   } else {
     display.putRequest(NEWMODE, PLAYER);
-    if (network.lostPlaying) {
-      player.sendCommand({PR_PLAY, config.lastStation()});
-      // Launch retry task if not already running
-      if (streamRetryTaskHandle == NULL) {
-        xTaskCreatePinnedToCore(retryStreamConnection, "streamRetry", 1024 * 4, NULL, 1, &streamRetryTaskHandle, 0);
-      }
-    }
+    if (network.lostPlaying) network.retryStream();
   }
   #ifdef MQTT_ENABLE
     if (config.store.mqttenable) connectToMqtt();
@@ -178,8 +190,11 @@ void MyNetwork::WiFiLostConnection(WiFiEvent_t event, WiFiEventInfo_t info) {
       network.status=SDREADY;
       display.putRequest(NEWIP, 0);
     } else {
-      network.lostPlaying = player.isRunning();
-      if (network.lostPlaying) { player.lockOutput = true; player.sendCommand({PR_STOP, 0}); }
+      /* a webstream plays on from its buffer and reconnects by itself, see audio_reconnect() */
+      #if I2S_DOUT==255 && !I2S_INTERNAL
+        network.lostPlaying = player.isRunning();
+        if (network.lostPlaying) { player.lockOutput = true; player.sendCommand({PR_STOP, 1}); }
+      #endif
       display.putRequest(NEWMODE, LOST);
     }
   }
@@ -557,8 +572,13 @@ bool getWeather(char *wstr) {
   #if (DSP_MODEL!=DSP_DUMMY || defined(USE_NEXTION)) && !defined(HIDE_WEATHER)
     WiFiClient client;
     const char* host  = "api.openweathermap.org";
-    
-    if (!client.connect(host, 80)) {
+    #if DNS_CACHE_SIZE>0
+      IPAddress ip;
+      bool connected = dnscache.resolve(host, ip) ? client.connect(ip, 80) : client.connect(host, 80);
+    #else
+      bool connected = client.connect(host, 80);
+    #endif
+    if (!connected) {
       Serial.println("##WEATHER###: connection  failed");
       return false;
     }
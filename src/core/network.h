@@ -33,6 +33,7 @@ class MyNetwork {
     void requestTimeSync(bool withTelnetOutput=false, uint8_t clientId=0);
     void raiseSoftAP();
     void requestWeatherSync();
+    void retryStream();     /* the stream was lost: replay the station with backoff once WiFi is up */
   private:
     Ticker rtimer;
     unsigned long lastImprovBroadcast = 0;
@@ -147,6 +147,21 @@ Use this tool to setup connections: https://trip5.github.io/ehRadio_myoptions/ge
 #if SDC_CS!=255
   #define USE_SD
 #endif
+#ifndef REC_DIR
+  #define REC_DIR             "/records"  // stream recorder target folder on the SD card
+#endif
+#ifndef REC_BUFFER_SIZE
+  #define REC_BUFFER_SIZE     262144      // recorder staging ring in PSRAM, power of two
+#endif
+#ifndef REC_BLOCK_SIZE
+  #define REC_BLOCK_SIZE      16384       // bytes per SD write, multiple of 512
+#endif
+#ifndef REC_MAX_FILE_SIZE
+  #define REC_MAX_FILE_SIZE   67108864    // start a new file after 64 MB
+#endif
+#ifndef REC_SPLIT_ON_TITLE
+  #define REC_SPLIT_ON_TITLE  false       // start a new file on every title change
+#endif
 
 /*            ENCODER             */
 #ifndef ENC_BTNL
@@ -321,6 +336,40 @@ Use this tool to setup connections: https://trip5.github.io/ehRadio_myoptions/ge
 #ifndef LOOP_TASK_STACK_SIZE      // sets the stack size for the FreeRTOS task that runs the main loop
   #define LOOP_TASK_STACK_SIZE 8  // Compiler default is 8KB but seems safe on ESP32-S3 to increase to 16KB for audio decoding + concurrent tasks
 #endif
+#ifndef PLAYER_TASK
+  #define PLAYER_TASK false // true = stream ingest and the player queue in their own task, so a slow handler in loop() can't starve the input buffer. Off until verified on hardware
+#endif
+#ifndef PLAYER_TASK_STACK_SIZE
+  #define PLAYER_TASK_STACK_SIZE LOOP_TASK_STACK_SIZE // KB, what this code had in loop() before; TLS handshakes run in it. The lowest free is on telnet (##PLAYER.STACK#, cli.ingest), size it from that
+#endif
+#ifndef AUDIO_TASK_PRIORITY
+  #define AUDIO_TASK_PRIORITY 2 // the decoder
+#endif
+#ifndef PLAYER_TASK_PRIORITY
+  #define PLAYER_TASK_PRIORITY 2 // above loop() (1), the same as the audio task: they take turns during a TLS handshake
+#endif
+#ifndef PLAYER_TASK_CORE_ID
+  #define PLAYER_TASK_CORE_ID 1
+#endif
+#ifndef INGEST_GAP_MS
+  #define INGEST_GAP_MS 100 // gaps between two reads of a playing stream longer than this are counted (telnet: ingest)
+#endif
+#ifndef SD_READAHEAD_KB
+  #ifdef BOARD_HAS_PSRAM
+    #define SD_READAHEAD_KB 32 // KB of DMA capable RAM a task fills ahead of a playing local file, 0 = the player reads the file itself
+  #else
+    #define SD_READAHEAD_KB 0 // internal RAM is short without PSRAM, set it (e.g. 16) to read ahead anyway
+  #endif
+#endif
+#ifndef SD_READAHEAD_BLOCK
+  #define SD_READAHEAD_BLOCK 4096 // bytes per card read, a multiple of the 512 byte sector (of the FAT cluster is best)
+#endif
+#ifndef SD_READAHEAD_PRIORITY
+  #define SD_READAHEAD_PRIORITY 2 // the same as the audio task, above loop() (1), it takes turns with the decoder
+#endif
+#ifndef SD_READAHEAD_CORE_ID
+  #define SD_READAHEAD_CORE_ID 1
+#endif
 #ifndef CONFIG_ASYNC_TCP_QUEUE_SIZE
   #define CONFIG_ASYNC_TCP_QUEUE_SIZE 64 // maybe 32 for ESP32?
 #endif
@@ -330,6 +379,171 @@ Use this tool to setup connections: https://trip5.github.io/ehRadio_myoptions/ge
 #ifndef SEARCHRESULTS_YIELDINTERVAL
   #define SEARCHRESULTS_YIELDINTERVAL 0 // With a large buffer, skipping is almost eliminated with 0
 #endif
+#ifndef TIMESHIFT_BUFFER_SIZE
+  #define TIMESHIFT_BUFFER_SIZE 0 // PSRAM bytes for pause/rewind of live web streams, 0 = off (4194304 holds ~4 minutes of 128k)
+#endif
+#ifndef TIMESHIFT_LIVE_MARGIN
+  #define TIMESHIFT_LIVE_MARGIN 2 // seconds left in the buffer when jumping back to live
+#endif
+#ifndef PCM_TAP_CONSUMERS
+  #define PCM_TAP_CONSUMERS 6 // max subscribers of the decoded PCM broadcast ring (meters, spectrum, detectors, plugins)
+#endif
+#ifndef PCM_TAP_FRAMES
+  #define PCM_TAP_FRAMES 16384 // stereo frames in PSRAM, power of two (~370 ms at 44.1 kHz)
+#endif
+#ifndef PCM_TAP_FRAMES_NOPSRAM
+  #define PCM_TAP_FRAMES_NOPSRAM 4096 // stereo frames without PSRAM, power of two
+#endif
+#ifndef VU_SPECTRUM
+  #define VU_SPECTRUM false // show a spectrum analyzer instead of the VU meter (color displays with spectrumConf)
+#endif
+#ifndef SPECTRUM_FFT_SIZE
+  #define SPECTRUM_FFT_SIZE 1024 // FFT points: 256, 512 or 1024
+#endif
+#ifndef SPECTRUM_FPS
+  #define SPECTRUM_FPS 25 // spectrum updates per second
+#endif
+#ifndef TITLE_HISTORY
+  #define TITLE_HISTORY 64 // recent stream titles with their time, all stations, on http://<ip>/titles and MQTT <topic>titles, 0 = off
+#endif
+#ifndef TITLE_HISTORY_NOPSRAM
+  #define TITLE_HISTORY_NOPSRAM 16 // without PSRAM (BUFLEN bytes each)
+#endif
+#ifndef TTFS_HISTORY
+  #define TTFS_HISTORY 32 // time to first sound of the last tunes, phase by phase, on http://<ip>/ttfs, telnet "ttfs" and MQTT <topic>ttfs, 0 = off
+#endif
+#ifndef TTFS_PER_STATION
+  #define TTFS_PER_STATION 4 // of those at most this many of one station
+#endif
+#ifndef RELAY_MAX_CLIENTS
+  #define RELAY_MAX_CLIENTS 3 // LAN listeners on http://<ip>/relay, 0 = off
+#endif
+#ifndef RELAY_BUFFER_SIZE
+  #define RELAY_BUFFER_SIZE 65536 // relay ring in PSRAM, power of two (~4 s of 128k)
+#endif
+#ifndef RELAY_BUFFER_SIZE_NOPSRAM
+  #define RELAY_BUFFER_SIZE_NOPSRAM 16384 // relay ring without PSRAM, power of two
+#endif
+#ifndef PREBUFFER_START_MS
+  #define PREBUFFER_START_MS 300 // audio buffered before a new station starts, learned per station from here
+#endif
+#ifndef PREBUFFER_RESUME_MS
+  #define PREBUFFER_RESUME_MS 1000 // audio buffered after an underrun before playback resumes, learned per station
+#endif
+#ifndef PREBUFFER_MIN_MS
+  #define PREBUFFER_MIN_MS 100
+#endif
+#ifndef PREBUFFER_MAX_MS
+  #define PREBUFFER_MAX_MS 8000 // also limited to 3/4 of the input buffer
+#endif
+#ifndef PREBUFFER_STABLE_S
+  #define PREBUFFER_STABLE_S 300 // lower the learned prebuffer by 1/8 after this long without underrun
+#endif
+#ifndef LEARN_SAVE_S
+  #define LEARN_SAVE_S 1800 // learned prebuffer and health of a station go to the flash at most this often, and only after a stable run
+#endif
+#ifndef I2S_DMA_TUNE
+  #define I2S_DMA_TUNE 1 // size the I2S DMA queue per sample rate from the measured underrun margin, 0 = fixed 32 x 256 frames (IDF4: 16 x 512)
+#endif
+#ifndef I2S_DMA_START_MS
+  #define I2S_DMA_START_MS 186 // DMA queue of a sample rate not seen yet, learned from here
+#endif
+#ifndef I2S_DMA_MIN_MS
+  #define I2S_DMA_MIN_MS 40
+#endif
+#ifndef I2S_DMA_MAX_MS
+  #define I2S_DMA_MAX_MS 250 // DMA buffers are internal RAM, 4 bytes per frame (47 KB at 48 kHz)
+#endif
+#ifndef I2S_DMA_STABLE_S
+  #define I2S_DMA_STABLE_S 60 // lower the DMA queue by 1/8 after this long with more than 3/4 of it left
+#endif
+#ifndef I2S_DMA_MIN_HEAP
+  #define I2S_DMA_MIN_HEAP 40000 // a bigger DMA queue is not taken below this free internal RAM
+#endif
+#ifndef RACE_STAGGER_MS
+  #define RACE_STAGGER_MS 250 // head start of each connection attempt over the next one (playlist mirrors, DNS addresses)
+#endif
+#ifndef RECONNECT_STALL_MS
+  #define RECONNECT_STALL_MS 4000 // no data from a playing webstream for this long: reconnect while the buffer plays on
+#endif
+#ifndef RECONNECT_MIN_MS
+  #define RECONNECT_MIN_MS 250 // wait between reconnect attempts, jittered and growing up to RECONNECT_MAX_MS
+#endif
+#ifndef RECONNECT_MAX_MS
+  #define RECONNECT_MAX_MS 8000
+#endif
+#ifndef RECONNECT_GIVEUP_S
+  #define RECONNECT_GIVEUP_S 60 // then the stream stops and the station is retried from scratch (STREAM_RETRY_*)
+#endif
+#ifndef RECONNECT_STABLE_S
+  #define RECONNECT_STABLE_S 600 // a run this long without a drop raises the health of the station
+#endif
+#ifndef WATCH_SILENCE_DB
+  #define WATCH_SILENCE_DB -66 // dBFS RMS, a webstream that stays below this is dead (I2S only), quiet content is far above
+#endif
+#ifndef WATCH_SILENCE_S
+  #define WATCH_SILENCE_S 20 // seconds below WATCH_SILENCE_DB without a single louder block, 0 = off
+#endif
+#ifndef WATCH_FROZEN_S
+  #define WATCH_FROZEN_S 10 // seconds of decoded blocks that only repeat the last 64, 0 = off
+#endif
+#ifndef WATCH_STUCK_S
+  #define WATCH_STUCK_S 5 // seconds without decoded audio while a second of data is buffered, 0 = off
+#endif
+#ifndef WATCH_STARVED_PCT
+  #define WATCH_STARVED_PCT 50 // less of the bitrate than this arrives over WATCH_STARVED_S, 0 = off
+#endif
+#ifndef WATCH_STARVED_S
+  #define WATCH_STARVED_S 20
+#endif
+#ifndef WATCH_LADDER
+  #define WATCH_LADDER 1 // repeated detections on a station: 1 reconnect, 2 another mirror/address, 4 next station (opt-in, both leave the station), 0 = alert only
+#endif
+#ifndef STREAM_RETRY_MIN_MS
+  #define STREAM_RETRY_MIN_MS 2000 // station retries after a stream was given up or WiFi came back, growing up to
+#endif
+#ifndef STREAM_RETRY_MAX_MS
+  #define STREAM_RETRY_MAX_MS 60000
+#endif
+#ifndef STREAM_RETRY_GIVEUP_S
+  #define STREAM_RETRY_GIVEUP_S 600 // then user intervention is required
+#endif
+#ifndef HLS_BUFFER_SIZE
+  #define HLS_BUFFER_SIZE 262144 // PSRAM ring for prefetched HLS segments, power of two, 0 = fetch each segment when it is needed
+#endif
+#ifndef HLS_ABR
+  #define HLS_ABR 1 // switch between the variants of a master playlist by the measured throughput, 0 = keep the one picked at the start
+#endif
+#ifndef DNS_CACHE_SIZE
+  #define DNS_CACHE_SIZE 16 // resolver cache entries shared by streams, weather and MQTT, 0 = off
+#endif
+#ifndef DNS_CACHE_PERSIST
+  #define DNS_CACHE_PERSIST 8 // busiest entries kept in NVS across reboots
+#endif
+#ifndef DNS_CACHE_MIN_TTL
+  #define DNS_CACHE_MIN_TTL 60
+#endif
+#ifndef DNS_CACHE_MAX_TTL
+  #define DNS_CACHE_MAX_TTL 86400
+#endif
+#ifndef DNS_CACHE_STALE_S
+  #define DNS_CACHE_STALE_S 86400 // serve an expired answer this long while it is refreshed in the background
+#endif
+#ifndef DNS_CACHE_NEG_TTL
+  #define DNS_CACHE_NEG_TTL 30 // remember names that did not resolve
+#endif
+#ifndef PREFETCH_STATIONS
+  #define PREFETCH_STATIONS 0 // keep the next (1) or next and previous (2) stations connected for instant zapping, PSRAM only
+#endif
+#ifndef PREFETCH_BUFFER_SIZE
+  #define PREFETCH_BUFFER_SIZE 65536 // PSRAM per warm station, power of two, newest data kept (~4 s of 128k); (PREFETCH_STATIONS+1) buffers
+#endif
+#ifndef PREFETCH_IDLE_S
+  #define PREFETCH_IDLE_S 120 // close warm connections that were not used for this long, reopened on the next zap
+#endif
+#ifndef PREFETCH_MIN_HEAP
+  #define PREFETCH_MIN_HEAP 60000 // don't open a warm connection (TLS needs internal RAM) below this free heap
+#endif
 #ifndef WEATHER_SYNC_INTERVAL
   #define WEATHER_SYNC_INTERVAL 1800 // 60 * 30 minutes
 #endif
@@ -733,6 +947,30 @@ Use this tool to setup connections: https://trip5.github.io/ehRadio_myoptions/ge
 #elif (EQ_BASS < -16) || (EQ_BASS > 16)
   #undef EQ_BASS
 #endif
+#ifndef NIGHT_MODE
+  #define NIGHT_MODE false // compressor and limiter in front of the volume (I2S only), the preset below is stored and set in settings
+#endif
+#ifndef NIGHT_THRESHOLD
+  #define NIGHT_THRESHOLD -24 // dBFS
+#endif
+#ifndef NIGHT_RATIO
+  #define NIGHT_RATIO 4 // 1..20, : 1
+#endif
+#ifndef NIGHT_ATTACK
+  #define NIGHT_ATTACK 5 // ms
+#endif
+#ifndef NIGHT_RELEASE
+  #define NIGHT_RELEASE 250 // ms
+#endif
+#ifndef NIGHT_MAKEUP
+  #define NIGHT_MAKEUP 9 // dB, 0..18
+#endif
+#ifndef NIGHT_CEILING
+  #define NIGHT_CEILING -1 // dBFS, brickwall limiter behind the compressor
+#endif
+#ifndef NIGHT_LOOKAHEAD_MS
+  #define NIGHT_LOOKAHEAD_MS 2 // of the limiter, added to the output latency, 5 at most
+#endif
 #ifndef SD_SHUFFLE
   #define SD_SHUFFLE false
 #endif
@@ -0,0 +1,105 @@
+#include "options.h"
+#if I2S_DOUT!=255 || I2S_INTERNAL // ============================== Everything ignored if not defined ==============================
+#include "pcmtap.h"
+
+PcmTap pcmtap;
+
+bool PcmTap::_alloc() {
+  if (_buf) return true;
+  /* frame positions are masked, both sizes must be powers of two */
+  _size = PCM_TAP_FRAMES;
+  if (psramFound()) _buf = (int16_t*)ps_malloc(_size * 4);
+  if (!_buf) {
+    _size = PCM_TAP_FRAMES_NOPSRAM;
+    _buf = (int16_t*)heap_caps_malloc(_size * 4, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+  }
+  if (!_buf) _size = 0;
+  return _buf!=NULL;
+}
+
+int8_t PcmTap::subscribe(const char *name) {
+  if (!_alloc()) return -1;
+  int8_t id = -1;
+  portENTER_CRITICAL(&_mux);
+  for (uint8_t i = 0; i < PCM_TAP_CONSUMERS; i++) {
+    if (_cons[i].used) continue;
+    _cons[i].cursor = _head;
+    _cons[i].overrun = false;
+    _cons[i].overruns = 0;
+    _cons[i].name = name;
+    _cons[i].used = true;
+    _active++;
+    id = i;
+    break;
+  }
+  portEXIT_CRITICAL(&_mux);
+  return id;
+}
+
+void PcmTap::unsubscribe(int8_t id) {
+  portENTER_CRITICAL(&_mux);
+  if (_valid(id)) {
+    _cons[id].used = false;
+    _active--;
+  }
+  portEXIT_CRITICAL(&_mux);
+}
+
+void PcmTap::write(const int16_t *frames, uint16_t count, uint32_t sampleRate) {
+  if (!_active || !count) return;
+  _sampleRate = sampleRate;
+  uint32_t head = _head;
+  _claim = head + count;          /* frames before _claim - _size are gone from here on */
+  __sync_synchronize();
+  while (count > 0) {
+    uint32_t off = head & (_size - 1);
+    uint32_t n = min((uint32_t)count, _size - off);
+    memcpy(_buf + off * 2, frames, n * 4);
+    frames += n * 2; count -= n; head += n;
+  }
+  __sync_synchronize();
+  _head = head;
+}
+
+uint32_t PcmTap::available(int8_t id) {
+  if (!_valid(id)) return 0;
+  int32_t a = (int32_t)(_head - _cons[id].cursor);
+  return a <= 0 ? 0 : (uint32_t)a > _size ? _size : a;
+}
+
+bool PcmTap::overrun(int8_t id) {
+  if (!_valid(id)) return false;
+  bool o = _cons[id].overrun;
+  _cons[id].overrun = false;
+  return o;
+}
+
+uint16_t PcmTap::read(int8_t id, int16_t *frames, uint16_t maxFrames) {
+  if (!_valid(id)) return 0;
+  pcmConsumer_t &c = _cons[id];
+  while (true) {
+    uint32_t cursor = c.cursor;
+    int32_t avail = (int32_t)(_head - cursor);  /* < 0 right after a skip past a write in progress */
+    __sync_synchronize();
+    if (_claim - cursor > _size) {
+      /* lapped, or a write in progress reaches the cursor: skip ahead and keep half a ring so the consumer does not overrun again right away */
+      c.cursor = _claim - _size / 2;
+      c.overrun = true;
+      c.overruns++;
+      continue;
+    }
+    if (avail <= 0) return 0;
+    uint32_t n = min((uint32_t)maxFrames, (uint32_t)avail);
+    uint32_t off = cursor & (_size - 1);
+    uint32_t first = min(n, _size - off);
+    memcpy(frames, _buf + off * 2, first * 4);
+    if (n > first) memcpy(frames + first * 2, _buf, (n - first) * 4);
+    /* a write that began during the copy may have overwritten part of it */
+    __sync_synchronize();
+    if (_claim - cursor > _size) continue;
+    c.cursor = cursor + n;
+    return n;
+  }
+}
+
+#endif // #if I2S_DOUT!=255 || I2S_INTERNAL
@@ -0,0 +1,53 @@
+#ifndef pcmtap_h
+#define pcmtap_h
+#include "options.h"
+
+#if I2S_DOUT!=255 || I2S_INTERNAL // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+
+struct pcmConsumer_t
+{
+  bool              used;
+  volatile bool     overrun;    /* set by read() when the writer lapped this cursor, cleared by the consumer */
+  uint32_t          cursor;     /* absolute frame position of the next frame to read */
+  uint32_t          overruns;
+  const char       *name;
+};
+
+/* Broadcast ring of decoded stereo PCM (int16 L/R frames, before EQ and volume).
+   The audio task is the only writer and never waits: write() is a memcpy, and only when someone listens.
+   Every consumer owns a cursor and reads from its own task at its own pace; a consumer that falls
+   more than a ring behind gets its overrun flag set and is moved forward, it never holds up the writer
+   or the other consumers. write() publishes the span it is about to overwrite (_claim) before the copy and
+   _head after it; read() checks _claim again after its own copy, so a block of any size that overwrote the
+   frames being read is noticed. */
+class PcmTap {
+  public:
+    PcmTap() {};
+    int8_t subscribe(const char *name);         /* returns consumer id or -1 */
+    void unsubscribe(int8_t id);
+    uint16_t read(int8_t id, int16_t *frames, uint16_t maxFrames);
+    uint32_t available(int8_t id);
+    bool overrun(int8_t id);                    /* returns and clears the overrun flag */
+    uint32_t overruns(int8_t id) { return _valid(id) ? _cons[id].overruns : 0; }
+    uint32_t sampleRate() { return _sampleRate; }
+    void write(const int16_t *frames, uint16_t count, uint32_t sampleRate);
+  private:
+    int16_t *_buf = NULL;                       /* 2 * _size int16 */
+    uint32_t _size = 0;                         /* frames, power of two */
+    volatile uint32_t _head = 0;                /* frames written */
+    volatile uint32_t _claim = 0;               /* frames written once the write() in progress is done */
+    volatile uint32_t _sampleRate = 0;
+    volatile uint8_t _active = 0;
+    pcmConsumer_t _cons[PCM_TAP_CONSUMERS] = {};
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    bool _valid(int8_t id) { return id >= 0 && id < PCM_TAP_CONSUMERS && _cons[id].used; }
+    bool _alloc();
+};
+
+extern PcmTap pcmtap;
+
+#endif // #if I2S_DOUT!=255 || I2S_INTERNAL
+
+#endif
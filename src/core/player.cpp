@@ -6,6 +6,10 @@
 #include "sdmanager.h"
 #include "netserver.h"
 #include "network.h"
+#include "recorder.h"
+#include "relay.h"
+#include "mqtt.h"
+#include "prefetch.h"
 #include "../displays/tools/l10n.h"
 #include "../pluginsManager/pluginsManager.h"
 #ifdef USE_ES8311
@@ -66,6 +70,10 @@ void Player::init() {
   #endif
   setBalance(config.store.balance);
   setTone(config.store.bass, config.store.middle, config.store.treble);
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    setCompressor(config.store.nightthr, config.store.nightratio, config.store.nightatk, config.store.nightrel, config.store.nightmakeup);
+    setNightMode(config.store.nightmode);
+  #endif
   setVolume(0);
   //_status = STOPPED;
   ////setOutputPins(false);
@@ -80,11 +88,15 @@ void Player::init() {
     es.setVolume((uint8_t)map(i2sVol_init, 0, 254, 0, 100)); /* Map I2S volume (0..254) to codec volume 0..100 */
   #endif
   setConnectionTimeout(1700, 3700);
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    if (TIMESHIFT_BUFFER_SIZE>0) setTimeshift(TIMESHIFT_BUFFER_SIZE);
+  #endif
   Serial.println("done");
 }
 
 void Player::sendCommand(playerRequestParams_t request) {
   if (playerQueue==NULL) return;
+  request.queued = millis();
   xQueueSend(playerQueue, &request, PLQ_SEND_DELAY);
 }
 
@@ -107,8 +119,21 @@ void Player::setError(const char *e) {
 
 void Player::_stop(bool alreadyStopped) {
   log_i("%s called", __func__);
+  #ifdef USE_SD
+    recorder.stop();
+  #endif
+  #if RELAY_MAX_CLIENTS>0
+    relay.reset();
+  #endif
+  #if (I2S_DOUT!=255 || I2S_INTERNAL) && PREFETCH_STATIONS>0
+    prefetch.update(0);
+  #endif
   if (config.getMode()==PM_SDCARD && !alreadyStopped) config.sdResumePos = player.getFilePos();
   _status = STOPPED;
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    _connecting = false;
+  #endif
+  ttfs().cancel();
   setOutputPins(false);
   if (!hasError()) config.setTitle((display.mode()==LOST || display.mode()==UPDATING)?"":LANG::const_PlStopped);
   config.station.bitrate = 0;
@@ -136,21 +161,66 @@ void Player::initHeaders(const char *file) {
 }
 
 #ifndef PL_QUEUE_TICKS
-  #define PL_QUEUE_TICKS 0
+  #define PL_QUEUE_TICKS (PLAYER_TASK ? 1 : 0)   /* the player task sleeps here, loop() must not */
 #endif
 #ifndef PL_QUEUE_TICKS_ST
   #define PL_QUEUE_TICKS_ST 15
 #endif
+void Player::startTask() {
+  #if PLAYER_TASK
+    if (_task) return;
+    xTaskCreatePinnedToCore(_taskLoop, "PlayerTask", PLAYER_TASK_STACK_SIZE * 1024, NULL, PLAYER_TASK_PRIORITY, &_task, PLAYER_TASK_CORE_ID);
+  #endif
+}
+
+void Player::_taskLoop(void *param) {   /* reads the stream into the input buffer and takes the commands, loop() only does the UI */
+  uint32_t checkT = 0;
+  for (;;) {
+    if (network.status == CONNECTED || network.status == SDREADY) player.loop();
+    else vTaskDelay(PL_QUEUE_TICKS_ST);
+    if (millis() - checkT >= 1000) { checkT = millis(); player._checkStack(); }
+  }
+}
+
+void Player::_checkStack() {   /* the deepest the task went (TLS handshakes, decoder init), each new low once */
+  #if PLAYER_TASK
+    uint32_t left = uxTaskGetStackHighWaterMark(NULL);
+    if (left >= _stackLow) return;
+    _stackLow = left;
+    telnet.printf("##PLAYER.STACK#: lowest free %u of %u bytes\r\n", left, PLAYER_TASK_STACK_SIZE * 1024);
+    if (left < 1024) log_w("player task stack: %u bytes left, raise PLAYER_TASK_STACK_SIZE", left);
+  #endif
+}
+
+bool Player::inTask() {
+  return !PLAYER_TASK || xTaskGetCurrentTaskHandle() == _task;
+}
+
 void Player::loop() {
   if (playerQueue==NULL) return;
+  uint32_t now = millis();
+  if (_status == PLAYING && _loopT) {
+    uint32_t gap = now - _loopT;
+    if (gap > _gapMax) _gapMax = gap > 0xFFFF ? 0xFFFF : gap;
+    if (gap > INGEST_GAP_MS && _gaps < 0xFFFF) _gaps++;
+  }
+  _loopT = now;
   playerRequestParams_t requestP;
   if (xQueueReceive(playerQueue, &requestP, isRunning()?PL_QUEUE_TICKS:PL_QUEUE_TICKS_ST)) {
     switch (requestP.type) {
-      case PR_STOP: _stop(); break;
+      case PR_STOP: {   /* payload 0: by the user, no more retries of a lost stream */
+        if (requestP.payload == 0) network.lostPlaying = false;
+        _stop();
+        break;
+      }
       case PR_PLAY: {
         if (requestP.payload>0) {
           config.setLastStation((uint16_t)requestP.payload);
         }
+        playerRequestParams_t next;   /* a newer station is already waiting, don't start this one */
+        if (xQueuePeek(playerQueue, &next, 0) && next.type == PR_PLAY) break;
+        ttfs().begin(requestP.queued);   /* phases up to the first sound, handed to audio_ttfs() */
+        ttfs().mark(Ttfs::QUEUE, millis());
         _play((uint16_t)abs(requestP.payload)); 
         if (player_on_station_change) player_on_station_change(); 
         pm.on_station_change();
@@ -160,6 +230,29 @@ void Player::loop() {
         toggle();
         break;
       }
+      #if I2S_DOUT!=255 || I2S_INTERNAL
+        case PR_TSPAUSE: {
+          if (_status == PLAYING) pauseResume();
+          break;
+        }
+        case PR_TSJUMP: {   /* payload: seconds to jump back, 0 = back to live */
+          if (requestP.payload>0) timeshiftJumpBack(requestP.payload); else timeshiftToLive();
+          break;
+        }
+        case PR_PREBUF:
+        case PR_PREBUF_STABLE: {   /* payload: learned start ms << 16 | resume ms */
+          if (requestP.station == _pbHash) _learnPrebuffer(requestP.payload, requestP.type == PR_PREBUF_STABLE);
+          break;
+        }
+        case PR_HEALTH: {   /* payload: Reconnect outcome */
+          if (requestP.station == _pbHash) _learnHealth(requestP.payload);
+          break;
+        }
+        case PR_WATCH: {    /* payload: StreamWatch reason */
+          if (_status == PLAYING && config.getMode() == PM_WEB) _watch(requestP.payload);
+          break;
+        }
+      #endif
       case PR_VOL: {
         config.setVolume(requestP.payload);
         uint8_t i2sVol = volToI2S(requestP.payload);
@@ -180,6 +273,25 @@ void Player::loop() {
           break;
         }
       #endif
+      case PR_TONE: {       /* the values are in config.store, set by Config::setTone() */
+        setTone(config.store.bass, config.store.middle, config.store.treble);
+        break;
+      }
+      case PR_BALANCE: {
+        setBalance(config.store.balance);
+        break;
+      }
+      #if I2S_DOUT!=255 || I2S_INTERNAL
+        case PR_NIGHT: {
+          setCompressor(config.store.nightthr, config.store.nightratio, config.store.nightatk, config.store.nightrel, config.store.nightmakeup);
+          setNightMode(config.store.nightmode);
+          break;
+        }
+      #endif
+      case PR_SEEK: {       /* payload: byte position in the file */
+        setFilePos(requestP.payload);
+        break;
+      }
       case PR_VUTONUS: {
         if (config.vuThreshold>10) config.vuThreshold -=10;
         break;
@@ -194,6 +306,18 @@ void Player::loop() {
     }
   }
   Audio::loop();
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    if (_connecting) {   /* the connection of the last _play() */
+      if (isStreaming()) { _connecting = false; _started(config.lastStation()); }
+      else if (!isRunning()) { _connecting = false; _failed(); }
+    }
+  #endif
+  #ifdef USE_SD
+    if (config.getMode()==PM_SDCARD && now-_sdPosT>=500) {   /* Audio's file state is only read here, see sdPos() */
+      _sdPosT = now;
+      _sdPos = { getFilePos(), getFileSize(), getAudioCurrentTime(), getAudioFileDuration() };
+    }
+  #endif
   if (!isRunning() && _status==PLAYING) _stop(true);
   if (_volTimer) {
     if ((millis()-_volTicks)>3000) {
@@ -214,6 +338,15 @@ void Player::setOutputPins(bool isPlaying) {
 
 void Player::_play(uint16_t stationId) {
   log_i("%s called, stationId=%d", __func__, stationId);
+  #ifdef USE_SD
+    recorder.stop();
+  #endif
+  #if RELAY_MAX_CLIENTS>0
+    relay.reset();
+  #endif
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    _connecting = false;
+  #endif
   setError("");
   setDefaults();
   remoteStationName = false;
@@ -227,7 +360,8 @@ void Player::_play(uint16_t stationId) {
   }
   setOutputPins(false);
   //config.setTitle(config.getMode()==PM_WEB?const_PlConnect:"");
-  if (!config.loadStation(stationId)) return;
+  if (!config.loadStation(stationId)) { ttfs().cancel(); return; }
+  ttfs().mark(Ttfs::LOAD, millis());
   config.setTitle(config.getMode()==PM_WEB?LANG::const_PlConnect:"[next track]");
   config.station.bitrate=0;
   config.setBitrateFormat(BF_UNKNOWN);
@@ -236,40 +370,133 @@ void Player::_play(uint16_t stationId) {
   display.putRequest(DBITRATE);
   display.putRequest(NEWSTATION);
   netserver.requestOnChange(STATION, 0);
-  netserver.loop();
-  netserver.loop();
+  #if !PLAYER_TASK
+    netserver.loop();   /* loop() and the display task run it, never the player task as well */
+    netserver.loop();
+  #endif
   bool isConnected = false;
   if (config.getMode()==PM_SDCARD && SDC_CS!=255) {
     isConnected=connecttoFS(sdman,config.station.url,config.sdResumePos==0?_resumeFilePos:config.sdResumePos-player.sd_min);
   } else {
     config.saveValue(&config.store.play_mode, static_cast<uint8_t>(PM_WEB));
   }
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    if (config.getMode()==PM_WEB) _loadLearned();
+  #endif
   if (config.getMode()==PM_WEB) isConnected=connecttohost(config.station.url);
-  if (isConnected) {
-  //if (config.store.play_mode==PM_WEB?connecttohost(config.station.url):connecttoFS(SD,config.station.url,config.sdResumePos==0?_resumeFilePos:config.sdResumePos-player.sd_min)) {
-    _status = PLAYING;
-    if (config.getMode()==PM_SDCARD) {
-      config.sdResumePos = 0;
-      config.saveValue(&config.store.lastSdStation, stationId);
-    }
-    //config.setTitle("");
-    netserver.requestOnChange(MODE, 0);
-    setOutputPins(true);
-    display.putRequest(NEWMODE, PLAYER);
-    display.putRequest(PSTART);
-    network.lostPlaying = false;  // Clear flag - we're playing again!
-    #ifdef RADIO_BROWSER_SEND_CLICKS
-      if (config.getMode()==PM_WEB) radioBrowserSendClick(config.station.url);
-    #endif
-    if (player_on_start_play) player_on_start_play();
-    pm.on_start_play();
-  } else {
-    telnet.printf("##ERROR#:\tError connecting to %s\r\n", config.station.url);
-    SET_PLAY_ERROR("Error connecting to %s", config.station.url);
-    _stop(true);
-  };
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    /* connecttohost() only starts the connection: loop() calls _started() once the response header is accepted,
+       or _failed() if it never gets there */
+    if (isConnected && config.getMode()==PM_WEB) { _connecting = true; return; }
+  #endif
+  if (isConnected) _started(stationId);
+  else _failed();
 }
 
+void Player::_started(uint16_t stationId) {
+  _status = PLAYING;
+  if (config.getMode()==PM_SDCARD) {
+    config.sdResumePos = 0;
+    config.saveValue(&config.store.lastSdStation, stationId);
+  }
+  //config.setTitle("");
+  netserver.requestOnChange(MODE, 0);
+  setOutputPins(true);
+  display.putRequest(NEWMODE, PLAYER);
+  display.putRequest(PSTART);
+  network.lostPlaying = false;  // Clear flag - we're playing again!
+  #ifdef RADIO_BROWSER_SEND_CLICKS
+    if (config.getMode()==PM_WEB) radioBrowserSendClick(config.station.url);
+  #endif
+  #if (I2S_DOUT!=255 || I2S_INTERNAL) && PREFETCH_STATIONS>0
+    if (config.getMode()==PM_WEB) prefetch.update(config.lastStation());
+  #endif
+  if (player_on_start_play) player_on_start_play();
+  pm.on_start_play();
+}
+
+void Player::_failed() {
+  telnet.printf("##ERROR#:\tError connecting to %s\r\n", config.station.url);
+  SET_PLAY_ERROR("Error connecting to %s", config.station.url);
+  _stop(true);
+}
+
+#if I2S_DOUT!=255 || I2S_INTERNAL
+/* Learned prebuffer and health live in RAM while a station plays and go to the flash (Preferences) at most every
+   LEARN_SAVE_S: the prebuffer only once a long run without underrun lowered it, the health on a long run without a
+   drop. Values queued by the audio task carry the url hash they belong to, a station change drops them. */
+static bool _saveDue(uint32_t savedT) {
+  return !savedT || millis() - savedT >= LEARN_SAVE_S * 1000UL;
+}
+
+void Player::_loadLearned() {
+  uint32_t h = 2166136261u;   /* FNV-1a of the url, Preferences keys are limited to 15 chars */
+  for (const char *p = config.station.url; *p; p++) { h ^= (uint8_t)*p; h *= 16777619u; }
+  if (h == _pbHash && _pbPacked) {   /* the same station again (a retry): RAM is ahead of the flash */
+    setPrebuffer(_pbPacked >> 16, _pbPacked & 0xFFFF);
+    return;
+  }
+  _pbHash = h;
+  snprintf(_pbKey, sizeof(_pbKey), "pb%08x", h);
+  _pbSavedT = _healthSavedT = 0;
+  Preferences prefs;
+  _pbPacked = 0;
+  if (prefs.begin("prebuf", true)) {
+    _pbPacked = prefs.getUInt(_pbKey, 0);
+    prefs.end();
+  }
+  if (!_pbPacked) _pbPacked = (uint32_t)PREBUFFER_START_MS << 16 | PREBUFFER_RESUME_MS;
+  setPrebuffer(_pbPacked >> 16, _pbPacked & 0xFFFF);
+  _health = 100;
+  if (prefs.begin("health", true)) {
+    _health = prefs.getUChar(_pbKey, 100);
+    prefs.end();
+  }
+}
+
+void Player::_learnPrebuffer(uint32_t packed, bool stable) {
+  if (packed == _pbPacked) return;
+  _pbPacked = packed;
+  telnet.printf("##PLAYER.PREBUFFER#: start %u ms, resume %u ms\r\n", packed >> 16, packed & 0xFFFF);
+  if (!stable || !_saveDue(_pbSavedT)) return;
+  Preferences prefs;
+  if (!prefs.begin("prebuf", false)) return;
+  if (prefs.getUInt(_pbKey, 0) != packed) prefs.putUInt(_pbKey, packed);
+  prefs.end();
+  _pbSavedT = millis();
+}
+
+void Player::_watch(uint8_t reason) {
+  /* the connection is up but nothing useful plays: reconnect, then (if WATCH_LADDER has them) another mirror or address, the next station */
+  if (_watchStation != config.lastStation()) { _watchStation = config.lastStation(); _watchStrikes = 0; }
+  uint8_t action = StreamWatch::action(_watchStrikes, WATCH_LADDER);
+  telnet.printf("##AUDIO.WATCH#: %s, strike %u, %s\r\n", StreamWatch::name(reason), _watchStrikes + 1, StreamWatch::actionName(action));
+  #ifdef MQTT_ENABLE
+    if (config.store.mqttenable && _watchStrikes <= StreamWatch::rungs(WATCH_LADDER)) mqttPublishWatch(reason, _watchStrikes + 1, action);
+  #endif
+  if (_watchStrikes < 255) _watchStrikes++;
+  switch (action) {
+    case StreamWatch::RECONNECT: restartStream(StreamWatch::name(reason)); break;
+    case StreamWatch::ALTERNATE: avoidServer(); sendCommand({PR_PLAY, config.lastStation()}); break;
+    case StreamWatch::NEXT:      next(); break;
+    default: break;                /* the ladder is climbed: only told, once to MQTT */
+  }
+}
+
+void Player::_learnHealth(uint8_t outcome) {
+  static const char *outcomes[] = { "", "reconnected", "reconnected with a dropout", "lost", "stable" };
+  _health = Reconnect::score(_health, outcome);
+  if (outcome == Reconnect::STABLE) _watchStrikes = 0;   /* a long run without a drop, the station recovered */
+  telnet.printf("##PLAYER.HEALTH#: %u (%s)\r\n", _health, outcome <= Reconnect::STABLE ? outcomes[outcome] : "");
+  if (outcome != Reconnect::STABLE || !_saveDue(_healthSavedT)) return;
+  Preferences prefs;
+  if (!prefs.begin("health", false)) return;
+  if (prefs.getUChar(_pbKey, 100) != _health) prefs.putUChar(_pbKey, _health);
+  prefs.end();
+  _healthSavedT = millis();
+}
+#endif
+
 void Player::browseUrl() {
   #ifdef MQTT_ENABLE
     playUrl(burl);
@@ -323,7 +550,11 @@ void Player::next() {
 }
 
 void Player::toggle() {
-  if (_status == PLAYING) {
+  bool on = _status == PLAYING;
+  #if I2S_DOUT!=255 || I2S_INTERNAL
+    on = on || _connecting;   /* stop a station that is still connecting too */
+  #endif
+  if (on) {
     sendCommand({PR_STOP, 0});
   } else {
     sendCommand({PR_PLAY, config.lastStation()});
@@ -18,15 +18,19 @@
 #define PLERR_LN        64
 #define SET_PLAY_ERROR(...) {char buff[512 + 64]; sprintf(buff,__VA_ARGS__); setError(buff);}
 
-enum playerRequestType_e : uint8_t { PR_PLAY = 1, PR_STOP = 2, PR_PREV = 3, PR_NEXT = 4, PR_VOL = 5, PR_CHECKSD = 6, PR_VUTONUS = 7, PR_BURL = 8, PR_TOGGLE = 9 };
+enum playerRequestType_e : uint8_t { PR_PLAY = 1, PR_STOP = 2, PR_PREV = 3, PR_NEXT = 4, PR_VOL = 5, PR_CHECKSD = 6, PR_VUTONUS = 7, PR_BURL = 8, PR_TOGGLE = 9, PR_TSPAUSE = 10, PR_TSJUMP = 11, PR_PREBUF = 12, PR_HEALTH = 13, PR_WATCH = 14, PR_PREBUF_STABLE = 15, PR_TONE = 16, PR_BALANCE = 17, PR_NIGHT = 18, PR_SEEK = 19 };
 struct playerRequestParams_t
 {
   playerRequestType_e type;
   int payload;
+  uint32_t queued = 0;   /* millis() of sendCommand(), a tune is timed from here */
+  uint32_t station = 0;  /* PR_PREBUF, PR_HEALTH: Player::stationHash() the values were learned on */
 };
 
 enum plStatus_e : uint8_t{ PLAYING = 1, STOPPED = 2 };
 
+struct sdPos_t { uint32_t pos, size, time, duration; };   /* file position, size (bytes), time and duration (s) */
+
 class Player: public Audio {
   public:
     bool lockOutput = true;
@@ -43,6 +47,13 @@ class Player: public Audio {
     void setError(const char *e);
     void initHeaders(const char *file);
     void loop();
+    void startTask();
+    bool inTask();              /* called from the task that runs loop() */
+    uint16_t ingestGapMax() { return _gapMax; }   /* longest time between two loop() runs while playing, ms */
+    uint16_t ingestGaps() { return _gaps; }       /* of them longer than INGEST_GAP_MS */
+    void ingestReset() { _gapMax = 0; _gaps = 0; }
+    TaskHandle_t task() { return _task; }
+    uint32_t stackLow() { return _stackLow; }    /* lowest free stack of the player task seen so far, bytes */
     void setOutputPins(bool isPlaying);
     void browseUrl();
     void playUrl(const char* url);
@@ -56,16 +67,45 @@ class Player: public Audio {
     bool hasError() { return strlen(_plError)>0; }
     plStatus_e status() { return _status; }
     void setResumeFilePos(uint32_t pos) { _resumeFilePos = pos; }
+    sdPos_t sdPos() { return _sdPos; }   /* of the playing file as loop() saw it last, for the other tasks */
+    #if I2S_DOUT!=255 || I2S_INTERNAL
+      uint8_t health() { return _health; }   /* 0..100 of the current station, from how its drops went (Reconnect::score) */
+      uint32_t stationHash() { return _pbHash; }
+    #endif
   private:
     uint32_t    _volTicks = 0;       /* delayed volume save  */
     bool        _volTimer = false;   /* delayed volume save  */
     uint32_t    _resumeFilePos = 0;
+    sdPos_t     _sdPos = {0, 0, 0, 0};
+    uint32_t    _sdPosT = 0;
     plStatus_e  _status = STOPPED;
     char        _plError[PLERR_LN];
+    TaskHandle_t _task = NULL;
+    uint32_t    _loopT = 0;
+    uint16_t    _gapMax = 0, _gaps = 0;
+    uint32_t    _stackLow = UINT32_MAX;
 
+    static void _taskLoop(void *param);
+    void _checkStack();
     void _stop(bool alreadyStopped = false);
     void _play(uint16_t stationId);
+    void _started(uint16_t stationId);   /* the station plays: status, display and start of play hooks */
+    void _failed();                      /* the station could not be connected */
     void _loadVol(uint8_t volume);
+    #if I2S_DOUT!=255 || I2S_INTERNAL
+      char        _pbKey[12] = {0};      /* Preferences key of the current station (learned prebuffer, health) */
+      uint32_t    _pbHash = 0;           /* of its url, _pbKey is made of it */
+      uint32_t    _pbPacked = 0;         /* learned prebuffer, start ms << 16 | resume ms, ahead of the flash */
+      uint32_t    _pbSavedT = 0, _healthSavedT = 0;  /* last write to the flash, 0 = none since the station was loaded */
+      uint8_t     _health = 100;
+      uint16_t    _watchStation = 0;    /* station the strikes were counted on */
+      uint8_t     _watchStrikes = 0;    /* dead stream detections on it, climb WATCH_LADDER */
+      bool        _connecting = false;  /* a webstream connection of _play() is on its way, see loop() */
+      void _loadLearned();
+      void _learnPrebuffer(uint32_t packed, bool stable);
+      void _learnHealth(uint8_t outcome);
+      void _watch(uint8_t reason);
+    #endif
 };
 
 extern Player player;
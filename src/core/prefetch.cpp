@@ -0,0 +1,316 @@
+#include "options.h"
+#if (I2S_DOUT!=255 || I2S_INTERNAL) && PREFETCH_STATIONS>0 // ============================== Everything ignored if not defined ==============================
+#include "config.h"
+#include "prefetch.h"
+
+#define PF_MASK        (PREFETCH_BUFFER_SIZE - 1)
+#define PF_HEADER_MS   5000
+#if (PREFETCH_BUFFER_SIZE & PF_MASK) != 0
+  #error PREFETCH_BUFFER_SIZE must be a power of two
+#endif
+
+enum { ICY_DATA=0, ICY_LEN, ICY_META };
+
+Prefetcher prefetch;
+
+/* lower case value of a response header field (name with colon), empty if missing */
+static void _field(const char *hdr, const char *name, char *val, size_t len) {
+  size_t nl = strlen(name);
+  val[0] = 0;
+  for (const char *l = strstr(hdr, "\r\n"); l; l = strstr(l + 2, "\r\n")) {
+    if (strncasecmp(l + 2, name, nl) != 0) continue;
+    const char *v = l + 2 + nl;
+    while (*v == ' ') v++;
+    size_t i = 0;
+    while (v[i] && v[i] != '\r' && i < len - 1) { val[i] = tolower(v[i]); i++; }
+    val[i] = 0;
+    return;
+  }
+}
+
+/* playlists, HLS and anything Audio would rewrite first are not worth keeping warm */
+static bool _warmable(const char *url) {
+  if (strncmp(url, "http://", 7) != 0 && strncmp(url, "https://", 8) != 0) return false;
+  if (strchr(url, ' ')) return false;
+  const char *ext = strrchr(url, '.');
+  if (ext && (strcasecmp(ext, ".m3u") == 0 || strcasecmp(ext, ".m3u8") == 0 || strcasecmp(ext, ".pls") == 0 || strcasecmp(ext, ".asx") == 0)) return false;
+  return true;
+}
+
+/***********************************************************************************************************************
+ *  WarmClient, prefetch task side
+ ***********************************************************************************************************************/
+bool WarmClient::_open() {
+  if (!psramFound() || ESP.getFreeHeap() < PREFETCH_MIN_HEAP) return false;
+  if (!_ring) _ring = (uint8_t*)ps_malloc(PREFETCH_BUFFER_SIZE);
+  if (!_hdr) _hdr = (char*)ps_malloc(PREFETCH_HEADER_MAX + 1);
+  if (!_ring || !_hdr) return false;
+  _hdrLen = _hdrPos = 0;
+  _head = _tail = 0;
+  _bHead = _bTail = 0;
+  _metaint = 0;
+  _aligned = true;
+
+  bool ssl = strncmp(url, "https://", 8) == 0;
+  const char *h = url + (ssl ? 8 : 7);
+  const char *path = strchr(h, '/');
+  char host[BUFLEN];
+  strlcpy(host, h, path ? min((size_t)(path - h + 1), sizeof(host)) : sizeof(host));
+  uint16_t port = ssl ? 443 : 80;
+  char *colon = strchr(host, ':');
+  if (colon) { port = atoi(colon + 1); *colon = 0; }
+  if (ssl) _secure.setInsecure();
+  _sock = ssl ? static_cast<WiFiClient*>(&_secure) : &_plain;
+  if (!_sock->connect(host, port)) return false;
+
+  /* the same request as Audio::connecttohost() sends */
+  char rqh[BUFLEN * 2 + 320];
+  snprintf(rqh, sizeof(rqh), "GET %s HTTP/1.1\r\nHost: %s\r\nIcy-MetaData:1\r\nIcy-MetaData:2\r\nAccept:*/*\r\n"
+           "User-Agent: VLC/3.0.21 LibVLC/3.0.21 AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+           "Accept-Encoding: identity;q=1,*;q=0\r\nConnection: keep-alive\r\n\r\n", path ? path : "/", host);
+  return _sock->print(rqh) == strlen(rqh);
+}
+
+/* 1 = header complete and usable, 0 = waiting, -1 = not a plain audio stream */
+int8_t WarmClient::_header() {
+  while (_sock->available() > 0) {
+    int c = _sock->read();
+    if (c < 0) break;
+    _hdr[_hdrLen++] = c;
+    if (_hdrLen >= 4 && memcmp(_hdr + _hdrLen - 4, "\r\n\r\n", 4) == 0) {
+      _hdr[_hdrLen] = 0;
+      const char *eol = strstr(_hdr, "\r\n");
+      const char *st = strstr(_hdr, " 200");
+      if (!st || st > eol) return -1;                 /* redirects and errors are left to Audio */
+      char val[48];
+      _field(_hdr, "transfer-encoding:", val, sizeof(val));
+      if (strstr(val, "chunked")) return -1;
+      _field(_hdr, "content-type:", val, sizeof(val));
+      if (strstr(val, "mpegurl") || strstr(val, "scpls")) return -1;
+      _field(_hdr, "icy-metaint:", val, sizeof(val));
+      _metaint = atoi(val);
+      if (_metaint >= PREFETCH_BUFFER_SIZE / 2) return -1;
+      _icy = ICY_DATA;
+      _left = _metaint;
+      return 1;
+    }
+    if (_hdrLen >= PREFETCH_HEADER_MAX) return -1;
+  }
+  return _sock->connected() ? 0 : -1;
+}
+
+/* a data block starts at _head */
+void WarmClient::_boundary() {
+  if (!_aligned) { _tail = _head; _bHead = _bTail = 0; _aligned = true; return; }
+  _bounds[_bHead++ & 31] = _head;
+  if ((uint8_t)(_bHead - _bTail) > 32) _bTail++;
+}
+
+void WarmClient::_put(const uint8_t *data, uint32_t len) {
+  if (!_aligned || !len) return;
+  if (_head - _tail + len > PREFETCH_BUFFER_SIZE) {
+    /* drop the oldest data; with metadata only up to the start of a data block */
+    uint32_t need = _head + len - PREFETCH_BUFFER_SIZE;
+    if (!_metaint) _tail = need;
+    else {
+      while (_bTail != _bHead && (int32_t)(_bounds[_bTail & 31] - need) < 0) _bTail++;
+      if (_bTail != _bHead) _tail = _bounds[_bTail++ & 31];
+      else { _tail = _head; _aligned = false; return; }   /* wait for the next block */
+    }
+  }
+  while (len > 0) {
+    uint32_t off = _head & PF_MASK;
+    uint32_t n = min(len, (uint32_t)PREFETCH_BUFFER_SIZE - off);
+    memcpy(_ring + off, data, n);
+    data += n; len -= n; _head += n;
+  }
+}
+
+bool WarmClient::_pump() {
+  uint8_t tmp[1024];
+  for (uint8_t guard = 0; guard < 16 && _sock->available() > 0; guard++) {
+    int n = _sock->read(tmp, sizeof(tmp));
+    if (n <= 0) break;
+    uint32_t i = 0;
+    /* follow the ICY metadata so blocks can be dropped whole */
+    while (i < (uint32_t)n) {
+      if (!_metaint) { _put(tmp + i, n - i); break; }
+      if (_icy == ICY_LEN) {
+        _put(tmp + i, 1);
+        _left = tmp[i++] * 16;
+        if (_left) _icy = ICY_META;
+        else { _icy = ICY_DATA; _left = _metaint; _boundary(); }
+        continue;
+      }
+      uint32_t k = min((uint32_t)n - i, _left);
+      _put(tmp + i, k);
+      i += k; _left -= k;
+      if (_left) continue;
+      if (_icy == ICY_DATA) _icy = ICY_LEN;
+      else { _icy = ICY_DATA; _left = _metaint; _boundary(); }
+    }
+  }
+  return _sock->connected() || _sock->available() > 0;
+}
+
+void WarmClient::_close() {
+  if (_sock) _sock->stop();
+  _sock = NULL;
+  _hdrLen = _hdrPos = 0;
+  _head = _tail = 0;
+  state = PF_IDLE;
+}
+
+/***********************************************************************************************************************
+ *  WarmClient, Audio side (PF_INUSE only, the prefetch task does not touch it any more)
+ ***********************************************************************************************************************/
+int WarmClient::available() {
+  if (state != PF_INUSE) return 0;
+  return buffered() + _sock->available();
+}
+
+int WarmClient::read(uint8_t *buf, size_t size) {
+  if (state != PF_INUSE) return -1;
+  size_t got = 0;
+  if (_hdrPos < _hdrLen) {
+    got = min(size, (size_t)(_hdrLen - _hdrPos));
+    memcpy(buf, _hdr + _hdrPos, got);
+    _hdrPos += got;
+  }
+  while (got < size && _tail != _head) {
+    uint32_t off = _tail & PF_MASK;
+    uint32_t n = min((uint32_t)(size - got), min(_head - _tail, (uint32_t)PREFETCH_BUFFER_SIZE - off));
+    memcpy(buf + got, _ring + off, n);
+    got += n; _tail += n;
+  }
+  if (got == 0) return _sock->read(buf, size);
+  if (got < size && _sock->available() > 0) {
+    int r = _sock->read(buf + got, size - got);
+    if (r > 0) got += r;
+  }
+  return got;
+}
+
+int WarmClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int WarmClient::peek() {
+  if (state != PF_INUSE) return -1;
+  if (_hdrPos < _hdrLen) return (uint8_t)_hdr[_hdrPos];
+  if (_tail != _head) return _ring[_tail & PF_MASK];
+  return _sock->peek();
+}
+
+uint8_t WarmClient::connected() {
+  if (state != PF_INUSE) return 0;
+  return buffered() > 0 || _sock->connected();
+}
+
+void WarmClient::stop() {
+  if (state == PF_INUSE) _close();
+}
+
+/***********************************************************************************************************************
+ *  Prefetcher
+ ***********************************************************************************************************************/
+void Prefetcher::update(uint16_t current) {
+  if (!psramFound()) return;
+  char want[PREFETCH_STATIONS][BUFLEN];
+  memset(want, 0, sizeof(want));
+  uint16_t len = config.playlistLength();
+  if (current > 0 && config.getMode()==PM_WEB && len > 1) {
+    /* next, previous, next but one, ... */
+    for (uint8_t k = 0; k < PREFETCH_STATIONS; k++) {
+      int32_t off = (k / 2 + 1) * (k % 2 ? -1 : 1);
+      uint16_t n = (((int32_t)current - 1 + off) % len + len) % len + 1;
+      if (n == current) continue;
+      if (!config.stationUrlByNum(n, want[k]) || !_warmable(want[k])) want[k][0] = 0;
+    }
+  }
+  if (!_lock) _lock = xSemaphoreCreateMutex();
+  if (!_lock) return;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  memcpy(_want, want, sizeof(_want));
+  _gen++;
+  xSemaphoreGive(_lock);
+  if (!_task && current > 0) xTaskCreate(_prefetchTask, "prefetchTask", 8192, this, 1, &_task);
+}
+
+WarmClient *Prefetcher::take(const char *url) {
+  if (!_lock || !url) return NULL;
+  WarmClient *res = NULL;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  for (uint8_t i = 0; i < PREFETCH_SLOTS; i++) {
+    if (_slots[i].state != PF_WARM || strcmp(_slots[i].url, url) != 0) continue;
+    res = &_slots[i];
+    res->state = PF_INUSE;
+    break;
+  }
+  xSemaphoreGive(_lock);
+  if (res) _hits++; else _misses++;
+  return res;
+}
+
+/* prefetch task: close what is no longer wanted, open what is missing */
+void Prefetcher::_reconcile() {
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  for (uint8_t i = 0; i < PREFETCH_SLOTS; i++) {
+    WarmClient &s = _slots[i];
+    if (s.state == PF_IDLE || s.state == PF_INUSE) continue;
+    bool wanted = false;
+    for (uint8_t k = 0; k < PREFETCH_STATIONS; k++) if (_want[k][0] && strcmp(_want[k], s.url) == 0) wanted = true;
+    /* failed and expired neighbours get another chance on every zap */
+    if (!wanted || s.state == PF_FAILED || s.state == PF_EXPIRED) s._close();
+    else if (s.state == PF_WARM) s.since = millis();
+  }
+  for (uint8_t k = 0; k < PREFETCH_STATIONS; k++) {
+    if (!_want[k][0]) continue;
+    WarmClient *idle = NULL;
+    bool have = false;
+    for (uint8_t i = 0; i < PREFETCH_SLOTS; i++) {
+      if (_slots[i].state == PF_IDLE) { if (!idle) idle = &_slots[i]; }
+      else if (strcmp(_slots[i].url, _want[k]) == 0) have = true;
+    }
+    if (have || !idle) continue;
+    strlcpy(idle->url, _want[k], BUFLEN);
+    idle->state = PF_CONNECTING;
+  }
+  xSemaphoreGive(_lock);
+}
+
+void Prefetcher::_prefetchTask(void *param) {
+  Prefetcher *p = static_cast<Prefetcher*>(param);
+  uint32_t gen = 0;
+  while (true) {
+    if (gen != p->_gen) { gen = p->_gen; p->_reconcile(); }
+    for (uint8_t i = 0; i < PREFETCH_SLOTS && gen == p->_gen; i++) {
+      WarmClient &s = p->_slots[i];
+      switch (s.state) {
+        case PF_CONNECTING:
+          if (s._open()) { s.since = millis(); s.state = PF_HEADER; }
+          else { s._close(); s.state = PF_FAILED; }
+          break;
+        case PF_HEADER: {
+          int8_t h = s._header();
+          if (h > 0) { s.since = millis(); s.state = PF_WARM; }
+          else if (h < 0 || millis() - s.since > PF_HEADER_MS) { s._close(); s.state = PF_FAILED; }
+          break;
+        }
+        case PF_WARM:
+          xSemaphoreTake(p->_lock, portMAX_DELAY);
+          if (s.state == PF_WARM) {
+            if (millis() - s.since > PREFETCH_IDLE_S * 1000UL) { s._close(); s.state = PF_EXPIRED; }
+            else if (!s._pump()) { s._close(); s.state = PF_FAILED; }
+          }
+          xSemaphoreGive(p->_lock);
+          break;
+        default: break;
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+  }
+}
+
+#endif // #if (I2S_DOUT!=255 || I2S_INTERNAL) && PREFETCH_STATIONS>0
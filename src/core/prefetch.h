@@ -0,0 +1,85 @@
+#ifndef prefetch_h
+#define prefetch_h
+#include "options.h"
+
+#if (I2S_DOUT!=255 || I2S_INTERNAL) && PREFETCH_STATIONS>0 // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+
+#define PREFETCH_SLOTS      (PREFETCH_STATIONS + 1)   /* one more for the connection handed to the player */
+#define PREFETCH_HEADER_MAX 1536
+
+enum prefetchState_e { PF_IDLE=0, PF_CONNECTING, PF_HEADER, PF_WARM, PF_INUSE, PF_FAILED, PF_EXPIRED };
+
+/* One prefetched station. While warm the prefetch task keeps reading the stream into a PSRAM ring,
+   dropping the oldest data (on ICY metadata boundaries, so Audio's metadata counter stays in step).
+   Handed to Audio it replays the response header and the buffered body, then reads from the socket. */
+class WarmClient : public WiFiClient {
+  public:
+    WarmClient() {};
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    uint8_t connected() override;
+    void stop() override;
+    size_t write(uint8_t data) override { return _sock ? _sock->write(data) : 0; }
+    size_t write(const uint8_t *buf, size_t size) override { return _sock ? _sock->write(buf, size) : 0; }
+
+    volatile uint8_t state = PF_IDLE;
+    char url[BUFLEN] = {0};
+    uint32_t since = 0;                 /* millis() when it became warm or was last wanted */
+    uint32_t buffered() { return (_hdrLen - _hdrPos) + (_head - _tail); }
+  private:
+    friend class Prefetcher;
+    WiFiClient _plain;
+    WiFiClientSecure _secure;
+    WiFiClient *_sock = NULL;
+    char *_hdr = NULL;
+    uint16_t _hdrLen = 0, _hdrPos = 0;
+    uint8_t *_ring = NULL;              /* PREFETCH_BUFFER_SIZE */
+    uint32_t _head = 0, _tail = 0;      /* absolute positions */
+    uint32_t _metaint = 0, _left = 0;
+    uint8_t _icy = 0;
+    bool _aligned = true;
+    uint32_t _bounds[32];               /* ring positions where a data block starts after metadata */
+    uint8_t _bHead = 0, _bTail = 0;
+
+    bool _open();
+    int8_t _header();
+    bool _pump();
+    void _close();
+    void _put(const uint8_t *data, uint32_t len);
+    void _boundary();
+};
+
+/* Keeps the neighbours of the current station connected so that next/prev starts from a few
+   seconds of already buffered audio instead of DNS + connect + TLS + prebuffer.
+   update() is called by the player task on every station change, all socket work is done by a
+   low priority task; Audio picks a warm connection up through audio_warm_client(). */
+class Prefetcher {
+  public:
+    Prefetcher() {};
+    void update(uint16_t current);      /* 0 = playback stopped, close all */
+    WarmClient *take(const char *url);
+    WarmClient *slot(uint8_t i) { return i < PREFETCH_SLOTS ? &_slots[i] : NULL; }
+    uint32_t hits() { return _hits; }
+    uint32_t misses() { return _misses; }
+  private:
+    TaskHandle_t _task = NULL;
+    SemaphoreHandle_t _lock = NULL;
+    WarmClient _slots[PREFETCH_SLOTS];
+    char _want[PREFETCH_STATIONS][BUFLEN] = {};
+    volatile uint32_t _gen = 0;
+    uint32_t _hits = 0, _misses = 0;
+
+    static void _prefetchTask(void *param);
+    void _reconcile();
+};
+
+extern Prefetcher prefetch;
+
+#endif // #if (I2S_DOUT!=255 || I2S_INTERNAL) && PREFETCH_STATIONS>0
+
+#endif
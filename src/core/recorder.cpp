@@ -0,0 +1,199 @@
+#include "options.h"
+#ifdef USE_SD // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+#include <SD.h>
+#include "config.h"
+#include "sdmanager.h"
+#include "player.h"
+#include "network.h"
+#include "netserver.h"
+#include "telnet.h"
+#include "recorder.h"
+
+Recorder recorder;
+
+static const char *_recExt() {
+  switch (config.configFmt) {
+    case BF_MP3:  return "mp3";
+    case BF_AAC:  return "aac";
+    case BF_FLAC: return "flac";
+    case BF_OGG:
+    case BF_VOR:
+    case BF_OPU:  return "ogg";
+    case BF_WAV:  return "wav";
+    default:      return "bin";
+  }
+}
+
+bool Recorder::start() {
+  if (_running) return true;
+  if (_task) {
+    telnet.printf("##ERROR#:\tRecorder: the last recording is still being written\r\n");
+    return false;
+  }
+  if (config.getMode()!=PM_WEB || player.status()!=PLAYING) return false;
+  if (!sdman.ready && !sdman.start()) {
+    telnet.printf("##ERROR#:\tRecorder: SD not found\r\n");
+    return false;
+  }
+  if (!_buf) {
+    /* ring size must be a power of two (positions are masked) and a multiple of REC_BLOCK_SIZE */
+    _size = REC_BUFFER_SIZE;
+    if (psramFound()) _buf = (uint8_t*)ps_malloc(_size);
+    if (!_buf) {
+      _size = REC_BLOCK_SIZE * 2;
+      _buf = (uint8_t*)heap_caps_malloc(_size, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+    }
+    if (!_buf) { _size = 0; return false; }
+  }
+  if (!_events) _events = xQueueCreate(4, sizeof(recEvent_t));
+  xQueueReset(_events);
+  _head = _tail = 0;
+  _written = _dropped = 0;
+  _busyUs = 0; _maxWriteUs = 0;
+  _part = 0;
+  sdman.lock();
+  if (!sdman.exists(REC_DIR)) sdman.mkdir(REC_DIR);
+  bool opened = _openFile();
+  sdman.unlock();
+  if (!opened) return false;
+  _running = true;
+  if (xTaskCreate(_writerTask, "recTask", 4096, this, 1, &_task)!=pdPASS) {
+    _running = false;
+    _task = NULL;
+    sdman.lock();
+    _closeFile();
+    sdman.unlock();
+    return false;
+  }
+  title(config.station.title);
+  netserver.requestOnChange(GETRECORD, 0);
+  return true;
+}
+
+void Recorder::stop() {
+  if (!_running) return;
+  _running = false;   /* the writer task drains the ring, closes the file, reports and deletes itself */
+  netserver.requestOnChange(GETRECORD, 0);
+}
+
+void Recorder::feed(const uint8_t *data, size_t len) {
+  if (!_running || !len) return;
+  uint32_t head = _head;
+  if (len > _size - (head - _tail)) { _dropped += len; return; } /* never block the stream reader */
+  uint32_t off = head & (_size - 1);
+  uint32_t n = min((uint32_t)len, _size - off);
+  memcpy(_buf + off, data, n);
+  if (len > n) memcpy(_buf, data + n, len - n);
+  _head = head + len;
+}
+
+void Recorder::title(const char *title) {
+  if (!_running || !title || strlen(title)==0) return;
+  recEvent_t ev;
+  ev.pos = _head;
+  ev.ms = millis();
+  strlcpy(ev.title, title, REC_TITLE_LEN);
+  xQueueSend(_events, &ev, 0);
+}
+
+uint32_t Recorder::writeRate() {
+  if (_busyUs==0) return 0;
+  return (uint32_t)((uint64_t)_written * 1000000 / _busyUs / 1024);
+}
+
+void Recorder::_writerTask(void *param) {
+  Recorder *r = static_cast<Recorder*>(param);
+  recEvent_t ev;
+  while (true) {
+    bool hasEv = xQueuePeek(r->_events, &ev, 0)==pdTRUE;
+    uint32_t avail = r->_head - r->_tail;
+    if (hasEv && ev.pos - r->_tail < avail) avail = ev.pos - r->_tail; /* write up to the title change first */
+    if (avail >= REC_BLOCK_SIZE || ((hasEv || !r->_running) && avail > 0)) {
+      sdman.lock();
+      bool ok = r->_writeBlock(avail);
+      sdman.unlock();
+      if (!ok) break;
+      continue;
+    }
+    if (hasEv) {
+      xQueueReceive(r->_events, &ev, 0);
+      bool ok = true;
+      sdman.lock();
+      if (REC_SPLIT_ON_TITLE && r->_fileSize > 0) {
+        r->_closeFile();
+        ok = r->_openFile();
+      }
+      if (ok) r->_writeIndex(ev);
+      sdman.unlock();
+      if (!ok) break;
+      continue;
+    }
+    if (!r->_running) break;
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+  r->_running = false;
+  sdman.lock();
+  r->_closeFile();
+  sdman.unlock();
+  telnet.printf("##REC#:\tstopped, %u bytes written, %u bytes dropped, %u kB/s\r\n", r->_written, r->_dropped, r->writeRate());
+  netserver.requestOnChange(GETRECORD, 0);
+  r->_task = NULL;
+  vTaskDelete(NULL);
+}
+
+bool Recorder::_writeBlock(uint32_t avail) {
+  uint32_t off = _tail & (_size - 1);
+  /* keep the writes aligned to REC_BLOCK_SIZE, a short write only happens before a title change or on stop */
+  uint32_t n = min(avail, (uint32_t)REC_BLOCK_SIZE - (off % REC_BLOCK_SIZE));
+  if (_fileSize + n > REC_MAX_FILE_SIZE) {
+    _closeFile();
+    if (!_openFile()) return false;
+  }
+  uint32_t t = micros();
+  size_t w = _file.write(_buf + off, n);
+  t = micros() - t;
+  _busyUs += t;
+  if (t > _maxWriteUs) _maxWriteUs = t;
+  if (w != n) {
+    telnet.printf("##ERROR#:\tRecorder: write error on %s\r\n", _path);
+    return false;
+  }
+  _tail += n;
+  _written += n;
+  _fileSize += n;
+  return true;
+}
+
+bool Recorder::_openFile() {
+  char stamp[20];
+  strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &network.timeinfo);
+  snprintf(_path, sizeof(_path), "%s/%s_%02u.%s", REC_DIR, stamp, ++_part, _recExt());
+  _file = sdman.open(_path, FILE_WRITE);
+  if (!_file) {
+    telnet.printf("##ERROR#:\tRecorder: can't create %s\r\n", _path);
+    return false;
+  }
+  _fileSize = 0;
+  _fileStart = millis();
+  telnet.printf("##REC#:\t%s\r\n", _path);
+  return true;
+}
+
+void Recorder::_closeFile() {
+  if (_file) _file.close();
+}
+
+void Recorder::_writeIndex(const recEvent_t &ev) {
+  char ipath[52];
+  strlcpy(ipath, _path, sizeof(ipath));
+  char *dot = strrchr(ipath, '.');
+  if (dot) strcpy(dot, ".txt");
+  File index = sdman.open(ipath, FILE_APPEND);
+  if (!index) return;
+  uint32_t s = (ev.ms > _fileStart ? ev.ms - _fileStart : 0) / 1000;
+  index.printf("%02u:%02u:%02u\t%s\r\n", s / 3600, (s / 60) % 60, s % 60, ev.title);
+  index.close();
+}
+
+#endif // #ifdef USE_SD
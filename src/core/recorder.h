@@ -0,0 +1,62 @@
+#ifndef recorder_h
+#define recorder_h
+#include "options.h"
+
+#ifdef USE_SD // ============================== Everything ignored if not defined ==============================
+#include <FS.h>
+
+#define REC_TITLE_LEN 96
+
+struct recEvent_t
+{
+  uint32_t pos;                 /* stream byte position of the title change */
+  uint32_t ms;                  /* millis() at the title change             */
+  char     title[REC_TITLE_LEN];
+};
+
+/* Records the compressed webstream (ICY metadata and chunk headers already stripped by Audio)
+   to the SD card. feed() only copies into a staging ring; all SD access is done by a
+   low priority writer task in REC_BLOCK_SIZE pieces under sdman.lock(), so SD latency never reaches
+   the stream reader. stop() only tells the writer, which drains the ring and closes the file itself.
+   Not measured on hardware yet: the write rate and that a 320 kbps (40 kB/s) stream has no more
+   underruns while it is recorded. ##REC# on stop gives kB/s and dropped bytes, compare the
+   "buffer underrun #" count of the same station with and without recording. */
+class Recorder {
+  public:
+    Recorder() {};
+    bool start();
+    void stop();
+    bool isRecording() { return _running; }
+    void feed(const uint8_t *data, size_t len);
+    void title(const char *title);
+    uint32_t bytesWritten() { return _written; }
+    uint32_t bytesDropped() { return _dropped; }
+    uint32_t writeRate();     /* SD write throughput, kB/s */
+    uint32_t maxWriteTime() { return _maxWriteUs / 1000; }
+  private:
+    uint8_t *_buf = NULL;
+    uint32_t _size = 0;
+    volatile uint32_t _head = 0, _tail = 0;
+    volatile bool _running = false;
+    TaskHandle_t _task = NULL;
+    QueueHandle_t _events = NULL;
+    File _file;
+    char _path[48] = {0};
+    uint8_t _part = 0;
+    uint32_t _fileSize = 0, _fileStart = 0;
+    uint32_t _written = 0, _dropped = 0;
+    uint64_t _busyUs = 0;
+    uint32_t _maxWriteUs = 0;
+
+    static void _writerTask(void *param);
+    bool _openFile();
+    void _closeFile();
+    bool _writeBlock(uint32_t avail);
+    void _writeIndex(const recEvent_t &ev);
+};
+
+extern Recorder recorder;
+
+#endif // #ifdef USE_SD
+
+#endif
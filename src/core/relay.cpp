@@ -0,0 +1,127 @@
+#include "options.h"
+#if RELAY_MAX_CLIENTS>0 // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+#include "config.h"
+#include "player.h"
+#include "telnet.h"
+#include "relay.h"
+
+#ifndef RESPONSE_TRY_AGAIN
+  #define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+#endif
+
+Relay relay;
+
+static const char *_relayMime() {
+  switch (config.configFmt) {
+    case BF_MP3:  return "audio/mpeg";
+    case BF_AAC:  return "audio/aac";
+    case BF_FLAC: return "audio/flac";
+    case BF_OGG:
+    case BF_VOR:
+    case BF_OPU:  return "audio/ogg";
+    case BF_WAV:  return "audio/wav";
+    default:      return "application/octet-stream";
+  }
+}
+
+bool Relay::_alloc() {
+  if (_buf) return true;
+  /* ring size must be a power of two, positions are masked */
+  _size = RELAY_BUFFER_SIZE;
+  if (psramFound()) _buf = (uint8_t*)ps_malloc(_size);
+  if (!_buf) {
+    _size = RELAY_BUFFER_SIZE_NOPSRAM;
+    _buf = (uint8_t*)heap_caps_malloc(_size, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+  }
+  if (!_buf) _size = 0;
+  return _buf!=NULL;
+}
+
+void Relay::feed(const uint8_t *data, size_t len) {
+  if (!_active || !len) return;
+  uint32_t head = _head;
+  while (len > 0) {
+    uint32_t off = head & (_size - 1);
+    uint32_t n = min((uint32_t)len, _size - off);
+    memcpy(_buf + off, data, n);
+    data += n; len -= n; head += n;
+  }
+  _head = head;
+}
+
+void Relay::reset() {
+  for (uint8_t i = 0; i < RELAY_MAX_CLIENTS; i++) if (_slots[i].used) _slots[i].kick = true;
+}
+
+void Relay::handle(AsyncWebServerRequest *request) {
+  if (config.getMode()!=PM_WEB || player.status()!=PLAYING) { request->send(503, "text/plain", "not playing"); return; }
+  if (!_alloc()) { request->send(500, "text/plain", "no memory"); return; }
+  uint8_t slot = RELAY_MAX_CLIENTS;
+  for (uint8_t i = 0; i < RELAY_MAX_CLIENTS; i++) if (!_slots[i].used) { slot = i; break; }
+  if (slot == RELAY_MAX_CLIENTS) { request->send(503, "text/plain", "too many clients"); return; }
+  relayClient_t &c = _slots[slot];
+  c.kick = false;
+  c.cursor = _head;
+  c.sent = 0;
+  c.since = millis();
+  c.ip = request->client()->remoteIP();
+  c.used = true;
+  _active++;
+  AsyncWebServerResponse *response = request->beginChunkedResponse(_relayMime(), [this, slot](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    return _fill(slot, buffer, maxLen);
+  });
+  response->addHeader("Cache-Control", "no-cache");
+  response->addHeader("icy-name", config.station.name);
+  request->onDisconnect([this, slot]() { _release(slot); });
+  request->send(response);
+  telnet.printf("##RELAY#:\t%s connected, %d client(s)\r\n", c.ip.toString().c_str(), _active);
+}
+
+size_t Relay::_fill(uint8_t slot, uint8_t *buffer, size_t maxLen) {
+  relayClient_t &c = _slots[slot];
+  if (!c.used || c.kick) return 0;
+  uint32_t cursor = c.cursor;
+  uint32_t avail = _head - cursor;
+  if (avail > _size) { c.kick = true; _dropped++; return 0; }
+  if (avail == 0) return RESPONSE_TRY_AGAIN;
+  uint32_t n = min((uint32_t)maxLen, avail);
+  uint32_t off = cursor & (_size - 1);
+  uint32_t first = min(n, _size - off);
+  memcpy(buffer, _buf + off, first);
+  if (n > first) memcpy(buffer + first, _buf, n - first);
+  /* the reader may have lapped us while copying, then the chunk is garbage */
+  if (_head - cursor > _size) { c.kick = true; _dropped++; return 0; }
+  c.cursor = cursor + n;
+  c.sent += n;
+  _sentTotal += n;
+  return n;
+}
+
+void Relay::_release(uint8_t slot) {
+  relayClient_t &c = _slots[slot];
+  if (!c.used) return;
+  telnet.printf("##RELAY#:\t%s %s, %u bytes sent\r\n", c.ip.toString().c_str(), c.kick?"dropped":"disconnected", c.sent);
+  c.used = false;
+  if (_active) _active--;
+}
+
+uint8_t Relay::clients() {
+  return _active;
+}
+
+uint32_t Relay::lag(uint8_t slot) {
+  if (slot >= RELAY_MAX_CLIENTS || !_slots[slot].used) return 0;
+  return _head - _slots[slot].cursor;
+}
+
+uint32_t Relay::rate() {
+  uint32_t now = millis();
+  uint32_t dt = now - _rateMs;
+  uint32_t r = dt ? (uint32_t)((uint64_t)(_sentTotal - _rateBytes) * 1000 / dt) : 0;
+  _rateBytes = _sentTotal;
+  _rateMs = now;
+  return r;
+}
+
+#endif // #if RELAY_MAX_CLIENTS>0
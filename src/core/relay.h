@@ -0,0 +1,51 @@
+#ifndef relay_h
+#define relay_h
+#include "options.h"
+
+#if RELAY_MAX_CLIENTS>0 // ============================== Everything ignored if not defined ==============================
+#include <ESPAsyncWebServer.h>
+
+struct relayClient_t
+{
+  bool              used;
+  volatile bool     kick;       /* close the response on the next fill           */
+  uint32_t          cursor;     /* absolute ring position of the next byte to send */
+  uint32_t          sent;
+  uint32_t          since;      /* millis() at connect                           */
+  IPAddress         ip;
+};
+
+/* Re-serves the compressed webstream to LAN clients on /relay.
+   feed() is called from the stream reader with the bytes already in Audio's input buffer, it only
+   copies into one shared ring and never waits for a client. Every client has its own read cursor;
+   a client that falls a whole ring behind is disconnected instead of holding the reader back. */
+class Relay {
+  public:
+    Relay() {};
+    void feed(const uint8_t *data, size_t len);
+    void reset();                               /* station changed, close all responses */
+    void handle(AsyncWebServerRequest *request);
+    uint8_t clients();
+    uint32_t rate();                            /* bytes/s sent to all clients since the last call */
+    uint32_t lag(uint8_t slot);                 /* bytes behind the stream reader */
+    relayClient_t *client(uint8_t slot) { return slot < RELAY_MAX_CLIENTS && _slots[slot].used ? &_slots[slot] : NULL; }
+    uint32_t dropped() { return _dropped; }
+  private:
+    uint8_t *_buf = NULL;
+    uint32_t _size = 0;
+    volatile uint32_t _head = 0;
+    volatile uint8_t _active = 0;
+    relayClient_t _slots[RELAY_MAX_CLIENTS] = {};
+    uint32_t _sentTotal = 0, _rateBytes = 0, _rateMs = 0;
+    uint32_t _dropped = 0;
+
+    bool _alloc();
+    size_t _fill(uint8_t slot, uint8_t *buffer, size_t maxLen);
+    void _release(uint8_t slot);
+};
+
+extern Relay relay;
+
+#endif // #if RELAY_MAX_CLIENTS>0
+
+#endif
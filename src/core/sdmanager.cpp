@@ -24,7 +24,21 @@
 
 SDManager sdman(FSImplPtr(new VFSImpl()));
 
+static SemaphoreHandle_t _sdLock() {
+  static SemaphoreHandle_t lock = xSemaphoreCreateRecursiveMutex();
+  return lock;
+}
+
+void SDManager::lock() {
+  xSemaphoreTakeRecursive(_sdLock(), portMAX_DELAY);
+}
+
+void SDManager::unlock() {
+  xSemaphoreGiveRecursive(_sdLock());
+}
+
 bool SDManager::start() {
+  lock();
   ready = begin(SDC_CS, SDREALSPI, SDSPISPEED);
   vTaskDelay(10);
   if (!ready) ready = begin(SDC_CS, SDREALSPI, SDSPISPEED);
@@ -32,12 +46,15 @@ bool SDManager::start() {
   if (!ready) ready = begin(SDC_CS, SDREALSPI, SDSPISPEED);
   vTaskDelay(50);
   if (!ready) ready = begin(SDC_CS, SDREALSPI, SDSPISPEED);
+  unlock();
   return ready;
 }
 
 void SDManager::stop() {
+  lock();   /* not under a file the recorder is writing */
   end();
   ready = false;
+  unlock();
 }
 #include "diskio_impl.h"
 bool SDManager::cardPresent() {
@@ -47,7 +64,9 @@ bool SDManager::cardPresent() {
     return false;
   }
   uint8_t buff[sectorSize()] = { 0 };
+  lock();
   bool bread = readRAW(buff, 1);
+  unlock();
   if (sectorSize()>0 && !bread) return false;
   return bread;
 }
@@ -84,7 +103,11 @@ void SDManager::listSD(File &plSDfile, File &plSDindex, const char* dirname, uin
     char* filePath;
     while (true) {
         vTaskDelay(2);
-        player.loop();
+        if (player.inTask()) player.loop();   /* otherwise the player task keeps playing */
+        for (uint8_t i = 0; i < 50 && player.readAheadLow(); i++) {   /* the card refills the read-ahead of a playing file first */
+            vTaskDelay(pdMS_TO_TICKS(10));
+            if (player.inTask()) player.loop();
+        }
         bool isDir;
         String fileName = root.getNextFileName(&isDir);
         if (fileName.isEmpty()) break;
@@ -11,6 +11,8 @@ class SDManager : public SDFS {
     bool cardPresent();
     void listSD(File &plSDfile, File &plSDindex, const char * dirname, uint8_t levels);
     void indexSDPlaylist();
+    void lock();      /* the card for a task outside the player, e.g. the recorder; recursive */
+    void unlock();
   private:
     uint32_t _sdFCount = 0;
     bool _checkNoMedia(const char* path);
@@ -0,0 +1,84 @@
+#include "options.h"
+#if I2S_DOUT!=255 || I2S_INTERNAL // ============================== Everything ignored if not defined ==============================
+#include "pcmtap.h"
+#include "spectrum.h"
+
+#if !(SPECTRUM_FFT_SIZE==256 || SPECTRUM_FFT_SIZE==512 || SPECTRUM_FFT_SIZE==1024)
+  #error SPECTRUM_FFT_SIZE must be 256, 512 or 1024
+#endif
+#define FFT_N SPECTRUM_FFT_SIZE
+
+Spectrum spectrum;
+
+bool Spectrum::_alloc() {
+  if (_ring) return true;
+  _ring = (int16_t*)calloc(FFT_N, sizeof(int16_t));
+  if (!_ring || !_fft.begin(FFT_N)) { _free(); return false; }
+  _ringPos = 0;
+  return true;
+}
+
+void Spectrum::_free() {
+  free(_ring);
+  _ring = NULL;
+  _fft.end();
+}
+
+bool Spectrum::start(uint8_t bands) {
+  if (_task) return true;
+  _bands = constrain(bands, 1, SPECTRUM_MAX_BANDS);
+  if (!_alloc()) return false;
+  _running = true;
+  if (xTaskCreate(_spectrumTask, "spectrumTask", 3072, this, 1, &_task)!=pdPASS) {
+    _running = false;
+    _task = NULL;
+    _free();
+    return false;
+  }
+  return true;
+}
+
+void Spectrum::stop() {
+  if (!_task) return;
+  _running = false;
+  uint32_t t = millis();
+  while (_task && millis()-t < 500) vTaskDelay(5);
+}
+
+void Spectrum::_spectrumTask(void *param) {
+  Spectrum *s = static_cast<Spectrum*>(param);
+  int8_t id = pcmtap.subscribe("spectrum");
+  int16_t chunk[64 * 2];
+  uint32_t filled = 0;
+  TickType_t wake = xTaskGetTickCount();
+  while (s->_running && id >= 0) {
+    uint16_t n;
+    bool fresh = false;
+    while ((n = pcmtap.read(id, chunk, 64)) > 0) {
+      for (uint16_t i = 0; i < n; i++) {
+        s->_ring[s->_ringPos] = ((int32_t)chunk[i * 2] + chunk[i * 2 + 1]) >> 1;
+        s->_ringPos = (s->_ringPos + 1) & (FFT_N - 1);
+      }
+      filled += n;
+      fresh = true;
+    }
+    pcmtap.overrun(id);   /* only the newest window matters here */
+    if (fresh && filled >= FFT_N && pcmtap.sampleRate() > 0) {
+      uint32_t t = micros();
+      s->_fft.run(s->_ring, s->_ringPos);
+      s->_fft.bands(s->_levels, s->_bands, pcmtap.sampleRate());
+      s->_costUs = micros() - t;
+    } else if (!fresh) {
+      memset((void*)s->_levels, 0, sizeof(s->_levels));
+    }
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(1000 / SPECTRUM_FPS));
+  }
+  pcmtap.unsubscribe(id);
+  memset((void*)s->_levels, 0, sizeof(s->_levels));
+  s->_free();
+  s->_running = false;
+  s->_task = NULL;
+  vTaskDelete(NULL);
+}
+
+#endif // #if I2S_DOUT!=255 || I2S_INTERNAL
@@ -0,0 +1,42 @@
+#ifndef spectrum_h
+#define spectrum_h
+#include "options.h"
+
+#if I2S_DOUT!=255 || I2S_INTERNAL // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+#include "spectrumfft.h"
+
+#define SPECTRUM_MAX_BANDS SpectrumFft::BANDS_MAX
+
+/* Spectrum analyzer for the display. A low priority task reads the decoded PCM from the pcmtap,
+   runs a Hann windowed Q15 FFT (spectrumfft.h) of SPECTRUM_FFT_SIZE points SPECTRUM_FPS times a second
+   and maps the bins to log spaced bands. Nothing of this runs on the audio task. */
+class Spectrum {
+  public:
+    Spectrum() {};
+    bool start(uint8_t bands);
+    void stop();
+    bool running() { return _task!=NULL; }
+    uint8_t bands() { return _bands; }
+    uint8_t level(uint8_t band) { return band < _bands ? _levels[band] : 0; }   /* 0..255, 60 dB range */
+    uint32_t cost() { return _costUs; }                                        /* last FFT + band mapping, us */
+  private:
+    TaskHandle_t _task = NULL;
+    volatile bool _running = false;
+    uint8_t _bands = 0;
+    volatile uint8_t _levels[SPECTRUM_MAX_BANDS] = {0};
+    volatile uint32_t _costUs = 0;
+    int16_t *_ring = NULL;        /* last SPECTRUM_FFT_SIZE mono samples */
+    uint16_t _ringPos = 0;
+    SpectrumFft _fft;
+
+    static void _spectrumTask(void *param);
+    bool _alloc();
+    void _free();
+};
+
+extern Spectrum spectrum;
+
+#endif // #if I2S_DOUT!=255 || I2S_INTERNAL
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef spectrumfft_h
+#define spectrumfft_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* Hann windowed Q15 FFT of the spectrum analyzer and the mapping of its bins to log spaced bands.
+   Plain C++ without Arduino dependencies, so a host harness can check and time it.
+   n is 256, 512 or 1024 points: radix-4 DIT stages over 4^k points, for 512 a radix-2 stage last.
+   Every radix-4 stage scales by 1/4 and the radix-2 stage by 1/2, so Q15 never overflows (total scale 1/n). */
+class SpectrumFft {
+public:
+  static const uint8_t BANDS_MAX = 64;
+  static const uint16_t LOW_HZ = 50, HIGH_HZ = 16000;
+
+  static bool valid(uint16_t n) { return n == 256 || n == 512 || n == 1024; }
+
+  bool begin(uint16_t n) {
+    if (_x) return n == _n;
+    if (!valid(n)) return false;
+    _n = n;
+    _q = (n & 0x5555) ? n : n / 2;   /* the radix-4 part, a power of 4 */
+    _x   = (int16_t *)malloc(n * 2 * sizeof(int16_t));
+    _sin = (int16_t *)malloc(n * sizeof(int16_t));
+    _win = (int16_t *)malloc(n / 2 * sizeof(int16_t));
+    if (!_x || !_sin || !_win) { end(); return false; }
+    for (uint16_t i = 0; i < n; i++)     _sin[i] = (int16_t)lroundf(32767.0f * sinf(2.0f * (float)M_PI * i / n));
+    for (uint16_t i = 0; i < n / 2; i++) _win[i] = (int16_t)lroundf(32767.0f * 0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / (n - 1))));
+    _edgesRate = 0;
+    return true;
+  }
+  void end() {
+    free(_x); free(_sin); free(_win);
+    _x = _sin = _win = nullptr;
+  }
+  uint16_t size() const { return _n; }
+  const int16_t *bins() const { return _x; }   /* interleaved re/im, n / 2 useful bins */
+
+  /* ring: n mono samples, the oldest at pos */
+  void run(const int16_t *ring, uint16_t pos) {
+    const uint16_t n = _n, mask = n - 1;
+    /* windowed input goes straight to its digit reversed slot */
+    for (uint16_t i = 0; i < n; i++) {
+      int16_t w = i < n / 2 ? _win[i] : _win[n - 1 - i];
+      uint16_t r = _rev(i) * 2;
+      _x[r]     = ((int32_t)ring[(pos + i) & mask] * w) >> 15;
+      _x[r + 1] = 0;
+    }
+    for (uint16_t L = 4; L <= _q; L <<= 2) {
+      uint16_t q = L >> 2, step = n / L;
+      for (uint16_t k = 0; k < q; k++) {
+        uint16_t m1 = k * step, m2 = 2 * m1, m3 = 3 * m1;
+        int32_t c1 = _cos(m1), s1 = _sin[m1];
+        int32_t c2 = _cos(m2), s2 = _sin[m2];
+        int32_t c3 = _cos(m3), s3 = _sin[m3];
+        for (uint16_t b = k; b < n; b += L) {
+          int16_t *p0 = _x + b * 2, *p1 = p0 + q * 2, *p2 = p1 + q * 2, *p3 = p2 + q * 2;
+          /* a * (c - js) */
+          int32_t a0r = p0[0], a0i = p0[1];
+          int32_t a1r = (p1[0] * c1 + p1[1] * s1) >> 15, a1i = (p1[1] * c1 - p1[0] * s1) >> 15;
+          int32_t a2r = (p2[0] * c2 + p2[1] * s2) >> 15, a2i = (p2[1] * c2 - p2[0] * s2) >> 15;
+          int32_t a3r = (p3[0] * c3 + p3[1] * s3) >> 15, a3i = (p3[1] * c3 - p3[0] * s3) >> 15;
+          int32_t t0r = a0r + a2r, t0i = a0i + a2i;
+          int32_t t1r = a0r - a2r, t1i = a0i - a2i;
+          int32_t t2r = a1r + a3r, t2i = a1i + a3i;
+          int32_t t3r = a1r - a3r, t3i = a1i - a3i;
+          p0[0] = (t0r + t2r) >> 2; p0[1] = (t0i + t2i) >> 2;
+          p1[0] = (t1r + t3i) >> 2; p1[1] = (t1i - t3r) >> 2;
+          p2[0] = (t0r - t2r) >> 2; p2[1] = (t0i - t2i) >> 2;
+          p3[0] = (t1r - t3i) >> 2; p3[1] = (t1i + t3r) >> 2;
+        }
+      }
+    }
+    if (_q == n) return;
+    /* radix-2 over the two halves, the even and the odd samples */
+    for (uint16_t k = 0; k < _q; k++) {
+      int16_t *p0 = _x + k * 2, *p1 = p0 + _q * 2;
+      int32_t c = _cos(k), s = _sin[k];
+      int32_t ar = (p1[0] * c + p1[1] * s) >> 15, ai = (p1[1] * c - p1[0] * s) >> 15;
+      int32_t br = p0[0], bi = p0[1];
+      p0[0] = (br + ar) >> 1; p0[1] = (bi + ai) >> 1;
+      p1[0] = (br - ar) >> 1; p1[1] = (bi - ai) >> 1;
+    }
+  }
+
+  /* levels 0..255 over 60 dB of bands (1..BANDS_MAX) from LOW_HZ to HIGH_HZ, from the last run() */
+  void bands(volatile uint8_t *levels, uint8_t count, uint32_t sampleRate) {
+    const uint16_t n = _n;
+    if (sampleRate != _edgesRate || count != _edgesCount) {
+      /* log spaced band edges in bins, every band gets at least one bin */
+      float hi = sampleRate / 2.0f < HIGH_HZ ? sampleRate / 2.0f : HIGH_HZ;
+      float ratio = hi / LOW_HZ;
+      for (uint8_t i = 0; i <= count; i++) {
+        uint16_t e = (uint16_t)(LOW_HZ * powf(ratio, (float)i / count) * n / sampleRate);
+        if (i > 0 && e <= _edges[i - 1]) e = _edges[i - 1] + 1;
+        _edges[i] = e < n / 2 ? e : n / 2;
+      }
+      _edgesRate = sampleRate;
+      _edgesCount = count;
+    }
+    /* full scale sine: |X|^2 ~ 2^26 after the 1/n scaling and the Hann gain, show the top 60 dB (20 doublings of power) */
+    const int32_t top = 26 << 4, range = 20 << 4;
+    for (uint8_t b = 0; b < count; b++) {
+      uint32_t p = 0;
+      for (uint16_t k = _edges[b]; k < _edges[b + 1]; k++) {
+        int32_t re = _x[k * 2], im = _x[k * 2 + 1];
+        uint32_t pk = (uint32_t)(re * re) + (uint32_t)(im * im);
+        if (pk > p) p = pk;
+      }
+      int32_t l = ((int32_t)log2q4(p) - (top - range)) * 255 / range;
+      levels[b] = l < 0 ? 0 : l > 255 ? 255 : l;
+    }
+  }
+
+  /* log2(v) in Q4 (4 fractional bits, linear interpolation) */
+  static uint16_t log2q4(uint32_t v) {
+    if (!v) return 0;
+    uint8_t e = 31 - __builtin_clz(v);
+    uint32_t f = e >= 4 ? (v >> (e - 4)) & 15 : (v << (4 - e)) & 15;
+    return (e << 4) | f;
+  }
+
+private:
+  uint16_t _n = 0, _q = 0;
+  int16_t *_x = nullptr;     /* interleaved re/im work buffer */
+  int16_t *_sin = nullptr;   /* one full sine period, Q15 */
+  int16_t *_win = nullptr;   /* first half of the Hann window, Q15 */
+  uint16_t _edges[BANDS_MAX + 1] = {};
+  uint32_t _edgesRate = 0;
+  uint8_t _edgesCount = 0;
+
+  int32_t _cos(uint16_t m) const { return _sin[(m + _n / 4) & (_n - 1)]; }
+
+  /* input slot of sample i: base 4 digit reversal over the radix-4 part, for 512 the even samples in
+     the first half and the odd ones in the second (the radix-2 stage splits them last) */
+  uint16_t _rev(uint16_t i) const {
+    uint16_t h = 0;
+    if (_q != _n) { h = (i & 1) * _q; i >>= 1; }
+    uint16_t r = 0;
+    for (uint16_t m = _q; m > 1; m >>= 2) { r = (r << 2) | (i & 3); i >>= 2; }
+    return h + r;
+  }
+};
+
+#endif // spectrumfft_h
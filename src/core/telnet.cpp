@@ -6,6 +6,15 @@
 #include "battery.h"
 #include "telnet.h"
 #include "netserver.h" // For launchPlaybackTask
+#ifdef USE_SD
+  #include "recorder.h"
+#endif
+#include "relay.h"
+#include "spectrum.h"
+#include "prefetch.h"
+#include "dnscache.h"
+#include "titlelog.h"
+#include "ttfslog.h"
 
 Telnet telnet;
 
@@ -289,6 +298,99 @@ void Telnet::on_input(const char* str, uint8_t clientId) {
       player.sendCommand({PR_PLAY, config.lastStation()});
       goto show_prompt;
     }
+    #ifdef USE_SD
+    if (strcmp(str, "cli.rec") == 0 || strcmp(str, "rec") == 0) {
+      printf(clientId, "##CLI.REC#: %s, written: %u, dropped: %u, SD write: %u kB/s, max write: %u ms\r\n", recorder.isRecording()?"recording":"stopped",
+             recorder.bytesWritten(), recorder.bytesDropped(), recorder.writeRate(), recorder.maxWriteTime());
+      goto show_prompt;
+    }
+    if (strcmp(str, "cli.rec 1") == 0 || strcmp(str, "rec 1") == 0) {
+      if (!recorder.start()) printf(clientId, "##CLI.REC#: can't start recording\r\n");
+      goto show_prompt;
+    }
+    if (strcmp(str, "cli.rec 0") == 0 || strcmp(str, "rec 0") == 0) {
+      recorder.stop();
+      goto show_prompt;
+    }
+    #endif
+    #if I2S_DOUT!=255 || I2S_INTERNAL
+    if (strcmp(str, "cli.spectrum") == 0 || strcmp(str, "spectrum") == 0) {
+      printf(clientId, "##CLI.SPECTRUM#: %s, %d bands, %d points, %d fps, FFT+bands: %u us\r\n", spectrum.running()?"running":"stopped",
+             spectrum.bands(), SPECTRUM_FFT_SIZE, SPECTRUM_FPS, spectrum.cost());
+      goto show_prompt;
+    }
+    #endif
+    #if (I2S_DOUT!=255 || I2S_INTERNAL) && PREFETCH_STATIONS>0
+    if (strcmp(str, "cli.prefetch") == 0 || strcmp(str, "prefetch") == 0) {
+      static const char *states[] = { "idle", "connecting", "header", "warm", "in use", "failed", "expired" };
+      printf(clientId, "##CLI.PREFETCH#: hits: %u, misses: %u\r\n", prefetch.hits(), prefetch.misses());
+      for (uint8_t i = 0; i < PREFETCH_SLOTS; i++) {
+        WarmClient *s = prefetch.slot(i);
+        if (s->state == PF_IDLE) continue;
+        printf(clientId, "##CLI.PREFETCH#: %s, %u bytes, %u s, %s\r\n", states[s->state], s->buffered(), (millis()-s->since)/1000, s->url);
+      }
+      goto show_prompt;
+    }
+    #endif
+    #if DNS_CACHE_SIZE>0
+    if (strcmp(str, "cli.dns") == 0 || strcmp(str, "dns") == 0) {
+      printf(clientId, "##CLI.DNS#: hits: %u, stale: %u, misses: %u, failures: %u, refreshes: %u\r\n", dnscache.hits(), dnscache.staleHits(),
+             dnscache.misses(), dnscache.failures(), dnscache.refreshes());
+      for (uint8_t i = 0; i < DNS_CACHE_SIZE; i++) {
+        const dnsEntry_t *e = dnscache.entry(i);
+        if (!e) continue;
+        int32_t left = (int32_t)(e->expires - millis()) / 1000;
+        printf(clientId, "##CLI.DNS#: %s, %s (%u), ttl: %d s, hits: %u\r\n", e->host, e->count ? IPAddress(e->ips[0]).toString().c_str() : "-",
+               e->count, left, e->hits);
+      }
+      goto show_prompt;
+    }
+    #endif
+    #if RELAY_MAX_CLIENTS>0
+    if (strcmp(str, "cli.relay") == 0 || strcmp(str, "relay") == 0) {
+      printf(clientId, "##CLI.RELAY#: %d client(s), %u B/s, %u dropped\r\n", relay.clients(), relay.rate(), relay.dropped());
+      for (uint8_t i = 0; i < RELAY_MAX_CLIENTS; i++) {
+        relayClient_t *c = relay.client(i);
+        if (!c) continue;
+        uint32_t lag = relay.lag(i);
+        printf(clientId, "##CLI.RELAY#: %s, %u s, sent: %u, lag: %u bytes (%u ms)\r\n", c->ip.toString().c_str(), (millis()-c->since)/1000,
+               c->sent, lag, config.station.bitrate ? lag * 8 / config.station.bitrate : 0);
+      }
+      goto show_prompt;
+    }
+    #endif
+    #if TITLE_HISTORY>0
+    if (strcmp(str, "cli.titles") == 0 || strcmp(str, "titles") == 0) {
+      titleEntry_t e;
+      for (uint8_t i = 0; titlelog.entry(i, e); i++) {
+        if (e.station != config.lastStation()) continue;
+        printf(clientId, "##CLI.TITLES#: %u s ago, %s\r\n", (millis()-e.up)/1000, e.title);
+      }
+      goto show_prompt;
+    }
+    #endif
+    #if TTFS_HISTORY>0
+    if (strcmp(str, "cli.ttfs") == 0 || strcmp(str, "ttfs") == 0) {
+      ttfsEntry_t e;
+      char line[160];
+      for (uint8_t i = 0; ttfslog.entry(config.lastStation(), i, e); i++) {
+        e.ttfs.format(line, sizeof(line));
+        printf(clientId, "##CLI.TTFS#: %u s ago, %s\r\n", (millis()-e.up)/1000, line);
+      }
+      goto show_prompt;
+    }
+    #endif
+    if (strcmp(str, "cli.ingest") == 0 || strcmp(str, "ingest") == 0) {   /* since the last call */
+      #if PLAYER_TASK
+        printf(clientId, "##CLI.INGEST#: player task, core %d, priority %d, stack left %u bytes\r\n", PLAYER_TASK_CORE_ID, PLAYER_TASK_PRIORITY,
+               player.task() ? uxTaskGetStackHighWaterMark(player.task()) : 0);
+      #else
+        printf(clientId, "##CLI.INGEST#: in loop()\r\n");
+      #endif
+      printf(clientId, "##CLI.INGEST#: longest gap %u ms, %u gaps over %u ms\r\n", player.ingestGapMax(), player.ingestGaps(), INGEST_GAP_MS);
+      player.ingestReset();
+      goto show_prompt;
+    }
     if (strcmp(str, "cli.vol") == 0 || strcmp(str, "vol") == 0) {
       printf(clientId, "##CLI.VOL#: %d\r\n", config.store.volume);
       goto show_prompt;
@@ -404,6 +506,20 @@ void Telnet::on_input(const char* str, uint8_t clientId) {
       printf(clientId, "new audioinfo value is: %d\r\n", config.store.audioinfo);
       goto show_prompt;
     }
+    #if I2S_DOUT!=255 || I2S_INTERNAL
+    if (strcmp(str, "cli.night") == 0 || strcmp(str, "night") == 0) {
+      uint16_t gr = player.getNightMode() ? player.getNightReduction() : 0;
+      printf(clientId, "##CLI.NIGHT#: %d, threshold %d dBFS, ratio %u:1, attack %u ms, release %u ms, makeup %u dB, reduction %u.%u dB\r\n",
+             config.store.nightmode, config.store.nightthr, config.store.nightratio, config.store.nightatk, config.store.nightrel, config.store.nightmakeup, gr / 10, gr % 10);
+      goto show_prompt;
+    }
+    int nmode;
+    if (sscanf(str, "night(%d)", &nmode) == 1 || sscanf(str, "cli.night(\"%d\")", &nmode) == 1 || sscanf(str, "night %d", &nmode) == 1) {
+      config.setNightMode(nmode != 0);
+      printf(clientId, "new night value is: %d\r\n", config.store.nightmode);
+      goto show_prompt;
+    }
+    #endif
     if (strcmp(str, "cli.smartstart") == 0 || strcmp(str, "smartstart") == 0) {
       printf(clientId, "##CLI.SMARTSTART#: %s\r\n", config.store.smartstart ? "true" : "false");
       goto show_prompt;
@@ -0,0 +1,96 @@
+#include "options.h"
+#if TITLE_HISTORY>0 // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+#include "config.h"
+#include "titlelog.h"
+
+TitleLog titlelog;
+
+bool TitleLog::_alloc() {
+  if (_e) return true;
+  if (!_lock) _lock = xSemaphoreCreateMutex();
+  if (!_lock) return false;
+  _size = TITLE_HISTORY;
+  if (psramFound()) _e = (titleEntry_t*)ps_malloc(_size * sizeof(titleEntry_t));
+  if (!_e) {
+    _size = TITLE_HISTORY_NOPSRAM;
+    _e = (titleEntry_t*)malloc(_size * sizeof(titleEntry_t));
+  }
+  if (!_e) _size = 0;
+  return _e!=NULL;
+}
+
+void TitleLog::add(uint16_t station, const char *title) {
+  if (!title[0] || !_alloc()) return;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  for (uint8_t i = 0; i < _count; i++) {          /* the station's last title, after a reconnect it comes again */
+    titleEntry_t &e = _e[(_head + _size - 1 - i) % _size];
+    if (e.station != station) continue;
+    if (strncmp(e.title, title, BUFLEN - 1) == 0) { xSemaphoreGive(_lock); return; }
+    break;
+  }
+  titleEntry_t &e = _e[_head];
+  time_t now = time(NULL);
+  e.station = station;
+  e.time = now > 1700000000 ? now : 0;
+  e.up = millis();
+  strlcpy(e.title, title, BUFLEN);
+  _head = (_head + 1) % _size;
+  if (_count < _size) _count++;
+  xSemaphoreGive(_lock);
+  _changed = true;
+}
+
+bool TitleLog::entry(uint8_t age, titleEntry_t &e) {
+  if (!_e) return false;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  bool ok = age < _count;
+  if (ok) e = _e[(_head + _size - 1 - age) % _size];
+  xSemaphoreGive(_lock);
+  return ok;
+}
+
+static void _escape(String &out, const char *s) {
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') out += '\\';
+    if ((uint8_t)*s >= 0x20) out += *s;
+  }
+}
+
+void TitleLog::json(uint16_t station, String &out) {
+  out = "{\"station\":";
+  out += station;
+  out += ",\"titles\":[";
+  if (_e) {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    uint32_t now = millis();
+    bool first = true;
+    for (uint8_t i = 0; i < _count; i++) {
+      titleEntry_t &e = _e[(_head + _size - 1 - i) % _size];
+      if (e.station != station) continue;
+      if (!first) out += ',';
+      first = false;
+      out += "{\"t\":";
+      out += (uint32_t)e.time;
+      out += ",\"ago\":";
+      out += (now - e.up) / 1000;
+      out += ",\"title\":\"";
+      _escape(out, e.title);
+      out += "\"}";
+    }
+    xSemaphoreGive(_lock);
+  }
+  out += "]}";
+}
+
+void TitleLog::handle(AsyncWebServerRequest *request) {
+  uint16_t station = config.lastStation();
+  if (request->hasParam("station")) station = request->getParam("station")->value().toInt();
+  String out;
+  json(station, out);
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", out);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+#endif // #if TITLE_HISTORY>0
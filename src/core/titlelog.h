@@ -0,0 +1,42 @@
+#ifndef titlelog_h
+#define titlelog_h
+#include "options.h"
+
+#if TITLE_HISTORY>0 // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+struct titleEntry_t
+{
+  uint16_t          station;    /* playlist index */
+  time_t            time;       /* 0 if the clock was not set yet */
+  uint32_t          up;         /* millis() */
+  char              title[BUFLEN];
+};
+
+/* Recent stream titles with the time they came, on http://<ip>/titles?station=N and MQTT <topic>titles.
+   add() is called from the audio task with every new title (the Audio library already drops the copies
+   repeated in each metadata block), a title equal to the station's last one is not added again. The ring
+   is shared by all stations, the oldest entry goes; json() lists the entries of one station, newest first. */
+class TitleLog {
+  public:
+    TitleLog() {};
+    void add(uint16_t station, const char *title);
+    void json(uint16_t station, String &out);     /* {"station":N,"titles":[{"t":epoch,"ago":s,"title":"..."}]} */
+    void handle(AsyncWebServerRequest *request);
+    bool changed() { bool c = _changed; _changed = false; return c; }   /* added to since the last call */
+    bool entry(uint8_t age, titleEntry_t &e);    /* copied out, 0 = newest, false past the oldest */
+  private:
+    titleEntry_t *_e = NULL;
+    uint8_t _size = 0, _head = 0, _count = 0;
+    SemaphoreHandle_t _lock = NULL;
+    volatile bool _changed = false;
+
+    bool _alloc();
+};
+
+extern TitleLog titlelog;
+
+#endif // #if TITLE_HISTORY>0
+
+#endif
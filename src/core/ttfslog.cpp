@@ -0,0 +1,88 @@
+#include "options.h"
+#if TTFS_HISTORY>0 // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+#include "config.h"
+#include "ttfslog.h"
+
+TtfsLog ttfslog;
+
+void TtfsLog::add(uint16_t station, const Ttfs &t) {
+  if (!_lock) _lock = xSemaphoreCreateMutex();
+  if (!_lock) return;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  uint8_t count = 0, slot = 0, own = 0;
+  for (uint8_t i = 0; i < TTFS_HISTORY; i++) {
+    if (_e[i].seq < _e[slot].seq) slot = i;                   /* a free one or the oldest of all */
+    if (_e[i].seq && _e[i].station == station) {
+      if (!count || _e[i].seq < _e[own].seq) own = i;
+      count++;
+    }
+  }
+  if (count >= TTFS_PER_STATION) slot = own;
+  ttfsEntry_t &e = _e[slot];
+  time_t now = time(NULL);
+  e.station = station;
+  e.time = now > 1700000000 ? now : 0;
+  e.up = millis();
+  e.seq = ++_seq;
+  e.ttfs = t;
+  xSemaphoreGive(_lock);
+}
+
+int16_t TtfsLog::_find(uint16_t station, uint8_t age) {
+  /* the age-th newest entry of the station, under the lock */
+  uint32_t below = UINT32_MAX;
+  int16_t found = -1;
+  for (uint8_t a = 0; a <= age; a++) {
+    found = -1;
+    for (uint8_t i = 0; i < TTFS_HISTORY; i++) {
+      if (!_e[i].seq || _e[i].station != station || _e[i].seq >= below) continue;
+      if (found < 0 || _e[i].seq > _e[found].seq) found = i;
+    }
+    if (found < 0) return -1;
+    below = _e[found].seq;
+  }
+  return found;
+}
+
+bool TtfsLog::entry(uint16_t station, uint8_t age, ttfsEntry_t &e) {
+  if (!_lock) return false;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  int16_t i = _find(station, age);
+  if (i >= 0) e = _e[i];
+  xSemaphoreGive(_lock);
+  return i >= 0;
+}
+
+void TtfsLog::json(uint16_t station, String &out) {
+  out = "{\"station\":";
+  out += station;
+  out += ",\"tunes\":[";
+  ttfsEntry_t e;
+  char buf[200];
+  uint32_t now = millis();
+  for (uint8_t age = 0; entry(station, age, e); age++) {
+    if (age) out += ',';
+    out += "{\"t\":";
+    out += (uint32_t)e.time;
+    out += ",\"ago\":";
+    out += (now - e.up) / 1000;
+    e.ttfs.json(buf, sizeof(buf));
+    out += ',';
+    out += buf;
+    out += '}';
+  }
+  out += "]}";
+}
+
+void TtfsLog::handle(AsyncWebServerRequest *request) {
+  uint16_t station = config.lastStation();
+  if (request->hasParam("station")) station = request->getParam("station")->value().toInt();
+  String out;
+  json(station, out);
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", out);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+#endif // #if TTFS_HISTORY>0
@@ -0,0 +1,42 @@
+#ifndef ttfslog_h
+#define ttfslog_h
+#include "options.h"
+
+#if TTFS_HISTORY>0 // ============================== Everything ignored if not defined ==============================
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "../libraries/I2S_Audio/ttfs.h"
+
+struct ttfsEntry_t
+{
+  uint16_t          station;    /* playlist index */
+  time_t            time;       /* 0 if the clock was not set yet */
+  uint32_t          up;         /* millis() */
+  uint32_t          seq;        /* 0 = free */
+  Ttfs              ttfs;
+};
+
+/* Time to first sound of the last tunes, phase by phase, on http://<ip>/ttfs?station=N, telnet "ttfs" and MQTT
+   <topic>ttfs. Player begins a Ttfs with each play request, the audio library marks the phases and hands it to add()
+   with the first write to the output. TTFS_HISTORY tunes are kept over all stations, TTFS_PER_STATION of one: a
+   station at its limit loses its own oldest, otherwise the oldest of all goes. */
+class TtfsLog {
+  public:
+    TtfsLog() {};
+    void add(uint16_t station, const Ttfs &t);
+    void json(uint16_t station, String &out);     /* {"station":N,"tunes":[{"t":epoch,"ago":s,"ms":total,"queue":ms,...}]} */
+    void handle(AsyncWebServerRequest *request);
+    bool entry(uint16_t station, uint8_t age, ttfsEntry_t &e);   /* copied out, 0 = newest, false past the oldest */
+  private:
+    ttfsEntry_t _e[TTFS_HISTORY] = {};
+    uint32_t _seq = 0;
+    SemaphoreHandle_t _lock = NULL;
+
+    int16_t _find(uint16_t station, uint8_t age);
+};
+
+extern TtfsLog ttfslog;
+
+#endif // #if TTFS_HISTORY>0
+
+#endif
@@ -57,6 +57,9 @@ const BitrateConfig fullbitrateConf PROGMEM = {{DSP_WIDTH-TFT_FRAMEWDT-21, 25, 1
 
 /* BANDS  */                             /* { onebandwidth, onebandheight, bandsHspace, bandsVspace, numofbands, fadespeed } */
 const VUBandsConfig bandsConf     PROGMEM = { 19, 90, 2, 2, 10, 2 };
+/* SPECTRUM  */                          /* { width, height, numofbands, bandsHspace, fadespeed } */
+#define SPECTRUM_CONF
+const SpectrumConfig spectrumConf PROGMEM = { 40, 90, 16, 1, 6 };
 /* STRINGS  */
 const char         numtxtFmt[]    PROGMEM = "%d";
 const char           rssiFmt[]    PROGMEM = "WiFi %d";
@@ -56,6 +56,9 @@ const BitrateConfig fullbitrateConf PROGMEM = {{DSP_WIDTH-TFT_FRAMEWDT-34, 43, 2
 
 /* BANDS  */                             /* { onebandwidth, onebandheight, bandsHspace, bandsVspace, numofbands, fadespeed } */
 const VUBandsConfig bandsConf     PROGMEM = { 24, 100, 4, 2, 10, 2 };
+/* SPECTRUM  */                          /* { width, height, numofbands, bandsHspace, fadespeed } */
+#define SPECTRUM_CONF
+const SpectrumConfig spectrumConf PROGMEM = { 52, 100, 16, 1, 6 };
 
 /* STRINGS  */
 const char * const         numtxtFmt    PROGMEM = "%d";
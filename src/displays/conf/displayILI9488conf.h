@@ -60,6 +60,9 @@ const BitrateConfig fullbitrateConf PROGMEM = {{DSP_WIDTH-TFT_FRAMEWDT-38, 59, 2
 
 /* BANDS  */                             /* { onebandwidth, onebandheight, bandsHspace, bandsVspace, numofbands, fadespeed } */
 const VUBandsConfig bandsConf     PROGMEM = { 32, 130, 4, 2, 10, 3 };
+/* SPECTRUM  */                          /* { width, height, numofbands, bandsHspace, fadespeed } */
+#define SPECTRUM_CONF
+const SpectrumConfig spectrumConf PROGMEM = { 68, 130, 16, 1, 8 };
 
 /* STRINGS  */
 const char         numtxtFmt[]    PROGMEM = "%d";
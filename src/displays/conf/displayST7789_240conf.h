@@ -51,6 +51,9 @@ const ProgressConfig bootPrgConf  PROGMEM = { 90, 14, 4 };
 
 /* BANDS  */                             /* { onebandwidth, onebandheight, bandsHspace, bandsVspace, numofbands, fadespeed } */
 const VUBandsConfig bandsConf     PROGMEM = { 100, 20, 10, 2, 10, 5 };
+/* SPECTRUM  */                          /* { width, height, numofbands, bandsHspace, fadespeed } */
+#define SPECTRUM_CONF
+const SpectrumConfig spectrumConf PROGMEM = { 210, 20, 32, 2, 2 };
 
 /* STRINGS  */
 const char         numtxtFmt[]    PROGMEM = "%d";
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include "widgets.h"
 #include "../../core/player.h"    //  for VU widget
+#include "../../core/spectrum.h"  //  for Spectrum widget
 #include "../../core/network.h"   //  for Clock widget
 #include "../../core/config.h"
 #include "../tools/l10n.h"
@@ -482,6 +483,79 @@ void VuWidget::loop(){ }
 void VuWidget::_clear(){ }
 #endif
 
+/************************
+      SPECTRUM WIDGET
+ ************************/
+#if !defined(DSP_LCD) && !defined(DSP_OLED) && (I2S_DOUT!=255 || I2S_INTERNAL)
+SpectrumWidget::~SpectrumWidget() {
+  spectrum.stop();
+  if(_canvas) free(_canvas);
+  free(_meas);
+}
+
+void SpectrumWidget::init(WidgetConfig wconf, SpectrumConfig bands, uint16_t vumaxcolor, uint16_t vumincolor, uint16_t bgcolor) {
+  Widget::init(wconf, bgcolor, bgcolor);
+  _vumaxcolor = vumaxcolor;
+  _vumincolor = vumincolor;
+  _bands = bands;
+  if(_bands.bands > SPECTRUM_MAX_BANDS) _bands.bands = SPECTRUM_MAX_BANDS;
+  _canvas = new Canvas(_bands.width, _bands.height);
+  _meas = (uint8_t *)calloc(_bands.bands, 1);
+}
+
+void SpectrumWidget::_draw(){
+  if(!_active || _locked) return;
+  /* the FFT task only runs while the widget is on screen */
+  if(!spectrum.running()) spectrum.start(_bands.bands);
+  uint16_t barw = (_bands.width - _bands.space * (_bands.bands - 1)) / _bands.bands;
+  if(barw == 0) barw = 1;
+  uint16_t left = (_bands.width - (barw + _bands.space) * _bands.bands + _bands.space) / 2;
+  uint16_t hot = _bands.height / 4;
+  uint16_t fade = (uint16_t)_bands.fadespeed * 255 / _bands.height + 1;
+  bool played = player.isRunning();
+  _canvas->fillRect(0, 0, _bands.width, _bands.height, _bgcolor);
+  for(uint8_t i=0; i<_bands.bands; i++){
+    uint8_t lvl = played?spectrum.level(i):0;
+    _meas[i] = (lvl >= _meas[i])?lvl:(_meas[i] > fade?_meas[i] - fade:0);
+    uint16_t h = (uint32_t)_meas[i] * _bands.height / 255;
+    if(h == 0) continue;
+    uint16_t x = left + i * (barw + _bands.space);
+    _canvas->fillRect(x, _bands.height - h, barw, h, _vumincolor);
+    if(h > _bands.height - hot) _canvas->fillRect(x, _bands.height - h, barw, h - (_bands.height - hot), _vumaxcolor);
+  }
+  #if DSP_MODEL!=DSP_ILI9225
+    dsp.startWrite();
+    dsp.setAddrWindow(_config.left, _config.top, _bands.width, _bands.height);
+    dsp.writePixels((uint16_t*)_canvas->getBuffer(), _bands.width * _bands.height);
+    dsp.endWrite();
+  #else
+    dsp.drawRGBBitmap(_config.left, _config.top, _canvas->getBuffer(), _bands.width, _bands.height);
+  #endif
+}
+
+void SpectrumWidget::loop(){
+  if(_active || !_locked) _draw();
+}
+
+void SpectrumWidget::_clear(){
+  dsp.fillRect(_config.left, _config.top, _bands.width, _bands.height, _bgcolor);
+}
+
+void SpectrumWidget::_reset(){
+  spectrum.stop();
+  memset(_meas, 0, _bands.bands);
+}
+#else // DSP_LCD
+SpectrumWidget::~SpectrumWidget() { }
+void SpectrumWidget::init(WidgetConfig wconf, SpectrumConfig bands, uint16_t vumaxcolor, uint16_t vumincolor, uint16_t bgcolor) {
+  Widget::init(wconf, bgcolor, bgcolor);
+}
+void SpectrumWidget::_draw(){ }
+void SpectrumWidget::loop(){ }
+void SpectrumWidget::_clear(){ }
+void SpectrumWidget::_reset(){ }
+#endif
+
 /************************
       NUM & CLOCK
  ************************/
@@ -169,6 +169,27 @@ class VuWidget: public Widget {
     void _clear();
 };
 
+class SpectrumWidget: public Widget {
+  public:
+    SpectrumWidget() {}
+    SpectrumWidget(WidgetConfig wconf, SpectrumConfig bands, uint16_t vumaxcolor, uint16_t vumincolor, uint16_t bgcolor)
+            { init(wconf, bands, vumaxcolor, vumincolor, bgcolor); }
+    ~SpectrumWidget();
+    using Widget::init;
+    void init(WidgetConfig wconf, SpectrumConfig bands, uint16_t vumaxcolor, uint16_t vumincolor, uint16_t bgcolor);
+    void loop();
+  protected:
+    #if !defined(DSP_LCD) && !defined(DSP_OLED)
+      Canvas *_canvas;
+    #endif
+    SpectrumConfig _bands;
+    uint16_t _vumaxcolor, _vumincolor;
+    uint8_t *_meas;
+    void _draw();
+    void _clear();
+    void _reset();
+};
+
 class NumWidget: public TextWidget {
   public:
     using Widget::init;
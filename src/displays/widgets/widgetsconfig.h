@@ -43,6 +43,14 @@ struct VUBandsConfig {
   uint8_t  fadespeed;
 };
 
+struct SpectrumConfig {
+  uint16_t width;
+  uint16_t height;
+  uint8_t  bands;
+  uint8_t  space;
+  uint8_t  fadespeed;
+};
+
 struct MoveConfig {
   uint16_t x;
   uint16_t y;
@@ -141,6 +141,7 @@ void AudioBuffer::bytesWritten(size_t bw) {
     if(m_writePtr == m_endPtr) { m_writePtr = m_buffer; }
     if(m_writePtr > m_endPtr) log_e("m_writePtr %i, m_endPtr %i", m_writePtr, m_endPtr);
     m_f_isEmpty = false;
+    if(m_histLength > freeSpace()) m_histLength = m_freeSpace; // the oldest history bytes are overwritten now
 }
 
 void AudioBuffer::bytesWasRead(size_t br) {
@@ -151,6 +152,18 @@ void AudioBuffer::bytesWasRead(size_t br) {
         m_readPtr = m_buffer + tmp;
     }
     if(m_readPtr == m_writePtr) m_f_isEmpty = true;
+    m_histLength += br;
+    if(m_histLength > freeSpace()) m_histLength = m_freeSpace;
+}
+
+size_t AudioBuffer::rewind(size_t br) {
+    if(br > m_histLength) br = m_histLength;
+    if(!br) return 0;
+    if((size_t)(m_readPtr - m_buffer) >= br) m_readPtr -= br;
+    else m_readPtr = m_endPtr - (br - (m_readPtr - m_buffer));
+    m_histLength -= br;
+    m_f_isEmpty = false;
+    return br;
 }
 
 uint8_t* AudioBuffer::getWritePtr() { return m_writePtr; }
@@ -167,6 +180,7 @@ void AudioBuffer::resetBuffer() {
     m_writePtr = m_buffer;
     m_readPtr = m_buffer;
     m_endPtr = m_buffer + m_buffSize;
+    m_histLength = 0;
     m_f_isEmpty = true;
 }
 
@@ -180,6 +194,7 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLO
 
     mutex_playAudioData = xSemaphoreCreateMutex();
     mutex_audioTask     = xSemaphoreCreateMutex();
+    mutex_file          = xSemaphoreCreateMutex();
 
     m_chbufSize = 512 + 64;
     m_ibuffSize = 512 + 64;
@@ -188,6 +203,20 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLO
     m_ibuff    = (char*) malloc(m_ibuffSize);
     m_lastHost = (char*) malloc(2048);
     m_outBuff  = (int16_t*)malloc(m_outbuffSize * sizeof(int16_t));
+
+    m_prebuf.setLimits(PREBUFFER_MIN_MS, PREBUFFER_MAX_MS, PREBUFFER_STABLE_S * 1000);
+    m_pbStartMs  = PREBUFFER_START_MS;
+    m_pbResumeMs = PREBUFFER_RESUME_MS;
+    m_reconn.setLimits(RECONNECT_MIN_MS, RECONNECT_MAX_MS, RECONNECT_GIVEUP_S * 1000);
+    m_reconnStallMs  = RECONNECT_STALL_MS;
+    m_reconnStableMs = RECONNECT_STABLE_S * 1000;
+    m_watch.setup(WATCH_SILENCE_DB, WATCH_SILENCE_S, WATCH_FROZEN_S, WATCH_STUCK_S, WATCH_STARVED_PCT, WATCH_STARVED_S);
+    m_dmaTune.setLimits(I2S_DMA_MIN_MS, I2S_DMA_MAX_MS, I2S_DMA_STABLE_S * 1000);
+    m_dmaTune.setStart(I2S_DMA_START_MS);
+    m_comp.setLimiter(NIGHT_CEILING, NIGHT_LOOKAHEAD_MS);
+#if HLS_BUFFER_SIZE>0
+    m_hls.setResolver(audio_resolve);
+#endif
     if(!m_chbuf || !m_outBuff || !m_ibuff) log_e("oom");
 
 #ifdef AUDIO_LOG
@@ -207,6 +236,12 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLO
     m_i2s_chan_cfg.role          = I2S_ROLE_MASTER;        // I2S controller master role, bclk and lrc signal will be set to output
     m_i2s_chan_cfg.dma_desc_num  = 32;                     // number of DMA buffer
     m_i2s_chan_cfg.dma_frame_num = 256;                // I2S frame number in one DMA buffer.
+    if(I2S_DMA_TUNE) {
+        uint16_t desc = 0, frames = 0;
+        m_dmaTune.size(44100, desc, frames);
+        m_i2s_chan_cfg.dma_desc_num  = desc;
+        m_i2s_chan_cfg.dma_frame_num = frames;
+    }
     m_i2s_chan_cfg.auto_clear    = true;                   // i2s will always send zero automatically if no data to send
     i2s_new_channel(&m_i2s_chan_cfg, &m_i2s_tx_handle, NULL);
 
@@ -223,8 +258,10 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLO
     m_i2s_std_cfg.clk_cfg.clk_src        = I2S_CLK_SRC_DEFAULT;        // Select PLL_F160M as the default source clock
     m_i2s_std_cfg.clk_cfg.mclk_multiple  = I2S_MCLK_MULTIPLE_512;      // mclk = sample_rate * 256
     i2s_channel_init_std_mode(m_i2s_tx_handle, &m_i2s_std_cfg);
+    I2Scallbacks();
     I2Sstart(m_i2s_num);
     m_sampleRate = 44100;
+    m_dmaTune.begin(44100, m_i2s_chan_cfg.dma_desc_num, m_i2s_chan_cfg.dma_frame_num);
 
     if (internalDAC)  {
         #ifdef CONFIG_IDF_TARGET_ESP32  // ESP32S3 has no DAC
@@ -239,6 +276,12 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLO
     m_i2s_config.intr_alloc_flags     = ESP_INTR_FLAG_LEVEL1; // interrupt priority
     m_i2s_config.dma_buf_count        = 16;
     m_i2s_config.dma_buf_len          = 512;
+    if(I2S_DMA_TUNE) {
+        uint16_t desc = 0, frames = 0;
+        m_dmaTune.size(44100, desc, frames);
+        m_i2s_config.dma_buf_count    = desc;
+        m_i2s_config.dma_buf_len      = frames;
+    }
     m_i2s_config.use_apll             = APLL_DISABLE; // must be disabled in V2.0.1-RC1
     m_i2s_config.tx_desc_auto_clear   = true;   // new in V1.0.1
     m_i2s_config.fixed_mclk           = true;
@@ -249,7 +292,7 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLO
         printf("internal DAC");
         m_i2s_config.mode             = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN );
         m_i2s_config.communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_STAND_MSB); // vers >= 2.0.5
-        i2s_driver_install((i2s_port_t)m_i2s_num, &m_i2s_config, 0, NULL);
+        I2Sinstall();
         i2s_set_dac_mode((i2s_dac_mode_t)m_f_channelEnabled);
         if(m_f_channelEnabled != I2S_DAC_CHANNEL_BOTH_EN) {
             m_f_forceMono = true;
@@ -259,10 +302,11 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLO
     else {
         m_i2s_config.mode             = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX);
         m_i2s_config.communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_STAND_I2S); // Arduino vers. > 2.0.0
-        i2s_driver_install((i2s_port_t)m_i2s_num, &m_i2s_config, 0, NULL);
+        I2Sinstall();
         m_f_forceMono = false;
     }
     i2s_zero_dma_buffer((i2s_port_t) m_i2s_num);
+    m_dmaTune.begin(44100, m_i2s_config.dma_buf_count, m_i2s_config.dma_buf_len);
 
 #endif // ESP_IDF_VERSION_MAJOR == 5
     for(int i = 0; i < 3; i++) {
@@ -298,8 +342,11 @@ Audio::~Audio() {
     x_ps_free(&m_speechtxt);
 
     stopAudioTask();
+    readAheadStop(true);
+    if(m_raTask) vTaskDelete(m_raTask);
     vSemaphoreDelete(mutex_playAudioData);
     vSemaphoreDelete(mutex_audioTask);
+    vSemaphoreDelete(mutex_file);
 }
 // clang-format on
 //****************************************************************************************
@@ -313,6 +360,7 @@ void Audio::initInBuff() {
 //--------------------------------------------------------------------------------------------------------------------------------------------------
 esp_err_t Audio::I2Sstart(uint8_t i2s_num) {
 #if ESP_IDF_VERSION_MAJOR == 5
+    if(!m_i2s_tx_handle) return ESP_ERR_INVALID_STATE;
     return i2s_channel_enable(m_i2s_tx_handle);
 #else
     // It is not necessary to call this function after i2s_driver_install() (it is started automatically),
@@ -323,11 +371,107 @@ esp_err_t Audio::I2Sstart(uint8_t i2s_num) {
 
 esp_err_t Audio::I2Sstop(uint8_t i2s_num) {
 #if ESP_IDF_VERSION_MAJOR == 5
+    if(!m_i2s_tx_handle) return ESP_ERR_INVALID_STATE;
     return i2s_channel_disable(m_i2s_tx_handle);
 #else
     return i2s_stop((i2s_port_t)i2s_num);
 #endif
 }
+
+#if ESP_IDF_VERSION_MAJOR == 5
+void Audio::I2Scallbacks() {
+    // sent descriptors and underruns for the DMA queue level, registered before the channel is enabled
+    i2s_event_callbacks_t cbs = {};
+    cbs.on_sent       = i2sSent;
+    cbs.on_send_q_ovf = i2sUnderrun;
+    i2s_channel_register_event_callback(m_i2s_tx_handle, &cbs, this);
+}
+
+bool IRAM_ATTR Audio::i2sSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    Audio* a = (Audio*)user_ctx;
+    a->m_dmaSent = a->m_dmaSent + event->size / 4;
+    return false;
+}
+
+bool IRAM_ATTR Audio::i2sUnderrun(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    Audio* a = (Audio*)user_ctx;
+    a->m_dmaUnder = a->m_dmaUnder + 1;
+    return false;
+}
+#else
+esp_err_t Audio::I2Sinstall() {
+    // with an event queue for the DMA queue level, drained in I2Slevel()
+    return i2s_driver_install((i2s_port_t)m_i2s_num, &m_i2s_config, m_i2s_config.dma_buf_count * 2, &m_i2sEvents);
+}
+#endif
+
+bool Audio::I2Sresize(uint16_t desc, uint16_t frames) {
+    // a new DMA queue while the channel is stopped, what was queued is dropped; false keeps the old size
+#if ESP_IDF_VERSION_MAJOR == 5
+    uint16_t oldDesc = m_i2s_chan_cfg.dma_desc_num, oldFrames = m_i2s_chan_cfg.dma_frame_num;
+#else
+    uint16_t oldDesc = m_i2s_config.dma_buf_count, oldFrames = m_i2s_config.dma_buf_len;
+#endif
+    uint32_t was = (uint32_t)oldDesc * oldFrames * 4, want = (uint32_t)desc * frames * 4;
+    if(want > was && heap_caps_get_free_size(MALLOC_CAP_DMA) < want - was + I2S_DMA_MIN_HEAP) {  // DMA buffers are internal RAM
+        AUDIO_INFO("I2S DMA %u x %u frames does not fit, kept %u x %u", desc, frames, oldDesc, oldFrames);
+        return false;
+    }
+    bool ok = false;
+#if ESP_IDF_VERSION_MAJOR == 5
+    if(m_i2s_tx_handle) i2s_del_channel(m_i2s_tx_handle);
+    m_i2s_tx_handle = NULL;
+#else
+    if(!m_f_i2sLost) i2s_driver_uninstall((i2s_port_t)m_i2s_num);
+    m_i2sEvents = NULL;                                               // deleted with the driver
+#endif
+    for(uint8_t i = 0; i < 2 && !ok; i++) {
+        if(i) {
+            log_e("I2S DMA %u x %u frames failed, back to %u x %u", desc, frames, oldDesc, oldFrames);
+            desc = oldDesc; frames = oldFrames;
+        }
+#if ESP_IDF_VERSION_MAJOR == 5
+        m_i2s_chan_cfg.dma_desc_num  = desc;
+        m_i2s_chan_cfg.dma_frame_num = frames;
+        ok = i2s_new_channel(&m_i2s_chan_cfg, &m_i2s_tx_handle, NULL) == ESP_OK;
+        if(ok && i2s_channel_init_std_mode(m_i2s_tx_handle, &m_i2s_std_cfg) != ESP_OK) { i2s_del_channel(m_i2s_tx_handle); ok = false; }
+        if(!ok) m_i2s_tx_handle = NULL;
+        if(ok) I2Scallbacks();
+#else
+        m_i2s_config.dma_buf_count = desc;
+        m_i2s_config.dma_buf_len   = frames;
+        ok = I2Sinstall() == ESP_OK;
+#endif
+    }
+    m_f_i2sLost = !ok;                                                // no channel, reconfigI2S tries again
+    if(!ok) { log_e("I2S channel lost"); return false; }
+#if ESP_IDF_VERSION_MAJOR != 5
+    if(m_f_internalDAC) {
+        i2s_set_pin((i2s_port_t)m_i2s_num, NULL);
+        #ifdef CONFIG_IDF_TARGET_ESP32
+        i2s_set_dac_mode((i2s_dac_mode_t)m_f_channelEnabled);
+        #endif
+    }
+    else i2s_set_pin((i2s_port_t)m_i2s_num, &m_pin_config);
+#endif
+    if(desc == oldDesc && frames == oldFrames) return false;
+    AUDIO_INFO("I2S DMA %u x %u frames", desc, frames);
+    return true;
+}
+
+void Audio::I2Slevel() {
+    // frames queued for the DMA: written - sent, below 0 it ran dry and sent silence
+#if ESP_IDF_VERSION_MAJOR != 5
+    i2s_event_t ev;
+    while(m_i2sEvents && xQueueReceive(m_i2sEvents, &ev, 0) == pdTRUE) {
+        if(ev.type == I2S_EVENT_TX_DONE) m_dmaSent = m_dmaSent + ev.size / 4;
+        else if(ev.type == I2S_EVENT_TX_Q_OVF) m_dmaUnder = m_dmaUnder + 1;
+    }
+#endif
+    uint32_t sent = m_dmaSent;
+    if((int32_t)(m_dmaWritten - sent) < 0) m_dmaWritten = sent;
+    m_dmaTune.level(m_dmaWritten - sent, m_dmaUnder, millis());
+}
 //---------------------------------------------------------------------------------------------------------------------
 esp_err_t Audio::i2s_mclk_pin_select(const uint8_t pin) {
     // IDF >= 4.4 use setPinout(BCLK, LRC, DOUT, DIN, MCK) only, i2s_mclk_pin_select() is no longer needed
@@ -372,20 +516,24 @@ void Audio::setDefaults() {
     x_ps_free(&m_playlistBuff);
     vector_clear_and_shrink(m_playlistURL);
     vector_clear_and_shrink(m_playlistContent);
-    m_hashQueue.clear();
-    m_hashQueue.shrink_to_fit(); 			// uint32_t vector
+    vector_clear_and_shrink(m_mirrorURL);
+    if(_client && _client != &client && _client != static_cast<WiFiClient*>(&clientsecure)) _client->stop(); // warm connection
     client.stop();
 //    client.clear(); 					// delete all leftovers in the receive buffer
     clientsecure.stop();
 //    clientsecure.clear(); 				// delete all leftovers in the receive buffer
     _client = static_cast<WiFiClient*>(&client); /* default to *something* so that no NULL deref can happen */
-    ts_parsePacket(0, 0, 0); 				// reset ts routine
+    m_ts.reset(); 						// reset ts routine
+    x_ps_free(&m_tsBuf);
+    x_ps_free(&m_m3u8Arena);
+    m_m3u8.begin(NULL, 0);
     x_ps_free(&m_lastM3U8host);
     x_ps_free(&m_speechtxt);
 
     AUDIO_INFO("buffers freed, free Heap: %lu bytes", (long unsigned int)ESP.getFreeHeap());
 
     m_f_timeout = false;
+    m_rhlT0 = 0; 				// no response header in progress
     m_f_chunked = false; 			// Assume not chunked
     m_f_firstmetabyte = false;
     m_f_playing = false;
@@ -411,6 +559,8 @@ void Audio::setDefaults() {
     m_f_ID3v1TagFound = false;
     m_f_lockInBuffer = false;
     m_f_acceptRanges = false;
+    m_f_tsPaused = false;
+    m_f_prebuffering = false;
 
     m_streamType = ST_NONE;
     m_codec = CODEC_NONE;
@@ -424,14 +574,13 @@ void Audio::setDefaults() {
     m_bitRate = 0; 				// Bitrate still unknown
     h_bitRate = 0; 				// Bitrate from header still unknown
     m_bytesNotDecoded = 0; 			// counts all not decodable bytes
-    m_chunkcount = 0;      			// for chunked streams
     m_contentlength = 0; 			// If Content-Length is known, count it
     m_curSample = 0;
     m_metaint = 0; 				// No metaint yet
     m_LFcount = 0; 				// For end of header detection
     m_controlCounter = 0; 			// Status within readID3data() and readWaveHeader()
     m_channels = 2; 				// assume stereo #209
-    m_streamTitleHash = 0;
+    m_icy.reset();
     m_fileSize = 0;
     m_ID3Size = 0;
     m_haveNewFilePos = 0;
@@ -604,8 +753,12 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
     char*    rqh           = NULL;  // request header
     char*    toEncode      = NULL;  // temporary memory for base64 encoding
     char*    h_host        = NULL;
+    WiFiClient* warm       = NULL;  // prefetched connection
+    std::vector<char*> urls;        // race candidates
 
     xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    m_pbT0 = millis();
+    m_ttfs.mark(Ttfs::CALL, m_pbT0);
 
     // optional basic authorization
     if(user && pwd) authLen = strlen(user) + strlen(pwd);
@@ -643,12 +796,21 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
 	    if(isalpha(host[pos_colon + 1])) pos_colon = -1; 		// no portnumber follows
     pos_ampersand = indexOf(h_host, "&", 10); 				// position of "&" in hostname
 
+    // race candidates: this url and the playlist mirrors (setDefaults() clears those), resolved and raced by loop()
+    m_mirrorURL.swap(urls);
+    if(startsWith(h_host, "http")) urls.insert(urls.begin(), x_ps_strdup(h_host));
+    else {
+        urls.insert(urls.begin(), x_ps_malloc(lenHost + 8));
+        if(urls[0]) sprintf(urls[0], "http://%s", h_host + (hostwoext_begin == 4 ? 4 : 0));
+    }
+
     if(pos_slash > 0) h_host[pos_slash] = '\0';
     if((pos_colon > 0) && ((pos_ampersand == -1) || (pos_ampersand > pos_colon))) {
         port = atoi(c_host + pos_colon + 1);  				// Get portnumber as integer
         h_host[pos_colon] = '\0'; 							// Host without portnumber
     }
     setDefaults();
+    m_connPending.swap(urls);
     rqh = x_ps_calloc(lenHost + strlen(authorization) + 330, 1); // http request header
     if(!rqh) {AUDIO_INFO("out of memory"); stopSong(); goto exit;}
 
@@ -668,14 +830,24 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
                        strcat(rqh, "Accept-Encoding: identity;q=1,*;q=0\r\n");
                        strcat(rqh, "Connection: keep-alive\r\n\r\n");
 
-    if(m_f_ssl) { _client = static_cast<WiFiClient*>(&clientsecure);}
-    else        { _client = static_cast<WiFiClient*>(&client); }
-
     timestamp = millis();
-    _client->setTimeout(m_f_ssl ? m_timeout_ms_ssl : m_timeout_ms);
-
-    AUDIO_INFO("connect to: \"%s\" on port %d path \"/%s\"", h_host + hostwoext_begin, port, h_host + pos_slash + 1);
-    res = _client->connect(h_host + hostwoext_begin, port);
+    m_connRequest = rqh;                                    // kept for a reconnect
+    rqh = NULL;
+    m_connKey = ConnRace::hash(c_host);
+    m_connStart = timestamp;
+    warm = audio_warm_client ? audio_warm_client(host) : NULL;
+    if(warm) {
+        AUDIO_INFO("connect to: \"%s\" on port %d path \"/%s\" (warm)", h_host + hostwoext_begin, port, h_host + pos_slash + 1);
+        _client = warm;
+        _client->setTimeout(m_f_ssl ? m_timeout_ms_ssl : m_timeout_ms);
+        vector_clear_and_shrink(m_connPending);
+        res = true;
+    }
+    else {                                                  // resolve, connect, TLS and request are done by connectLoop()
+        AUDIO_INFO("connect to: \"%s\" on port %d path \"/%s\"", h_host + hostwoext_begin, port, h_host + pos_slash + 1);
+        connectPhase(CONN_RESOLVE);
+        res = true;
+    }
 
     if(pos_slash > 0) h_host[pos_slash] = '/';
     if(pos_colon > 0) h_host[pos_colon] = ':';
@@ -684,12 +856,11 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
     m_expectedPlsFmt = FORMAT_NONE;
 
     if(res) {
-        uint32_t dt = millis() - timestamp;
         x_ps_free(&m_lastHost);
-        m_lastHost = x_ps_strdup(c_host);
-        AUDIO_INFO("%s has been established in %lu ms, free Heap: %lu bytes", m_f_ssl ? "SSL" : "Connection", (long unsigned int)dt, (long unsigned int)ESP.getFreeHeap());
+        m_lastHost = x_ps_strdup(c_host);                  // the winning mirror once connected
+        if(warm) AUDIO_INFO("%s has been established in %lu ms, free Heap: %lu bytes", m_f_ssl ? "SSL" : "Connection",
+                            (long unsigned int)(millis() - timestamp), (long unsigned int)ESP.getFreeHeap());
         m_f_running = true;
-        _client->print(rqh);
         if(endsWith(h_host, ".mp3" )) m_expectedCodec  = CODEC_MP3;
         if(endsWith(h_host, ".aac" )) m_expectedCodec  = CODEC_AAC;
         if(endsWith(h_host, ".aacp" )) m_expectedCodec  = CODEC_AAC;
@@ -709,7 +880,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
             m_expectedPlsFmt = FORMAT_M3U8;
             if(audio_lasthost) audio_lasthost(m_lastHost);
         }
-        m_dataMode = HTTP_RESPONSE_HEADER; 				// Handle header
+        m_dataMode = warm ? HTTP_RESPONSE_HEADER : AUDIO_CONNECTING; 	// Handle header
         m_streamType = ST_WEBSTREAM;
     }
     else {
@@ -723,6 +894,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
 
 exit:
     xSemaphoreGiveRecursive(mutex_playAudioData);
+    vector_clear_and_shrink(urls);
     x_ps_free(&c_host);
     x_ps_free(&h_host);
     x_ps_free(&rqh);
@@ -730,6 +902,239 @@ exit:
     return res;
 }
 //****************************************************************************************
+void Audio::connectPhase(uint8_t phase) {
+    uint32_t now = millis();
+    if(m_connPhase != CONN_IDLE) m_connMs[m_connPhase] = now - m_connT0;
+    else memset(m_connMs, 0, sizeof(m_connMs));
+    m_connPhase = phase;
+    m_connT0 = now;
+}
+//****************************************************************************************
+void Audio::connectCancel() {
+    // a newer connecttohost() or stopSong(): drop whatever is in flight
+    if(m_connPhase == CONN_TLS) clientsecure.stop();
+    m_race.clear();
+    vector_clear_and_shrink(m_connPending);
+    x_ps_free(&m_connRequest);
+    m_connPhase = CONN_IDLE;
+}
+//****************************************************************************************
+void Audio::connectLoop() {
+    // connecttohost() without blocking the caller: resolve -> connect (raced) -> TLS -> request, each with its own
+    // timeout, one step per loop(); then parseHttpResponseHeader() takes over
+    uint32_t t = millis() - m_connT0;
+    int8_t w = m_race.winner();
+    switch(m_connPhase) {
+        case CONN_IDLE: {                                   // reconnect, waiting for the next attempt
+            if(!m_reconn.due(millis())) return;
+            m_reconn.attempt();
+            m_connPending.push_back(x_ps_strdup(m_lastHost));
+            m_f_metadata = false;                           // as the new response header says
+            m_metaint = 0;
+            m_f_chunked = false;
+            m_contentlength = 0;
+            m_streamType = ST_WEBSTREAM;
+            m_connStart = millis();
+            connectPhase(CONN_RESOLVE);
+            return;
+        }
+        case CONN_RESOLVE: {
+            for(int i = 0; i < m_connPending.size(); i++) {
+                if(m_connPending[i] && m_race.add(m_connPending[i], audio_resolve, false) == ConnRace::RESOLVING) continue;
+                free(m_connPending[i]);
+                m_connPending.erase(m_connPending.begin() + i--);
+            }
+            if(m_connPending.size() && t < CONN_RESOLVE_MS) return;
+            vector_clear_and_shrink(m_connPending);
+            if(!m_race.count()) { AUDIO_INFO("%s can't be resolved", m_lastHost); goto fail; }
+            m_ttfs.mark(Ttfs::DNS, millis());
+            const char* headers = strstr(m_connRequest, "\r\nHost: ");
+            headers = strstr(headers + 2, "\r\n") + 2;           // the request lines after Host:
+            if(m_race.count() > 1) AUDIO_INFO("racing %d connections", m_race.count());   // one is raced alone: no blocking connect
+            m_race.start(m_connKey, headers, RACE_STAGGER_MS, CONN_TCP_MS, m_f_ssl ? m_timeout_ms_ssl : CONN_RESPONSE_MS,
+                         []() { return (uint32_t)millis(); });
+            connectPhase(CONN_CONNECT);
+            return;
+        }
+        case CONN_CONNECT: {
+            int8_t r = m_race.poll(2);
+            if(r == 0) return;
+            if(r < 0) goto fail;
+            w = m_race.winner();
+            m_ttfs.mark(Ttfs::CONNECT, millis());
+            IPAddress ip(m_race.ip(w));
+            AUDIO_INFO("%s (%s) %s in %lu ms", m_race.url(w), ip.toString().c_str(), m_race.count() > 1 ? "won the race" : "answered",
+                       (long unsigned int)m_race.winMs());
+            x_ps_free(&m_lastHost);
+            m_lastHost = x_ps_strdup(m_race.url(w));
+            m_f_ssl = m_race.tls(w);
+            if(!m_f_ssl) {                                  // the response is waiting in the socket
+                client = WiFiClient(m_race.release(w));
+                _client = static_cast<WiFiClient*>(&client);
+                _client->setTimeout(m_timeout_ms);
+                break;
+            }
+            _client = static_cast<WiFiClient*>(&clientsecure);
+            clientsecure.setTimeout(m_timeout_ms_ssl);
+            close(m_race.release(w));                       // WiFiClientSecure makes its own connection to the winning address
+            connectPhase(CONN_TLS);                         // in the next pass, a newer connecttohost() can still cancel
+            return;
+        }
+        case CONN_TLS: {                                    // blocking: WiFiClientSecure has no way to take the raced socket
+            IPAddress ip(m_race.ip(w));
+            clientsecure.setHandshakeTimeout((CONN_TLS_MS + 999) / 1000);
+            if(!clientsecure.connect(ip, m_race.port(w), m_race.host(w), NULL, NULL, NULL)) {
+                AUDIO_INFO("TLS handshake with %s failed", m_race.host(w));
+                goto fail;
+            }
+            m_ttfs.mark(Ttfs::TLS, millis());
+            connectPhase(CONN_REQUEST);
+            return;
+        }
+        case CONN_REQUEST: {
+            const char* headers = strstr(m_connRequest, "\r\nHost: ");
+            headers = strstr(headers + 2, "\r\n") + 2;
+            size_t len = strlen(m_race.url(w)) + strlen(headers) + 32;
+            char* req = x_ps_malloc(len);
+            if(!req) goto fail;
+            m_race.request(w, headers, req, len);
+            bool sent = _client->print(req) == strlen(req);
+            x_ps_free(&req);
+            if(!sent) goto fail;
+            break;
+        }
+        default: return;
+    }
+    // connected, the request is out
+    connectPhase(CONN_IDLE);
+    AUDIO_INFO("%s has been established in %lu ms (resolve %u, connect %u, tls %u), free Heap: %lu bytes", m_f_ssl ? "SSL" : "Connection",
+               (long unsigned int)(millis() - m_connStart), m_connMs[CONN_RESOLVE], m_connMs[CONN_CONNECT], m_connMs[CONN_TLS],
+               (long unsigned int)ESP.getFreeHeap());
+    m_race.clear();
+    m_dataMode = HTTP_RESPONSE_HEADER;
+    return;
+
+fail:
+    if(m_reconn.active()) { if(reconnectRetry()) return; }
+    else if(audio_reconnect) audio_reconnect(Reconnect::FAILED, 0, millis() - m_connStart);
+    AUDIO_ERROR("Request %s failed!", m_lastHost);
+    connectCancel();
+    m_dataMode = AUDIO_NONE;
+    m_f_running = false;
+    if(audio_showstation) audio_showstation("");
+    if(audio_showstreamtitle) audio_showstreamtitle("");
+    if(audio_icydescription) audio_icydescription("");
+    if(audio_icyurl) audio_icyurl("");
+}
+//****************************************************************************************
+bool Audio::reconnectStart(const char* why) {
+    // the webstream dropped while playing: the audio task goes on decoding what is buffered, connectLoop()
+    // connects again behind it with backoff, processWebStream() splices the new data in
+    if(m_streamType != ST_WEBSTREAM || m_playlistFormat == FORMAT_M3U8 || !m_connRequest) return false;
+    AUDIO_INFO("stream %s, reconnecting, %lu ms buffered", why, (long unsigned int)((uint64_t)InBuff.bufferFilled() * 1000 / streamBytesPerSec()));
+    _client->stop();
+    m_reconnCodec = m_codec;
+    m_reconnSkipped = 0;
+    m_reconn.begin(millis(), esp_random());
+    m_connPhase = CONN_IDLE;
+    m_dataMode = AUDIO_CONNECTING;
+    return true;
+}
+//****************************************************************************************
+bool Audio::reconnectRetry() {
+    // an attempt of a reconnect failed: wait for the next one, false = give up (the caller stops the stream)
+    uint32_t now = millis();
+    _client->stop();
+    m_race.clear();
+    vector_clear_and_shrink(m_connPending);
+    m_connPhase = CONN_IDLE;
+    m_rhlT0 = 0;
+    m_f_timeout = false;
+    if(!m_reconn.retry(now)) {
+        AUDIO_INFO("stream lost, no reconnect after %u attempts in %lu ms", m_reconn.attempts(), (long unsigned int)m_reconn.elapsed(now));
+        if(audio_reconnect) audio_reconnect(Reconnect::FAILED, m_reconn.attempts(), m_reconn.elapsed(now));
+        return false;
+    }
+    AUDIO_INFO("reconnect attempt %u failed, next in %lu ms", m_reconn.attempts(), (long unsigned int)m_reconn.waitMs(now));
+    m_dataMode = AUDIO_CONNECTING;
+    return true;
+}
+//****************************************************************************************
+void Audio::reconnectSplice(uint8_t* data, int32_t* len) {
+    // first data of a reconnected stream: start it at a frame sync and tell playAudioData() where the old data ends
+    int32_t sync = 0;
+    switch(m_codec) {
+        case CODEC_MP3:    sync = MP3FindSyncWord(data, *len); break;
+        case CODEC_AAC:    sync = AACFindSyncWord(data, *len); break;
+        case CODEC_FLAC:   sync = FLACFindSyncWord(data, *len); break;
+        case CODEC_OPUS:   sync = OPUSFindSyncWord(data, *len); break;
+        case CODEC_VORBIS: sync = VORBISFindSyncWord(data, *len); break;
+        default: break;                                     // wav, m4a: nothing to sync to
+    }
+    if(sync < 0) {
+        if(m_reconnSkipped + *len < InBuff.getMaxBlockSize() * 8) { m_reconnSkipped += *len; *len = 0; return; } // look in the next block
+        sync = 0;                                           // no sync in sight, the decoder has to find it
+    }
+    if(sync > 0) { memmove(data, data + sync, *len - sync); *len -= sync; }
+    m_f_resync = false;
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    m_spliceLeft = InBuff.bufferFilled();
+    xSemaphoreGive(mutex_audioTask);
+
+    uint32_t now = millis();
+    uint8_t outcome = m_reconn.done();
+    AUDIO_INFO("stream reconnected after %u attempt(s) in %lu ms, %s", m_reconn.attempts(), (long unsigned int)m_reconn.elapsed(now),
+               outcome == Reconnect::SEAMLESS ? "no dropout" : "with a dropout");
+    if(audio_reconnect) audio_reconnect(outcome, m_reconn.attempts(), m_reconn.elapsed(now));
+    m_stableT0 = now;
+}
+//****************************************************************************************
+uint32_t Audio::frameLength(const uint8_t* p) {
+    // length of the mp3 (layer III) or ADTS frame that starts at p, 0 = no frame header there or another codec
+    if(m_codec == CODEC_MP3 && p[0] == 0xFF && (p[1] & 0xE0) == 0xE0 && (p[1] & 0x06) == 0x02) {
+        static const uint16_t kbps1[16] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0};
+        static const uint16_t kbps2[16] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0};
+        static const uint16_t hz1[4]    = {44100, 48000, 32000, 0};
+        uint8_t  ver  = (p[1] >> 3) & 0x03;                 // 3 = MPEG1, 2 = MPEG2, 0 = MPEG2.5
+        uint32_t kbps = (ver == 3 ? kbps1 : kbps2)[p[2] >> 4];
+        uint32_t hz   = hz1[(p[2] >> 2) & 0x03] >> (ver == 3 ? 0 : (ver == 2 ? 1 : 2));
+        if(ver == 1 || !kbps || !hz) return 0;
+        return (ver == 3 ? 144000 : 72000) * kbps / hz + ((p[2] >> 1) & 0x01);
+    }
+    if(m_codec == CODEC_AAC && p[0] == 0xFF && (p[1] & 0xF6) == 0xF0) {
+        return ((p[3] & 0x03) << 11) | (p[4] << 3) | (p[5] >> 5);
+    }
+    return 0;
+}
+//****************************************************************************************
+bool Audio::connectCached(const char* host, uint16_t port) {
+    // _client->connect(host, port) with the address from the resolver cache, if there is one
+    uint32_t ip = 0;
+    if(!audio_resolve || !audio_resolve(host, &ip, 1, true)) return _client->connect(host, port);
+    bool res;
+    if(_client == static_cast<WiFiClient*>(&clientsecure)) res = clientsecure.connect(IPAddress(ip), port, host, NULL, NULL, NULL); // SNI needs the name
+    else res = _client->connect(IPAddress(ip), port);
+    if(!res) res = _client->connect(host, port);            // cached address is gone, ask lwIP
+    return res;
+}
+//****************************************************************************************
+#if HLS_BUFFER_SIZE>0
+bool Audio::hlsStart(const char* first) {
+    // hand a m3u8 stream over to the segment engine once the media playlist is known, first is the segment to
+    // start with; without PSRAM (or if the engine can't start) the segments are fetched one by one as before.
+    // m_lastM3U8host was picked from the master playlist m_lastHost, the engine switches between its variants
+    if(!m_f_psramFound) return false;
+    const char* playlist = m_lastM3U8host ? m_lastM3U8host : m_lastHost;
+    const char* master = HLS_ABR && m_lastM3U8host ? m_lastHost : NULL;
+    if(!m_hls.begin(playlist, first, master)) return false;
+    AUDIO_INFO("HLS segments are prefetched from %s", playlist);
+    _client->stop();
+    _client = &m_hls;
+    vector_clear_and_shrink(m_playlistURL); 			// the engine reads the playlist itself from now on
+    return true;
+}
+#endif
+//****************************************************************************************
 bool Audio::httpPrint(const char* host) {
     // user and pwd for authentification only, can be empty
     if(!m_f_running) return false;
@@ -799,7 +1204,7 @@ bool Audio::httpPrint(const char* host) {
          if(m_f_ssl) { _client = static_cast<WiFiClient*>(&clientsecure); if(m_f_ssl && port == 80) port = 443;}
          else        { _client = static_cast<WiFiClient*>(&client); }
         AUDIO_INFO("The host has disconnected, reconnecting");
-        if(!_client->connect(hostwoext, port)) {
+        if(!connectCached(hostwoext, port)) {
             log_e("connection lost");
             stopSong();
             return false;
@@ -912,7 +1317,7 @@ log_e("%s", rqh);
     if(m_f_ssl) { _client = static_cast<WiFiClient*>(&clientsecure); if(m_f_ssl && port == 80) port = 443;}
     else        { _client = static_cast<WiFiClient*>(&client); }
     AUDIO_INFO("The host has disconnected, reconnecting");
-    if(!_client->connect(hostwoext, port)) {
+    if(!connectCached(hostwoext, port)) {
         log_e("connection lost");
         stopSong();
         return false;
@@ -994,6 +1399,7 @@ bool Audio::connecttoSD(const char* path, int32_t resumeFilePos) {
 bool Audio::connecttoFS(fs::FS& fs, const char* path, int32_t fileStartPos) {
 
     xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    m_ttfs.mark(Ttfs::CALL, millis());
     bool res = false;
     int16_t dotPos;
     char* audioPath = NULL;
@@ -2416,6 +2822,7 @@ uint32_t Audio::stopSong() {
             }
             // if(_client->connected()) _client->stop();
         }
+        readAheadStop(true);                // the ring is internal RAM a webstream's TLS needs
         if(audiofile) {
             // added this before putting 'm_f_localfile = false' in stopSong(); shoulf never occur....
             AUDIO_INFO("Closing audio file \"%s\"", audiofile.name());
@@ -2426,12 +2833,21 @@ uint32_t Audio::stopSong() {
         m_audioCurrentTime = 0;
         m_audioFileDuration = 0;
         m_codec = CODEC_NONE;
+        connectCancel();
+        m_reconn.cancel();
+        m_watch.disarm();
+        m_f_resync = false;
+        m_spliceLeft = 0;
+#if HLS_BUFFER_SIZE>0
+        m_hls.stop();
+#endif
         m_dataMode = AUDIO_NONE;
         m_f_lockInBuffer = false;
     return pos;
 }
 //****************************************************************************************
 bool Audio::pauseResume() {
+    if(timeshiftActive()) return timeshiftPause(!m_f_tsPaused); // live stream: keep receiving while paused
     xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
     bool retVal = false;
     if(m_dataMode == AUDIO_LOCALFILE || m_streamType == ST_WEBSTREAM || m_streamType == ST_WEBFILE) {
@@ -2446,6 +2862,91 @@ bool Audio::pauseResume() {
     return retVal;
 }
 //****************************************************************************************
+//            ***     T i m e s h i f t     ***
+//
+// The InBuff is allocated with m_timeshiftSize bytes in PSRAM and serves as timeshift ring. It keeps the already
+// decoded data behind the readpointer until processWebStream() overwrites it, so no additional copy is needed.
+// While paused, the stream is still received; if the ring is full, the oldest unplayed data will be dropped.
+//****************************************************************************************
+bool Audio::setTimeshift(size_t bytes) {
+    if(m_f_running) { log_w("timeshift can only be changed while stopped"); return false; }
+    if(bytes == m_timeshiftSize) return true;
+    if(bytes && !psramFound()) { log_w("timeshift needs PSRAM"); return false; }
+    InBuff.setBufsize(-1, bytes ? bytes : UINT16_MAX * 10);
+    size_t size = InBuff.init();
+    if(bytes && !InBuff.havePSRAM()) { 				// not enough PSRAM, back to the default buffer
+        log_w("timeshift: can't allocate %u bytes", bytes);
+        InBuff.setBufsize(-1, UINT16_MAX * 10);
+        InBuff.init();
+        m_timeshiftSize = 0;
+        return false;
+    }
+    m_timeshiftSize = bytes;
+    AUDIO_INFO("timeshift %s, inputBufferSize: %u bytes", bytes ? "on" : "off", size);
+    return true;
+}
+//****************************************************************************************
+bool Audio::timeshiftActive() {
+    return m_timeshiftSize && m_f_running && m_streamType == ST_WEBSTREAM && m_playlistFormat != FORMAT_M3U8;
+}
+//****************************************************************************************
+uint32_t Audio::streamBytesPerSec() {
+    uint32_t br = m_avr_bitrate ? m_avr_bitrate : m_bitRate;
+    if(!br) br = h_bitRate;
+    if(!br) br = 128000;
+    return br / 8;
+}
+//****************************************************************************************
+uint32_t Audio::prebufferBytes(uint16_t ms) { // never more than the inputbuffer can hold while the socket keeps delivering
+    uint32_t bytes = (uint64_t)streamBytesPerSec() * ms / 1000;
+    uint32_t cap = InBuff.getBufsize() * 3 / 4;
+    return bytes < cap ? bytes : cap;
+}
+//****************************************************************************************
+void Audio::timeshiftResync() { // the readpointer has been moved, seek for the next syncword
+    memset(m_outBuff, 0, m_outbuffSize * sizeof(int16_t));
+    m_validSamples = 0;
+    m_f_playing = false;
+}
+//****************************************************************************************
+bool Audio::timeshiftPause(bool pause) {
+    if(!timeshiftActive()) return false;
+    if(pause == m_f_tsPaused) return true;
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    m_f_tsPaused = pause;
+    if(pause) timeshiftResync();
+    xSemaphoreGive(mutex_audioTask);
+    AUDIO_INFO("timeshift %s, %lu s behind live", pause ? "paused" : "resumed", (long unsigned int)getTimeshiftDelay());
+    return true;
+}
+//****************************************************************************************
+uint32_t Audio::timeshiftJumpBack(uint16_t sec) {
+    if(!timeshiftActive()) return 0;
+    uint32_t bps = streamBytesPerSec();
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    size_t br = InBuff.rewind((size_t)sec * bps);
+    if(br) timeshiftResync();
+    xSemaphoreGive(mutex_audioTask);
+    return br / bps;
+}
+//****************************************************************************************
+bool Audio::timeshiftToLive() {
+    if(!timeshiftActive()) return false;
+    size_t keep = TIMESHIFT_LIVE_MARGIN * streamBytesPerSec();
+    if(keep < InBuff.getMaxBlockSize() * 2) keep = InBuff.getMaxBlockSize() * 2;
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    size_t filled = InBuff.bufferFilled();
+    if(filled > keep) { InBuff.bytesWasRead(filled - keep); timeshiftResync(); }
+    m_f_tsPaused = false;
+    xSemaphoreGive(mutex_audioTask);
+    return true;
+}
+//****************************************************************************************
+uint32_t Audio::getTimeshiftDelay() {
+    if(!timeshiftActive()) return 0;
+    return InBuff.bufferFilled() / streamBytesPerSec();
+}
+//****************************************************************************************
 void Audio::playChunk() {
 
     int16_t validSamples = 0;
@@ -2468,6 +2969,9 @@ void Audio::playChunk() {
     //    m_validSamples *= 2;
     }
 
+    if(audio_process_pcm) audio_process_pcm(m_outBuff, m_validSamples, getSampleRate());
+    m_watch.pcm(m_outBuff, m_validSamples, millis());   // decoded, before the filters and the volume
+
     validSamples = m_validSamples;
 
     while(validSamples) {
@@ -2491,6 +2995,15 @@ void Audio::playChunk() {
             (*sample)[RIGHTCHANNEL] = (int16_t)xy;
             (*sample)[LEFTCHANNEL]  = (int16_t)xy;
         }
+        i += 2;
+        validSamples -= 1;
+    }
+
+    m_comp.process(m_outBuff, m_validSamples);    // night mode, delays by its look-ahead while on
+    if(audio_process_block) audio_process_block(m_outBuff, m_validSamples, getSampleRate());
+
+    for(i = 0; i < m_validSamples * 2; i += 2) {
+        *sample = m_outBuff + i;
         Gain(*sample);
 
         if(m_f_internalDAC) {
@@ -2498,8 +3011,6 @@ void Audio::playChunk() {
             s2[LEFTCHANNEL] += 0x8000;
             s2[RIGHTCHANNEL] += 0x8000;
         }
-        i += 2;
-        validSamples -= 1;
     }
 
     if(audio_process_i2s) {
@@ -2509,13 +3020,21 @@ void Audio::playChunk() {
         if(!continueI2S) {
             m_validSamples = 0;
             count = 0;
+            m_dmaTune.pause();
             return;
         }
     }
 
 i2swrite:
 
+    if(m_f_i2sLost) {                                                 // no I2S channel until reconfigI2S makes one
+        m_validSamples = 0;
+        count = 0;
+        m_dmaTune.pause();
+        return;
+    }
     validSamples = m_validSamples;
+    I2Slevel();
 
 #if(ESP_IDF_VERSION_MAJOR == 5)
     err = i2s_channel_write(m_i2s_tx_handle, (int16_t*)m_outBuff + count, validSamples * sampleSize, &i2s_bytesConsumed, 10);
@@ -2525,6 +3044,8 @@ i2swrite:
 
     if( ! (err == ESP_OK || err == ESP_ERR_TIMEOUT)) goto exit;
     m_validSamples -= i2s_bytesConsumed / sampleSize;
+    m_dmaWritten += i2s_bytesConsumed / sampleSize;
+    if(i2s_bytesConsumed && m_ttfs.once(Ttfs::OUTPUT, millis()) && audio_ttfs) audio_ttfs(m_ttfs);
     count += i2s_bytesConsumed / 2;
     if(m_validSamples < 0) { m_validSamples = 0; }
     if(m_validSamples == 0) { count = 0; }
@@ -2560,6 +3081,7 @@ void Audio::loop() {
         switch(m_dataMode) {
             case AUDIO_LOCALFILE:
                 processLocalFile(); break;
+            case AUDIO_CONNECTING: connectLoop(); break;
             case HTTP_RESPONSE_HEADER:
                 static uint8_t count = 0;
                 if(!parseHttpResponseHeader()) {
@@ -2586,7 +3108,11 @@ void Audio::loop() {
         static uint8_t no_host_cnt = 0;
         static uint32_t no_host_timer = millis();
         if(no_host_timer > millis()) {return;}
+#if HLS_BUFFER_SIZE>0
+        if(_client == &m_hls) m_hls.buffered(InBuff.bufferFilled() * 1000ULL / streamBytesPerSec()); // for the variant choice
+#endif
         switch(m_dataMode) {
+            case AUDIO_CONNECTING: connectLoop(); break;
             case HTTP_RESPONSE_HEADER:
                 static uint8_t count = 0;
                 if(!parseHttpResponseHeader()) {
@@ -2599,17 +3125,42 @@ void Audio::loop() {
                 break;
             case AUDIO_PLAYLISTINIT: readPlayListData(); break;
             case AUDIO_PLAYLISTDATA:
+#if HLS_BUFFER_SIZE>0
+                if(_client == &m_hls) { 					// the segments come prefetched
+                    int8_t r = m_hls.next();
+                    if(r > 0) {
+                        const char* extinf = m_hls.title();
+                        if(extinf && indexOf(extinf, "title", 0) > 0 && STfromEXTINF(extinf)) showstreamtitle(m_chbuf);
+                        if(m_hls.discontinuity()) m_ts.reset(); 	// other encoder settings, PIDs and counters may follow
+                        if(endsWith(m_hls.url(), "ts") || indexOf(m_hls.url(), ".ts?") > 0) m_f_ts = true;
+                        if(m_f_Log) log_i("now playing %s, %lu ms ready behind it", m_hls.url(), (long unsigned int)m_hls.aheadMs());
+                        m_dataMode = HTTP_RESPONSE_HEADER;
+                    }
+                    else if(r < 0) {
+                        if(m_hls.ended()) { AUDIO_INFO("End of HLS stream"); if(audio_eof_stream) audio_eof_stream(m_lastHost); }
+                        else {
+                            AUDIO_INFO("HLS playlist lost, %lu segments played, %lu lost", (long unsigned int)m_hls.segments(), (long unsigned int)m_hls.lost());
+                            if(audio_reconnect) audio_reconnect(Reconnect::FAILED, 1, 0);
+                        }
+                        stopSong();
+                    }
+                    break;
+                }
+#endif
                 host = parsePlaylist_M3U8();
                 if(!host) no_host_cnt++; else {no_host_cnt = 0; no_host_timer = millis();}
                 if(no_host_cnt == 2){no_host_timer = millis() + 2000;} 	// no new url? wait 2 seconds
                 if(host) { 								// host contains the next playlist URL
+#if HLS_BUFFER_SIZE>0
+                    if(hlsStart(host)) { m_dataMode = AUDIO_PLAYLISTDATA; break; }
+#endif
                     httpPrint(host);
                     m_dataMode = HTTP_RESPONSE_HEADER;
                 }
                 else { // host == NULL means connect to m3u8 URL
-                    if(m_lastM3U8host) {connecttohost(m_lastM3U8host);}
-                    else               {httpPrint(m_lastHost);} 		// if url has no first redirection
-                    m_dataMode = HTTP_RESPONSE_HEADER; 	// we have a new playlist now
+                    if(m_lastM3U8host) {connecttohost(m_lastM3U8host);} 	// sets its own data mode
+                    else               {httpPrint(m_lastHost); 		// if url has no first redirection
+                                        m_dataMode = HTTP_RESPONSE_HEADER;} 	// we have a new playlist now
                 }
                 break;
             case AUDIO_DATA:
@@ -2628,69 +3179,72 @@ void Audio::loop() {
 bool Audio::readPlayListData() {
 
     if(m_dataMode != AUDIO_PLAYLISTINIT) return false;
-    if(_client->available() == 0) return false;
-
-    uint32_t chunksize = 0;
-    uint8_t  readedBytes = 0;
-    if(m_f_chunked) chunksize = chunkedDataTransfer(&readedBytes);
+    if(bodyAvailable() == 0) return false;
 
-    // reads the content of the playlist and stores it in the vector m_contentlength
-    // m_contentlength is a table of pointers to the lines
+    // reads the content of the playlist and stores it in the vector m_playlistContent
+    // m_playlistContent is a table of pointers to the lines
     char     pl[512] = {0}; // playlistLine
-    uint32_t ctl = 0;
+    uint8_t  block[256];    // as readBody() delivers it, without the chunked framing
+    uint16_t pos = 0;
     int      lines = 0;
+    uint32_t ctime = millis();
+    uint32_t timeout = 2000; // ms
     // delete all memory in m_playlistContent
     if(m_playlistFormat == FORMAT_M3U8 && !psramFound()) { log_e("m3u8 playlists requires PSRAM enabled!"); }
     vector_clear_and_shrink(m_playlistContent);
-    while(true) { // outer while
-
-        uint32_t ctime = millis();
-        uint32_t timeout = 2000; // ms
-
-        while(true) { // inner while
-            uint16_t pos = 0;
-            while(_client->available()) { // super inner while :-))
-                pl[pos] = _client->read();
-                ctl++;
-                if(pl[pos] == '\n') { pl[pos] = '\0'; pos++; break; }
-                //    if(pl[pos] == '&' ) {pl[pos] = '\0'; pos++; break;}
-                if(pl[pos] == '\r') { pl[pos] = '\0'; pos++; continue;; }
-                pos++;
-                if(pos == 510) { pos--; continue; }
-                if(pos == 509) { pl[pos] = '\0'; }
-                if(ctl == chunksize) { pl[pos] = '\0'; break; }
-                if(ctl == m_contentlength) { pl[pos] = '\0'; break; }
-            }
-            //log_w("pl %s, ctl %i, chunksize %i, m_contentlength %i", pl, ctl, chunksize, m_contentlength);
-            if(ctl == chunksize) break;
-            if(ctl == m_contentlength) break;
-            if(pos) { pl[pos] = '\0'; break; }
-
-            if(ctime + timeout < millis()) {
-                log_e("timeout");
-                for(int i = 0; i < m_playlistContent.size(); i++) log_e("pl%i = %s", i, m_playlistContent[i]);
-                goto exit;
+    if(m_playlistFormat == FORMAT_M3U8) { 			// not stored line by line, parsed as it comes in (m3u8.h)
+        if(!m_m3u8Arena) {
+            m_m3u8Arena = x_ps_malloc(M3U8_ARENA_SIZE);
+            m_m3u8.begin(m_m3u8Arena, M3U8_ARENA_SIZE);
+        }
+        if(!m_m3u8Arena) { log_e("out of memory"); goto exit; }
+        m_m3u8.start();
+    }
+    while(true) {
+        int32_t n = readBody(block, sizeof(block));
+        bool    end = false;
+        if(n < 0) goto exit;
+        if(n == 0) {
+            // termination conditions: the end of the body (content-length or the last chunk) or, without both,
+            // the closed connection
+            end = m_http.done() || (!_client->connected() && !bodyAvailable());
+            if(!end) {
+                if(millis() - ctime > timeout) {
+                    log_e("timeout");
+                    for(int i = 0; i < m_playlistContent.size(); i++) log_e("pl%i = %s", i, m_playlistContent[i]);
+                    goto exit;
+                }
+                vTaskDelay(1);
+                continue;
             }
-        } // inner while
+            block[0] = '\n'; 						// the last line may come without
+            n = 1;
+        }
+        else ctime = millis();
 
-        if(startsWith(pl, "<!DOCTYPE")) { AUDIO_INFO("url is a webpage!"); goto exit; }
-        if(startsWith(pl, "<html")) { AUDIO_INFO("url is a webpage!"); goto exit; }
+        for(int32_t i = 0; i < n; i++) {
+            if(block[i] == '\r') continue;
+            if(block[i] != '\n') { if(pos < 509) pl[pos++] = block[i]; continue; }
+            pl[pos] = '\0';
+            pos = 0;
 
-        if(strlen(pl) > 0) m_playlistContent.push_back(x_ps_strdup(pl));
-        if(!m_f_psramFound && m_playlistContent.size() == 101) {
-            AUDIO_INFO("the number of lines in playlist > 100, for bigger playlist use PSRAM!");
-            break;
-        }
-        if(m_playlistContent.size() && m_playlistContent.size() % 1000 == 0) { AUDIO_INFO("current playlist line: %lu", (long unsigned)m_playlistContent.size()); }
-        // termination conditions
-        // 1. The http response header returns a value for contentLength -> read chars until contentLength is reached
-        // 2. no contentLength, but Transfer-Encoding:chunked -> compute chunksize and read until chunksize is reached
-        // 3. no chunksize and no contentlengt, but Connection: close -> read all available chars
-        if(ctl == m_contentlength) { while(_client->available()) _client->read(); break; } // read '\n\n' if exists
-        if(ctl == chunksize) { while(_client->available()) _client->read(); break; }
-        if(!_client->connected() && _client->available() == 0) break;
+            if(startsWith(pl, "<!DOCTYPE")) { AUDIO_INFO("url is a webpage!"); goto exit; }
+            if(startsWith(pl, "<html")) { AUDIO_INFO("url is a webpage!"); goto exit; }
 
-    } // outer while
+            if(strlen(pl) > 0) {
+                if(m_playlistFormat == FORMAT_M3U8) { uint16_t l = strlen(pl); pl[l] = '\n'; m_m3u8.feed(pl, l + 1); }
+                else m_playlistContent.push_back(x_ps_strdup(pl));
+            }
+            if(!m_f_psramFound && m_playlistContent.size() == 101) {
+                AUDIO_INFO("the number of lines in playlist > 100, for bigger playlist use PSRAM!");
+                end = true;
+                break;
+            }
+            if(m_playlistContent.size() && m_playlistContent.size() % 1000 == 0) { AUDIO_INFO("current playlist line: %lu", (long unsigned)m_playlistContent.size()); }
+        }
+        if(end) break;
+    }
+    if(m_playlistFormat == FORMAT_M3U8) m_m3u8.finish();
     lines = m_playlistContent.size();
     for(int i = 0; i < lines; i++) { 					// print all string in first vector of 'arr'
     //    log_w("pl=%i \"%s\"", i, m_playlistContent[i]);
@@ -2700,6 +3254,7 @@ bool Audio::readPlayListData() {
 
 exit:
     vector_clear_and_shrink(m_playlistContent);
+    m_m3u8.start();
     m_f_running = false;
     m_dataMode = AUDIO_NONE;
     return false;
@@ -2722,12 +3277,17 @@ const char* Audio::parsePlaylist_M3U() {
         if(startsWith(m_playlistContent[i], "#")) { 			// Commentline?
             continue;
         }
+        if(host) {                                              // further entries are mirrors, raced in connecttohost
+            pos = indexOf(m_playlistContent[i], "http", 0);
+            if(pos >= 0 && m_mirrorURL.size() < ConnRace::MAX_CANDIDATES - 1) m_mirrorURL.push_back(x_ps_strdup(m_playlistContent[i] + pos));
+            continue;
+        }
 
         pos = indexOf(m_playlistContent[i], "http://:@", 0); 	// ":@"??  remove that!
         if(pos >= 0) {
             AUDIO_INFO("Entry in playlist found: %s", (m_playlistContent[i] + pos + 9));
             host = m_playlistContent[i] + pos + 9;
-            break;
+            continue;
         }
         // AUDIO_INFO("Entry in playlist found: %s", pl);
         pos = indexOf(m_playlistContent[i], "http", 0); 		// Search for "http"
@@ -2735,7 +3295,7 @@ const char* Audio::parsePlaylist_M3U() {
 											//    log_e("%s pos=%i", m_playlistContent[i], pos);
             AUDIO_INFO("Entry in M3U-playlist found: %s", (m_playlistContent[i] + pos));
             host = m_playlistContent[i] + pos;          			// Yes, set new host
-            break;
+            continue;
         }
     }
     //    vector_clear_and_shrink(m_playlistContent);
@@ -2765,6 +3325,11 @@ const char* Audio::parsePlaylist_PLS() {
             }
             continue;
         }
+        if(startsWith(m_playlistContent[i], "File")) {          // File2, File3 ... are mirrors, raced in connecttohost
+            pos = indexOf(m_playlistContent[i], "http", 0);
+            if(pos >= 0 && m_mirrorURL.size() < ConnRace::MAX_CANDIDATES - 1) m_mirrorURL.push_back(x_ps_strdup(m_playlistContent[i] + pos));
+            continue;
+        }
         if(startsWith(m_playlistContent[i], "Title1")) { 		// Title1=Antenne Tirol
             const char* plsStationName = (m_playlistContent[i] + 7);
             if(audio_showstation) audio_showstation(plsStationName);
@@ -2842,146 +3407,43 @@ const char* Audio::parsePlaylist_M3U8() {
     // http://n3fa-e2.revma.ihrhls.com/zc7729/63_sdtszizjcjbz02/main/163374039.aac
 
     if(!m_lastHost) {log_e("m_lastHost is NULL"); return NULL;} // guard
-    static uint64_t xMedSeq = 0;
-    static boolean  f_mediaSeq_found = false;
-    boolean         f_EXTINF_found = false;
-    char            llasc[21]; 			// uint64_t max = 18,446,744,073,709,551,615  thats 20 chars + \0
     if(m_f_firstM3U8call) {
         m_f_firstM3U8call = false;
-        xMedSeq = 0;
-        f_mediaSeq_found = false;
+        m_m3u8.forget();
     }
 
-    uint8_t     lines = m_playlistContent.size();
-    bool        f_begin = false;
     const char* ret;
-    if(lines) {
-        for(uint16_t i = 0; i < lines; i++) {
-            if(strlen(m_playlistContent[i]) == 0) continue; 		// empty line
-            if(startsWith(m_playlistContent[i], "#EXTM3U")) { f_begin = true; continue; } // what we expected
-            if(!f_begin) continue;
-
-            if(startsWith(m_playlistContent[i], "#EXT-X-STREAM-INF:")) {
-                uint8_t codec = CODEC_NONE;
-                ret = m3u8redirection(&codec);
-                if(ret) {
-                    m_codec = codec; 					// can be AAC or MP3
-                    x_ps_free(&m_lastM3U8host);
-                    m_lastM3U8host = strdup(ret);
-                    x_ps_free_const(&ret);
-                    vector_clear_and_shrink(m_playlistContent);
-                    return NULL;
-                }
-            }
-            if(m_codec == CODEC_NONE) m_codec = CODEC_AAC; // if we have no redirection
-
-            // "#EXT-X-DISCONTINUITY-SEQUENCE: // not used, 0: seek for continuity numbers, is sometimes not set
-            // "#EXT-X-MEDIA-SEQUENCE:"        // not used, is unreliable
-            if(startsWith(m_playlistContent[i], "#EXT-X-VERSION:")) continue;
-            if(startsWith(m_playlistContent[i], "#EXT-X-ALLOW-CACHE:")) continue;
-            if(startsWith(m_playlistContent[i], "##")) continue;
-            if(startsWith(m_playlistContent[i], "#EXT-X-INDEPENDENT-SEGMENTS")) continue;
-            if(startsWith(m_playlistContent[i], "#EXT-X-PROGRAM-DATE-TIME:")) continue;
-
-            if(!f_mediaSeq_found) {
-                xMedSeq = m3u8_findMediaSeqInURL();
-                if(xMedSeq == UINT64_MAX) {
-                    log_e("X MEDIA SEQUENCE NUMBER not found");
-                    stopSong();
-                    return NULL;
-                }
-                else f_mediaSeq_found = true;
-            }
-
-            if(startsWith(m_playlistContent[i], "#EXTINF")) {
-                f_EXTINF_found = true;
-                if(STfromEXTINF(m_playlistContent[i])) { showstreamtitle(m_chbuf); }
-                i++;
-                if(startsWith(m_playlistContent[i], "#")) i++;   	// #MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20....
-                if(i == lines) continue; 					// and exit for()
-
-                char* tmp = nullptr;
-                if(!startsWith(m_playlistContent[i], "http")) {
-
-                        //  playlist:   http://station.com/aaa/bbb/xxx.m3u8
-                        //  chunklist:  http://station.com/aaa/bbb/ddd.aac
-                        //  result:     http://station.com/aaa/bbb/ddd.aac
-
-                    if(m_lastM3U8host) {
-                        tmp = x_ps_calloc(strlen(m_lastM3U8host) + strlen(m_playlistContent[i]) + 1, sizeof(char));
-                        strcpy(tmp, m_lastM3U8host);
-                    }
-                    else {
-                        tmp = x_ps_calloc(strlen(m_lastHost) + strlen(m_playlistContent[i]) + 1, sizeof(char));
-                        strcpy(tmp, m_lastHost);
-                    }
-
-                    if(m_playlistContent[i][0] != '/'){
-
-                        //  playlist:   http://station.com/aaa/bbb/xxx.m3u8  // tmp
-                        //  chunklist:  ddd.aac                              // m_playlistContent[i]
-                        //  result:     http://station.com/aaa/bbb/ddd.aac   // m_playlistContent[i]
-
-                        int idx = lastIndexOf(tmp, "/");
-                        tmp[idx  + 1] = '\0';
-                        strcat(tmp, m_playlistContent[i]);
-                    }
-                    else{
-
-                        //  playlist:   http://station.com/aaa/bbb/xxx.m3u8
-                        //  chunklist:  /aaa/bbb/ddd.aac
-                        //  result:     http://station.com/aaa/bbb/ddd.aac
-
-                        int idx = indexOf(tmp, "/", 8);
-                        tmp[idx] = '\0';
-                        strcat(tmp, m_playlistContent[i]);
-                    }
-                }
-                else { tmp = strdup(m_playlistContent[i]); }
-
-                if(f_mediaSeq_found) {
-                    lltoa(xMedSeq, llasc, 10);
-                    if(indexOf(tmp, llasc) > 0) {
-                        m_playlistURL.insert(m_playlistURL.begin(), strdup(tmp));
-                        xMedSeq++;
-                    }
-                    else{
-                        lltoa(xMedSeq + 1, llasc, 10);
-                        if(indexOf(tmp, llasc) > 0) {
-                            m_playlistURL.insert(m_playlistURL.begin(), strdup(tmp));
-                            log_w("mediaseq %llu skipped", xMedSeq);
-                            xMedSeq+= 2;
-                        }
-                    }
-                }
-                else { 							// without mediaSeqNr, with hash
-                    uint32_t hash = simpleHash(tmp);
-                    if(m_hashQueue.size() == 0) {
-                        m_hashQueue.insert(m_hashQueue.begin(), hash);
-                        m_playlistURL.insert(m_playlistURL.begin(), strdup(tmp));
-                    }
-                    else {
-                        bool known = false;
-                        for(int i = 0; i < m_hashQueue.size(); i++) {
-                            if(hash == m_hashQueue[i]) {
-                                if(m_f_Log) log_i("file already known %s", tmp);
-                                known = true;
-                            }
-                        }
-                        if(!known) {
-                            m_hashQueue.insert(m_hashQueue.begin(), hash);
-                            m_playlistURL.insert(m_playlistURL.begin(), strdup(tmp));
-                        }
-                    }
-                    if(m_hashQueue.size() > 20) m_hashQueue.pop_back();
-                }
-
-                x_ps_free(&tmp);
-
-                continue;
-            }
-        }
-        vector_clear_and_shrink(m_playlistContent); // clear after reading everything, m_playlistContent.size is now 0
+    if(m_m3u8.type() == M3u8::MASTER) { 				// #EXT-X-STREAM-INF
+        uint8_t codec = CODEC_NONE;
+        ret = m3u8redirection(&codec);
+        m_m3u8.start();
+        if(ret) {
+            m_codec = codec; 						// can be AAC or MP3
+            x_ps_free(&m_lastM3U8host);
+            m_lastM3U8host = strdup(ret);
+            x_ps_free_const(&ret);
+        }
+        return NULL;
+    }
+    if(m_m3u8.type() == M3u8::MEDIA) { 				// a new playlist was read, queue what is new in it
+        if(m_codec == CODEC_NONE) m_codec = CODEC_AAC; 	// if we have no redirection
+        const char* base = m_lastM3U8host ? m_lastM3U8host : m_lastHost;
+        const char* extinf = NULL;
+        uint32_t    restarts = m_m3u8.restarts();
+        if(m_m3u8.diff() && m_m3u8.restarts() != restarts) log_w("media sequence restarted at %llu", m_m3u8.mediaSeq());
+        for(uint16_t i = 0; i < m_m3u8.segments(); i++) {
+            const M3u8::segment_t& seg = m_m3u8.segment(i);
+            if(!seg.fresh) continue;
+            uint16_t size = strlen(base) + strlen(seg.uri) + 2;
+            char* url = x_ps_malloc(size);
+            if(!url || !M3u8::resolve(base, seg.uri, url, size)) { x_ps_free(&url); continue; }
+            m_playlistURL.insert(m_playlistURL.begin(), url);
+            uint64_t lost = m_m3u8.take(seg);
+            if(lost) log_w("%llu segments lost (%llu..%llu)", lost, seg.seq - lost, seg.seq - 1);
+            if(seg.extinf) extinf = seg.extinf;
+        }
+        if(extinf && indexOf(extinf, "title", 0) > 0 && STfromEXTINF(extinf)) showstreamtitle(m_chbuf);
+        m_m3u8.start(); 							// parsed, the next call only takes from m_playlistURL
     }
 
     if(m_playlistURL.size() > 0) {
@@ -2998,41 +3460,6 @@ const char* Audio::parsePlaylist_M3U8() {
         if(indexOf(m_playlistBuff, ".ts?") > 0) m_f_ts = true;
         return m_playlistBuff;
     }
-    else {
-        if(f_EXTINF_found) {
-            if(f_mediaSeq_found) {
-                if(m_playlistContent.size() == 0) return NULL;
-                uint64_t mediaSeq = m3u8_findMediaSeqInURL();
-                if(xMedSeq == 0 || xMedSeq == UINT64_MAX) {
-                    log_e("xMediaSequence not found"); connecttohost(m_lastHost); }
-                if(mediaSeq < xMedSeq) {
-                    uint64_t diff = xMedSeq - mediaSeq;
-                    if(diff < 10) { ; }
-                    else {
-                        if(m_playlistContent.size() > 0) {
-                            for(int j = 0; j < lines; j++) {
-                                if(m_f_Log) log_i("lines %i, %s", lines, m_playlistContent[j]);
-                            }
-                        }
-                        else { ; }
-
-                        if(m_playlistURL.size() > 0) {
-                            for(int j = 0; j < m_playlistURL.size(); j++) {
-                                if(m_f_Log) log_i("m_playlistURL lines %i, %s", j, m_playlistURL[j]);
-                            }
-                        }
-                        else { ; }
-
-                        if(m_playlistURL.size() == 0) { connecttohost(m_lastHost); }
-                    }
-                }
-                else {
-                    if(mediaSeq != UINT64_MAX) { log_e("err, %u packets lost from %u, to %u", mediaSeq - xMedSeq, xMedSeq, mediaSeq); }
-                    xMedSeq = mediaSeq;
-                }
-            } // f_medSeq_found
-        }
-    }
 //    playAudioData(); // avoid audio gap
     return NULL;
 }
@@ -3060,185 +3487,41 @@ const char* Audio::m3u8redirection(uint8_t* codec) {
         "mp4a.67",    // MPEG-2 AAC LC
     };
 
-    uint16_t choosenLine = 0;
-    uint16_t plcSize = m_playlistContent.size();
+    uint16_t choosen = 0;
     int8_t   cS = 100;
 
-    for(uint16_t i = 0; i < plcSize; i++) { // looking for lowest codeString
-        int16_t posCodec = indexOf(m_playlistContent[i], "CODECS=\"mp4a");
-        if(posCodec > 0){
-            bool found = false;
-            for(uint8_t j = 0; j < sizeof(codecString); j++){
-                if(indexOf(m_playlistContent[i], codecString[j]) > 0){
-                    if(j < cS){cS = j; choosenLine = i;}
-                    found = true;
-                }
+    for(uint16_t i = 0; i < m_m3u8.variants(); i++) { // looking for lowest codeString
+        const char* codecs = m_m3u8.variant(i).codecs;
+        if(!startsWith(codecs, "mp4a")) continue;
+        bool found = false;
+        for(uint8_t j = 0; j < sizeof(codecString) / sizeof(codecString[0]); j++){
+            if(indexOf(codecs, codecString[j]) >= 0){
+                if(j < cS){cS = j; choosen = i;}
+                found = true;
             }
-            if(!found) log_w("codeString %s not in list", m_playlistContent[i] + posCodec);
         }
-        if(cS == 0)            *codec = CODEC_MP3;
-        if(cS > 0 && cS < 100) *codec = CODEC_AAC;
+        if(!found) log_w("codeString %s not in list", codecs);
     }
+    if(cS == 0) *codec = CODEC_MP3;
+    else        *codec = CODEC_AAC;                   // "mp4a.xx.xx" not found: assume AAC
 
-    char* tmp = nullptr;
-    choosenLine++; // next line is the redirection url
-
-    if(cS == 100) {                             // "mp4a.xx.xx" not found
-        *codec = CODEC_AAC;                     // assume AAC
-        for(uint16_t i = 0; i < plcSize; i++) { // we have no codeString, looking for "http"
-            if(startsWith(m_playlistContent[i], "http")) choosenLine = i;
+    if(cS == 100) {                                 // we have no codeString, looking for "http"
+        for(uint16_t i = 0; i < m_m3u8.variants(); i++) {
+            if(startsWith(m_m3u8.variant(i).uri, "http")) choosen = i;
         }
     }
 
-    // if((!endsWith(m_playlistContent[choosenLine], "m3u8") && indexOf(m_playlistContent[choosenLine], "m3u8?") == -1)) {
-    //     // we have a new m3u8 playlist, skip to next line
-    //     int pos = indexOf(m_playlistContent[choosenLine - 1], "CODECS=\"mp4a", 18);
-    //     if(pos < 0) { // not found
-    //         int pos1 = indexOf(m_playlistContent[choosenLine - 1], "CODECS=", 18);
-    //         if(pos1 < 0) pos1 = 0;
-    //         log_e("codec %s in m3u8 playlist not supported", m_playlistContent[choosenLine - 1] + pos1);
-    //         goto exit;
-    //     }
-    // }
-
-
-    if(!startsWith(m_playlistContent[choosenLine], "http")) {
-
-        // http://livees.com/prog_index.m3u8 and prog_index48347.aac -->
-        // http://livees.com/prog_index48347.aac http://livees.com/prog_index.m3u8 and chunklist022.m3u8 -->
-        // http://livees.com/chunklist022.m3u8
-
-        tmp = (char*)malloc(strlen(m_lastHost) + strlen(m_playlistContent[choosenLine]));
-        strcpy(tmp, m_lastHost);
-        int idx1 = lastIndexOf(tmp, "/");
-        strcpy(tmp + idx1 + 1, m_playlistContent[choosenLine]);
-    }
-    else { tmp = strdup(m_playlistContent[choosenLine]); }
-
-    if(startsWith(m_playlistContent[choosenLine], "../")){
-        // ../../2093120-b/RISMI/stream01/streamPlaylist.m3u8
-        x_ps_free(&tmp);
-        tmp = (char*)malloc(strlen(m_lastHost) + strlen(m_playlistContent[choosenLine] + 1));
-        strcpy(tmp, m_lastHost);
-        int idx1 = lastIndexOf(tmp, "/");
-        tmp[idx1] = '\0';
-
-        while(startsWith(m_playlistContent[choosenLine], "../")){
-            memcpy(m_playlistContent[choosenLine], m_playlistContent[choosenLine] + 3, strlen(m_playlistContent[choosenLine] +3) + 1); // shift << 3
-            idx1 = lastIndexOf(tmp, "/");
-            tmp[idx1] = '\0';
-        }
-        strcat(tmp, "/");
-        strcat(tmp, m_playlistContent[choosenLine]);
-    }
-
-    if(m_playlistContent[choosenLine]) {
-        x_ps_free(&m_playlistContent[choosenLine]);
-    }
+    // http://livees.com/prog_index.m3u8 and chunklist022.m3u8 --> http://livees.com/chunklist022.m3u8
+    // http://livees.com/a/b/prog_index.m3u8 and ../../2093120-b/streamPlaylist.m3u8 --> http://livees.com/2093120-b/streamPlaylist.m3u8
+    const char* uri = m_m3u8.variant(choosen).uri;
+    uint16_t    size = strlen(m_lastHost) + strlen(uri) + 2;
+    char*       tmp = x_ps_malloc(size);
+    if(tmp && !M3u8::resolve(m_lastHost, uri, tmp, size)) x_ps_free(&tmp);
 
     return tmp; // it's a redirection, a new m3u8 playlist
 }
 //****************************************************************************************
-uint64_t Audio::m3u8_findMediaSeqInURL() { // We have no clue what the media sequence is
-/*
-myList:     #EXTM3U
-            #EXT-X-VERSION:3
-            #EXT-X-TARGETDURATION:4
-            #EXT-X-MEDIA-SEQUENCE:227213779
-            #EXT-X-DISCONTINUITY-SEQUENCE:0
-            #EXTINF:3.008,
-            #MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316100954"
-            media-ur748eh1d_b192000_227213779.aac
-            #EXTINF:3.008,
-            #MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316100957"
-            media-ur748eh1d_b192000_227213780.aac
-            #EXTINF:3.008,
-            #MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316101000"
-            media-ur748eh1d_b192000_227213781.aac
-            #EXTINF:3.008,
-            #MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316101003"
-            media-ur748eh1d_b192000_227213782.aac
-            #EXTINF:3.008,
-            #MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316101006"
-            media-ur748eh1d_b192000_227213783.aac
-            #EXTINF:3.008,
-            #MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316101009"
-            media-ur748eh1d_b192000_227213784.aac
-
-result:     m_linesWithSeqNr[0] = #EXTINF:3.008,#MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316100954"media-ur748eh1d_b192000_227213779.aac
-            m_linesWithSeqNr[1] = #EXTINF:3.008,#MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316100957"media-ur748eh1d_b192000_227213780.aac
-            m_linesWithSeqNr[2] = #EXTINF:3.008,#MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316101000"media-ur748eh1d_b192000_227213781.aac
-            m_linesWithSeqNr[3] = #EXTINF:3.008,#MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316101003"media-ur748eh1d_b192000_227213782.aac
-            m_linesWithSeqNr[4] = #EXTINF:3.008,#MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316101006"media-ur748eh1d_b192000_227213783.aac
-            m_linesWithSeqNr[5] = #EXTINF:3.008,#MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20250316101009"media-ur748eh1d_b192000_227213784.aac */
-
-    std::vector<char*> m_linesWithSeqNr;
-    bool addNextLine = false;
-    int idx = -1;
-    for(uint16_t i = 0; i < m_playlistContent.size(); i++) {
-    //  log_w("pl%i = %s", i, m_playlistContent[i]);
-        if(!startsWith(m_playlistContent[i], "#EXTINF:") && addNextLine) {
-            m_linesWithSeqNr[idx] = x_ps_realloc(m_linesWithSeqNr[idx], strlen(m_linesWithSeqNr[idx]) + strlen(m_playlistContent[i]) + 1);
-            if(!m_linesWithSeqNr[idx]) { log_e("realloc failed"); return UINT64_MAX; }
-            strcat(m_linesWithSeqNr[idx], m_playlistContent[i]);
-        }
-        if(startsWith(m_playlistContent[i], "#EXTINF:")) {
-            idx++;
-            m_linesWithSeqNr.push_back(x_ps_strdup(m_playlistContent[i]));
-            addNextLine = true;
-        }
-    }
-
-    // for (uint16_t i = 0; i < m_linesWithSeqNr.size(); i++) {
-    //     log_w("m_linesWithSeqNr[%i] = %s", i, m_linesWithSeqNr[i]);
-    // }
-
-    if(m_linesWithSeqNr.size() < 2) {
-        log_e("not enough lines with \"#EXTINF:\" found");
-        return UINT64_MAX;
-    }
-
-    // Look for differences from right:                                                    ∨
-    // http://lampsifmlive.mdc.akamaized.net/strmLampsi/userLampsi/l_50551_3318804060_229668.aac
-    // http://lampsifmlive.mdc.akamaized.net/strmLampsi/userLampsi/l_50551_3318810050_229669.aac
-    // go back to first digit:                                                        ∧
-
-
-    int16_t len = strlen(m_linesWithSeqNr[0]) - 1;
-    int16_t qm = indexOf(m_linesWithSeqNr[0], "?", 0);
-    if(qm > 0) len = qm; // If we find a question mark, look to the left of it
-
-    char*    pEnd;
-    uint64_t MediaSeq = 0;
-    char     llasc[21]; // uint64_t max = 18,446,744,073,709,551,615  thats 20 chars + \0
-
-    for(int16_t pos = len; pos >= 0; pos--) {
-        if(isdigit(m_linesWithSeqNr[0][pos])) {
-            while(isdigit(m_linesWithSeqNr[0][pos])) pos--;
-            pos++;
-            uint64_t a, b, c;
-            a = strtoull(m_linesWithSeqNr[0] + pos, &pEnd, 10);
-            b = a + 1;
-            c = b + 1;
-            lltoa(b, llasc, 10);
-            int16_t idx_b = indexOf(m_linesWithSeqNr[1], llasc, pos - 1);
-            while(m_linesWithSeqNr[1][idx_b - 1] == '0') {idx_b--;} // Jump at the beginning of the leading zeros, if any
-            lltoa(c, llasc, 10);
-            int16_t idx_c = indexOf(m_linesWithSeqNr[2], llasc, pos - 1);
-            while(m_linesWithSeqNr[2][idx_c - 1] == '0') {idx_c--;} // Jump at the beginning of the leading zeros, if any
-            if(idx_b > 0 && idx_c > 0 && idx_b - pos < 3 && idx_c - pos < 3) { // idx_b and idx_c must be positive and near pos
-                MediaSeq = a;
-                AUDIO_INFO("media sequence number: %llu", MediaSeq);
-                break;
-            }
-        }
-    }
-    vector_clear_and_shrink(m_linesWithSeqNr);
-    return MediaSeq;
-}
-
-//****************************************************************************************
-bool Audio::STfromEXTINF(char* str) {
+bool Audio::STfromEXTINF(const char* str) {
     // the result is copied in chbuf!!
     // extraxt StreamTitle from m3u #EXTINF line to icy-format
     // orig: #EXTINF:10,title="text="TitleName",artist="ArtistName"
@@ -3254,7 +3537,8 @@ bool Audio::STfromEXTINF(char* str) {
         n0 = 12;
         t2 = t1 + 7; // title="
         t3 = indexOf(str, "\"", t2);
-        while(str[t3 - 1] == '\\') { t3 = indexOf(str, "\"", t3 + 1); }
+        if(t3 < 0) return false;
+        while(str[t3 - 1] == '\\') { t3 = indexOf(str, "\"", t3 + 1); if(t3 < 0) return false; }
         if(t2 < 0 || t2 > t3) return false;
         n1 = t3 - t2;
         strncpy(m_chbuf + n0, str + t2, n1);
@@ -3298,7 +3582,12 @@ void Audio::processLocalFile() {
     }
     availableBytes = InBuff.writeSpace();
 
-    int32_t bytesAddedToBuffer = audiofile.read(InBuff.getWritePtr(), availableBytes);
+    int32_t bytesAddedToBuffer;
+    if(m_f_readAhead) {
+        bytesAddedToBuffer = m_ra.take(InBuff.getWritePtr(), availableBytes);
+        if(bytesAddedToBuffer > 0) xTaskNotifyGive(m_raTask); // a block may be free for the next read
+    }
+    else bytesAddedToBuffer = audiofile.read(InBuff.getWritePtr(), availableBytes);
     if(bytesAddedToBuffer > 0) {InBuff.bytesWritten(bytesAddedToBuffer);}
 
     if(!m_f_stream) {
@@ -3322,7 +3611,9 @@ void Audio::processLocalFile() {
         }
         else {
             m_f_stream = true;
+            m_ttfs.once(Ttfs::PREBUFFER, millis());
             AUDIO_INFO("stream ready");
+            readAheadStart(audiofile.position()); // the header is read, from here on the file is read in blocks
         }
     }
 
@@ -3332,6 +3623,7 @@ void Audio::processLocalFile() {
     }
 
     if(m_resumeFilePos >= 0) {
+        readAheadStop();                                  // the resume position is looked for in the file
         if(m_resumeFilePos <  (int32_t)m_audioDataStart) m_resumeFilePos = m_audioDataStart;
         if(m_resumeFilePos >= (int32_t)m_audioDataStart + m_audioDataSize) {goto exit;}
         m_haveNewFilePos = m_resumeFilePos;
@@ -3347,6 +3639,7 @@ void Audio::processLocalFile() {
             while(m_f_audioTaskIsDecoding) vTaskDelay(1); // We can't reset the InBuffer while the decoding is in progress
             audiofile.seek(m_resumeFilePos);
             InBuff.resetBuffer();
+            readAheadStart(m_resumeFilePos);
             m_sumBytesDecoded = m_haveNewFilePos = m_resumeFilePos;
             m_resumeFilePos = -1;
             if(m_codec == CODEC_MP3) MP3Decoder_ClearBuffer();
@@ -3355,10 +3648,12 @@ void Audio::processLocalFile() {
 
     // end of file reached? - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_eof){ // m_f_eof and m_f_ID3v1TagFound will be set in playAudioData()
+        readAheadStop();
         if(m_f_loop){ // file loop
             m_sumBytesDecoded = m_haveNewFilePos = m_audioDataStart;
             audiofile.seek(m_audioDataStart);
             InBuff.resetBuffer();
+            readAheadStart(m_audioDataStart);
             AUDIO_INFO("file loop");
             m_f_eof = false;
             return;
@@ -3391,32 +3686,85 @@ exit:
     }
 }
 //****************************************************************************************
+void Audio::readAheadStart(uint32_t pos) { // the player's task, audiofile is at pos
+#if SD_READAHEAD_KB > 0
+    if(!m_raMem) {
+        if(heap_caps_get_free_size(MALLOC_CAP_DMA) >= SD_READAHEAD_KB * 1024 + I2S_DMA_MIN_HEAP)
+            m_raMem = (uint8_t*)heap_caps_malloc(SD_READAHEAD_KB * 1024, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if(!m_raMem || !m_ra.begin(m_raMem, SD_READAHEAD_KB * 1024, SD_READAHEAD_BLOCK)) {
+            log_w("no memory for the read-ahead, the file is read directly");
+            return;
+        }
+    }
+    if(!m_ra.ready()) return;
+    if(!m_raTask) xTaskCreatePinnedToCore(readAheadTask, "ReadAhead", 3072, this, SD_READAHEAD_PRIORITY, &m_raTask, SD_READAHEAD_CORE_ID);
+    if(!m_raTask) return;
+    xSemaphoreTake(mutex_file, portMAX_DELAY);
+    m_ra.reset(pos, audiofile.size());
+    m_f_readAhead = true;
+    xSemaphoreGive(mutex_file);
+    xTaskNotifyGive(m_raTask);
+#endif
+}
+//****************************************************************************************
+void Audio::readAheadStop(bool release) { // when it returns the task is out of the file, audiofile is the caller's again
+    if(m_f_readAhead) {
+        xSemaphoreTake(mutex_file, portMAX_DELAY);
+        m_f_readAhead = false;
+        xSemaphoreGive(mutex_file);
+    }
+    if(release && m_raMem) {m_ra.end(); heap_caps_free(m_raMem); m_raMem = NULL;} // begin() again at the next start
+}
+//****************************************************************************************
+bool Audio::readAheadFill() { // one block from the card into the ring, false: nothing to do
+    bool done = false;
+    xSemaphoreTake(mutex_file, portMAX_DELAY);
+    uint32_t pos, len;
+    uint8_t* dst = m_f_readAhead ? m_ra.space(&pos, &len) : NULL;
+    if(dst) {
+        if(audiofile.position() != pos) audiofile.seek(pos);
+        m_ra.filled(audiofile.read(dst, len));
+        done = true;
+    }
+    xSemaphoreGive(mutex_file);
+    return done;
+}
+//****************************************************************************************
+void Audio::readAheadTask(void* param) {
+    Audio* audio = static_cast<Audio*>(param);
+    for(;;) {
+        if(!audio->readAheadFill()) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50)); // the player took a block or a new file began
+    }
+}
+//****************************************************************************************
 void Audio::processWebStream() {
 
     if(m_dataMode != AUDIO_DATA) return; // guard
 
     const uint16_t  maxFrameSize = InBuff.getMaxBlockSize(); // every mp3/aac frame is not bigger
-    static uint32_t chunkSize;                               // chunkcount read from stream
 
     // first call, set some values to default  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_firstCall) { // runs only ont time per connection, prepare for start
         m_f_firstCall = false;
-        m_f_stream = false;
-        chunkSize = 0;
         m_metacount = m_metaint;
-        readMetadata(0, true); // reset all static vars
+        readMetadata(true); // reset all static vars
+        m_rxT = millis();
+        if(m_reconn.active()) {  // reconnected: keep playing, the new data is spliced in at a frame sync
+            m_f_resync = true;
+            m_prebuf.resume(m_rxT);
+        }
+        else {
+            m_f_stream = false;
+            m_prebuf.begin(m_pbStartMs, m_pbResumeMs, m_rxT);
+            m_stableT0 = m_rxT;
+            m_watch.arm(m_rxT);
+        }
     }
-    uint32_t availableBytes = _client->available(); // available from stream
+    uint32_t availableBytes = bodyAvailable(); // available from stream, chunked framing included (readBody takes it out)
 
-    // chunked data tramsfer - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_f_chunked && availableBytes) {
-        uint8_t readedBytes = 0;
-        if(!chunkSize) chunkSize = chunkedDataTransfer(&readedBytes);
-        availableBytes = min(availableBytes, chunkSize);
-    }
     // we have metadata  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_metadata && availableBytes) {
-        if(m_metacount == 0) { chunkSize -= readMetadata(availableBytes); return; }
+        if(m_metacount == 0) { readMetadata(); return; }
         availableBytes = min(availableBytes, m_metacount);
     }
 
@@ -3425,28 +3773,71 @@ void Audio::processWebStream() {
         if(streamDetection(availableBytes)) return;
     }
 
+    // timeshift paused and ring full: drop the oldest data instead of stalling the connection  - - - - - - - - - - -
+    if(m_f_tsPaused && availableBytes > InBuff.freeSpace()) {
+        uint32_t drop = availableBytes - InBuff.freeSpace();
+        m_spliceLeft = m_spliceLeft > drop ? m_spliceLeft - drop : 0;
+        InBuff.bytesWasRead(drop);
+    }
+
     // buffer fill routine - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(availableBytes) {
         availableBytes = min(availableBytes, (uint32_t)InBuff.writeSpace());
-        int32_t bytesAddedToBuffer = _client->read(InBuff.getWritePtr(), availableBytes);
+        int32_t bytesAddedToBuffer = readBody(InBuff.getWritePtr(), availableBytes);
+        if(bytesAddedToBuffer < 0) { if(!reconnectStart("framing broken")) stopSong(); return; }
 
         if(bytesAddedToBuffer > 0) {
+            m_rxT = millis();
             if(m_f_metadata) m_metacount -= bytesAddedToBuffer;
-            if(m_f_chunked) chunkSize -= bytesAddedToBuffer;
-            InBuff.bytesWritten(bytesAddedToBuffer);
+            m_prebuf.arrival(m_rxT, bytesAddedToBuffer);
+            m_watch.input(bytesAddedToBuffer);
+            if(m_f_resync) reconnectSplice(InBuff.getWritePtr(), &bytesAddedToBuffer);
+            if(bytesAddedToBuffer > 0) {
+                if(audio_process_stream) audio_process_stream(InBuff.getWritePtr(), bytesAddedToBuffer);
+                InBuff.bytesWritten(bytesAddedToBuffer);
+            }
+        }
+    }
+
+    // closed or stalled connection: reconnect while the buffer plays on - - - - - - - - - - - - - - - - - - - - - - -
+    else if(millis() - m_rxT > 100) {
+        if(millis() - m_rxT > m_reconnStallMs) { if(reconnectStart("stalled")) return; }
+        else if(!_client->connected()) { if(reconnectStart("closed")) return; }
+    }
+
+    // the connection is up, but silence, a looping buffer, a stuck decoder or a trickle: the player decides  - - - -
+    if(m_f_tsPaused || m_reconn.active()) m_watch.hold(millis());
+    else {
+        bool known = m_avr_bitrate || m_bitRate || h_bitRate;   // a guessed bitrate would make every slower stream starve
+        uint8_t why = m_watch.check(millis(), m_f_stream && !m_f_prebuffering, InBuff.bufferFilled(), known ? streamBytesPerSec() : 0);
+        if(why) {
+            AUDIO_INFO("stream %s, still connected", StreamWatch::name(why));
+            if(audio_watch) audio_watch(why);
         }
     }
 
+    // a long run without underrun lowers the learned prebuffer - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    if(m_f_stream && !m_f_prebuffering && m_prebuf.stable(millis())) {
+        if(audio_prebuffer) audio_prebuffer(m_prebuf.learnedStart(), m_prebuf.learnedResume(), true);
+    }
+    if(m_f_stream && millis() - m_stableT0 > m_reconnStableMs) { // and a long run without a drop the health of the station
+        m_stableT0 = millis();
+        if(audio_reconnect) audio_reconnect(Reconnect::STABLE, 0, m_reconnStableMs);
+    }
+
     // start audio decoding - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(InBuff.bufferFilled() > maxFrameSize && !m_f_stream) { // waiting for buffer filled
+    uint32_t startBytes = max((uint32_t)maxFrameSize, prebufferBytes(m_prebuf.startMs()));
+    if(InBuff.bufferFilled() > startBytes && !m_f_stream) { // waiting for buffer filled
         if(m_codec == CODEC_OGG) { 					// log_i("determine correct codec here");
             uint8_t codec = determineOggCodec(InBuff.getReadPtr(), maxFrameSize);
             if(codec == CODEC_FLAC) {initializeDecoder(codec); m_codec = codec; audio_info("format is flac");}
             if(codec == CODEC_OPUS) {initializeDecoder(codec); m_codec = codec; audio_info("format is opus");}
             if(codec == CODEC_VORBIS) {initializeDecoder(codec); m_codec = codec; audio_info("format is vorbis");}
         }
-        AUDIO_INFO("stream ready");
+        AUDIO_INFO("stream ready, prebuffer %u ms (%lu bytes), jitter %lu ms, first sound after %lu ms", m_prebuf.startMs(),
+                   (long unsigned int)startBytes, (long unsigned int)m_prebuf.jitterMs(), (long unsigned int)(millis() - m_pbT0));
         m_f_stream = true; 							// ready to play the audio data
+        m_ttfs.once(Ttfs::PREBUFFER, millis());
 
     }
 }
@@ -3454,7 +3845,6 @@ void Audio::processWebStream() {
 void Audio::processWebFile() {
     if(!m_lastHost) {log_e("m_lastHost is NULL"); return;}   		// guard
     const uint32_t  maxFrameSize = InBuff.getMaxBlockSize(); // every mp3/aac frame is not bigger
-    static uint32_t chunkSize; 				// chunkcount read from stream
     static size_t   audioDataCount; 			// counts the decoded audiodata only
     static uint32_t byteCounter;                             // count received data
 
@@ -3463,7 +3853,6 @@ void Audio::processWebFile() {
         m_f_firstCall = false;
         m_t0 = millis();
         byteCounter = 0;
-        chunkSize = 0;
         audioDataCount = 0;
         m_f_stream = false;
         m_audioDataSize = m_contentlength;
@@ -3472,19 +3861,9 @@ void Audio::processWebFile() {
 
 //    if(!m_contentlength && !m_f_tts) { log_e("webfile without contentlength!"); stopSong(); return; } 	// guard
 
-    uint32_t availableBytes = _client->available(); 		// available from stream
-
-    // chunked data tramsfer - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_f_chunked && availableBytes) {
-        uint8_t readedBytes = 0;
-        if(m_f_chunked && chunkSize == byteCounter) {
-            chunkSize += chunkedDataTransfer(&readedBytes);
-            m_contentlength += chunkSize;
-        }
-        availableBytes = min(availableBytes, chunkSize - byteCounter);
-    }
+    uint32_t availableBytes = bodyAvailable(); 		// available from stream
 
-    if(!m_contentlength && !chunkSize) {
+    if(!m_contentlength && !m_f_chunked) {
         log_e("webfile is not chunked or is without contentlength!");
         stopSong();
         return;
@@ -3493,19 +3872,20 @@ void Audio::processWebFile() {
     // if the buffer is often almost empty issue a warning - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_stream) {if(streamDetection(availableBytes)) return;}
     availableBytes = min(availableBytes, (uint32_t)InBuff.writeSpace());
-    int32_t bytesAddedToBuffer = _client->read(InBuff.getWritePtr(), availableBytes);
+    int32_t bytesAddedToBuffer = readBody(InBuff.getWritePtr(), availableBytes);
+    if(bytesAddedToBuffer < 0) { stopSong(); return; }
 
     if(bytesAddedToBuffer > 0) {
         m_webFilePos += bytesAddedToBuffer;
         byteCounter += bytesAddedToBuffer;
-        if(m_f_chunked) m_chunkcount -= bytesAddedToBuffer;
         if(m_controlCounter == 100) audioDataCount += bytesAddedToBuffer;
         InBuff.bytesWritten(bytesAddedToBuffer);
     }
+    if(m_f_chunked) m_contentlength = byteCounter + m_http.left(); 	// as far as the chunk sizes tell, all of it once done
 
     // we have a webfile, read the file header first - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter != 100) {
-        if(InBuff.bufferFilled() > maxFrameSize || (InBuff.bufferFilled() == m_contentlength)) { // at least one complete frame or the file is smaller
+        if(InBuff.bufferFilled() > maxFrameSize || (m_contentlength && InBuff.bufferFilled() == m_contentlength)) { // at least one complete frame or the file is smaller
             int32_t bytesRead = readAudioHeader(InBuff.getMaxAvailableBytes());
             if(bytesRead > 0) InBuff.bytesWasRead(bytesRead);
         }
@@ -3522,6 +3902,7 @@ void Audio::processWebFile() {
 
     if(!m_f_stream && m_controlCounter == 100) {
         m_f_stream = true; // ready to play the audio data
+        m_ttfs.once(Ttfs::PREBUFFER, millis());
         uint16_t filltime = millis() - m_t0;
         AUDIO_INFO("Webfile: stream ready, buffer filled in %d ms", filltime);
         return;
@@ -3559,89 +3940,77 @@ void Audio::processWebStreamTS() {
     uint32_t        availableBytes; 				// available bytes in stream
     static bool     f_firstPacket;
     static bool     f_chunkFinished;
-    static bool     f_nextRound;
-    static uint32_t byteCounter;    				// count received data
-    static uint8_t  ts_packet[188]; 				// m3u8 transport stream is 188 bytes long
-    uint8_t         ts_packetStart = 0;
-    uint8_t         ts_packetLength = 0;
-    static uint8_t  ts_packetPtr = 0;
-    const uint8_t   ts_packetsize = 188;
-    static size_t   chunkSize = 0;
+    static uint16_t tsFill;         				// bytes in m_tsBuf, a packet cut off by the last read comes first
+    static uint32_t id3Skip;        				// ID3 header in front of the first packet
+    static uint16_t audioPid;
+    static uint32_t tsErrors;
+    TsDemux::span_t spans[TS_BATCH];
+    uint16_t        nSpans = 0;
 
     // first call, set some values to default - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_firstCall) { 						// runs only ont time per connection, prepare for start
         f_firstPacket = true;
         f_chunkFinished = false;
-        f_nextRound = false;
-        byteCounter = 0;
-        chunkSize = 0;
         m_t0 = millis();
-        ts_packetPtr = 0;
+        tsFill = 0;
+        id3Skip = 0;
+        audioPid = 0;
+        tsErrors = 0;
         m_controlCounter = 0;
         m_f_firstCall = false;
+        if(!m_tsBuf) m_tsBuf = (uint8_t*)x_ps_malloc(TS_BATCH * TS_PACKET_SIZE);
     }
+    if(!m_tsBuf) { stopSong(); return; }
 
     if(m_dataMode != AUDIO_DATA) return; 		// guard
 
 nextRound:
-    availableBytes = _client->available();
+    nSpans = 0;
+    availableBytes = bodyAvailable();
     if(availableBytes) {
-
-        /* If the m3u8 stream uses 'chunked data transfer' no content length is supplied. Then the chunk size determines the audio data to be processed.
-           However, the chunk size in some streams is limited to 32768 bytes, although the chunk can be larger. Then the chunk size is
-           calculated again. The data used to calculate (here readedBytes) the chunk size is not part of it.
-        */
-        uint8_t readedBytes = 0;
-        uint32_t minAvBytes = 0;
-        if(m_f_chunked && chunkSize == byteCounter) {chunkSize += chunkedDataTransfer(&readedBytes); goto exit;}
-        if(chunkSize) minAvBytes = min3(availableBytes, ts_packetsize - ts_packetPtr, chunkSize - byteCounter);
-        else          minAvBytes = min(availableBytes, (uint32_t)(ts_packetsize - ts_packetPtr));
-
-        int res = _client->read(ts_packet + ts_packetPtr, minAvBytes);
+        // up to TS_BATCH packets with one read, not more than InBuff takes (the payload is less); readBody stops at the
+        // end of the segment and takes the chunked framing out, wherever it falls in the packets
+        uint32_t n = min3(availableBytes, TS_BATCH * TS_PACKET_SIZE - tsFill, InBuff.freeSpace());
+        int res = n ? readBody(m_tsBuf + tsFill, n) : 0;
+        if(res < 0) { stopSong(); return; }
         if(res > 0) {
-            ts_packetPtr += res;
-            byteCounter += res;
-            if(ts_packetPtr < ts_packetsize) return; // not enough data yet, the process must be repeated if the packet size (188 bytes) is not reached
-            ts_packetPtr = 0;
-            if(f_firstPacket) { 				// search for ID3 Header in the first packet
+            tsFill += res;
+            uint32_t used = 0;
+            if(f_firstPacket && tsFill >= TS_PACKET_SIZE) { 	// search for ID3 Header in the first packet
                 f_firstPacket = false;
-                uint8_t ID3_HeaderSize = process_m3u8_ID3_Header(ts_packet);
-                if(ID3_HeaderSize > ts_packetsize) {
-                    log_e("ID3 Header is too big");
-                    stopSong();
-                    return;
-                }
-                if(ID3_HeaderSize) {
-                    memcpy(ts_packet, &ts_packet[ID3_HeaderSize], ts_packetsize - ID3_HeaderSize);
-                    ts_packetPtr = ts_packetsize - ID3_HeaderSize;
-                    return;
-                }
+                id3Skip = process_m3u8_ID3_Header(m_tsBuf);
             }
-            ts_parsePacket(&ts_packet[0], &ts_packetStart, &ts_packetLength); // todo: check for errors
+            if(id3Skip) { used = min(id3Skip, (uint32_t)tsFill); id3Skip -= used; }
 
-            if(ts_packetLength) {
+            used += m_ts.parse(m_tsBuf + used, tsFill - used, spans, TS_BATCH, &nSpans);
+            for(uint16_t i = 0; i < nSpans; i++) { 				// the payload goes from m_tsBuf to InBuff, nothing in between
                 size_t ws = InBuff.writeSpace();
-                if(ws >= ts_packetLength) {
-                    memcpy(InBuff.getWritePtr(), ts_packet + ts_packetStart, ts_packetLength);
-                    InBuff.bytesWritten(ts_packetLength);
-                    f_nextRound = true;
+                if(ws >= spans[i].len) {
+                    memcpy(InBuff.getWritePtr(), spans[i].data, spans[i].len);
+                    InBuff.bytesWritten(spans[i].len);
                 }
                 else {
-                    memcpy(InBuff.getWritePtr(), ts_packet + ts_packetStart, ws);
+                    memcpy(InBuff.getWritePtr(), spans[i].data, ws);
                     InBuff.bytesWritten(ws);
-                    memcpy(InBuff.getWritePtr(), &ts_packet[ws + ts_packetStart], ts_packetLength - ws);
-                    InBuff.bytesWritten(ts_packetLength - ws);
+                    memcpy(InBuff.getWritePtr(), spans[i].data + ws, spans[i].len - ws);
+                    InBuff.bytesWritten(spans[i].len - ws);
                 }
             }
-            if (byteCounter == m_contentlength || byteCounter == chunkSize) {
-                f_chunkFinished = true;
-                f_nextRound = false;
-                byteCounter = 0;
-                int av = _client->available();
-                if(av == 7) for(int i = 0; i < av; i++) _client->read(); // waste last chunksize: 0x0D 0x0A 0x30 0x0D 0x0A 0x0D 0x0A (==0, end of chunked data transfer)
+            tsFill -= used;
+            if(tsFill) memmove(m_tsBuf, m_tsBuf + used, tsFill);
+            if(m_ts.audioPid() != audioPid) {
+                audioPid = m_ts.audioPid();
+                if(m_f_Log) log_i("TS audio PID 0x%04X, stream type 0x%02X", audioPid, m_ts.streamType());
+            }
+        }
+        if(n && m_http.done()) { 						// end of the segment, the last chunk may come without payload
+            f_chunkFinished = true;
+            tsFill = 0; 							// a packet cut off at the end of the segment
+            if(m_ts.ccErrors() + m_ts.resyncs() + m_ts.badPackets() != tsErrors) {
+                tsErrors = m_ts.ccErrors() + m_ts.resyncs() + m_ts.badPackets();
+                log_w("TS: %lu packets lost, %lu resyncs (%lu bytes skipped), %lu bad packets", (long unsigned int)m_ts.ccErrors(),
+                      (long unsigned int)m_ts.resyncs(), (long unsigned int)m_ts.dropped(), (long unsigned int)m_ts.badPackets());
             }
-            if(m_contentlength && byteCounter > m_contentlength) {log_e("byteCounter overflow, byteCounter: %d, contentlength: %d", byteCounter, m_contentlength); return;}
-            if(chunkSize       && byteCounter > chunkSize)       {log_e("byteCounter overflow, byteCounter: %d, chunkSize: %d",     byteCounter, chunkSize); return;}
         }
     }
     if(f_chunkFinished) {
@@ -3666,12 +4035,13 @@ nextRound:
     if(true) {                                                  // statement has no effect
         if(InBuff.bufferFilled() > 60000 && !m_f_stream) {     // waiting for buffer filled
             m_f_stream = true;                                  // ready to play the audio data
+            m_ttfs.once(Ttfs::PREBUFFER, millis());
             uint16_t filltime = millis() - m_t0;
             AUDIO_INFO("stream ready");
             AUDIO_INFO("buffer filled in %d ms", filltime);
         }
     }
-    if(f_nextRound){goto nextRound;}
+    if(nSpans && !f_chunkFinished) {goto nextRound;}
 exit:
     return;
 }
@@ -3684,8 +4054,6 @@ void Audio::processWebStreamHLS() {
     uint32_t        availableBytes; 				// available bytes in stream
     static bool     firstBytes;
     static bool     f_chunkFinished;
-    static uint32_t byteCounter; 				// count received data
-    static size_t   chunkSize = 0;
     static uint16_t ID3WritePtr;
     static uint16_t ID3ReadPtr;
     static uint8_t* ID3Buff;
@@ -3695,8 +4063,6 @@ void Audio::processWebStreamHLS() {
         m_f_firstCall = false;
         m_f_m3u8data = true;
         f_chunkFinished = false;
-        byteCounter = 0;
-        chunkSize = 0;
         ID3WritePtr = 0;
         ID3ReadPtr = 0;
         m_t0 = millis();
@@ -3708,15 +4074,13 @@ void Audio::processWebStreamHLS() {
 
     if(m_dataMode != AUDIO_DATA) return; 		// guard
 
-    availableBytes = _client->available();
+    availableBytes = bodyAvailable();
     if(availableBytes) { 						// an ID3 header could come here
-        uint8_t readedBytes = 0;
-
-        if(m_f_chunked && !chunkSize) { chunkSize = chunkedDataTransfer(&readedBytes); byteCounter += readedBytes; }
-
         if(firstBytes) {
             if(ID3WritePtr < ID3BuffSize) {
-                ID3WritePtr += _client->readBytes(&ID3Buff[ID3WritePtr], ID3BuffSize - ID3WritePtr);
+                int32_t res = readBody(&ID3Buff[ID3WritePtr], ID3BuffSize - ID3WritePtr);
+                if(res < 0) { stopSong(); return; }
+                ID3WritePtr += res;
                 return;
             }
             if(m_controlCounter < 100) {
@@ -3739,25 +4103,15 @@ void Audio::processWebStreamHLS() {
                 InBuff.bytesWritten(ID3BuffSize - (ID3ReadPtr + ws));
             }
             x_ps_free(&ID3Buff);
-            byteCounter += ID3BuffSize;
             ID3Buff = NULL;
             firstBytes = false;
         }
 
-        size_t bytesWasWritten = 0;
-        if(InBuff.writeSpace() >= availableBytes) {
-//            if(availableBytes > 1024) availableBytes = 1024; 					// 1K throttle
-            bytesWasWritten = _client->read(InBuff.getWritePtr(), availableBytes);
-        }
-        else { bytesWasWritten = _client->read(InBuff.getWritePtr(), InBuff.writeSpace()); }
+        int32_t bytesWasWritten = readBody(InBuff.getWritePtr(), min(availableBytes, (uint32_t)InBuff.writeSpace()));
+        if(bytesWasWritten < 0) { stopSong(); return; }
         InBuff.bytesWritten(bytesWasWritten);
 
-        byteCounter += bytesWasWritten;
-
-        if(byteCounter == m_contentlength || byteCounter == chunkSize) {
-            f_chunkFinished = true;
-            byteCounter = 0;
-        }
+        if(m_http.done()) f_chunkFinished = true; 		// end of the segment
     }
 
     if(f_chunkFinished) {
@@ -3777,6 +4131,7 @@ void Audio::processWebStreamHLS() {
 
     if(InBuff.bufferFilled() > maxFrameSize && !m_f_stream) { 		// waiting for buffer filled
         m_f_stream = true; 								// ready to play the audio data
+        m_ttfs.once(Ttfs::PREBUFFER, millis());
         uint16_t filltime = millis() - m_t0;
         AUDIO_INFO("stream ready");
         if(m_f_Log) AUDIO_INFO("buffer filled in %u ms", filltime);
@@ -3801,7 +4156,23 @@ void Audio::playAudioData() {
     }
 
     if(m_validSamples) {playChunk(); return;}    // play samples first
-    if(m_f_eof) return;
+    if(m_f_eof) {m_dmaTune.pause(); return;}     // no more writes to I2S, the DMA queue runs dry on purpose
+
+    if(!f_isFile && m_streamType == ST_WEBSTREAM && m_playlistFormat != FORMAT_M3U8) {
+        if(m_f_prebuffering) {                     // underrun, refill up to the resume threshold
+            if(InBuff.bufferFilled() < prebufferBytes(m_prebuf.resumeMs())) {m_dmaTune.pause(); return;}
+            m_f_prebuffering = false;
+        }
+        else if(InBuff.bufferFilled() < InBuff.getMaxBlockSize()) {
+            m_f_prebuffering = true;
+            m_dmaTune.pause();
+            if(m_reconn.active()) { m_reconn.dry(); return; } // ran out during a reconnect, not a reason to buffer more
+            m_prebuf.underrun(millis());
+            AUDIO_INFO("buffer underrun #%u, prebuffer now %u / %u ms", m_prebuf.underruns(), m_prebuf.learnedStart(), m_prebuf.learnedResume());
+            if(audio_prebuffer) audio_prebuffer(m_prebuf.learnedStart(), m_prebuf.learnedResume(), false);
+            return;
+        }
+    }
 
     if(m_f_lockInBuffer) return;
     m_f_audioTaskIsDecoding = true;
@@ -3812,8 +4183,13 @@ void Audio::playAudioData() {
         if(bytesToDecode < InBuff.getMaxBlockSize()) {lastFrame = true;}
         if(m_sumBytesDecoded >= m_audioDataSize && m_sumBytesDecoded != 0) { m_f_eof = true; goto exit; }
     }
-    if(!lastFrame) if(InBuff.bufferFilled() < InBuff.getMaxBlockSize()) goto exit;;
+    if(!lastFrame) if(InBuff.bufferFilled() < InBuff.getMaxBlockSize()) {m_dmaTune.pause(); goto exit;} // starved, not late
 
+    if(m_spliceLeft && frameLength(InBuff.getReadPtr()) > m_spliceLeft) { // the last frame before a reconnect is cut off, skip it
+        InBuff.bytesWasRead(m_spliceLeft);
+        m_sumBytesDecoded += m_spliceLeft;
+        m_spliceLeft = 0;
+    }
     bytesDecoded = sendBytes(InBuff.getReadPtr(), InBuff.getMaxBlockSize());
     if(!m_f_running) return;
 
@@ -3821,12 +4197,14 @@ void Audio::playAudioData() {
         next = 200;
         if(InBuff.bufferFilled() < next) next = InBuff.bufferFilled();
         InBuff.bytesWasRead(next); // try next chunk
+        m_spliceLeft = m_spliceLeft > next ? m_spliceLeft - next : 0;
         m_bytesNotDecoded += next;
         m_sumBytesDecoded += next;
     }
     else {
         if(bytesDecoded > 0) {
             InBuff.bytesWasRead(bytesDecoded);
+            m_spliceLeft = m_spliceLeft > (uint32_t)bytesDecoded ? m_spliceLeft - bytesDecoded : 0;
             m_sumBytesDecoded += bytesDecoded;
             if(f_isFile && m_codec == CODEC_MP3){
                 if (m_audioDataSize - m_sumBytesDecoded == 128){m_f_ID3v1TagFound = true; m_f_eof = true; goto exit;}
@@ -3845,227 +4223,158 @@ bool Audio::parseHttpResponseHeader() { 		// this is the response to a GET / req
     if(m_dataMode != HTTP_RESPONSE_HEADER) return false;
     if(!m_lastHost) {log_e("m_lastHost is NULL"); return false;}
 
-    uint32_t ctime = millis();
-    uint32_t timeout = 3000; 				// ms
-
-    static uint32_t stime;
-    static bool     f_time = false;
-
-    if(_client->available() == 0) {
-        if(!f_time) {
-            stime = millis();
-            f_time = true;
-        }
-        if((millis() - stime) > timeout) {
-            log_e("timeout");
-            f_time = false;
-            return false;
-        }
-    }
-    f_time = false;
+    // called by loop() until the header is complete: m_http takes what has arrived, read in blocks, and stops behind
+    // every line; a partly received line waits in m_rhl, the bytes read behind the header wait in m_rest (readBody)
+    uint32_t timeout = CONN_RESPONSE_MS;
+    bool&    ct_seen = m_f_ctSeen;
 
-    char rhl[512] = {0}; 					// responseHeaderline
-    bool ct_seen = false;
+    if(!m_rhlT0) { m_rhlT0 = millis(); m_http.begin(m_rhl, sizeof(m_rhl)); m_restPos = m_restLen = 0; ct_seen = false; }
 
     while(true) { 							// outer while
-        uint16_t pos = 0;
-        if((millis() - ctime) > timeout) {
+        if((millis() - m_rhlT0) > timeout) {
             log_e("timeout");
             m_f_timeout = true;
             goto exit;
         }
-        while(_client->available()) {
-            uint8_t b = _client->read();
-            if(b == '\n') {
-                if(!pos) { 						// empty line received, is the last line of this responseHeader
-                    if(ct_seen) goto lastToDo;
-                    else goto exit;
-                }
-                break;
-            }
-            if(b == '\r') rhl[pos] = 0;
-            if(b < 0x20) continue;
-            rhl[pos] = b;
-            pos++;
-            if(pos == 511) { pos = 510; continue; }
-            if(pos == 510) { rhl[pos] = '\0';
-                if(m_f_Log) log_i("responseHeaderline overflow");
-            }
-        } // inner while
-
-        if(!pos) { vTaskDelay(5); continue; }
-
-        int16_t posColon = indexOf(rhl, ":", 0); 	// lowercase all letters up to the colon
-        if(posColon >= 0) {
-            for(int i = 0; i < posColon; i++) { rhl[i] = toLowerCase(rhl[i]); }
-        }
-
-        if(startsWith(rhl, "HTTP/")) { 			// HTTP status error code
-            char statusCode[5];
-            statusCode[0] = rhl[9];
-            statusCode[1] = rhl[10];
-            statusCode[2] = rhl[11];
-            statusCode[3] = '\0';
-            int sc = atoi(statusCode);
-            if(sc > 310) { 					// e.g. HTTP/1.1 301 Moved Permanently
-                if(audio_showstreamtitle) audio_showstreamtitle(rhl);
-                AUDIO_ERROR(" %s", rhl);
+        if(m_restPos == m_restLen) {
+            int av = _client->available();
+            if(av <= 0) return true; 				// the rest has not arrived yet
+            int r = _client->read(m_rest, min(av, (int)sizeof(m_rest)));
+            if(r <= 0) return true;
+            m_restPos = 0;
+            m_restLen = r;
+        }
+        uint32_t used;
+        int8_t   ev = m_http.head((const char*)m_rest + m_restPos, m_restLen - m_restPos, used);
+        m_restPos += used;
+        if(ev == HttpParser::MORE) continue;
+        if(ev == HttpParser::FAILED) { AUDIO_INFO("no HTTP response from %s", m_lastHost); goto exit; }
+        if(ev == HttpParser::END) { 			// empty line received, is the last line of this responseHeader
+            m_ttfs.mark(Ttfs::HEADERS, millis());
+            if(ct_seen) goto lastToDo;
+            else goto exit;
+        }
+        if(ev == HttpParser::STATUS) { 		// HTTP status error code
+            if(m_http.status() > 310) { 			// e.g. HTTP/1.1 404 Not Found
+                if(m_reconn.active()) { AUDIO_INFO(" %s", m_http.line()); goto exit; } // still playing, try again later
+                if(audio_showstreamtitle) audio_showstreamtitle(m_http.line());
+                AUDIO_ERROR(" %s", m_http.line());
                 goto exit;
             }
+            continue;
         }
 
-        else if(startsWith(rhl, "content-type:")) { 				// content-type: text/html; charset=UTF-8
-            // log_w("cT: %s", rhl);
-            int idx = indexOf(rhl + 13, ";");
-            if(idx > 0) rhl[13 + idx] = '\0';
-            if(parseContentType(rhl + 13)) ct_seen = true;
-            else{
-                AUDIO_ERROR("unknown contentType %s", rhl + 13);
-                goto exit;
+        char* val = m_http.value(); 				// the name is lowercased and known ones are m_http.field()
+        switch(m_http.field()) {
+            case HttpParser::H_CONTENT_TYPE: { 		// content-type: text/html; charset=UTF-8
+                int idx = indexOf(val, ";");
+                if(idx > 0) val[idx] = '\0';
+                if(parseContentType(val)) ct_seen = true;
+                else{
+                    AUDIO_ERROR("unknown contentType %s", val);
+                    goto exit;
+                }
+                break;
             }
-        }
-
-        else if(startsWith(rhl, "location:")) {
-            int pos = indexOf(rhl, "http", 0);
-            if(pos >= 0) {
-                const char* c_host = (rhl + pos);
-                if(strcmp(c_host, m_lastHost) != 0) { // prevent a loop
-                    int pos_slash = indexOf(c_host, "/", 9);
-                    if(pos_slash > 9) {
-                        if(!strncmp(c_host, m_lastHost, pos_slash)) {
-                            AUDIO_INFO("redirect to new extension at existing host \"%s\"", c_host);
-                            if(m_playlistFormat == FORMAT_M3U8) {
-                                x_ps_free(&m_lastHost);
-                                m_lastHost = x_ps_strdup(c_host);
-                                m_f_m3u8data = true;
-                            }
-                            httpPrint(c_host);
-                            while(_client->available()) _client->read(); 	// empty client buffer
-                            return true;
-                        }
+            case HttpParser::H_LOCATION: {
+                int pos = indexOf(val, "http", 0);
+                if(pos < 0) break;
+                const char* c_host = (val + pos);
+                if(strcmp(c_host, m_lastHost) == 0) break; 	// prevent a loop
+                int pos_slash = indexOf(c_host, "/", 9);
+                if(pos_slash > 9 && !strncmp(c_host, m_lastHost, pos_slash)) {
+                    AUDIO_INFO("redirect to new extension at existing host \"%s\"", c_host);
+                    if(m_playlistFormat == FORMAT_M3U8) {
+                        x_ps_free(&m_lastHost);
+                        m_lastHost = x_ps_strdup(c_host);
+                        m_f_m3u8data = true;
                     }
-                    AUDIO_INFO("redirect to new host \"%s\"", c_host);
-                    connecttohost(c_host);
+                    m_rhlT0 = 0;
+                    httpPrint(c_host);
+                    while(_client->available()) _client->read(); 	// empty client buffer
                     return true;
                 }
+                AUDIO_INFO("redirect to new host \"%s\"", c_host);
+                m_rhlT0 = 0;
+                connecttohost(c_host);
+                return true;
             }
-        }
-
-        else if(startsWith(rhl, "content-encoding:")) {
-            if(indexOf(rhl, "gzip")) {
-                AUDIO_INFO("can't extract gzip");
-                goto exit;
-            }
-        }
-
-        else if(startsWith(rhl, "content-disposition:")) {
-            int pos1, pos2; // pos3;
-            // e.g we have this headerline:  content-disposition: attachment; filename=stream.asx
-            // filename is: "stream.asx"
-            pos1 = indexOf(rhl, "filename=", 0);
-            if(pos1 > 0) {
-                pos1 += 9;
-                if(rhl[pos1] == '\"') pos1++; 				// remove '\"' around filename if present
-                pos2 = strlen(rhl);
-                if(rhl[pos2 - 1] == '\"') rhl[pos2 - 1] = '\0';
-            }
-            AUDIO_INFO("Filename is %s", rhl + pos1);
-        }
-
-        else if(startsWith(rhl, "connection:")) {
-            if(indexOf(rhl, "close", 0) >= 0) { ; /* do nothing */ }
-        }
-
-        else if(startsWith(rhl, "icy-genre:")) {
-            ; // do nothing Ambient, Rock, etc
-        }
-
-        else if(startsWith(rhl, "icy-logo:")) {
-            char* c_icylogo = (rhl + 9); 					// Get logo URL
-            trim(c_icylogo);
-            if(strlen(c_icylogo) > 0) {
-                if(m_f_Log) AUDIO_INFO("icy-logo: %s", c_icylogo);
-                if(audio_icylogo) audio_icylogo(c_icylogo);
-            }
-        }
-
-        else if(startsWith(rhl, "icy-br:")) {
-            const char* c_bitRate = (rhl + 7);
-            int32_t     br = atoi(c_bitRate); 				// Found bitrate tag, read the bitrate in Kbit
-            br = br * 1000;
-       h_bitRate = br;
-            setBitrate(br);
-//            sprintf(m_chbuf, "%lu", (long unsigned int)getBitRate());
-            sprintf(m_chbuf, "%lu", (long unsigned int)m_bitRate);
-            if(audio_bitrate) audio_bitrate(m_chbuf);
-        }
-
-        else if(startsWith(rhl, "icy-metaint:")) {
-            const char* c_metaint = (rhl + 12);
-            int32_t     i_metaint = atoi(c_metaint);
-            m_metaint = i_metaint;
-            if(m_metaint) m_f_metadata = true; 			// Multimediastream
-        }
-
-        else if(startsWith(rhl, "icy-name:")) {
-            char* c_icyname = (rhl + 9); 					// Get station name
-            trim(c_icyname);
-            if(strlen(c_icyname) > 0) {
-                if(m_f_Log) AUDIO_INFO("icy-name: %s", c_icyname);
-                if(audio_showstation) audio_showstation(c_icyname);
-            }
-        }
-
-        else if(startsWith(rhl, "content-length:")) {
-            const char* c_cl = (rhl + 15);
-            int32_t     i_cl = atoi(c_cl);
-            m_contentlength = i_cl;
-            m_streamType = ST_WEBFILE; 					// Stream comes from a fileserver
-            if(m_f_Log) AUDIO_INFO("content-length: %lu", (long unsigned int)m_contentlength);
-        }
-
-        else if(startsWith(rhl, "icy-description:")) {
-            const char* c_idesc = (rhl + 16);
-            while(c_idesc[0] == ' ') c_idesc++;
-            latinToUTF8(rhl, sizeof(rhl)); 					// if already UTF-8 do nothing, otherwise convert to UTF-8
-            if(strlen(c_idesc) > 0 && specialIndexOf((uint8_t*)c_idesc, "24bit", 0) > 0) {
-                AUDIO_INFO("icy-description: %s has to be 8 or 16", c_idesc);
-                stopSong();
+            case HttpParser::H_CONTENT_ENCODING:
+                if(indexOf(val, "gzip", 0) >= 0) {
+                    AUDIO_INFO("can't extract gzip");
+                    goto exit;
+                }
+                break;
+            case HttpParser::H_CONTENT_DISPOSITION: { 	// e.g content-disposition: attachment; filename=stream.asx
+                int pos = indexOf(val, "filename=", 0);
+                if(pos < 0) break;
+                char* fn = val + pos + 9;
+                if(fn[0] == '\"') fn++; 				// remove '\"' around filename if present
+                int len = strlen(fn);
+                if(len && fn[len - 1] == '\"') fn[len - 1] = '\0';
+                AUDIO_INFO("Filename is %s", fn);
+                break;
             }
-            if(audio_icydescription) audio_icydescription(c_idesc);
-        }
-
-        else if(startsWith(rhl, "transfer-encoding:")) {
-            if(endsWith(rhl, "chunked") || endsWith(rhl, "Chunked")) { 	// Station provides chunked transfer
-                m_f_chunked = true;
-                AUDIO_INFO("chunked data transfer");
-                m_chunkcount = 0; 								// Expect chunkcount in DATA
+            case HttpParser::H_ICY_LOGO: 				// Get logo URL
+                if(strlen(val) > 0) {
+                    if(m_f_Log) AUDIO_INFO("icy-logo: %s", val);
+                    if(audio_icylogo) audio_icylogo(val);
+                }
+                break;
+            case HttpParser::H_ICY_BR: {
+                int32_t br = atoi(val); 				// Found bitrate tag, read the bitrate in Kbit
+                br = br * 1000;
+                h_bitRate = br;
+                setBitrate(br);
+                sprintf(m_chbuf, "%lu", (long unsigned int)m_bitRate);
+                if(audio_bitrate) audio_bitrate(m_chbuf);
+                break;
             }
+            case HttpParser::H_ICY_METAINT:
+                m_metaint = atoi(val);
+                if(m_metaint) m_f_metadata = true; 			// Multimediastream
+                break;
+            case HttpParser::H_ICY_NAME: 				// Get station name
+                if(strlen(val) > 0) {
+                    if(m_f_Log) AUDIO_INFO("icy-name: %s", val);
+                    if(audio_showstation) audio_showstation(val);
+                }
+                break;
+            case HttpParser::H_CONTENT_LENGTH:
+                m_contentlength = atoi(val);
+                m_streamType = ST_WEBFILE; 					// Stream comes from a fileserver
+                if(m_f_Log) AUDIO_INFO("content-length: %lu", (long unsigned int)m_contentlength);
+                break;
+            case HttpParser::H_ICY_DESCRIPTION:
+                latinToUTF8(val, sizeof(m_rhl) - (val - m_rhl)); 	// if already UTF-8 do nothing, otherwise convert to UTF-8
+                if(strlen(val) > 0 && specialIndexOf((uint8_t*)val, "24bit", 0) > 0) {
+                    AUDIO_INFO("icy-description: %s has to be 8 or 16", val);
+                    stopSong();
+                }
+                if(audio_icydescription) audio_icydescription(val);
+                break;
+            case HttpParser::H_TRANSFER_ENCODING:
+                if(m_http.chunked() && !m_f_chunked) { 		// Station provides chunked transfer
+                    m_f_chunked = true;
+                    AUDIO_INFO("chunked data transfer");
+                }
+                break;
+            case HttpParser::H_ACCEPT_RANGES:
+                if(endsWith(val, "bytes")) m_f_acceptRanges = true;
+                break;
+            case HttpParser::H_ICY_URL:
+                if(audio_icyurl) audio_icyurl(val);
+                break;
+            case HttpParser::H_WWW_AUTHENTICATE:
+                AUDIO_INFO("authentification failed, wrong credentials?");
+                goto exit;
+            default: break; 						// connection, icy-genre, content-range and the like
         }
-
-        else if(startsWith(rhl, "accept-ranges:")) {
-            if(endsWith(rhl, "bytes")) m_f_acceptRanges = true;
-        //    log_w("%s", rhl);
-        }
-
-        else if(startsWith(rhl, "content-range:")) {
-        //    log_w("%s", rhl);
-        }
-
-        else if(startsWith(rhl, "icy-url:")) {
-            char* icyurl = (rhl + 8);
-            trim(icyurl);
-            if(audio_icyurl) audio_icyurl(icyurl);
-        }
-
-        else if(startsWith(rhl, "www-authenticate:")) {
-            AUDIO_INFO("authentification failed, wrong credentials?");
-            goto exit;
-        }
-        else { ; }
     } // outer while
 
 exit: // termination condition
+    m_rhlT0 = 0;
+    if(m_reconn.active() && reconnectRetry()) return true;
     if(audio_showstation) audio_showstation("");
     if(audio_icydescription) audio_icydescription("");
     if(audio_icyurl) audio_icyurl("");
@@ -4074,6 +4383,15 @@ exit: // termination condition
     return false;
 
 lastToDo:
+    m_rhlT0 = 0;
+    if(m_reconn.active() && m_codec != m_reconnCodec) { 	// the reconnected stream has to continue the old one
+        if(m_codec == CODEC_OGG && (m_reconnCodec == CODEC_FLAC || m_reconnCodec == CODEC_OPUS || m_reconnCodec == CODEC_VORBIS)) m_codec = m_reconnCodec;
+        else {
+            AUDIO_INFO("reconnected stream is %s now, restarting", codecname[m_codec]);
+            connecttohost(m_lastHost);
+            return true;
+        }
+    }
     if(m_codec != CODEC_NONE) {
         m_dataMode = AUDIO_DATA; 						// Expecting data now
         if(!(m_codec == CODEC_OGG)){
@@ -4315,129 +4633,29 @@ void Audio::showstreamtitle(const char* ml) {
     // example for ml:
     // StreamTitle='Oliver Frank - Mega Hitmix';StreamUrl='www.radio-welle-woerthersee.at';
     // or adw_ad='true';durationMilliseconds='10135';adId='34254';insertionType='preroll';
-
-    int16_t  idx1, idx2, idx4, idx5, idx6, idx7, titleLen = 0, artistLen = 0;
-    uint16_t i = 0, hash = 0;
-
-    idx1 = indexOf(ml, "StreamTitle=", 0);        // Streamtitle found
-    if(idx1 < 0) idx1 = indexOf(ml, "Title:", 0); // Title found (e.g. https://stream-hls.bauermedia.pt/comercial.aac/playlist.m3u8)
-
-    if(idx1 >= 0) {
-        if(indexOf(ml, "xml version=", 7) > 0) {
-            /* e.g. xmlStreamTitle
-                  StreamTitle='<?xml version="1.0" encoding="utf-8"?><RadioInfo><Table><DB_ALBUM_ID>37364</DB_ALBUM_ID>
-                  <DB_ALBUM_IMAGE>00000037364.jpg</DB_ALBUM_IMAGE><DB_ALBUM_NAME>Boyfriend</DB_ALBUM_NAME>
-                  <DB_ALBUM_TYPE>Single</DB_ALBUM_TYPE><DB_DALET_ARTIST_NAME>DOVE CAMERON</DB_DALET_ARTIST_NAME>
-                  <DB_DALET_ITEM_CODE>CD4161</DB_DALET_ITEM_CODE><DB_DALET_TITLE_NAME>BOYFRIEND</DB_DALET_TITLE_NAME>
-                  <DB_FK_SITE_ID>2</DB_FK_SITE_ID><DB_IS_MUSIC>1</DB_IS_MUSIC><DB_LEAD_ARTIST_ID>26303</DB_LEAD_ARTIST_ID>
-                  <DB_LEAD_ARTIST_NAME>Dove Cameron</DB_LEAD_ARTIST_NAME><DB_RADIO_IMAGE>cidadefm.jpg</DB_RADIO_IMAGE>
-                  <DB_RADIO_NAME>Cidade</DB_RADIO_NAME><DB_SONG_ID>120126</DB_SONG_ID><DB_SONG_LYRIC>60981</DB_SONG_LYRIC>
-                  <DB_SONG_NAME>Boyfriend</DB_SONG_NAME></Table><AnimadorInfo><TITLE>Cidade</TITLE>
-                  <START_TIME_UTC>2022-11-15T22:00:00+00:00</START_TIME_UTC><END_TIME_UTC>2022-11-16T06:59:59+00:00
-                  </END_TIME_UTC><SHOW_NAME>Cidade</SHOW_NAME><SHOW_HOURS>22h às 07h</SHOW_HOURS><SHOW_PANEL>0</SHOW_PANEL>
-                  </AnimadorInfo></RadioInfo>';StreamUrl='';
-            */
-
-            idx4 = indexOf(ml, "<DB_DALET_TITLE_NAME>");
-            idx5 = indexOf(ml, "</DB_DALET_TITLE_NAME>");
-
-            idx6 = indexOf(ml, "<DB_LEAD_ARTIST_NAME>");
-            idx7 = indexOf(ml, "</DB_LEAD_ARTIST_NAME>");
-
-            if(idx4 == -1 || idx5 == -1) return;
-            idx4 += 21; // <DB_DALET_TITLE_NAME>
-            titleLen = idx5 - idx4;
-
-            if(idx6 != -1 && idx7 != -1) {
-                idx6 += 21; // <DB_LEAD_ARTIST_NAME>
-                artistLen = idx7 - idx6;
-            }
-
-            char* title = NULL;
-            title = (char*)malloc(titleLen + artistLen + 4);
-            memcpy(title, ml + idx4, titleLen);
-            title[titleLen] = '\0';
-
-            char* artist = NULL;
-            if(artistLen) {
-                memcpy(title + titleLen, " - ", 3);
-                memcpy(title + titleLen + 3, ml + idx6, artistLen);
-                title[titleLen + 3 + artistLen] = '\0';
-            }
-
-            if(title) {
-                while(i < strlen(title)) {
-                    hash += title[i] * i + 1;
-                    i++;
-                }
-                if(m_streamTitleHash != hash) {
-                    m_streamTitleHash = hash;
-                    if(audio_showstreamtitle) audio_showstreamtitle(title);
-                }
-                x_ps_free(&title);
-            }
-            x_ps_free(&artist);
-            return;
-        }
-
-        idx2 = indexOf(ml, ";", idx1);
-        char* sTit;
-        if(idx2 >= 0) {
-            sTit = strndup(ml + idx1, idx2 + 1);
-            sTit[idx2] = '\0';
-        }
-        else sTit = strdup(ml);
-
-        while(i < strlen(sTit)) {
-            hash += sTit[i] * i + 1;
-            i++;
-        }
-
-        if(m_streamTitleHash != hash) {
-            m_streamTitleHash = hash;
-            AUDIO_INFO("%.*s", m_ibuffSize, sTit);
-            uint8_t pos = 12; 						// remove "StreamTitle="
-            if(sTit[pos] == '\'') pos++; 				// remove leading  \'
-            if(sTit[strlen(sTit) - 1] == '\'') sTit[strlen(sTit) - 1] = '\0'; // remove trailing \'
-            if(audio_showstreamtitle) audio_showstreamtitle(sTit + pos);
-        }
-        x_ps_free(&sTit);
-    }
-
-    idx1 = indexOf(ml, "StreamUrl=", 0);
-    idx2 = indexOf(ml, ";", idx1);
-    if(idx1 >= 0 && idx2 > idx1) { 				// StreamURL found
-        uint16_t len = idx2 - idx1;
-        char*    sUrl;
-        sUrl = strndup(ml + idx1, len + 1);
-        sUrl[len] = '\0';
-
-        while(i < strlen(sUrl)) {
-            hash += sUrl[i] * i + 1;
-            i++;
-        }
-        if(m_streamTitleHash != hash) {
-            m_streamTitleHash = hash;
-            AUDIO_INFO("%.*s", m_ibuffSize, sUrl);
-        }
-        x_ps_free(&sUrl);
-    }
-
-    idx1 = indexOf(ml, "adw_ad=", 0);
-    if(idx1 >= 0) { 							// Advertisement found
-        idx1 = indexOf(ml, "durationMilliseconds=", 0);
-        idx2 = indexOf(ml, ";", idx1);
-        if(idx1 >= 0 && idx2 > idx1) {
-            uint16_t len = idx2 - idx1;
-            char*    sAdv;
-            sAdv = strndup(ml + idx1, len + 1);
-            sAdv[len] = '\0';
-            AUDIO_INFO("%s", sAdv);
-            uint8_t pos = 21;                                                 // remove "StreamTitle="
-            if(sAdv[pos] == '\'') pos++;                                      // remove leading  \'
-            if(sAdv[strlen(sAdv) - 1] == '\'') sAdv[strlen(sAdv) - 1] = '\0'; // remove trailing \'
-            if(audio_commercial) audio_commercial(sAdv + pos);
-            x_ps_free(&sAdv);
+    showIcy(m_icy.parse(ml, strlen(ml)));
+}
+//****************************************************************************************
+void Audio::showIcy(uint8_t news) {
+    // reports what m_icy found new in the last metadata, titles repeated in every block are not passed on
+    const uint16_t max = m_ibuffSize - 32;                      // AUDIO_INFO writes into m_ibuff
+    if(news & Icy::TITLE) {
+        Icy::slice_t t = m_icy.rawTitle();
+        AUDIO_INFO("StreamTitle='%.*s'", t.len < max ? t.len : max, t.p);
+        m_icy.title(m_ibuff, m_ibuffSize);
+        if(audio_showstreamtitle) audio_showstreamtitle(m_ibuff);
+    }
+    if(news & Icy::URL) {
+        Icy::slice_t u = m_icy.url();
+        AUDIO_INFO("StreamUrl='%.*s'", u.len < max ? u.len : max, u.p);
+    }
+    if(news & Icy::AD) {
+        Icy::slice_t d = m_icy.adMs();
+        AUDIO_INFO("durationMilliseconds='%.*s'", d.len < max ? d.len : max, d.p);
+        if(audio_commercial) {
+            char ms[12];
+            snprintf(ms, sizeof(ms), "%.*s", d.len < 11 ? d.len : 11, d.p);
+            audio_commercial(ms);
         }
     }
 }
@@ -4765,6 +4983,12 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
         setDecoderItems();
         m_PlayingStartTime = millis();
     }
+    else if(m_playlistFormat == FORMAT_M3U8 && m_validSamples) {
+        // another HLS variant or a discontinuity (ad break) may come with another sample rate, the decoder goes on
+        uint32_t sr = m_codec == CODEC_AAC ? AACGetSampRate() : m_codec == CODEC_MP3 ? MP3GetSampRate() : 0;
+        uint8_t  ch = m_codec == CODEC_AAC ? AACGetChannels() : m_codec == CODEC_MP3 ? MP3GetChannels() : 0;
+        if(sr && (sr != getSampleRate() || ch != getChannels())) setDecoderItems();
+    }
 
     uint16_t bytesDecoderOut = m_validSamples;
     if(m_channels == 2) bytesDecoderOut /= 2;
@@ -4772,6 +4996,7 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
     computeAudioTime(bytesDecoded, bytesDecoderOut);
 
     m_curSample = 0;
+    m_ttfs.once(Ttfs::DECODE, millis());
     playChunk();
     return bytesDecoded;
 }
@@ -5019,7 +5244,8 @@ bool Audio::setPinout(uint8_t BCLK, uint8_t LRC, uint8_t DOUT, int8_t DIN, int8_
 #endif
 
 #if(ESP_IDF_VERSION_MAJOR == 5)
-    i2s_std_gpio_config_t gpio_cfg = {};
+    i2s_std_gpio_config_t& gpio_cfg = m_i2s_std_cfg.gpio_cfg;   // kept, the channel is made anew when the DMA queue is resized
+    gpio_cfg = {};
     gpio_cfg.bclk = (gpio_num_t)BCLK;
     gpio_cfg.din = (gpio_num_t)DIN;
     gpio_cfg.dout = (gpio_num_t)DOUT;
@@ -5050,6 +5276,7 @@ uint32_t Audio::getFileSize() {			 // returns the size of webfile or local file
 uint32_t Audio::getFilePos() {
     if(m_dataMode == AUDIO_LOCALFILE){
         if(!audiofile) return 0;
+        if(m_f_readAhead) return m_ra.position(); // what went into InBuff, the file is further ahead
         return audiofile.position();
     }
     if(m_streamType == ST_WEBFILE){
@@ -5205,16 +5432,31 @@ void Audio::reconfigI2S(){
 
     m_i2s_std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_BOTH;
 
+    uint16_t desc = m_i2s_chan_cfg.dma_desc_num, frames = m_i2s_chan_cfg.dma_frame_num;   // learned for this rate
+    bool other = I2S_DMA_TUNE && m_dmaTune.size(m_i2s_std_cfg.clk_cfg.sample_rate_hz, desc, frames);
+    if(other || m_f_i2sLost) I2Sresize(desc, frames);
+    if(m_f_i2sLost) { log_e("no I2S channel"); return; }
+
     i2s_channel_reconfig_std_clock(m_i2s_tx_handle, &m_i2s_std_cfg.clk_cfg);
     i2s_channel_reconfig_std_slot(m_i2s_tx_handle, &m_i2s_std_cfg.slot_cfg);
 
     I2Sstart(m_i2s_num);
+    m_dmaTune.begin(m_i2s_std_cfg.clk_cfg.sample_rate_hz, m_i2s_chan_cfg.dma_desc_num, m_i2s_chan_cfg.dma_frame_num);
 #else
     m_i2s_config.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+    uint16_t desc = m_i2s_config.dma_buf_count, frames = m_i2s_config.dma_buf_len;         // learned for this rate
+    bool other = I2S_DMA_TUNE && m_dmaTune.size(m_sampleRate, desc, frames);
+    if(other || m_f_i2sLost) I2Sresize(desc, frames);
+    if(m_f_i2sLost) { log_e("no I2S channel"); return; }
     i2s_set_clk((i2s_port_t)m_i2s_num, m_sampleRate, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_STEREO);
+    m_dmaTune.begin(m_sampleRate, m_i2s_config.dma_buf_count, m_i2s_config.dma_buf_len);
 #endif
+    m_dmaWritten = m_dmaSent;
+    uint16_t wait = m_dmaTune.latencyMs() / 4;                        // the queue must not run dry while the task waits
+    m_dmaSleepMs = wait > 20 ? 20 : wait < 2 ? 2 : wait;
     memset(m_filterBuff, 0, sizeof(m_filterBuff)); // Clear FilterBuffer
     IIR_calculateCoefficients(m_gain0, m_gain1, m_gain2); // must be recalculated after each samplerate change
+    m_comp.setRate(getSampleRate());
     return;
 }
 //****************************************************************************************
@@ -5246,7 +5488,7 @@ void Audio::setI2SCommFMT_LSB(bool commFMT) {
     }
 //    AUDIO_INFO("commFMT = %i", m_i2s_config.communication_format);
     i2s_driver_uninstall((i2s_port_t)m_i2s_num);
-    i2s_driver_install((i2s_port_t)m_i2s_num, &m_i2s_config, 0, NULL);
+    I2Sinstall();
 #else
     i2s_channel_disable(m_i2s_tx_handle);
     if(commFMT) {
@@ -5691,314 +5933,78 @@ void Audio::IIR_filterChain2(int16_t iir_in[2], bool clear) { 	// Infinite Impul
     return;
 }
 // clang-format on
-//---------------------------------------------------------------------------------------------------------------------------------------------------
-//    AAC - T R A N S P O R T S T R E A M
-//---------------------------------------------------------------------------------------------------------------------------------------------------
-bool Audio::ts_parsePacket(uint8_t* packet, uint8_t* packetStart, uint8_t* packetLength) {
-
-    bool log = false;
-
-    const uint8_t TS_PACKET_SIZE = 188;
-    const uint8_t PAYLOAD_SIZE = 184;
-    const uint8_t PID_ARRAY_LEN = 4;
-
-    (void)PAYLOAD_SIZE; // suppress [-Wunused-variable]
-
-    typedef struct {
-        int number = 0;
-        int pids[PID_ARRAY_LEN];
-    } pid_array;
-
-    static pid_array pidsOfPMT;
-    static int       PES_DataLength = 0;
-    static int       pidOfAAC = 0;
-
-    if(packet == NULL) {
-        if(log) log_w("parseTS reset");
-        for(int i = 0; i < PID_ARRAY_LEN; i++) pidsOfPMT.pids[i] = 0;
-        PES_DataLength = 0;
-        pidOfAAC = 0;
-        return true;
-    }
-
-    // --------------------------------------------------------------------------------------------------------
-    // 0. Byte SyncByte  | 0 | 1 | 0 | 0 | 0 | 1 | 1 | 1 | always bit pattern of 0x47
-    //---------------------------------------------------------------------------------------------------------
-    // 1. Byte           |PUSI|TP|   |PID|PID|PID|PID|PID|
-    //---------------------------------------------------------------------------------------------------------
-    // 2. Byte           |PID|PID|PID|PID|PID|PID|PID|PID|
-    //---------------------------------------------------------------------------------------------------------
-    // 3. Byte           |TSC|TSC|AFC|AFC|CC |CC |CC |CC |
-    //---------------------------------------------------------------------------------------------------------
-    // 4.-187. Byte      |Payload data if AFC==01 or 11  |
-    //---------------------------------------------------------------------------------------------------------
-
-    // PUSI Payload unit start indicator, set when this packet contains the first byte of a new payload unit.
-    //      The first byte of the payload will indicate where this new payload unit starts.
-    // TP   Transport priority, set when the current packet has a higher priority than other packets with the same PID.
-    // PID  Packet Identifier, describing the payload data.
-    // TSC  Transport scrambling control, '00' = Not scrambled.
-    // AFC  Adaptation field control, 01 – no adaptation field, payload only, 10 – adaptation field only, no payload,
-    //                                11 – adaptation field followed by payload, 00 – RESERVED for future use
-    // CC   Continuity counter, Sequence number of payload packets (0x00 to 0x0F) within each stream (except PID 8191)
-
-    // for(int i = 1; i < 188; i++) {printf("%02X ", packet[i - 1]); if(i && (i % 16 == 0)) printf("\n");}
-    // printf("\n----------\n");
-
-    if(packet[0] != 0x47) {
-        log_e("ts SyncByte not found, first bytes are 0x%02X 0x%02X 0x%02X 0x%02X", packet[0], packet[1], packet[2], packet[3]);
-        // stopSong();
-        return false;
-    }
-    int PID = (packet[1] & 0x1F) << 8 | (packet[2] & 0xFF);
-    if(log) log_w("PID: 0x%04X(%d)", PID, PID);
-    int PUSI = (packet[1] & 0x40) >> 6;
-    if(log) log_w("Payload Unit Start Indicator: %d", PUSI);
-    int AFC = (packet[3] & 0x30) >> 4;
-    if(log) log_w("Adaption Field Control: %d", AFC);
-
-    int AFL = -1;
-    if((AFC & 0b10) == 0b10) {  // AFC '11' Adaptation Field followed
-        AFL = packet[4] & 0xFF; // Adaptation Field Length
-        if(log) log_w("Adaptation Field Length: %d", AFL);
-    }
-    int PLS = PUSI ? 5 : 4;     // PayLoadStart, Payload Unit Start Indicator
-    if(AFL > 0) PLS += AFL + 1; // skip adaption field
-
-    if(AFC == 2){ // The TS package contains only an adaptation Field and no user data.
-        *packetStart = AFL + 1;
-        *packetLength = 0;
-        return true;
-    }
-
-    if(PID == 0) {
-        // Program Association Table (PAT) - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        if(log) log_w("PAT");
-        pidsOfPMT.number = 0;
-        pidOfAAC = 0;
-
-        int startOfProgramNums = 8;
-        int lengthOfPATValue = 4;
-        int sectionLength = ((packet[PLS + 1] & 0x0F) << 8) | (packet[PLS + 2] & 0xFF);
-        if(log) log_w("Section Length: %d", sectionLength);
-        int program_number, program_map_PID;
-        int indexOfPids = 0;
-        (void)program_number; // [-Wunused-but-set-variable]
-        for(int i = startOfProgramNums; i <= sectionLength; i += lengthOfPATValue) {
-            program_number = ((packet[PLS + i] & 0xFF) << 8) | (packet[PLS + i + 1] & 0xFF);
-            program_map_PID = ((packet[PLS + i + 2] & 0x1F) << 8) | (packet[PLS + i + 3] & 0xFF);
-            if(log) log_w("Program Num: 0x%04X(%d) PMT PID: 0x%04X(%d)", program_number, program_number, program_map_PID, program_map_PID);
-            pidsOfPMT.pids[indexOfPids++] = program_map_PID;
-        }
-        pidsOfPMT.number = indexOfPids;
-        *packetStart = 0;
-        *packetLength = 0;
-        return true;
-    }
-    else if(PID == pidOfAAC) {
-        static uint8_t fillData = 0;
-        if(log) log_w("AAC");
-        uint8_t posOfPacketStart = 4;
-        if(AFL >= 0) { posOfPacketStart = 5 + AFL;
-            if(log) log_w("posOfPacketStart: %d", posOfPacketStart); }
-        // Packetized Elementary Stream (PES) - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        if(log) log_w("PES_DataLength %i", PES_DataLength);
-        if(PES_DataLength > 0) {
-            *packetStart = posOfPacketStart + fillData;
-            *packetLength = TS_PACKET_SIZE - posOfPacketStart - fillData;
-            if(log) log_w("packetlength %i", *packetLength);
-            fillData = 0;
-            PES_DataLength -= (*packetLength);
-            return true;
-        }
-        else {
-            int firstByte = packet[posOfPacketStart] & 0xFF;
-            int secondByte = packet[posOfPacketStart + 1] & 0xFF;
-            int thirdByte = packet[posOfPacketStart + 2] & 0xFF;
-            if(log) log_w ("First 3 bytes: 0x%02X, 0x%02X, 0x%02X", firstByte, secondByte, thirdByte);
-            if(firstByte == 0x00 && secondByte == 0x00 && thirdByte == 0x01) { 	// Packet start code prefix
-                // --------------------------------------------------------------------------------------------------------
-                // posOfPacketStart + 0...2     0x00, 0x00, 0x01                                          PES-Startcode
-                //---------------------------------------------------------------------------------------------------------
-                // posOfPacketStart + 3         0xE0 (Video) od 0xC0 (Audio)                              StreamID
-                //---------------------------------------------------------------------------------------------------------
-                // posOfPacketStart + 4...5     0xLL, 0xLL                                                PES Packet length
-                //---------------------------------------------------------------------------------------------------------
-                // posOfPacketStart + 6...7                                                               PTS/DTS Flags
-                //---------------------------------------------------------------------------------------------------------
-                // posOfPacketStart + 8         0xXX                                                      header length
-                //---------------------------------------------------------------------------------------------------------
-
-                uint8_t StreamID = packet[posOfPacketStart + 3] & 0xFF;
-                if(StreamID >= 0xC0 && StreamID <= 0xDF) { ; } // okay ist audio stream
-                if(StreamID >= 0xE0 && StreamID <= 0xEF) {log_e("video stream!"); return false; }
-                int PES_PacketLength = ((packet[posOfPacketStart + 4] & 0xFF) << 8) + (packet[posOfPacketStart + 5] & 0xFF);
-                if(log) log_w("PES PacketLength: %d", PES_PacketLength);
-                bool PTS_flag = false;
-                bool DTS_flag = false;
-                int flag_byte1 = packet[posOfPacketStart + 6] & 0xFF;
-                int flag_byte2 = packet[posOfPacketStart + 7] & 0xFF;  (void) flag_byte2; // unused yet
-                if(flag_byte1 & 0b10000000) PTS_flag = true;
-                if(flag_byte1 & 0b00000100) DTS_flag = true;
-                if(log && PTS_flag) log_w("PTS_flag is set");
-                if(log && DTS_flag) log_w("DTS_flag is set");
-                uint8_t PES_HeaderDataLength = packet[posOfPacketStart + 8] & 0xFF;
-                if(log) log_w("PES_headerDataLength %d", PES_HeaderDataLength);
-
-                PES_DataLength = PES_PacketLength;
-                int startOfData = PES_HeaderDataLength + 9;
-                if(posOfPacketStart + startOfData >= 188) { // only fillers in packet
-                    if(log) log_w("posOfPacketStart + startOfData %i", posOfPacketStart + startOfData);
-                    *packetStart = 0;
-                    *packetLength = 0;
-                    PES_DataLength -= (PES_HeaderDataLength + 3);
-                    fillData = (posOfPacketStart + startOfData) - 188;
-                    if(log) log_w("fillData %i", fillData);
-                    return true;
-                }
-                if(log) log_w("First AAC data byte: %02X", packet[posOfPacketStart + startOfData]);
-                if(log) log_w("Second AAC data byte: %02X", packet[posOfPacketStart + startOfData + 1]);
-                *packetStart = posOfPacketStart + startOfData;
-                *packetLength = TS_PACKET_SIZE - posOfPacketStart - startOfData;
-                PES_DataLength -= (*packetLength);
-                PES_DataLength -= (PES_HeaderDataLength + 3);
-                return true;
-            }
-            if(firstByte == 0 && secondByte == 0 && thirdByte == 0){
-                // PES packet startcode prefix is 0x000000
-                // skip such packets
-                return true;
-            }
-        }
-        *packetStart = 0;
-        *packetLength = 0;
-        log_e("PES not found");
-        return false;
-    }
-    else if(pidsOfPMT.number) {
-        //  Program Map Table (PMT) - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        for(int i = 0; i < pidsOfPMT.number; i++) {
-            if(PID == pidsOfPMT.pids[i]) {
-                if(m_f_Log) log_i("PMT");
-                int staticLengthOfPMT = 12;
-                int sectionLength = ((packet[PLS + 1] & 0x0F) << 8) | (packet[PLS + 2] & 0xFF);
-                if(m_f_Log) log_i("Section Length: %d", sectionLength);
-                int programInfoLength = ((packet[PLS + 10] & 0x0F) << 8) | (packet[PLS + 11] & 0xFF);
-                if(m_f_Log) log_i("Program Info Length: %d", programInfoLength);
-                int cursor = staticLengthOfPMT + programInfoLength;
-                while(cursor < sectionLength - 1) {
-                    int streamType = packet[PLS + cursor] & 0xFF;
-                    int elementaryPID = ((packet[PLS + cursor + 1] & 0x1F) << 8) | (packet[PLS + cursor + 2] & 0xFF);
-                    if(m_f_Log) log_i("Stream Type: 0x%02X Elementary PID: 0x%04X", streamType, elementaryPID);
-
-                    if(streamType == 0x0F || streamType == 0x11) {
-                        if(m_f_Log) log_i("AAC PID discover");
-                        pidOfAAC = elementaryPID;
-                    }
-                    int esInfoLength = ((packet[PLS + cursor + 3] & 0x0F) << 8) | (packet[PLS + cursor + 4] & 0xFF);
-                    if(m_f_Log) log_i("ES Info Length: 0x%04X", esInfoLength);
-                    cursor += 5 + esInfoLength;
-                }
-            }
-        }
-        *packetStart = 0;
-        *packetLength = 0;
-        return true;
-    }
-    // PES received before PAT and PMT seen
-    *packetStart = 0;
-    *packetLength = 0;
-    return false;
-}
 //------------------------------------------------------------------------------------------------------------------------------------------------
 //    W E B S T R E A M  -  H E L P   F U N C T I O N S
 //------------------------------------------------------------------------------------------------------------------------------------------------
-uint16_t Audio::readMetadata(uint16_t maxBytes, bool first) {
+int32_t Audio::readBody(uint8_t* buf, uint32_t size) {
+    // the body of the response as it arrives, without the chunked framing (m_http takes it out in place); first come
+    // the bytes that were read with the end of the header. Returns the payload bytes, 0 if only framing came, -1 if
+    // the framing is broken
+    if(m_http.failed()) return -1;
+    size = m_http.want(size); 					// not into the next response on a keep-alive connection
+    uint32_t n = 0;
+    if(m_restPos < m_restLen) {
+        n = min(size, (uint32_t)(m_restLen - m_restPos));
+        memcpy(buf, m_rest + m_restPos, n);
+        m_restPos += n;
+    }
+    if(n < size) {
+        int av = _client->available();
+        if(av > 0) {
+            int r = _client->read(buf + n, min(size - n, (uint32_t)av));
+            if(r > 0) n += r;
+        }
+    }
+    n = m_http.body(buf, n);
+    if(n) m_ttfs.once(Ttfs::FIRST_BYTE, millis());
+    if(m_http.failed()) { log_e("broken chunked transfer"); return n ? n : -1; }
+    return n;
+}
+//****************************************************************************************
+uint32_t Audio::bodyAvailable() {   // bytes to read, with the framing; none once the body is through
+    if(m_http.done()) return 0;
+    int av = _client->available();
+    return (m_restLen - m_restPos) + (av > 0 ? av : 0);
+}
+//****************************************************************************************
+void Audio::readMetadata(bool first) {
+    // the metadata is read on top of readBody(): a chunk boundary anywhere in it (the length byte as well) is gone
+    // before it gets here
     static uint16_t pos_ml = 0; 		// determines the current position in metaline
     static uint16_t metalen = 0;
-    uint16_t        res = 0;
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(first) {
         pos_ml = 0;
         metalen = 0;
-        return 0;
+        return;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(!maxBytes) return 0; 			// guard
-
     if(!metalen) {
-        int b = _client->read(); 		// First byte of metadata?
-        metalen = b * 16; 			// New count for metadata including length byte, max 4096
+        uint8_t b;
+        int32_t r;
+        while(!(r = readBody(&b, 1)) && bodyAvailable()) {;} 	// framing may come first
+        if(r != 1) return;
+        if(!b) { m_metacount = m_metaint; return; } 		// metalen is 0
+        metalen = b * 16; 			// New count for metadata including length byte, max 4080
         pos_ml = 0;
-        m_chbuf[pos_ml] = 0; 		// Prepare for new line
-        res = 1;
     }
-    if(!metalen) { m_metacount = m_metaint; return res; } 		// metalen is 0
-    if(metalen < m_chbufSize) {
-        uint16_t a = _client->readBytes(&m_chbuf[pos_ml], min((uint16_t)(metalen - pos_ml), (uint16_t)(maxBytes - 1)));
-        res += a;
+
+    // the block is read into m_chbuf in as few reads as there are, m_icy parses it there; of a block too long for
+    // m_chbuf (no PSRAM) the first half is kept, the rest is read over the second half
+    uint16_t keep = metalen < m_chbufSize ? metalen : m_chbufSize / 2;
+    while(pos_ml < metalen) {
+        uint16_t at = pos_ml < keep ? pos_ml : keep;
+        uint16_t n = min((uint16_t)(metalen - pos_ml), (uint16_t)(pos_ml < keep ? keep - pos_ml : m_chbufSize - keep));
+        int32_t  a = readBody((uint8_t*)&m_chbuf[at], n);
+        if(a < 0 || (!a && !bodyAvailable())) break; 	// the rest has not arrived yet
         pos_ml += a;
     }
-    else { 						// metadata doesn't fit in m_chbuf
-        uint8_t c = 0;
-        int8_t  i = 0;
-        while(pos_ml != metalen) {
-            i = _client->read(&c, 1); 	// fake read
-            if(i != -1) { pos_ml++; res++; }
-            else { return res; }
-        }
-        m_metacount = m_metaint;
-        metalen = 0;
-        pos_ml = 0;
-        return res;
-    }
     if(pos_ml == metalen) {
-        m_chbuf[pos_ml] = '\0';
-        if(strlen(m_chbuf)) { 				// Any info present?
-            // metaline contains artist and song name.  For example:
-            // "StreamTitle='Don McLean - American Pie';StreamUrl='';"
-            // Sometimes it is just other info like:
-            // "StreamTitle='60s 03 05 Magic60s';StreamUrl='';"
-            // Isolate the StreamTitle, remove leading and trailing quotes if present.
-            latinToUTF8(m_chbuf, m_chbufSize);          // convert to UTF-8 if necessary
-            int pos = indexOf(m_chbuf, "song_spot", 0); // remove some irrelevant infos
-            if(pos > 3) {                               // e.g. song_spot="T" MediaBaseId="0" itunesTrackId="0"
-                m_chbuf[pos] = 0;
-            }
-            showstreamtitle(m_chbuf); // Show artist and title if present in metadata
-        }
+        showIcy(m_icy.parse(m_chbuf, keep));
         m_metacount = m_metaint;
         metalen = 0;
         pos_ml = 0;
     }
-    return res;
-}
-//****************************************************************************************
-size_t Audio::chunkedDataTransfer(uint8_t* bytes) {
-    uint8_t  byteCounter = 0;
-    size_t   chunksize = 0;
-    int      b = 0;
-    uint32_t ctime = millis();
-    uint32_t timeout = 2000; 			// ms
-    while(true) {
-        if(ctime + timeout < millis()) {
-            log_e("timeout");
-            stopSong();
-            return 0;
-        }
-        b = _client->read();  // e.g. 0x66 0x34 0x31 0x37 0x0D 0x0A --> 62487 Bytes + CR LF
-        byteCounter++;        //      0x30 0x0D 0x0A   --> last chunk, CAN
-        if(b < 0) continue; 				// -1 no data available
-        if(b == '\n') break;
-        if(b < '0') continue;
-        // We have received a hexadecimal character.  Decode it and add to the result.
-        b = toupper(b) - '0'; 				// Be sure we have uppercase
-        if(b > 9) b = b - 7;  				// Translate A..F to 10..15
-        chunksize = (chunksize << 4) + b;
-    }
-//    if(m_f_Log) log_i("chunksize %d", chunksize);
-    *bytes = byteCounter;
-    return chunksize;
 }
 //****************************************************************************************
 bool Audio::readID3V1Tag() {
@@ -6085,7 +6091,7 @@ boolean Audio::streamDetection(uint32_t bytesAvail) {
                 AUDIO_INFO("End of Stream.");
                 m_f_running = false;
                 m_dataMode = AUDIO_NONE;
-            } else {
+            } else if(!reconnectStart("lost")) {
                 AUDIO_INFO("Stream lost -> try new connection");
                 connecttohost(m_lastHost);
             }
@@ -6511,7 +6517,7 @@ void Audio::startAudioTask() {
         "PeriodicTask",         /* Name of the task */
         AUDIO_STACK_SIZE,       /* Stack size in words */
         this,                   /* Task input parameter */
-        2,                      /* Priority of the task */
+        AUDIO_TASK_PRIORITY,    /* Priority of the task */
         xAudioStack,            /* Task stack */
         &xAudioTaskBuffer,      /* Memory for the task's control block */
         m_audioTaskCoreId       /* Core where the task should run */
@@ -6546,12 +6552,13 @@ void Audio::audioTask() {
 }
 //****************************************************************************************
 void Audio::performAudioTask() {
-    if(!m_f_running) return;
-    if(!m_f_stream) return;
-    if(m_codec == CODEC_NONE) return; // wait for codec is  set
-    if(m_codec == CODEC_OGG)  return; // wait for FLAC, VORBIS or OPUS
+    bool idle = !m_f_running || !m_f_stream;
+    idle |= m_f_tsPaused;             // timeshift, stream is buffered only
+    idle |= m_codec == CODEC_NONE;    // wait for codec is  set
+    idle |= m_codec == CODEC_OGG;     // wait for FLAC, VORBIS or OPUS
+    if(idle) {m_dmaTune.pause(); return;} // the DMA queue runs dry on purpose
     xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
-    while(m_validSamples) {vTaskDelay(20 / portTICK_PERIOD_MS); playChunk();} // I2S buffer full
+    while(m_validSamples) {vTaskDelay(m_dmaSleepMs / portTICK_PERIOD_MS); playChunk();} // I2S buffer full
     playAudioData();
     xSemaphoreGive(mutex_audioTask);
 }
@@ -27,6 +27,19 @@
 #include <FFat.h>
 #include <codecvt>
 #include <locale>
+#include "prebuffer.h"
+#include "dmatune.h"
+#include "connrace.h"
+#include "reconnect.h"
+#include "hls.h"
+#include "tsdemux.h"
+#include "m3u8.h"
+#include "icy.h"
+#include "httpparser.h"
+#include "ttfs.h"
+#include "compressor.h"
+#include "streamwatch.h"
+#include "readahead.h"
 
 //#include <SPI.h>
 
@@ -66,6 +79,15 @@ extern __attribute__((weak)) void audio_icydescription(const char*);
 extern __attribute__((weak)) void audio_lasthost(const char*);
 extern __attribute__((weak)) void audio_eof_speech(const char*);
 extern __attribute__((weak)) void audio_eof_stream(const char*); // The webstream comes to an end
+extern __attribute__((weak)) void audio_prebuffer(uint16_t startMs, uint16_t resumeMs, bool stable); // learned prebuffer changed, stable: lowered after a long run without underrun
+extern __attribute__((weak)) void audio_ttfs(const Ttfs& t);   // a tune reached the first write to I2S, phase by phase
+extern __attribute__((weak)) void audio_reconnect(uint8_t outcome, uint8_t attempts, uint32_t ms); // Reconnect::SEAMLESS, GAP, FAILED or STABLE for the current station
+extern __attribute__((weak)) void audio_watch(uint8_t reason);   // StreamWatch::SILENT, FROZEN, STUCK or STARVED, the connection is still up
+extern __attribute__((weak)) void audio_process_stream(const uint8_t* data, size_t len); // raw webstream data, without metadata
+extern __attribute__((weak)) void audio_process_pcm(const int16_t* frames, uint16_t count, uint32_t sampleRate); // decoded stereo frames, before EQ and volume
+extern __attribute__((weak)) void audio_process_block(int16_t* frames, uint16_t count, uint32_t sampleRate); // stereo frames after EQ and night mode, before volume, in place
+extern __attribute__((weak)) WiFiClient* audio_warm_client(const char* url); // already requested connection to url (prefetched), or NULL
+extern __attribute__((weak)) uint8_t audio_resolve(const char* host, uint32_t* ips, uint8_t max, bool wait); // cached addresses of host (network order), 0 = let lwIP resolve, ConnRace::RESOLVING = not yet (wait == false)
 extern __attribute__((weak)) void audio_process_i2s(int16_t* outBuff, uint16_t validSamples, uint8_t bitsPerSample, uint8_t channels, bool *continueI2S); // record audiodata or send via BT
 extern __attribute__((weak)) void audio_log(uint8_t logLevel, const char* msg, const char* arg);
 
@@ -131,6 +153,8 @@ public:
     uint32_t getReadPos();                      // read position relative to the beginning
     void     resetBuffer();                     // restore defaults
     bool     havePSRAM() { return m_f_psram; };
+    size_t   historyLength() { return m_histLength; }; // already read bytes behind m_readPtr, not yet overwritten
+    size_t   rewind(size_t br);                 // move readpointer back into the history, returns the moved bytes
 
 protected:
     size_t            m_buffSizePSRAM    = UINT16_MAX * 10;   // most webstreams limit ( 65535 * 10)
@@ -147,6 +171,7 @@ protected:
     uint8_t*          m_writePtr         = NULL;
     uint8_t*          m_readPtr          = NULL;
     uint8_t*          m_endPtr           = NULL;
+    size_t            m_histLength       = 0;        // timeshift: read data that is still intact in the buffer
     bool              m_f_init           = false;
     bool              m_f_isEmpty        = true;
     bool              m_f_psram          = false;    // PSRAM is available (and used...)
@@ -218,7 +243,39 @@ public:
     uint32_t inBufferSize();   // returns the size of the inputbuffer in bytes
     void setBufferSize(size_t mbs); // sets the size of the inputbuffer in bytes
     void setTone(int8_t gainLowPass, int8_t gainBandPass, int8_t gainHighPass);
+    /* N I G H T   M O D E */
+    void     setNightMode(bool on) {m_comp.enable(on);}
+    void     setCompressor(int8_t thresholdDb, uint8_t ratio, uint8_t attackMs, uint16_t releaseMs, uint8_t makeupDb)
+                 {m_comp.setParams(thresholdDb, ratio, attackMs, releaseMs, makeupDb);}
+    bool     getNightMode() {return m_comp.enabled();}
+    uint16_t getNightReduction() {return m_comp.reductionDb10();}  // gain reduction of the last block, 0.1 dB
     void setI2SCommFMT_LSB(bool commFMT);
+    /* T I M E S H I F T */
+    bool     setTimeshift(size_t bytes);     // PSRAM ring size for live webstreams, 0 = off (only while stopped)
+    bool     timeshiftPause(bool pause);
+    bool     isTimeshiftPaused() {return m_f_tsPaused;}
+    uint32_t timeshiftJumpBack(uint16_t sec); // returns the seconds really jumped back
+    bool     timeshiftToLive();
+    uint32_t getTimeshiftDelay();             // seconds behind the live stream
+    /* P R E B U F F E R */
+    void     setPrebuffer(uint16_t startMs, uint16_t resumeMs) {m_pbStartMs = startMs; m_pbResumeMs = resumeMs;} // learned values for the next connection
+    uint16_t getPrebufferUnderruns() {return m_prebuf.underruns();}
+    uint32_t getPrebufferJitter() {return m_prebuf.jitterMs();}
+    bool     isReconnecting() {return m_reconn.active();} // a dropped webstream plays on from the buffer meanwhile
+    bool     isStreaming() {return m_dataMode == AUDIO_DATA;} // the response header of connecttohost() was accepted, audio data follows
+    /* S T R E A M   W A T C H */
+    bool     restartStream(const char* why) {return reconnectStart(why);} // reconnect behind the buffer, call from the loop task
+    void     avoidServer() {ConnRace::avoid(m_connKey);} // the next connection to this url races the last winner last
+    Ttfs&    ttfs() {return m_ttfs;}              // time to first sound of the current tune, begun by the caller
+    /* S D   R E A D - A H E A D */
+    bool     readAheadLow() {return m_f_readAhead && m_ra.low();} // a directory scan should leave the card to the player
+    /* I 2 S   D M A */
+    uint16_t getI2SLatency() {return m_dmaTune.latencyMs();}    // audio the DMA queue holds
+    uint16_t getI2STarget() {return m_dmaTune.targetMs();}      // learned for the sample rate, taken at the next rate change
+    uint16_t getI2SMargin() {return m_dmaTune.marginMs();}      // least audio left in the queue in the last 10 s
+    uint16_t getI2SUnderruns() {return m_dmaTune.underruns();}
+    uint16_t getI2SDesc() {return m_dmaTune.desc();}
+    uint16_t getI2SFrames() {return m_dmaTune.frames();}
     int getCodec() {return m_codec;}
     const char *getCodecname() {return codecname[m_codec];}
     const char *getVersion() {return audioI2SVers;}
@@ -239,7 +296,20 @@ private:
   void            initInBuff();
   bool            httpPrint(const char* host);
   bool            httpRange(const char* host, uint32_t range);
+  void            connectLoop();
+  void            connectPhase(uint8_t phase);
+  void            connectCancel();
+  bool            reconnectStart(const char* why);
+  bool            reconnectRetry();
+  void            reconnectSplice(uint8_t* data, int32_t* len);
+  uint32_t        frameLength(const uint8_t* data);
+  bool            connectCached(const char* host, uint16_t port);
+  bool            hlsStart(const char* first);
   void            processLocalFile();
+  void            readAheadStart(uint32_t pos);
+  void            readAheadStop(bool release = false);
+  bool            readAheadFill();
+  static void     readAheadTask(void* param);
   void            processWebStream();
   void            processWebFile();
   void            processWebStreamTS();
@@ -251,8 +321,7 @@ private:
   const char*     parsePlaylist_ASX();
   const char*     parsePlaylist_M3U8();
   const char*     m3u8redirection(uint8_t* codec);
-  uint64_t        m3u8_findMediaSeqInURL();
-  bool            STfromEXTINF(char* str);
+  bool            STfromEXTINF(const char* str);
   void            showCodecParams();
   int             findNextSync(uint8_t* data, size_t len);
   int             sendBytes(uint8_t* data, size_t len);
@@ -277,18 +346,31 @@ private:
   void            computeLimit();
   void            Gain(int16_t* sample);
   void            showstreamtitle(const char* ml);
+  void            showIcy(uint8_t news);
   bool            parseContentType(char* ct);
   bool            parseHttpResponseHeader();
   bool            initializeDecoder(uint8_t codec);
   esp_err_t       I2Sstart(uint8_t i2s_num);
   esp_err_t       I2Sstop(uint8_t i2s_num);
+  bool            I2Sresize(uint16_t desc, uint16_t frames);
+  void            I2Slevel();
+#if ESP_IDF_VERSION_MAJOR == 5
+  void            I2Scallbacks();
+  static bool     i2sSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+  static bool     i2sUnderrun(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+#else
+  esp_err_t       I2Sinstall();
+#endif
   void            IIR_filterChain0(int16_t iir_in[2], bool clear = false);
   void            IIR_filterChain1(int16_t iir_in[2], bool clear = false);
   void            IIR_filterChain2(int16_t iir_in[2], bool clear = false);
   inline uint32_t streamavail() { return _client ? _client->available() : 0; }
   void            IIR_calculateCoefficients(int8_t G1, int8_t G2, int8_t G3);
-  bool            ts_parsePacket(uint8_t* packet, uint8_t* packetStart, uint8_t* packetLength);
   uint32_t        find_m4a_atom(uint32_t fileSize, const char* atomType, uint32_t depth = 0);
+  bool            timeshiftActive();
+  uint32_t        streamBytesPerSec();
+  uint32_t        prebufferBytes(uint16_t ms);
+  void            timeshiftResync();
 
   //+++ create a T A S K  for playAudioData(), output via I2S +++
 public:
@@ -304,8 +386,9 @@ private:
   bool            m_f_audioTaskIsRunning = false;
 
   //+++ W E B S T R E A M  -  H E L P   F U N C T I O N S +++
-  uint16_t readMetadata(uint16_t b, bool first = false);
-  size_t   chunkedDataTransfer(uint8_t* bytes);
+  void     readMetadata(bool first = false);
+  int32_t  readBody(uint8_t* buf, uint32_t size);
+  uint32_t bodyAvailable();
   bool     readID3V1Tag();
   boolean  streamDetection(uint32_t bytesAvail);
   void     seek_m4a_stsz();
@@ -467,16 +550,6 @@ uint64_t bigEndian(uint8_t* base, uint8_t numBytes, uint8_t shiftLeft = 8) {
         vec.shrink_to_fit();
     }
 
-    uint32_t simpleHash(const char* str){
-        if(str == NULL) return 0;
-        uint32_t hash = 0;
-        for(int i=0; i<strlen(str); i++){
-		    if(str[i] < 32) continue; // ignore control sign
-		    hash += (str[i] - 31) * i * 32;
-        }
-        return hash;
-	  }
-
     char* x_ps_malloc(uint16_t len) {
         char* ps_str = NULL;
         if(psramFound()){ps_str = (char*) ps_malloc(len);}
@@ -618,7 +691,9 @@ private:
     enum : int { EXTERNAL_I2S = 0, INTERNAL_DAC = 1, INTERNAL_PDM = 2 };
     enum : int { FORMAT_NONE = 0, FORMAT_M3U = 1, FORMAT_PLS = 2, FORMAT_ASX = 3, FORMAT_M3U8 = 4};
     enum : int { AUDIO_NONE, HTTP_RESPONSE_HEADER, AUDIO_DATA, AUDIO_LOCALFILE,
-                 AUDIO_PLAYLISTINIT, AUDIO_PLAYLISTHEADER,  AUDIO_PLAYLISTDATA};
+                 AUDIO_PLAYLISTINIT, AUDIO_PLAYLISTHEADER,  AUDIO_PLAYLISTDATA, AUDIO_CONNECTING};
+    enum : uint8_t { CONN_IDLE = 0, CONN_RESOLVE = 1, CONN_CONNECT = 2, CONN_TLS = 3, CONN_REQUEST = 4 };
+    static const uint16_t CONN_RESOLVE_MS = 3000, CONN_TCP_MS = 4000, CONN_TLS_MS = 8000, CONN_RESPONSE_MS = 3000;
     enum : int { FLAC_BEGIN = 0, FLAC_MAGIC = 1, FLAC_MBH =2, FLAC_SINFO = 3, FLAC_PADDING = 4, FLAC_APP = 5,
                  FLAC_SEEK = 6, FLAC_VORBIS = 7, FLAC_CUESHEET = 8, FLAC_PICTURE = 9, FLAC_OKAY = 100};
     enum : int { M4A_BEGIN = 0, M4A_FTYP = 1, M4A_CHK = 2, M4A_MOOV = 3, M4A_FREE = 4, M4A_TRAK = 5, M4A_MDAT = 6,
@@ -649,6 +724,7 @@ private:
 
     SemaphoreHandle_t     mutex_playAudioData;
     SemaphoreHandle_t     mutex_audioTask;
+    SemaphoreHandle_t     mutex_file;   // audiofile between the read-ahead task and the rest
     TaskHandle_t          m_audioTaskHandle = nullptr;
 
 #pragma GCC diagnostic push
@@ -660,12 +736,19 @@ private:
 #else
     i2s_config_t          m_i2s_config = {};
     i2s_pin_config_t      m_pin_config = {};
+    QueueHandle_t         m_i2sEvents = NULL;  // TX_DONE and TX_Q_OVF of the driver, drained in I2Slevel()
 #endif
 #pragma GCC diagnostic pop
-
-    std::vector<char*>    m_playlistContent;  // m3u8 playlist buffer
+    bool                  m_f_i2sLost = false; // I2Sresize could make neither queue, no channel until reconfigI2S makes one
+    DmaTune               m_dmaTune;           // size of the DMA queue per sample rate
+    volatile uint32_t     m_dmaSent = 0;       // frames the DMA has sent, silence included
+    volatile uint32_t     m_dmaUnder = 0;      // descriptors sent empty (the queue ran dry)
+    uint32_t              m_dmaWritten = 0;    // frames written to the DMA queue
+    uint8_t               m_dmaSleepMs = 20;   // audio task wait while the queue is full
+
+    std::vector<char*>    m_playlistContent;  // m3u, pls, asx playlist lines
     std::vector<char*>    m_playlistURL;      // m3u8 streamURLs buffer
-    std::vector<uint32_t> m_hashQueue;
+    std::vector<char*>    m_mirrorURL;        // further entries of a pls/m3u playlist, raced against the first one
 
     const size_t    m_frameSizeWav    = 4096;
     const size_t    m_frameSizeMP3    = 1600;
@@ -724,7 +807,6 @@ private:
     int16_t         m_curSample{0};
     uint16_t        m_dataMode{0};                  // Statemaschine
     int16_t         m_decodeError = 0;              // Stores the return value of the decoder
-    uint16_t        m_streamTitleHash = 0;          // remember streamtitle, ignore multiple occurence in metadata
     uint16_t        m_timeout_ms = 250;
     uint16_t        m_timeout_ms_ssl = 2700;
     uint8_t         m_flacBitsPerSample = 0;        // bps should be 16
@@ -734,7 +816,6 @@ private:
     uint16_t        m_flacMaxBlockSize = 0;         // can be read out in the FLAC file header
     uint32_t        m_flacTotalSamplesInStream = 0; // can be read out in the FLAC file header
     uint32_t        m_metaint = 0;                  // Number of databytes between metadata
-    uint32_t        m_chunkcount = 0 ;              // Counter for chunked transfer
     uint32_t        m_t0 = 0;                       // store millis(), is needed for a small delay
     uint32_t        m_contentlength = 0;            // Stores the length if the stream comes from fileserver
     uint32_t        m_bytesNotDecoded = 0;          // pictures or something else that comes with the stream
@@ -779,6 +860,51 @@ private:
     bool            m_f_lockInBuffer = false;       // lock inBuffer for manipulation
     bool            m_f_audioTaskIsDecoding = false;
     bool            m_f_acceptRanges = false;
+    bool            m_f_tsPaused = false;           // timeshift: decoder halted, stream is still received
+    size_t          m_timeshiftSize = 0;            // timeshift: size of InBuff in PSRAM, 0 = off
+    Prebuffer       m_prebuf;                       // adaptive start / resume threshold for webstreams
+    bool            m_f_prebuffering = false;       // webstream underrun, wait for the resume threshold
+    uint16_t        m_pbStartMs = 0;
+    uint16_t        m_pbResumeMs = 0;
+    uint32_t        m_pbT0 = 0;                     // connection start, for time to first sound
+    Ttfs            m_ttfs;                         // phases of the current tune up to the first write to I2S
+    Compressor      m_comp;                         // night mode, between the filter chain and the volume
+    ConnRace        m_race;                         // candidates of the current connecttohost
+    uint8_t         m_connPhase = CONN_IDLE;        // connection setup driven by connectLoop()
+    uint32_t        m_connT0 = 0;                   // start of the current phase
+    uint32_t        m_connStart = 0;                // connecttohost() call
+    uint16_t        m_connMs[CONN_REQUEST + 1] = {0}; // time spent in each phase
+    uint32_t        m_connKey = 0;                  // hash of the url, the race remembers its winner by it
+    char*           m_connRequest = NULL;           // request header, sent once connected and again on a reconnect
+    std::vector<char*> m_connPending;               // urls still being resolved
+    HttpParser      m_http;                         // response header and chunked framing of _client
+    char            m_rhl[512];                     // response header line being received
+    uint8_t         m_rest[256];                    // the header is read in blocks, what came behind it is body
+    uint16_t        m_restPos = 0, m_restLen = 0;
+    uint32_t        m_rhlT0 = 0;                    // first parseHttpResponseHeader() call of this header, 0 = none yet
+    bool            m_f_ctSeen = false;             // content-type seen in this header
+    Reconnect       m_reconn;                       // a dropped webstream reconnects while the buffer plays on
+    StreamWatch     m_watch;                        // silence, frozen buffer, stuck decoder or trickle of a connected webstream
+    ReadAhead       m_ra;                           // blocks of the local file the read-ahead task read ahead of the player
+    uint8_t*        m_raMem = NULL;
+    TaskHandle_t    m_raTask = NULL;
+    volatile bool   m_f_readAhead = false;          // processLocalFile() takes from m_ra, the task owns the file position
+    uint16_t        m_reconnStallMs = 0;            // no data for this long counts as a drop
+    uint32_t        m_reconnStableMs = 0;           // a run this long without a drop is reported as STABLE
+    uint32_t        m_rxT = 0;                      // last data from the webstream
+    uint32_t        m_stableT0 = 0;                 // start of the current run without a drop
+    uint8_t         m_reconnCodec = 0;              // codec before the drop, the new connection has to match
+    uint32_t        m_reconnSkipped = 0;            // new data dropped while looking for a frame sync
+    bool            m_f_resync = false;             // reconnected: drop new data up to the first frame sync
+    uint32_t        m_spliceLeft = 0;               // old bytes in InBuff before the new data, the last frame is cut off
+#if HLS_BUFFER_SIZE>0
+    HlsClient       m_hls;                          // playlist reloads and segment prefetch of a m3u8 stream
+#endif
+    TsDemux         m_ts;                           // m3u8 transport stream segments
+    uint8_t*        m_tsBuf = NULL;                 // TS_BATCH packets read at once
+    M3u8            m_m3u8;                         // m3u8 playlist, parsed as it is read
+    char*           m_m3u8Arena = NULL;             // M3U8_ARENA_SIZE, PSRAM
+    Icy             m_icy;                          // metadata parser, remembers the last title and url
     uint8_t         m_f_channelEnabled = 3;         // internal DAC, both channels
     uint32_t        m_audioFileDuration = 0;
     float           m_audioCurrentTime = 0;
@@ -0,0 +1,68 @@
+// Adaptive bitrate for HLS master playlists, used by the HLS segment engine. Plain C++ without Arduino
+// dependencies, times are passed in (ms), so it can be driven by a throttled test server.
+//
+// The throughput is estimated from the segment downloads, two exponentially weighted averages (fast and slow,
+// weighted by download time) of which the lower one counts: a drop shows within a few segments, a rise only once
+// it lasts. A variant is chosen with hysteresis: up only when its bandwidth fits well below the estimate, at least
+// one segment is ready ahead and the last switch is a while ago; down as soon as the current variant no longer
+// fits or the buffer runs low. Variants are sorted by bandwidth, ascending.
+
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+class Abr {
+  public:
+    void begin(uint32_t now) {                                          // a stream starts, nothing measured yet
+        _fast = _slow = 0; _weight = 0;
+        _switchT = now;
+    }
+
+    void sample(uint32_t bytes, uint32_t ms) {                          // a segment download
+        if(bytes < MIN_BYTES) return;                                   // too short to tell (slow start, proxy cache)
+        if(ms < 1) ms = 1;
+        float bps = bytes * 8000.0f / ms;
+        float w = ms / 1000.0f;
+        _fast = _mix(_fast, bps, w, FAST_S);
+        _slow = _mix(_slow, bps, w, SLOW_S);
+        _weight += w;
+    }
+
+    uint32_t estimate() {                                               // bit/s, 0 = not measured yet
+        if(_weight <= 0) return 0;
+        float f = _fast / (1 - powf(0.5f, _weight / FAST_S));           // without the bias of the zero start
+        float s = _slow / (1 - powf(0.5f, _weight / SLOW_S));
+        return f < s ? f : s;
+    }
+
+    // variant to play from the next segment on, cur if it stays; bufferMs = what is ready ahead of playback
+    uint8_t choose(const uint32_t* bw, uint8_t n, uint8_t cur, uint32_t bufferMs, uint32_t targetMs, uint32_t now) {
+        uint32_t est = estimate();
+        if(!est || n < 2) return cur;
+        uint8_t fit = 0;                                                // best one that fits well below the estimate
+        while(fit + 1 < n && bw[fit + 1] <= (uint64_t)est * UP_PCT / 100) fit++;
+        bool low = bufferMs < targetMs / 2;
+        if(cur > 0 && (uint64_t)bw[cur] * 100 > (uint64_t)est * DOWN_PCT) { _switchT = now; return fit; }
+        if(cur > 0 && low && fit < cur) { _switchT = now; return cur - 1; }    // fits, but not by much: one step
+        if(fit > cur && !low && bufferMs >= targetMs && now - _switchT >= HOLD_SEGMENTS * targetMs) {
+            _switchT = now;
+            return fit;
+        }
+        return cur;
+    }
+
+  private:
+    static constexpr float    FAST_S = 3, SLOW_S = 9;                   // half-lives in seconds of download
+    static constexpr uint32_t MIN_BYTES = 16000;
+    static constexpr uint8_t  UP_PCT = 70;                              // up to a variant of at most 70 % of the estimate
+    static constexpr uint8_t  DOWN_PCT = 90;                            // down when the current one needs over 90 %
+    static constexpr uint8_t  HOLD_SEGMENTS = 4;                        // no way up for this many target durations
+
+    float    _fast = 0, _slow = 0, _weight = 0;
+    uint32_t _switchT = 0;
+
+    static float _mix(float avg, float v, float w, float halfLife) {
+        float a = powf(0.5f, w / halfLife);
+        return a * avg + (1 - a) * v;
+    }
+};
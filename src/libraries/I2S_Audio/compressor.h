@@ -0,0 +1,184 @@
+// Night mode, used by Audio::playChunk: a stereo linked feed-forward compressor with a brickwall look-ahead limiter
+// behind it. Plain C++ without Arduino dependencies and integer only in process(), so a host harness measures the
+// same gain curves and cycles.
+//
+// The compressor takes the peak of both channels over SUB frames, turns it into a level in 1/256 steps of log2
+// (6.02 dB), reduces what is above the threshold by the ratio, smooths that with attack and release, adds the makeup
+// gain and ramps to the new gain over the next SUB frames. The limiter delays its input by the look-ahead. The gain a
+// frame needs to stay below the ceiling is held for the look-ahead (sliding minimum), released slowly and averaged
+// over the look-ahead, so the gain is already down when the peak leaves the delay line; the average never exceeds
+// the gain of a peak inside its window, nothing passes the ceiling.
+
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+class Compressor {
+  public:
+    static const uint16_t LOOK_MAX = 256;                               // frames, 5.3 ms at 48 kHz
+    static const uint8_t  SUB = 16;                                     // frames per compressor gain step
+    static const uint16_t RELEASE_MS = 50;                              // of the limiter
+
+    void setParams(int8_t thresholdDb, uint8_t ratio, uint8_t attackMs, uint16_t releaseMs, uint8_t makeupDb) {
+        _thrDb = thresholdDb > 0 ? 0 : thresholdDb;
+        _ratio = ratio < 1 ? 1 : ratio;
+        _atkMs = attackMs < 1 ? 1 : attackMs;
+        _relMs = releaseMs < 1 ? 1 : releaseMs;
+        _makeupDb = makeupDb > 18 ? 18 : makeupDb;                      // 8 x, the limiter takes the rest
+        _dirty = true;                                                  // taken by process(), in the audio task
+    }
+    void setLimiter(int8_t ceilingDb, uint8_t lookaheadMs) {           // taken at the next setRate()
+        _ceilDb = ceilingDb > 0 ? 0 : ceilingDb;
+        _lookMs = lookaheadMs;
+    }
+    void setRate(uint32_t rate) {                                       // from the audio task, drops the delay line
+        _rate = rate;
+        uint32_t look = (uint64_t)_lookMs * rate / 1000;
+        _look = look < 1 ? 1 : look > LOOK_MAX ? LOOK_MAX : look;
+        _ceil = 32768.0f * powf(10.0f, _ceilDb / 20.0f);
+        if(_ceil > 32767) _ceil = 32767;
+        _coefs();
+        reset();
+    }
+    void enable(bool on) { _want = on; }                                // taken at the next process()
+    bool enabled() const { return _want; }
+
+    void reset() {
+        for(uint16_t i = 0; i < _look; i++) { _dl[i][0] = _dl[i][1] = 0; _gr[i] = UNITY; }
+        _sum = _full = (uint32_t)_look * UNITY;
+        _inv = 0xFFFFFFFFu / _look;
+        _pos = 0; _n = 0; _qh = 0; _qn = 0;
+        _held = UNITY;
+        _red = 0; _redMin = UNITY;
+        _sub = SUB; _peak = 0; _level = 0;
+        _g = _exp2(_makeup); _dg = 0;
+    }
+
+    void process(int16_t* lr, uint32_t frames) {                       // interleaved stereo, in place
+        if(!_want) { _on = false; return; }
+        if(!_rate) return;
+        if(_dirty) _coefs();
+        if(!_on) { _on = true; reset(); }                               // starts from silence, the look-ahead is lost
+        uint16_t low = UNITY;
+        for(uint32_t f = 0; f < frames; f++, lr += 2) {
+            /* compressor, gain in Q16 ramped per frame */
+            int32_t l = lr[0], r = lr[1];
+            int32_t pk = l < 0 ? -l : l, b = r < 0 ? -r : r;
+            if(b > pk) pk = b;
+            if(pk > _peak) _peak = pk;
+            if(!--_sub) _step();
+            _g += _dg;
+            int32_t gq = _g >> 4;                                       // Q12, 18 dB at most: fits with 16 bits
+            l = l * gq >> 12;
+            r = r * gq >> 12;
+
+            /* limiter, the gain this frame needs (Q15) */
+            pk = l < 0 ? -l : l; b = r < 0 ? -r : r;
+            if(b > pk) pk = b;
+            uint16_t need = pk > _ceil ? (uint32_t)_ceil * UNITY / pk : UNITY;
+            while(_qn && _qv[_qidx(_qn - 1)] >= need) _qn--;           // sliding minimum over the look-ahead
+            _qv[_qidx(_qn)] = need; _qi[_qidx(_qn)] = _n; _qn++;
+            if(_n - _qi[_qh] >= _look) { _qh = _qh + 1 == QLEN ? 0 : _qh + 1; _qn--; }
+            uint16_t held = _qv[_qh];
+            _held += ((uint32_t)(UNITY - _held) * _lrel + 32767) >> 15;  // release, rounded up to reach unity
+            if(held < _held) _held = held;
+            _sum += _held; _sum -= _gr[_pos]; _gr[_pos] = _held;       // averaged over the look-ahead
+            uint32_t gain = _sum == _full ? UNITY : (uint32_t)(((uint64_t)_sum * _inv) >> 32);
+            if(gain < low) low = gain;
+
+            _dl[_pos][0] = l; _dl[_pos][1] = r;
+            _pos = _pos + 1 == _look ? 0 : _pos + 1;                   // now the oldest frame, look - 1 behind
+            int32_t ol = _scale(_dl[_pos][0], gain), or_ = _scale(_dl[_pos][1], gain);
+            if(ol > _ceil || ol < -_ceil || or_ > _ceil || or_ < -_ceil) {   // never, counted for the harness
+                _clips++;
+                ol = ol > _ceil ? _ceil : ol < -_ceil ? -_ceil : ol;
+                or_ = or_ > _ceil ? _ceil : or_ < -_ceil ? -_ceil : or_;
+            }
+            lr[0] = ol; lr[1] = or_;
+            _n++;
+        }
+        _redMin = low;
+        _red = (_level >> 8) + (low < UNITY ? 15 * 256 - _log2(low) : 0);
+    }
+
+    uint16_t reductionDb10() const { return (uint32_t)_red * 602 / 2560; } // compressor and limiter, last block, 0.1 dB
+    uint16_t limiterGain() const { return _redMin; }                   // lowest of the last block, Q15
+    uint16_t latency() const { return _look - 1; }                      // frames
+    uint32_t clipped() const { return _clips; }
+
+    static int32_t log2q8(uint32_t x) { return x ? _log2(x) : 0; }     // for the harness
+    static int32_t exp2q8(int32_t x) { return _exp2(x); }
+
+  private:
+    static const uint16_t UNITY = 32768;                                // Q15
+    static const uint16_t QLEN = LOOK_MAX + 1;
+    int8_t   _thrDb = -24, _ceilDb = -1;
+    uint8_t  _ratio = 4, _atkMs = 5, _makeupDb = 6, _lookMs = 2;
+    uint16_t _relMs = 250;
+    volatile bool _want = false, _dirty = true;
+    bool     _on = false;
+    uint32_t _rate = 0;
+    /* compressor */
+    int32_t  _thr = 0, _makeup = 0, _atk = 0, _rel = 0;                  // log2 Q8, coefficients Q15 per SUB frames
+    int32_t  _level = 0;                                                // smoothed reduction, log2 Q16
+    int32_t  _g = 65536, _dg = 0, _peak = 0;
+    uint8_t  _sub = SUB;
+    /* limiter */
+    int32_t  _ceil = 29204;
+    uint16_t _look = 1, _pos = 0, _qh = 0, _qn = 0, _held = UNITY, _lrel = 1, _redMin = UNITY;
+    uint32_t _n = 0, _sum = UNITY, _full = UNITY, _inv = 0xFFFFFFFFu, _clips = 0;
+    int32_t  _dl[LOOK_MAX][2] = {};
+    uint16_t _gr[LOOK_MAX] = {};
+    uint16_t _qv[QLEN] = {};
+    uint32_t _qi[QLEN] = {};
+    uint16_t _red = 0;
+
+    static int32_t _scale(int32_t v, uint32_t gain) {                  // rounded towards zero, stays below the ceiling
+        int64_t p = (int64_t)v * gain;
+        return (p + (p < 0 ? 32767 : 0)) >> 15;
+    }
+    uint16_t _qidx(uint16_t k) const { uint16_t i = _qh + k; return i >= QLEN ? i - QLEN : i; }
+
+    void _coefs() {
+        _dirty = false;
+        _thr = lroundf(_thrDb * 256 / 6.0206f);
+        _makeup = lroundf(_makeupDb * 256 / 6.0206f);
+        float sub = (float)SUB * 1000 / _rate;                          // ms per gain step
+        _atk = lroundf(32768 * (1 - expf(-sub / _atkMs)));
+        _rel = lroundf(32768 * (1 - expf(-sub / _relMs)));
+        _lrel = ceilf(32768 * (1 - expf(-1000.0f / _rate / RELEASE_MS)));
+        if(_atk < 1) _atk = 1;
+        if(_rel < 1) _rel = 1;
+    }
+
+    void _step() {                                                      // the next compressor gain, every SUB frames
+        _sub = SUB;
+        int32_t lv = _peak ? _log2(_peak) - 15 * 256 : -16 * 256;      // of full scale
+        _peak = 0;
+        int32_t over = lv - _thr;
+        int32_t t = over > 0 ? (over - over / _ratio) << 8 : 0;
+        int32_t c = t > _level ? _atk : _rel;
+        _level += (int32_t)(((int64_t)(t - _level) * c) >> 15);
+        _dg = (_exp2(_makeup - (_level >> 8)) - _g) / SUB;
+    }
+
+    static int32_t _log2(uint32_t x) {                                  // log2(x) in Q8, x > 0
+        static const uint16_t lg[33] = {0, 11, 22, 33, 44, 54, 63, 73, 82, 92, 100, 109, 118, 126, 134, 142, 150,
+                                        157, 165, 172, 179, 186, 193, 200, 207, 213, 220, 226, 232, 238, 244, 250, 256};
+        int32_t e = 31 - __builtin_clz(x);
+        uint32_t m = e >= 10 ? x >> (e - 10) : x << (10 - e);           // 1.10, 1024..2047
+        uint32_t k = m >> 5 & 31, fr = m & 31;
+        return e * 256 + lg[k] + ((int32_t)(lg[k + 1] - lg[k]) * (int32_t)fr >> 5);
+    }
+
+    static int32_t _exp2(int32_t x) {                                   // 2^(x / 256) in Q16
+        static const uint32_t ex[33] = {32768, 33486, 34219, 34968, 35734, 36516, 37316, 38133, 38968, 39821, 40693,
+                                        41584, 42495, 43425, 44376, 45348, 46341, 47356, 48393, 49452, 50535, 51642,
+                                        52773, 53928, 55109, 56316, 57549, 58809, 60097, 61413, 62757, 64132, 65536};
+        int32_t i = (x >> 8) + 1;                                       // the table is Q15
+        uint32_t fr = x & 255, k = fr >> 3;
+        uint32_t v = ex[k] + ((ex[k + 1] - ex[k]) * (fr & 7) >> 3);
+        if(i >= 0) return i > 14 ? 0x7FFFFFFF : v << i;
+        return i < -31 ? 0 : v >> -i;
+    }
+};
@@ -0,0 +1,291 @@
+// Connection racing for webstreams, used by Audio::connecttohost.
+// Plain BSD sockets (lwIP on the ESP32) and a passed in clock (ms), so it can be run against local test servers.
+//
+// Every candidate is one address of one URL (playlist mirrors x DNS results). Attempts start staggered,
+// the winner of the last race for the same key first (last if it was avoided), and the next one is started at once when an attempt
+// fails or runs out of time (connectMs for the TCP connect, responseMs for the status line). A plain http
+// candidate wins with the first valid ICY/HTTP status line (only peeked, the response stays in the socket
+// for Audio), an https candidate with its TCP connect (TLS follows, see Audio::connectLoop). All other attempts
+// are closed. Nothing blocks: start() and then poll() until it is decided, run() does both.
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef ESP_PLATFORM
+  #include <lwip/sockets.h>
+  #include <lwip/netdb.h>
+#else
+  #include <sys/socket.h>
+  #include <sys/select.h>
+  #include <netinet/in.h>
+  #include <netdb.h>
+#endif
+
+class ConnRace {
+  public:
+    static const uint8_t MAX_CANDIDATES = 8;
+
+    ~ConnRace() { clear(); }
+
+    void clear() {
+        for(uint8_t i = 0; i < _n; i++) { _closeFd(_c[i]); free(_c[i].url); }
+        _n = 0; _winner = -1;
+        free(_headers); _headers = NULL;
+    }
+
+    static const uint8_t RESOLVING = 0xFF;                              // from a resolver that was told not to wait: ask again later
+    typedef uint8_t (*resolver_t)(const char* host, uint32_t* ips, uint8_t max, bool wait);
+
+    // returns number of addresses added, or RESOLVING. Without a resolver getaddrinfo() is used (and waited for).
+    uint8_t add(const char* url, resolver_t resolve = NULL, bool wait = true) {
+        if(!url || _n >= MAX_CANDIDATES) return 0;
+        bool tls = strncmp(url, "https://", 8) == 0;
+        if(!tls && strncmp(url, "http://", 7) != 0) return 0;
+        const char* h = url + (tls ? 8 : 7);
+        const char* path = strchr(h, '/');
+        size_t hl = path ? (size_t)(path - h) : strlen(h);
+        char host[sizeof(_c[0].host)];
+        if(hl >= sizeof(host)) return 0;
+        memcpy(host, h, hl); host[hl] = 0;
+        uint16_t port = tls ? 443 : 80;
+        char* colon = strchr(host, ':');
+        if(colon) { port = atoi(colon + 1); *colon = 0; }
+
+        uint32_t ips[MAX_CANDIDATES];
+        uint8_t count = resolve ? resolve(host, ips, MAX_CANDIDATES, wait) : 0;
+        if(count == RESOLVING) return RESOLVING;
+        if(!resolve) {
+            struct addrinfo hints, *res = NULL;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            if(getaddrinfo(host, NULL, &hints, &res) != 0 || !res) return 0;
+            for(struct addrinfo* ai = res; ai && count < MAX_CANDIDATES; ai = ai->ai_next) ips[count++] = ((struct sockaddr_in*)ai->ai_addr)->sin_addr.s_addr;
+            freeaddrinfo(res);
+        }
+        uint8_t added = 0;
+        for(uint8_t a = 0; a < count && _n < MAX_CANDIDATES; a++) {
+            uint32_t ip = ips[a];
+            bool dup = false;
+            for(uint8_t i = 0; i < _n; i++) if(_c[i].ip == ip && _c[i].port == port && strcmp(_c[i].url, url) == 0) dup = true;
+            if(dup) continue;
+            candidate_t& c = _c[_n];
+            memset(&c, 0, sizeof(c));
+            c.url = strdup(url);
+            if(!c.url) break;
+            strcpy(c.host, host);
+            c.path = path ? c.url + (path - url) : "/";
+            c.port = port; c.tls = tls; c.ip = ip; c.fd = -1;
+            _n++; added++;
+        }
+        return added;
+    }
+
+    // headers: request lines after "Host:", ending with the empty line
+    void start(uint32_t key, const char* headers, uint16_t staggerMs, uint32_t connectMs, uint32_t responseMs, uint32_t (*clock)()) {
+        free(_headers);
+        _headers = strdup(headers ? headers : "\r\n");
+        _key = key; _connectMs = connectMs; _responseMs = responseMs; _clock = clock;
+        _winner = -1;
+        _preferWinner(key);
+        _t0 = clock();
+        for(uint8_t i = 0; i < _n; i++) { _c[i].state = C_WAIT; _c[i].at = i * staggerMs; }
+    }
+
+    // 1 = decided, see winner(); 0 = still running; -1 = every candidate failed. Waits at most waitMs for the sockets.
+    int8_t poll(uint16_t waitMs) {
+        if(_winner >= 0) return 1;
+        if(!_headers) return -1;
+        uint32_t t = _clock() - _t0;
+        bool pending = false;
+        int maxfd = -1;
+        fd_set rd, wr;
+        FD_ZERO(&rd); FD_ZERO(&wr);
+        for(uint8_t i = 0; i < _n; i++) {
+            candidate_t& c = _c[i];
+            if(c.state == C_WAIT && t >= c.at) { if(_start(c)) c.at = t; else _fail(i, t); }
+            if(c.state == C_CONNECTING && t - c.at > _connectMs) _fail(i, t);
+            if(c.state == C_SENT && t - c.at > _responseMs) _fail(i, t);
+            if(c.state == C_WAIT) pending = true;
+            if(c.state == C_CONNECTING) { FD_SET(c.fd, &wr); pending = true; }
+            if(c.state == C_SENT)       { FD_SET(c.fd, &rd); pending = true; }
+            if(c.fd > maxfd) maxfd = c.fd;
+        }
+        if(!pending) {                                                  // everything failed
+            for(uint8_t i = 0; i < _n; i++) _closeFd(_c[i]);
+            free(_headers); _headers = NULL;
+            return -1;
+        }
+        struct timeval tv = {0, (long)waitMs * 1000};
+        if(select(maxfd + 1, maxfd >= 0 ? &rd : NULL, maxfd >= 0 ? &wr : NULL, NULL, &tv) <= 0) return 0;
+        t = _clock() - _t0;
+        for(uint8_t i = 0; i < _n; i++) {
+            candidate_t& c = _c[i];
+            if(c.state == C_CONNECTING && FD_ISSET(c.fd, &wr)) {
+                int err = 0;
+                socklen_t errLen = sizeof(err);
+                if(getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &errLen) != 0 || err) { _fail(i, t); continue; }
+                if(c.tls) { _win(i, t); break; }
+                size_t len = strlen(c.path) + strlen(c.host) + strlen(_headers) + 32;
+                char* rqh = (char*)malloc(len);
+                int l = rqh ? request(i, _headers, rqh, len) : -1;
+                bool sent = l > 0 && send(c.fd, rqh, l, 0) == l;
+                free(rqh);
+                if(!sent) { _fail(i, t); continue; }
+                c.state = C_SENT;
+                c.at = t;
+            }
+            else if(c.state == C_SENT && FD_ISSET(c.fd, &rd)) {
+                char buf[16];
+                int n = recv(c.fd, buf, sizeof(buf) - 1, MSG_PEEK);
+                if(n <= 0) { _fail(i, t); continue; }
+                buf[n] = 0;
+                int8_t s = _status(buf, n);
+                if(s > 0) { _win(i, t); break; }
+                if(s < 0) _fail(i, t);
+            }
+        }
+        return _winner >= 0 ? 1 : 0;
+    }
+
+    // start() and poll() until decided, returns the winner or -1
+    int8_t run(uint32_t key, const char* headers, uint16_t staggerMs, uint32_t timeoutMs, uint32_t (*clock)()) {
+        start(key, headers, staggerMs, timeoutMs, timeoutMs, clock);
+        int8_t r;
+        while((r = poll(10)) == 0);
+        return r > 0 ? _winner : -1;
+    }
+
+    int request(uint8_t i, const char* headers, char* buf, size_t len) {
+        int l = snprintf(buf, len, "GET %s HTTP/1.1\r\nHost: %s\r\n%s", _c[i].path, _c[i].host, headers);
+        return l > 0 && (size_t)l < len ? l : -1;
+    }
+
+    int release(uint8_t i) {                                            // hand the socket over, back to blocking
+        int fd = _c[i].fd;
+        _c[i].fd = -1;
+        if(fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+        return fd;
+    }
+
+    uint8_t     count()           { return _n; }
+    int8_t      winner()          { return _winner; }
+    uint32_t    winMs()           { return _winMs; }
+    const char* url(uint8_t i)    { return _c[i].url; }
+    const char* host(uint8_t i)   { return _c[i].host; }
+    uint16_t    port(uint8_t i)   { return _c[i].port; }
+    uint32_t    ip(uint8_t i)     { return _c[i].ip; }              // network order
+    bool        tls(uint8_t i)    { return _c[i].tls; }
+
+    static uint32_t hash(const char* s) {                               // FNV-1a
+        uint32_t h = 2166136261u;
+        while(*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+        return h;
+    }
+
+    // the remembered winner of key goes last in its next race (a dead stream behind a connection that stays up)
+    static void avoid(uint32_t key) {
+        won_t* w = _won();
+        for(uint8_t k = 0; k < REMEMBER; k++) if(w[k].key == key) { w[k].avoid = true; return; }
+    }
+
+  private:
+    enum { C_WAIT = 0, C_CONNECTING, C_SENT, C_FAILED, C_WON };
+    struct candidate_t {
+        char*       url;
+        char        host[128];
+        const char* path;
+        uint16_t    port;
+        bool        tls;
+        uint32_t    ip;
+        int         fd;
+        uint8_t     state;
+        uint32_t    at;                                                 // C_WAIT: start time, then start of the current phase
+    };
+    struct won_t { uint32_t key, url, ip; bool avoid; };
+    static const uint8_t REMEMBER = 8;
+
+    candidate_t _c[MAX_CANDIDATES];
+    uint8_t     _n = 0;
+    int8_t      _winner = -1;
+    uint32_t    _winMs = 0;
+    char*       _headers = NULL;
+    uint32_t    _key = 0, _t0 = 0, _connectMs = 0, _responseMs = 0;
+    uint32_t    (*_clock)() = NULL;
+
+    static won_t* _won() { static won_t w[REMEMBER] = {}; return w; }  // most recent first
+
+    void _preferWinner(uint32_t key) {
+        won_t* w = _won();
+        for(uint8_t k = 0; k < REMEMBER; k++) {
+            if(w[k].key != key) continue;
+            for(uint8_t i = 0; i < _n; i++) {
+                if(_c[i].ip != w[k].ip || hash(_c[i].url) != w[k].url) continue;
+                candidate_t c = _c[i];
+                if(w[k].avoid) { memmove(&_c[i], &_c[i + 1], (_n - 1 - i) * sizeof(candidate_t)); _c[_n - 1] = c; }
+                else { memmove(&_c[1], &_c[0], i * sizeof(candidate_t)); _c[0] = c; }
+                break;
+            }
+            return;
+        }
+    }
+
+    void _remember(uint32_t key, uint8_t i) {
+        won_t* w = _won();
+        uint8_t k = 0;
+        while(k < REMEMBER - 1 && w[k].key != key) k++;
+        memmove(&w[1], &w[0], k * sizeof(won_t));
+        w[0].key = key; w[0].url = hash(_c[i].url); w[0].ip = _c[i].ip; w[0].avoid = false;
+    }
+
+    bool _start(candidate_t& c) {
+        c.fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if(c.fd < 0) return false;
+        fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL, 0) | O_NONBLOCK);
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(c.port);
+        sa.sin_addr.s_addr = c.ip;
+        if(connect(c.fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 && errno != EINPROGRESS) return false;
+        c.state = C_CONNECTING;
+        return true;
+    }
+
+    void _fail(uint8_t i, uint32_t t) {
+        _closeFd(_c[i]);
+        _c[i].state = C_FAILED;
+        for(uint8_t j = 0; j < _n; j++) {                               // don't wait for the stagger
+            if(_c[j].state != C_WAIT) continue;
+            if(_c[j].at > t) _c[j].at = t;
+            break;
+        }
+    }
+
+    void _win(uint8_t i, uint32_t t) {
+        _c[i].state = C_WON;
+        _winner = i; _winMs = t;
+        for(uint8_t j = 0; j < _n; j++) if(j != i) _closeFd(_c[j]);
+        _remember(_key, i);
+    }
+
+    // 1 = usable status line (2xx, 3xx), -1 = error status, 0 = not complete yet
+    static int8_t _status(const char* b, int n) {
+        const char* code = NULL;
+        if(n >= 7 && strncmp(b, "ICY ", 4) == 0) code = b + 4;
+        else if(n >= 12 && strncmp(b, "HTTP/1.", 7) == 0) code = b + 9;
+        else if(n >= 12) return -1;
+        if(!code) return (strncmp(b, "ICY ", n < 4 ? n : 4) == 0 || strncmp(b, "HTTP/1.", n < 7 ? n : 7) == 0) ? 0 : -1;
+        return (code[0] == '2' || code[0] == '3') ? 1 : -1;
+    }
+
+    static void _closeFd(candidate_t& c) {
+        if(c.fd >= 0) close(c.fd);
+        c.fd = -1;
+    }
+};
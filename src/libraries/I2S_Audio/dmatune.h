@@ -0,0 +1,107 @@
+// I2S DMA queue sizing, used by Audio::playChunk / reconfigI2S.
+// Plain C++ without Arduino dependencies, fill levels and times are passed in, so it can be driven by recorded traces.
+//
+// level() is called before each write to I2S with the frames still queued for the DMA. The lowest level of a window
+// of WINDOW_MS is how close the audio task came to an underrun (the margin). A window with an underrun, or with less
+// than a quarter of the queue left, raises the latency of the sample rate; windows with more than three quarters left
+// for stableMs in a row lower it by 1/8. The latency is learned per sample rate (a rate not seen yet starts from the
+// one in use), size() turns it into descriptors and frames per descriptor. A new queue drops what is queued and
+// takes DMA memory, so it is only taken at the next reconfigI2S and only when the learned latency is more than
+// KEEP_PCT away from what the queue in use holds at the new rate: a change between 44.1 and 48 kHz alone keeps it.
+
+#pragma once
+#include <stdint.h>
+
+class DmaTune {
+  public:
+    static const uint16_t DESC_MIN = 4, DESC_MAX = 64;
+    static const uint16_t FRAME_MIN = 64, FRAME_MAX = 1016;             // 4092 bytes per descriptor at most (IDF5)
+
+    void setLimits(uint16_t minMs, uint16_t maxMs, uint32_t stableMs) {
+        _minMs = minMs; _maxMs = maxMs;
+        _stable = stableMs / WINDOW_MS ? stableMs / WINDOW_MS : 1;
+    }
+    void setStart(uint16_t ms) { _startMs = ms; }                       // for the first sample rate
+
+    void begin(uint32_t rate, uint16_t desc, uint16_t frames) {         // (re)configured with this queue
+        _rate = rate; _desc = desc; _frames = frames;
+        _slot = _find(rate);
+        _applied = _slots[_slot].ms;
+        _run = 0;
+        pause();
+    }
+
+    void pause() { _armed = false; }    // no writes for a while on purpose (stopped, starved, paused), not a measurement
+
+    void level(uint32_t queued, uint32_t underruns, uint32_t now) {
+        if(!_rate) return;
+        uint32_t cap = (uint32_t)_desc * _frames;
+        if(!_armed) {                                                   // the queue fills up again first
+            _lastUnder = underruns;
+            if(queued < cap / 2) return;
+            _armed = true; _t0 = now; _min = cap; _under = 0;
+            return;
+        }
+        if(underruns != _lastUnder) { _lastUnder = underruns; _under++; _underruns++; }   // once per write
+        if(queued < _min) _min = queued;
+        if(now - _t0 < WINDOW_MS) return;
+        _margin = (uint64_t)_min * 1000 / _rate;
+        /* decided on the queue in use only, a choice not applied yet is not raised or lowered again */
+        uint16_t& ms = _slots[_slot].ms;
+        if(ms == _applied) {
+            if(_under) { ms = _clamp(ms + ms / 2); _run = 0; }
+            else if(_min < cap / 4) { ms = _clamp(ms + ms / 4); _run = 0; }
+            else if(_min > cap / 4 * 3) { if(++_run >= _stable) { ms = _clamp(ms - ms / 8); _run = 0; } }
+            else _run = 0;
+        }
+        _t0 = now; _min = cap; _under = 0;
+    }
+
+    bool size(uint32_t rate, uint16_t& desc, uint16_t& frames) {       // the queue for rate, true if it is another one
+        uint16_t ms = _slots[_find(rate)].ms;
+        uint32_t cur = (uint64_t)desc * frames * 1000 / rate;           // of the queue in use, at this rate
+        if(cur && cur * (100 + KEEP_PCT) >= ms * 100u && ms * (100u + KEEP_PCT) >= cur * 100) return false;
+        uint32_t lat = (uint64_t)ms * rate / 1000;
+        uint32_t f = lat / 16 & ~7u;                                    // about 16 descriptors, a level step is one
+        if(f < FRAME_MIN) f = FRAME_MIN;
+        if(f > FRAME_MAX) f = FRAME_MAX;
+        uint32_t d = (lat + f - 1) / f;
+        if(d < DESC_MIN) d = DESC_MIN;
+        if(d > DESC_MAX) d = DESC_MAX;
+        bool other = d != desc || f != frames;
+        desc = d; frames = f;
+        return other;
+    }
+
+    uint16_t latencyMs() { return _rate ? (uint64_t)_desc * _frames * 1000 / _rate : 0; }  // of the queue in use
+    uint16_t targetMs()  { return _rate ? _slots[_slot].ms : 0; }      // learned, taken at the next reconfigI2S
+    uint16_t marginMs()  { return _margin; }                            // lowest level of the last window
+    uint16_t underruns() { return _underruns; }
+    uint16_t desc()      { return _desc; }
+    uint16_t frames()    { return _frames; }
+
+  private:
+    static const uint32_t WINDOW_MS = 10000;
+    static const uint32_t KEEP_PCT = 10;                                // below one step down (1/8), above 48 / 44.1
+    static const uint8_t  SLOTS = 8;
+    struct slot_t { uint32_t rate; uint16_t ms; };
+    slot_t   _slots[SLOTS] = {};
+    uint8_t  _slot = 0, _next = 0;
+    uint16_t _minMs = 40, _maxMs = 250, _startMs = 186, _stable = 6;
+    uint32_t _rate = 0;
+    uint16_t _desc = 0, _frames = 0, _applied = 0;
+    bool     _armed = false;
+    uint32_t _t0 = 0, _min = 0, _lastUnder = 0;
+    uint16_t _under = 0, _run = 0, _margin = 0, _underruns = 0;
+
+    uint8_t _find(uint32_t rate) {
+        for(uint8_t i = 0; i < SLOTS; i++) if(_slots[i].rate == rate) return i;
+        uint8_t i = _next;                                              // the oldest one goes
+        _next = (_next + 1) % SLOTS;
+        if(i == _slot && _rate) { i = _next; _next = (_next + 1) % SLOTS; }  // not the one in use
+        _slots[i].rate = rate;
+        _slots[i].ms = _rate ? _slots[_slot].ms : _clamp(_startMs);   // the network does not change with the rate
+        return i;
+    }
+    uint16_t _clamp(uint32_t v) { return v < _minMs ? _minMs : (v > _maxMs ? _maxMs : v); }
+};
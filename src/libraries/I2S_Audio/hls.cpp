@@ -0,0 +1,717 @@
+#include "../../core/options.h"
+#if (I2S_DOUT!=255 || I2S_INTERNAL) && HLS_BUFFER_SIZE>0
+#include "hls.h"
+
+#define HLS_MASK    (HLS_BUFFER_SIZE - 1)
+#define HLS_URL_MAX 1024
+#if (HLS_BUFFER_SIZE & HLS_MASK) != 0
+  #error HLS_BUFFER_SIZE must be a power of two
+#endif
+
+static char* _psdup(const char* s) {
+    size_t n = strlen(s) + 1;
+    char* d = (char*)ps_malloc(n);
+    if(d) memcpy(d, s, n);
+    return d;
+}
+
+/***********************************************************************************************************************
+ *  HlsConn
+ ***********************************************************************************************************************/
+bool HlsConn::_connect(hlsResolver_t resolver) {
+    // as Audio::connectCached(): the address from the resolver cache if there is one, SNI needs the name
+    if(_ssl) _secure.setInsecure();
+    _sock = _ssl ? static_cast<WiFiClient*>(&_secure) : &_plain;
+    uint32_t ip = 0;
+    bool ok = false;
+    if(resolver && resolver(_host, &ip, 1, true)) {
+        if(_ssl) ok = _secure.connect(IPAddress(ip), _port, _host, NULL, NULL, NULL);
+        else     ok = _plain.connect(IPAddress(ip), _port, HLS_TIMEOUT_MS);
+    }
+    if(!ok) ok = _sock->connect(_host, _port);
+    if(!ok) _sock = NULL;
+    return ok;
+}
+
+bool HlsConn::request(const char* url, uint32_t from, hlsResolver_t resolver) {
+    bool ssl = strncmp(url, "https://", 8) == 0;
+    if(!ssl && strncmp(url, "http://", 7) != 0) return false;
+    const char* h = url + (ssl ? 8 : 7);
+    const char* path = strchr(h, '/');
+    size_t hl = path ? path - h : strlen(h);
+    char host[sizeof(_host)];
+    if(hl >= sizeof(host)) return false;
+    memcpy(host, h, hl);
+    host[hl] = '\0';
+    uint16_t port = ssl ? 443 : 80;
+    char* colon = strchr(host, ':');
+    if(colon) { port = atoi(colon + 1); *colon = '\0'; }
+    if(!_line) _line = (char*)ps_malloc(HLS_LINE_MAX + HLS_HEADER_READ);
+    if(!_line) return false;
+    _rest = (uint8_t*)_line + HLS_LINE_MAX;
+
+    // the last response was read to its end and the server did not say close: ask on the same connection
+    _reused = _sock && _state == DONE && !_close && _ssl == ssl && _port == port && !strcmp(_host, host) && _sock->connected();
+    if(!_reused) {
+        stop();
+        strcpy(_host, host);
+        _port = port;
+        _ssl = ssl;
+        if(!_connect(resolver)) return false;
+    }
+    if(!path) path = "/";
+    char rqh[strlen(path) + strlen(host) + 300];
+    int n = sprintf(rqh, "GET %s HTTP/1.1\r\nHost: %s", path, host);
+    if(port != (ssl ? 443 : 80)) n += sprintf(rqh + n, ":%u", port);
+    n += sprintf(rqh + n, "\r\nAccept: */*\r\nUser-Agent: VLC/3.0.21 LibVLC/3.0.21 AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+                          "Accept-Encoding: identity;q=1,*;q=0\r\nConnection: keep-alive\r\n");
+    if(from) n += sprintf(rqh + n, "Range: bytes=%lu-\r\n", (long unsigned int)from);
+    n += sprintf(rqh + n, "\r\n");
+
+    status = 0;
+    length = -1;
+    type[0] = '\0';
+    free(location);
+    location = NULL;
+    _close = false;
+    _http.begin(_line, HLS_LINE_MAX);
+    _restPos = _restLen = 0;
+    _state = WAITING;
+    _rxT = millis();
+    if(_sock->write((const uint8_t*)rqh, n) != (size_t)n) { stop(); return false; }
+    return true;
+}
+
+void HlsConn::_field() {
+    char* v = _http.value();
+    if(_http.field() == HttpParser::H_LOCATION) {
+        free(location);
+        location = _psdup(v);
+    }
+    else if(_http.field() == HttpParser::H_CONTENT_TYPE) {
+        size_t i = 0;
+        while(v[i] && v[i] != ';' && v[i] != ' ' && i < sizeof(type) - 1) { type[i] = tolower(v[i]); i++; }
+        type[i] = '\0';
+    }
+}
+
+int8_t HlsConn::poll() {
+    if(!_sock) return FAILED;
+    if(_state != WAITING) return _state;
+    while(true) {
+        if(_restPos == _restLen) {                     // read in blocks, what comes behind the header is body
+            int av = _sock->available();
+            if(av <= 0) break;
+            int r = _sock->read(_rest, min(av, HLS_HEADER_READ));
+            if(r <= 0) break;
+            _rxT = millis();
+            _restPos = 0;
+            _restLen = r;
+        }
+        uint32_t used;
+        int8_t   ev = _http.head((const char*)_rest + _restPos, _restLen - _restPos, used);
+        _restPos += used;
+        if(ev == HttpParser::FIELD) _field();
+        else if(ev == HttpParser::FAILED) return _state = FAILED;
+        else if(ev == HttpParser::END) {
+            status = _http.status();
+            length = _http.chunked() ? -1 : _http.length();
+            _close = _http.close();
+            _state = _http.done() ? DONE : BODY;       // 204, 304, content-length 0
+            return HEADER;
+        }
+    }
+    if(!_sock->connected()) return _state = FAILED;
+    return WAITING;
+}
+
+int32_t HlsConn::body(uint8_t* buf, uint32_t size) {
+    if(_state == DONE) return 0;
+    if(_state != BODY || !_sock) return -1;
+    size = _http.want(size);                           // never into the next response
+    uint32_t n = 0;
+    if(_restPos < _restLen) {
+        n = min(size, (uint32_t)(_restLen - _restPos));
+        memcpy(buf, _rest + _restPos, n);
+        _restPos += n;
+    }
+    if(n < size) {
+        int av = _sock->available();
+        if(av > 0) {
+            int r = _sock->read(buf + n, min(size - n, (uint32_t)av));
+            if(r < 0) return -1;
+            n += r;
+        }
+        else if(!n && !_sock->connected()) {
+            if(!_http.chunked() && _http.length() < 0) { _state = DONE; _close = true; return 0; }   // the body ends with the connection
+            return -1;
+        }
+    }
+    if(n) _rxT = millis();
+    n = _http.body(buf, n);
+    if(_http.failed()) return -1;
+    if(_http.done()) _state = DONE;
+    return n;
+}
+
+void HlsConn::stop() {
+    if(_sock) _sock->stop();
+    _sock = NULL;
+    _state = WAITING;
+    _reused = false;
+    free(location);
+    location = NULL;
+}
+
+/***********************************************************************************************************************
+ *  HlsClient, helpers
+ ***********************************************************************************************************************/
+void HlsClient::_free(hlsSeg_t* s) {
+    free(s->url);
+    free(s->title);
+    s->url = s->title = NULL;
+}
+
+void HlsClient::_setState(uint8_t state) {              // task side, unless Audio asked for something else meanwhile
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if(_ack == _gen && _state == RUNNING) _state = state;
+    xSemaphoreGive(_lock);
+}
+
+/***********************************************************************************************************************
+ *  HlsClient, task side
+ ***********************************************************************************************************************/
+void HlsClient::_reset(uint32_t gen) {
+    _pl.stop();
+    _seg.stop();
+    for(uint8_t i = _qTail; i != _qHead; i++) { free(_queue[i % HLS_QUEUE].url); free(_queue[i % HLS_QUEUE].title); }
+    _qHead = _qTail = 0;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    for(uint8_t i = 0; i < HLS_SEGMENTS; i++) _free(&_segs[i]);
+    _head = _tail = 0;
+    _sHead = _sTail = 0;
+    free(_plUrl);
+    _plUrl = _wantPl;
+    _wantPl = NULL;
+    char* first = _wantFirst;
+    _wantFirst = NULL;
+    free(_master);
+    _master = _wantMaster;
+    _wantMaster = NULL;
+    xSemaphoreGive(_lock);
+
+    uint32_t now = millis();
+    _plBusy = _plLoaded = _endlist = false;
+    _nextReload = now;
+    _targetMs = 10000;
+    _plRetry.setLimits(RECONNECT_MIN_MS, RECONNECT_MAX_MS, RECONNECT_GIVEUP_S * 1000UL);
+    _plRetry.cancel();
+    _segRetry.cancel();
+    _m3u8.forget();
+    _fetch = NULL;
+    _retrying = false;
+    _skip = 0;
+    _segments = _lost = _reloads = 0;
+    _plDead = _hasSeq = false;
+    for(uint8_t i = 0; i < _vars; i++) free(_varUrl[i]);
+    _vars = _var = 0;
+    _plMaster = _switched = false;
+    _lastSeq = UINT64_MAX;
+    _switches = 0;
+    _abr.begin(now);
+    if(_plUrl && first) {                               // fetched while the playlist is loaded again
+        _queue[_qHead++ % HLS_QUEUE] = { UINT64_MAX, 0, false, first, NULL };
+        _m3u8.remember(first);
+    }
+    else free(first);
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if(_gen == gen) _ack = gen;
+    xSemaphoreGive(_lock);
+}
+
+void HlsClient::_plFail(uint32_t now, const char* why) {
+    bool reused = _pl.reused();
+    _pl.stop();
+    _plBusy = false;
+    if(_plMaster) {                                     // once more on a new connection, then the stream plays on without
+        _plMaster = false;
+        if(!reused) { log_w("master playlist %s, no variants to switch to", why); free(_master); _master = NULL; }
+        return;
+    }
+    if(reused) { _nextReload = now; return; }         // the server had closed the idle connection
+    if(!_plRetry.active()) _plRetry.begin(now, esp_random());
+    if(!_plRetry.retry(now)) {
+        log_e("playlist %s, giving up after %u attempts", why, _plRetry.attempts());
+        _endlist = _plDead = true;                      // what is queued still plays
+        return;
+    }
+    _plRetry.attempt();
+    _nextReload = now + _plRetry.waitMs(now);
+    log_w("playlist %s, next attempt in %lu ms", why, (long unsigned int)_plRetry.waitMs(now));
+}
+
+void HlsClient::_playlist(uint32_t now) {
+    if(!_plBusy) {
+        _plMaster = _master && _plLoaded;              // read after the first media playlist, playback starts first
+        if(!_plMaster && (_endlist || (int32_t)(now - _nextReload) < 0)) return;
+        _plT0 = now;
+        _plLen = 0;
+        _m3u8.start();
+        if(!_pl.request(_plMaster ? _master : _plUrl, 0, _resolver)) { _plFail(now, "connect failed"); return; }
+        _plBusy = true;
+        return;
+    }
+    int8_t r = _pl.poll();
+    if(r == HlsConn::FAILED) { _plFail(now, "connection lost"); return; }
+    if(r == HlsConn::WAITING) {
+        if(_pl.idleMs(now) > HLS_TIMEOUT_MS) _plFail(now, "timeout");
+        return;
+    }
+    if(r == HlsConn::HEADER) {
+        uint16_t st = _pl.status;
+        if(st >= 300 && st < 400 && _pl.location) {
+            char*& url = _plMaster ? _master : _plUrl;
+            if(!M3u8::resolve(url, _pl.location, _url, HLS_URL_MAX)) { _plFail(now, "bad redirect"); return; }
+            log_i("playlist moved to %s", _url);
+            free(url);
+            url = _psdup(_url);
+            _pl.stop();
+            _plBusy = false;
+            _nextReload = now;
+            return;
+        }
+        if(st != 200) { char why[24]; sprintf(why, "status %u", st); _plFail(now, why); return; }
+    }
+    while(!_pl.complete()) {
+        if(_plLen >= HLS_PLAYLIST_MAX) { _pl.stop(); break; }   // cut off, parse what is there
+        char buf[512];
+        int32_t n = _pl.body((uint8_t*)buf, sizeof(buf));
+        if(n < 0) { _plFail(now, "connection lost"); return; }
+        if(n == 0) break;
+        _m3u8.feed(buf, n);
+        _plLen += n;
+    }
+    if(!_pl.complete() && _plLen < HLS_PLAYLIST_MAX) {
+        if(_pl.idleMs(now) > HLS_TIMEOUT_MS) _plFail(now, "timeout");
+        return;
+    }
+    _plBusy = false;
+    _plRetry.cancel();
+    _parse(now);
+}
+
+void HlsClient::_parse(uint32_t now) {
+    uint8_t type = _m3u8.finish();
+    if(_plMaster) {                                     // read for its variants, the media playlist goes on
+        _plMaster = false;
+        if(type == M3u8::MASTER && _variants(_master, _plUrl) >= 0) log_i("%u variants to switch between", _vars);
+        free(_master);
+        _master = NULL;
+        return;
+    }
+    _reloads++;
+    if(type == M3u8::NONE) { _plFail(now, "is no m3u8"); return; }
+    if(type == M3u8::MASTER) {                          // a master playlist after all: take its first variant
+        if(!M3u8::resolve(_plUrl, _m3u8.variant(0).uri, _url, HLS_URL_MAX)) { _plFail(now, "bad variant"); return; }
+        log_i("variant playlist %s", _url);
+        char* url = _psdup(_url);
+        if(url) _variants(_plUrl, url);                 // switched between as well
+        free(_plUrl);
+        _plUrl = url;
+        _nextReload = now;
+        return;
+    }
+    if(_m3u8.targetMs()) _targetMs = min(_m3u8.targetMs(), (uint32_t)60000);
+    if(_m3u8.cut()) log_d("playlist too long, the oldest %lu segments dropped", (long unsigned int)_m3u8.cut());
+
+    uint32_t restarts = _m3u8.restarts();
+    bool fresh = false;
+    if(_m3u8.diff()) {
+        if(_m3u8.restarts() != restarts) log_w("media sequence restarted at %llu", _m3u8.mediaSeq());
+        for(uint16_t i = 0; i < _m3u8.segments(); i++) if(_m3u8.segment(i).fresh && _offer(_m3u8.segment(i))) fresh = true;
+    }
+    _endlist = _m3u8.endlist();
+    _hasSeq = _m3u8.hasSeq();
+    _plLoaded = true;
+    _nextReload = _plT0 + (fresh ? _targetMs : _targetMs / 2);
+}
+
+bool HlsClient::_offer(const M3u8::segment_t& s) {
+    if((uint8_t)(_qHead - _qTail) >= HLS_QUEUE) return false; // next reload
+    if(!M3u8::resolve(_plUrl, s.uri, _url, HLS_URL_MAX)) return false;
+    hlsItem_t& q = _queue[_qHead % HLS_QUEUE];
+    q.seq = s.seq;
+    q.ms = min(s.ms, (uint32_t)UINT16_MAX);
+    q.disc = s.discontinuity || _switched;
+    q.url = _psdup(_url);
+    q.title = s.extinf ? _psdup(s.extinf) : NULL;
+    if(!q.url) { free(q.title); return false; }
+    _qHead++;
+    _switched = false;
+    uint64_t lost = _m3u8.take(s);
+    if(lost) {
+        log_w("%llu segments lost (%llu..%llu)", lost, s.seq - lost, s.seq - 1);
+        _lost += lost;
+    }
+    return true;
+}
+
+int8_t HlsClient::_variants(const char* base, const char* cur) {
+    // the variants of a master playlist with the codecs of the one played (cur), another codec would need another
+    // decoder; sorted by bandwidth, returns the index of cur, -1 = not among them (no switching)
+    for(uint8_t i = 0; i < _vars; i++) free(_varUrl[i]);
+    _vars = _var = 0;
+    int16_t ref = -1;
+    for(uint16_t i = 0; i < _m3u8.variants() && ref < 0; i++)
+        if(M3u8::resolve(base, _m3u8.variant(i).uri, _url, HLS_URL_MAX) && !strcmp(_url, cur)) ref = i;
+    if(ref < 0 || !_m3u8.variant(ref).bandwidth) return -1;
+    const char* codecs = _m3u8.variant(ref).codecs;
+    char* curUrl = NULL;
+    for(uint16_t i = 0; i < _m3u8.variants(); i++) {
+        const M3u8::variant_t& v = _m3u8.variant(i);
+        if(!v.bandwidth || strcmp(v.codecs, codecs) || !M3u8::resolve(base, v.uri, _url, HLS_URL_MAX)) continue;
+        char* u = _psdup(_url);
+        if(!u) continue;
+        if(i == ref) curUrl = u;
+        uint8_t k = _vars++;
+        for(; k && _bw[k - 1] > v.bandwidth; k--) { _bw[k] = _bw[k - 1]; _varUrl[k] = _varUrl[k - 1]; }
+        _bw[k] = v.bandwidth;
+        _varUrl[k] = u;
+    }
+    for(uint8_t i = 0; i < _vars; i++) if(_varUrl[i] == curUrl) { _var = i; return i; }
+    for(uint8_t i = 0; i < _vars; i++) free(_varUrl[i]);
+    _vars = 0;
+    return -1;
+}
+
+void HlsClient::_adapt(uint32_t now) {
+    // a segment is complete: the next one from another variant? Its media sequence numbers must match this one's
+    if(_vars < 2 || !_hasSeq || _lastSeq == UINT64_MAX) return;
+    uint8_t v = _abr.choose(_bw, _vars, _var, _audioMs + aheadMs(), _targetMs, now);
+    if(v == _var) return;
+    char* url = _psdup(_varUrl[v]);
+    if(!url) return;
+    log_i("variant %lu -> %lu bit/s, %lu bit/s measured", (long unsigned int)_bw[_var], (long unsigned int)_bw[v],
+          (long unsigned int)_abr.estimate());
+    for(uint8_t i = _qTail; i != _qHead; i++) { free(_queue[i % HLS_QUEUE].url); free(_queue[i % HLS_QUEUE].title); }
+    _qHead = _qTail = 0;                                // queued from the old variant
+    _m3u8.seek(_lastSeq + 1);
+    free(_plUrl);
+    _plUrl = url;
+    _var = v;
+    _switched = true;
+    _switches++;
+    if(_plBusy) { _pl.stop(); _plBusy = false; }        // a reload of the old variant, not needed any more
+    _nextReload = now;
+}
+
+bool HlsClient::_start(uint32_t now) {
+    if(_qHead == _qTail) {
+        if(_endlist) _setState(_plDead ? FAILED : ENDED);
+        return false;
+    }
+    if((uint8_t)(_sHead - _sTail) >= HLS_SEGMENTS) return false;
+    hlsItem_t& q = _queue[_qTail++ % HLS_QUEUE];
+    hlsSeg_t* s = &_segs[_sHead % HLS_SEGMENTS];
+    _lastSeq = q.seq;
+    _fetchFull = false;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    s->seq = q.seq;
+    s->start = _head;
+    s->got = s->len = 0;
+    s->ms = q.ms;
+    s->disc = q.disc;
+    s->sized = s->done = s->gone = false;
+    s->ts = strstr(q.url, ".ts") != NULL;
+    s->type[0] = '\0';
+    s->url = q.url;
+    s->title = q.title;
+    _sHead++;
+    xSemaphoreGive(_lock);
+    q.url = q.title = NULL;
+    _fetch = s;
+    _fetchT0 = now;
+    _redirects = 0;
+    _segRetry.setLimits(RECONNECT_MIN_MS, RECONNECT_MAX_MS, max(2UL * _targetMs, 10000UL));
+    _segRetry.cancel();
+    _retrying = false;
+    if(!_request()) _segFail(now, "connect failed");
+    return true;
+}
+
+bool HlsClient::_request() {
+    _skip = 0;
+    return _seg.request(_fetch->url, _fetch->got, _resolver);
+}
+
+void HlsClient::_segFail(uint32_t now, const char* why) {
+    log_d("segment %llu %s after %lu bytes", _fetch->seq, why, (long unsigned int)_fetch->got);
+    _seg.stop();
+    if(!_segRetry.active()) _segRetry.begin(now, esp_random());   // the first retry at once
+    else if(!_segRetry.retry(now)) {
+        log_e("segment %llu %s, skipped after %u attempts", _fetch->seq, why, _segRetry.attempts());
+        _finish(false);
+        return;
+    }
+    _retrying = true;
+}
+
+void HlsClient::_finish(bool ok) {
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if(!ok && !_fetch->got) _fetch->gone = true;         // skipped, unless Audio already started it (it gets padding)
+    if(!_fetch->sized) { _fetch->len = _fetch->got; _fetch->sized = true; }
+    if(_fetch->got > _fetch->len) _fetch->len = _fetch->got;
+    _fetch->done = true;
+    xSemaphoreGive(_lock);
+    if(ok) _segments++;
+    else _lost++;
+    _fetch = NULL;
+    _retrying = false;
+    _segRetry.cancel();
+    if(!ok) _seg.stop();                                // a complete response leaves the connection for the next one
+}
+
+uint32_t HlsClient::_segment(uint32_t now) {
+    if(!_fetch && !_start(now)) return 0;
+    if(!_fetch) return 0;
+    if(_retrying) {
+        if(!_segRetry.due(now)) return 0;
+        _retrying = false;
+        _segRetry.attempt();
+        if(!_request()) { _segFail(now, "connect failed"); return 0; }
+    }
+    int8_t r = _seg.poll();
+    if(r == HlsConn::FAILED) { _segFail(now, "connection lost"); return 0; }
+    if(r == HlsConn::WAITING) {
+        if(_seg.idleMs(now) > HLS_TIMEOUT_MS) _segFail(now, "timeout");
+        return 0;
+    }
+    if(r == HlsConn::HEADER) {
+        uint16_t st = _seg.status;
+        if(st >= 300 && st < 400 && _seg.location && _redirects < 4) {
+            _redirects++;
+            if(!M3u8::resolve(_fetch->url, _seg.location, _url, HLS_URL_MAX)) { _finish(false); return 0; }
+            char* u = _psdup(_url);
+            if(!u) { _finish(false); return 0; }
+            xSemaphoreTake(_lock, portMAX_DELAY);
+            free(_fetch->url);
+            _fetch->url = u;
+            xSemaphoreGive(_lock);
+            _seg.stop();
+            if(!_request()) _segFail(now, "connect failed");
+            return 0;
+        }
+        if(st == 404 || st == 410) {                    // rolled out of the server's window
+            log_w("segment %llu gone (%u)", _fetch->seq, st);
+            _finish(false);
+            return 0;
+        }
+        if(st != 200 && st != 206) { char why[24]; sprintf(why, "status %u", st); _segFail(now, why); return 0; }
+        if(st == 200 && _fetch->got) _skip = _fetch->got;   // no range support, drop what we have
+        if(!_fetch->sized) {
+            xSemaphoreTake(_lock, portMAX_DELAY);
+            const char* t = _seg.type;
+            if(!t[0] || !strcmp(t, "application/octet-stream") || !strcmp(t, "text/plain") || !strcmp(t, "binary/octet-stream"))
+                t = _fetch->ts ? "video/mp2t" : strstr(_fetch->url, ".mp3") ? "audio/mpeg" : "audio/aac";
+            strlcpy(_fetch->type, t, sizeof(_fetch->type));
+            if(st == 200 && _seg.length >= 0) { _fetch->len = _seg.length; _fetch->sized = true; }
+            xSemaphoreGive(_lock);
+        }
+    }
+
+    uint32_t moved = 0;
+    while(!_seg.complete()) {
+        if(_skip) {
+            uint8_t tmp[512];
+            int32_t k = _seg.body(tmp, min(_skip, (uint32_t)sizeof(tmp)));
+            if(k < 0) { _segFail(now, "connection lost"); return moved; }
+            if(k == 0) break;
+            _skip -= k;
+            continue;
+        }
+        uint32_t space = HLS_BUFFER_SIZE - (_head - _tail);
+        if(!space) { _fetchFull = true; break; }        // Audio is behind, the server waits
+        uint32_t off = _head & HLS_MASK;
+        uint32_t n = min(min(space, (uint32_t)HLS_BUFFER_SIZE - off), (uint32_t)16384);
+        if(_fetch->sized) {
+            if(_fetch->got >= _fetch->len) break;
+            n = min(n, _fetch->len - _fetch->got);
+        }
+        int32_t k = _seg.body(_ring + off, n);
+        if(k < 0) { _segFail(now, "connection lost"); return moved; }
+        if(k == 0) break;
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        _head += k;
+        _fetch->got += k;
+        xSemaphoreGive(_lock);
+        moved += k;
+    }
+    if(_seg.complete() || (_fetch->sized && _fetch->got >= _fetch->len)) {
+        if(!_seg.complete()) _seg.stop();               // more than announced, not reusable
+        log_d("segment %llu: %lu bytes in %lu ms", _fetch->seq, (long unsigned int)_fetch->got, (long unsigned int)(now - _fetchT0));
+        if(!_fetchFull) _abr.sample(_fetch->got, now - _fetchT0);
+        _finish(true);
+        _adapt(now);
+    }
+    else if(!moved && _head - _tail < HLS_BUFFER_SIZE && _seg.idleMs(now) > HLS_TIMEOUT_MS) _segFail(now, "stalled");
+    return moved;
+}
+
+void HlsClient::_hlsTask(void* param) {
+    HlsClient* h = static_cast<HlsClient*>(param);
+    uint32_t gen = 0;
+    while(true) {
+        if(gen != h->_gen) { gen = h->_gen; h->_reset(gen); }
+        uint32_t moved = 0;
+        if(h->_state == RUNNING && h->_ack == gen) {
+            uint32_t now = millis();
+            h->_playlist(now);
+            moved = h->_segment(now);
+        }
+        vTaskDelay(moved ? 1 : pdMS_TO_TICKS(10));
+    }
+}
+
+/***********************************************************************************************************************
+ *  HlsClient, Audio side
+ ***********************************************************************************************************************/
+bool HlsClient::begin(const char* playlist, const char* first, const char* master) {
+    if(!psramFound() || !playlist) return false;
+    if(!_lock) _lock = xSemaphoreCreateMutex();
+    if(!_ring) _ring = (uint8_t*)ps_malloc(HLS_BUFFER_SIZE);
+    if(!_arena) { _arena = (char*)ps_malloc(M3U8_ARENA_SIZE); _m3u8.begin(_arena, M3U8_ARENA_SIZE); }
+    if(!_url) _url = (char*)ps_malloc(HLS_URL_MAX);
+    if(!_lock || !_ring || !_arena || !_url) return false;
+    char* pl = _psdup(playlist);
+    if(!pl) return false;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    free(_wantPl);
+    free(_wantFirst);
+    free(_wantMaster);
+    _wantPl = pl;
+    _wantFirst = first ? _psdup(first) : NULL;
+    _wantMaster = master ? _psdup(master) : NULL;
+    _state = RUNNING;
+    _gen++;
+    xSemaphoreGive(_lock);
+    _cur = NULL;
+    _off = 0;
+    _hdrLen = _hdrPos = 0;
+    _waitT0 = millis();
+    _waits = 0;
+    if(!_task) xTaskCreate(_hlsTask, "hlsTask", 8192, this, 1, &_task);
+    return _task != NULL;
+}
+
+int8_t HlsClient::next() {
+    if(_ack != _gen) return 0;
+    int8_t r = 0;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if(_cur && !_cur->done) r = -2;                     // still coming in, Audio asked too early
+    else {
+        if(_cur) { _tail = _cur->start + _cur->got; _free(_cur); _sTail++; _cur = NULL; }
+        while(_sTail != _sHead && _segs[_sTail % HLS_SEGMENTS].gone) { _free(&_segs[_sTail % HLS_SEGMENTS]); _sTail++; }
+        if(_sTail != _sHead && _segs[_sTail % HLS_SEGMENTS].sized) {
+            _cur = &_segs[_sTail % HLS_SEGMENTS];
+            _off = 0;
+            _tail = _cur->start;
+            _hdrLen = snprintf(_hdr, sizeof(_hdr), "HTTP/1.1 200 OK\r\ncontent-type: %s\r\ncontent-length: %lu\r\n\r\n", _cur->type, (long unsigned int)_cur->len);
+            _hdrPos = 0;
+            r = 1;
+        }
+        else if(_sTail == _sHead && (_state == FAILED || _state == ENDED)) r = -1;
+    }
+    xSemaphoreGive(_lock);
+    if(r == -2) return 0;
+    if(r == 1) _waitT0 = 0;
+    else if(r == 0 && !_waitT0) { _waitT0 = millis(); _waits++; }
+    return r;
+}
+
+uint32_t HlsClient::aheadMs() {
+    uint32_t ms = 0;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    for(uint8_t i = _sTail; i != _sHead; i++) {
+        hlsSeg_t* s = &_segs[i % HLS_SEGMENTS];
+        if(s != _cur && s->done && !s->gone) ms += s->ms;
+    }
+    xSemaphoreGive(_lock);
+    return ms;
+}
+
+uint32_t HlsClient::_readable() {                       // under the lock
+    if(!_cur) return 0;
+    uint32_t n = _cur->got > _off ? _cur->got - _off : 0;
+    if(_cur->done && _cur->len > max(_off, _cur->got)) n += _cur->len - max(_off, _cur->got);   // padding
+    return n;
+}
+
+int HlsClient::available() {
+    if(_ack != _gen || !_cur) return 0;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    uint32_t n = _readable();
+    xSemaphoreGive(_lock);
+    return n + (_hdrLen - _hdrPos);
+}
+
+int HlsClient::read(uint8_t* buf, size_t size) {
+    if(_ack != _gen || !_cur) return 0;
+    size_t got = 0;
+    if(_hdrPos < _hdrLen) {
+        got = min(size, (size_t)(_hdrLen - _hdrPos));
+        memcpy(buf, _hdr + _hdrPos, got);
+        _hdrPos += got;
+    }
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    while(got < size && _off < _cur->got) {
+        uint32_t pos = (_cur->start + _off) & HLS_MASK;
+        uint32_t n = min(min((uint32_t)(size - got), _cur->got - _off), (uint32_t)HLS_BUFFER_SIZE - pos);
+        memcpy(buf + got, _ring + pos, n);
+        got += n;
+        _off += n;
+    }
+    _tail = _cur->start + min(_off, _cur->got);
+    if(got < size && _cur->done && _off >= _cur->got && _off < _cur->len) {
+        // the segment could not be completed: fill it up, with TS null packets (PID 0x1FFF) from the next packet on
+        uint32_t n = min((uint32_t)(size - got), _cur->len - _off);
+        for(uint32_t i = 0; i < n; i++) {
+            uint32_t p = (_off + i) % 188;
+            buf[got + i] = !_cur->ts ? 0 : p == 0 ? 0x47 : p == 1 ? 0x1F : p == 3 ? 0x10 : 0xFF;
+        }
+        got += n;
+        _off += n;
+    }
+    xSemaphoreGive(_lock);
+    return got;
+}
+
+int HlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int HlsClient::peek() {
+    if(_ack != _gen || !_cur) return -1;
+    if(_hdrPos < _hdrLen) return (uint8_t)_hdr[_hdrPos];
+    int c = -1;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if(_off < _cur->got) c = _ring[(_cur->start + _off) & HLS_MASK];
+    xSemaphoreGive(_lock);
+    return c;
+}
+
+uint8_t HlsClient::connected() {
+    if(_ack != _gen) return _state == RUNNING;
+    return _state == RUNNING || (_cur && available() > 0) || _sTail != _sHead;
+}
+
+void HlsClient::stop() {
+    if(!_lock) return;
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if(_state != IDLE || _ack != _gen) { _state = IDLE; _gen++; }
+    xSemaphoreGive(_lock);
+    _cur = NULL;
+    _hdrLen = _hdrPos = 0;
+}
+
+#endif // #if (I2S_DOUT!=255 || I2S_INTERNAL) && HLS_BUFFER_SIZE>0
@@ -0,0 +1,203 @@
+// HLS segment engine, used by Audio for m3u8 streams when HLS_BUFFER_SIZE is set (PSRAM only).
+//
+// A low priority task keeps two keep-alive connections, one for the media playlist and one for the segments.
+// The playlist is reloaded on its own schedule (#EXT-X-TARGETDURATION after a change, half of it when nothing
+// new came, RFC 8216 6.3.4), M3u8::diff() finds the new segments so nothing is fetched twice and lost ones are
+// counted. Segments are downloaded back to back into a PSRAM ring: while Audio plays segment N, N+1 (and more,
+// as far as the ring goes) is already there.
+//
+// Audio reads it as a WiFiClient: next() presents the following segment as a plain HTTP response (status,
+// content-type, content-length, body), so the header parser and the TS/AAC readers work on it as on a
+// segment fetched the old way. A segment that can't be completed is padded up to its announced length
+// (TS null packets), the reader's framing stays intact.
+//
+// Given the master playlist the stream was picked from, its variants with the same codecs are read once and
+// Abr switches between them by the measured throughput (abr.h). A switch happens between two segments: the
+// queue of the old variant is dropped, the new one goes on at the next media sequence number and its first
+// segment is marked as a discontinuity (other PIDs and counters in TS), the decoder plays on.
+
+#pragma once
+#include "../../core/options.h"
+
+#if (I2S_DOUT!=255 || I2S_INTERNAL) && HLS_BUFFER_SIZE>0
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+#include "reconnect.h"
+#include "m3u8.h"
+#include "abr.h"
+#include "httpparser.h"
+
+#define HLS_QUEUE        16      // segment URLs taken from the playlist, not fetched yet
+#define HLS_SEGMENTS     8       // segments in the ring
+#define HLS_PLAYLIST_MAX 524288  // bytes read of a playlist, the rest of a longer one is cut off
+#define HLS_LINE_MAX     512     // response header line
+#define HLS_HEADER_READ  512     // response header bytes read at once, what came behind it waits for body()
+#define HLS_TIMEOUT_MS   5000    // no progress on a request for this long fails it
+
+typedef uint8_t (*hlsResolver_t)(const char* host, uint32_t* ips, uint8_t max, bool wait);
+
+class HlsConn {                  // one keep-alive connection, non-blocking HTTP/1.1 response reader
+  public:
+    enum : int8_t { FAILED = -1, WAITING = 0, HEADER = 1, BODY = 2, DONE = 3 };
+
+    bool     request(const char* url, uint32_t from, hlsResolver_t resolver); // GET, from > 0 asks for a byte range
+    int8_t   poll();                                 // reads the header, HEADER once it is complete
+    int32_t  body(uint8_t* buf, uint32_t size);      // de-chunked body bytes, -1 failed
+    bool     complete() { return _state == DONE; }
+    bool     reused() { return _reused; }
+    void     stop();
+    uint32_t idleMs(uint32_t now) { return (int32_t)(now - _rxT) > 0 ? now - _rxT : 0; }  // now may be older than the request
+
+    uint16_t status = 0;
+    int32_t  length = -1;                            // content-length, -1 unknown (chunked or until close)
+    char     type[32] = {0};                         // content-type
+    char*    location = NULL;                        // of a redirect
+
+  private:
+    WiFiClient   _plain;
+    WiFiClientSecure _secure;
+    WiFiClient*  _sock = NULL;
+    char         _host[64] = {0};
+    uint16_t     _port = 0;
+    bool         _ssl = false, _close = false, _reused = false;
+    int8_t       _state = WAITING;
+    HttpParser   _http;
+    char*        _line = NULL;                       // HLS_LINE_MAX + HLS_HEADER_READ, PSRAM
+    uint8_t*     _rest = NULL;                       // the header bytes read, behind the line
+    uint16_t     _restPos = 0, _restLen = 0;
+    uint32_t     _rxT = 0;
+
+    bool    _connect(hlsResolver_t resolver);
+    void    _field();
+};
+
+class HlsClient : public WiFiClient {
+  public:
+    enum : uint8_t { IDLE = 0, RUNNING, FAILED, ENDED };
+
+    HlsClient() {};
+    bool     begin(const char* playlist, const char* first, const char* master = NULL);  // first = segment Audio picked
+                                                              // from the playlist, fetched at once; master = the master
+                                                              // playlist it was picked from, NULL = no switching
+    int8_t   next();                                          // 1 = next segment presented, 0 = not yet, -1 = failed or ended
+    bool     ended() { return _state == ENDED; }
+    void     setResolver(hlsResolver_t resolver) { _resolver = resolver; }
+
+    const char* url() { return _cur ? _cur->url : ""; }       // of the presented segment
+    const char* title() { return _cur && _cur->title ? _cur->title : NULL; } // its #EXTINF line
+    uint64_t sequence() { return _cur ? _cur->seq : 0; }
+    bool     discontinuity() { return _cur && _cur->disc; }   // #EXT-X-DISCONTINUITY in front of the presented segment
+    uint32_t aheadMs();                                       // complete segments waiting behind the presented one
+    uint32_t segments() { return _segments; }
+    uint32_t lost() { return _lost; }
+    uint32_t reloads() { return _reloads; }
+    uint32_t waits() { return _waits; }                       // next() had to wait for a segment
+    void     buffered(uint32_t ms) { _audioMs = ms; }         // Audio's input buffer, what plays before the presented segment
+    uint32_t switches() { return _switches; }                 // between variants
+    uint32_t throughput() { return _abr.estimate(); }         // bit/s, 0 = not measured yet
+
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    uint8_t connected() override;
+    void stop() override;
+    size_t write(uint8_t data) override { return 0; }
+    size_t write(const uint8_t* buf, size_t size) override { return 0; }
+
+  private:
+    struct hlsItem_t {                                        // queued, task only
+        uint64_t seq;
+        uint16_t ms;                                          // #EXTINF duration
+        bool     disc;                                        // #EXT-X-DISCONTINUITY in front of it
+        char*    url;
+        char*    title;
+    };
+    struct hlsSeg_t {                                         // in the ring
+        uint64_t seq;
+        uint32_t start;                                       // ring position
+        uint32_t got;                                         // bytes in the ring
+        uint32_t len;                                         // announced length, valid once sized
+        uint16_t ms;
+        bool     disc;
+        bool     sized, done, gone;                           // gone = not on the server any more, skipped
+        bool     ts;
+        char     type[24];
+        char*    url;
+        char*    title;
+    };
+
+    TaskHandle_t      _task = NULL;
+    SemaphoreHandle_t _lock = NULL;
+    hlsResolver_t     _resolver = NULL;
+    volatile uint32_t _gen = 0, _ack = 0;                      // begin()/stop() count up, the task acknowledges after its reset
+    volatile uint8_t  _state = IDLE;
+    char*             _wantPl = NULL;                          // handed over by begin()
+    char*             _wantFirst = NULL;
+    char*             _wantMaster = NULL;
+
+    // ring, written by the task, read by Audio (positions and segments under _lock)
+    uint8_t*          _ring = NULL;                            // HLS_BUFFER_SIZE
+    volatile uint32_t _head = 0, _tail = 0;                    // absolute positions
+    hlsSeg_t          _segs[HLS_SEGMENTS] = {};
+    uint8_t           _sHead = 0, _sTail = 0;
+
+    // Audio side
+    hlsSeg_t*         _cur = NULL;                             // presented segment
+    uint32_t          _off = 0;                                // read position in it
+    char              _hdr[96];
+    uint8_t           _hdrLen = 0, _hdrPos = 0;
+    uint32_t          _waitT0 = 0;
+    uint32_t          _waits = 0;
+    volatile uint32_t _audioMs = 0;
+
+    // task side
+    HlsConn           _pl, _seg;
+    char*             _plUrl = NULL;
+    char*             _arena = NULL;                           // M3U8_ARENA_SIZE
+    M3u8              _m3u8;
+    char*             _url = NULL;                             // scratch for resolved URLs
+    uint32_t          _plLen = 0;
+    bool              _plBusy = false, _plLoaded = false, _endlist = false, _plDead = false, _hasSeq = false;
+    uint32_t          _plT0 = 0, _nextReload = 0;
+    uint16_t          _targetMs = 10000;
+    Reconnect         _plRetry, _segRetry;
+    hlsItem_t         _queue[HLS_QUEUE] = {};
+    uint8_t           _qHead = 0, _qTail = 0;
+    hlsSeg_t*         _fetch = NULL;                           // segment being downloaded
+    bool              _retrying = false;
+    uint32_t          _fetchT0 = 0;
+    uint32_t          _skip = 0;                               // bytes to drop of a retried segment the server sent whole
+    uint8_t           _redirects = 0;
+    uint32_t          _segments = 0, _lost = 0, _reloads = 0;
+    char*             _master = NULL;                          // read once for its variants, then freed
+    bool              _plMaster = false;                       // the playlist request is for it
+    uint32_t          _bw[M3U8_VARIANTS];                      // the variants with the codecs played, by bandwidth
+    char*             _varUrl[M3U8_VARIANTS] = {};
+    uint8_t           _vars = 0, _var = 0;                     // how many, the one played
+    Abr               _abr;
+    bool              _switched = false;                       // the next segment queued begins another variant
+    bool              _fetchFull = false;                      // the ring was full during the download, no sample
+    uint64_t          _lastSeq = UINT64_MAX;                   // of the segment started last
+    uint32_t          _switches = 0;
+
+    static void _hlsTask(void* param);
+    void     _reset(uint32_t gen);
+    void     _setState(uint8_t state);
+    void     _playlist(uint32_t now);
+    void     _plFail(uint32_t now, const char* why);
+    void     _parse(uint32_t now);
+    bool     _offer(const M3u8::segment_t& s);
+    int8_t   _variants(const char* base, const char* cur);
+    void     _adapt(uint32_t now);
+    uint32_t _segment(uint32_t now);
+    bool     _start(uint32_t now);
+    bool     _request();
+    void     _segFail(uint32_t now, const char* why);
+    void     _finish(bool ok);
+    void     _free(hlsSeg_t* s);
+    uint32_t _readable();
+};
+
+#endif // #if (I2S_DOUT!=255 || I2S_INTERNAL) && HLS_BUFFER_SIZE>0
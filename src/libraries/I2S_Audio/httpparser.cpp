@@ -0,0 +1,225 @@
+#include "httpparser.h"
+#include <string.h>
+#include <strings.h>
+
+void HttpParser::begin(char* line, uint16_t size) {
+    _line = line;
+    _size = size;
+    _pos = _val = 0;
+    _state = line && size > 1 ? ST_LINE : ST_FAILED;
+    if(_state == ST_LINE) _line[0] = '\0';
+    _field = H_OTHER;
+    _status = 0;
+    _chunked = _close = _hex = false;
+    _length = -1;
+    _left = _received = 0;
+}
+
+int8_t HttpParser::head(const char* data, uint32_t len, uint32_t& used) {
+    used = 0;
+    if(_state == ST_FAILED) return FAILED;
+    if(_state != ST_LINE && _state != ST_HEADERS) return MORE;     // the header is through, the rest is body
+    while(used < len) {
+        const char* p = data + used;
+        const char* nl = (const char*)memchr(p, '\n', len - used);
+        uint32_t    n = nl ? nl - p : len - used;
+        for(uint32_t i = 0; i < n; i++) {
+            char c = p[i];
+            if((uint8_t)c < 0x20 && c != '\t') continue;           // '\r' and other control characters
+            if(_pos < _size - 1) _line[_pos++] = c;                 // a longer line is cut
+        }
+        used += n;
+        if(!nl) return MORE;                                        // the rest of the line has not arrived yet
+        used++;
+        _line[_pos] = '\0';
+        int8_t ev = _state == ST_LINE ? _statusLine() : _headerLine();
+        _pos = 0;
+        if(ev != MORE) return ev;
+    }
+    return MORE;
+}
+
+int8_t HttpParser::_statusLine() {
+    // HTTP/1.1 200 OK, ICY 200 OK (SHOUTcast v1); empty lines in front of it are skipped
+    if(!_pos) return MORE;
+    const char* p = _line;
+    if(!strncasecmp(p, "HTTP/", 5)) {
+        _close = !strncmp(p + 5, "1.0", 3);                         // 1.0 closes unless it says keep-alive
+        p += 5;
+    }
+    else if(!strncasecmp(p, "ICY", 3)) { _close = true; p += 3; }
+    else { _state = ST_FAILED; return FAILED; }
+    while(*p && *p != ' ') p++;
+    while(*p == ' ') p++;
+    if(p[0] < '1' || p[0] > '5' || p[1] < '0' || p[1] > '9' || p[2] < '0' || p[2] > '9' || (p[3] && p[3] != ' ')) {
+        _state = ST_FAILED;
+        return FAILED;
+    }
+    _status = (p[0] - '0') * 100 + (p[1] - '0') * 10 + (p[2] - '0');
+    _field = H_OTHER;
+    _val = p - _line;
+    _state = ST_HEADERS;
+    return STATUS;
+}
+
+int8_t HttpParser::_headerLine() {
+    if(!_pos) return _end();
+    if(_line[0] == ' ' || _line[0] == '\t') return MORE;           // obsolete line folding, dropped
+    char* colon = (char*)memchr(_line, ':', _pos);
+    if(!colon) return MORE;
+    char* e = colon;
+    while(e > _line && (e[-1] == ' ' || e[-1] == '\t')) e--;
+    for(char* c = _line; c < e; c++) if(*c >= 'A' && *c <= 'Z') *c += 'a' - 'A';
+    *e = '\0';
+    char* v = colon + 1;
+    while(*v == ' ' || *v == '\t') v++;
+    char* t = _line + _pos;
+    while(t > v && (t[-1] == ' ' || t[-1] == '\t')) t--;
+    *t = '\0';
+    _val = v - _line;
+    _field = _known(_line, e - _line);
+    switch(_field) {
+        case H_CONTENT_LENGTH: {
+            uint32_t n = 0;
+            const char* d = v;
+            while(*d >= '0' && *d <= '9' && n <= 0x7FFFFFFF / 10 - 1) n = n * 10 + (*d++ - '0');
+            if(d > v && !*d) _length = n;                           // anything else is ignored
+            break;
+        }
+        case H_TRANSFER_ENCODING: if(_token(v, "chunked")) _chunked = true; break;
+        case H_CONNECTION:
+            if(_token(v, "close")) _close = true;
+            else if(_token(v, "keep-alive")) _close = false;
+            break;
+    }
+    return FIELD;
+}
+
+int8_t HttpParser::_end() {
+    if(_status >= 100 && _status < 200) {                          // 100 Continue and the like, the response follows
+        begin(_line, _size);
+        return MORE;
+    }
+    _field = H_OTHER;
+    _val = 0;                                                      // the empty line
+    if(_status == 204 || _status == 304) { _chunked = false; _length = 0; }
+    _body();
+    return END;
+}
+
+void HttpParser::framing(bool chunked, int32_t length) {
+    _chunked = chunked;
+    _length = length;
+    _left = _received = 0;
+    _body();
+}
+
+void HttpParser::_body() {
+    _hex = false;
+    _pos = 0;
+    _left = 0;
+    if(_chunked) { _length = -1; _state = CH_SIZE; }                // transfer-encoding wins over content-length
+    else if(_length >= 0) { _left = _length; _state = _left ? ST_LENGTH : ST_DONE; }
+    else { _close = true; _state = ST_EOF; }                       // the body ends with the connection
+}
+
+uint32_t HttpParser::want(uint32_t size) {
+    if(_state == ST_LENGTH) return size < _left ? size : _left;
+    if(_state == ST_DONE || _state == ST_FAILED) return 0;
+    return size;
+}
+
+uint32_t HttpParser::body(uint8_t* buf, uint32_t len) {
+    // chunked: <hex size>[;extension]CRLF <data> CRLF ... 0 CRLF [trailer lines] CRLF
+    if(_state == ST_EOF) { _received += len; return len; }
+    if(_state == ST_LENGTH) {
+        uint32_t n = len < _left ? len : _left;                     // the rest would be another response
+        _left -= n;
+        _received += n;
+        if(!_left) _state = ST_DONE;
+        return n;
+    }
+    uint32_t out = 0, i = 0;
+    while(i < len) {
+        if(_state == CH_DATA) {                                     // the payload is moved over the framing in front of it
+            uint32_t n = len - i < _left ? len - i : _left;
+            if(out != i) memmove(buf + out, buf + i, n);
+            out += n;
+            i += n;
+            _left -= n;
+            if(!_left) _state = CH_CR;
+            continue;
+        }
+        if(_state < CH_SIZE || _state > CH_TRAILER) break;          // done or failed, the rest is dropped
+        uint8_t c = buf[i++];
+        switch(_state) {
+            case CH_SIZE: {
+                int8_t d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+                if(d >= 0) {
+                    if(_left > 0x0FFFFFFF) { _state = ST_FAILED; break; }
+                    _left = _left << 4 | d;
+                    _hex = true;
+                }
+                else if(c == '\n') {
+                    if(!_hex) break;                                // an empty line where the size belongs, tolerated
+                    _hex = false;
+                    _state = _left ? CH_DATA : CH_TRAILER;
+                }
+                else if(c == '\r' || (!_hex && (c == ' ' || c == '\t'))) ;
+                else if(_hex && (c == ';' || c == ' ' || c == '\t')) _state = CH_EXT;
+                else _state = ST_FAILED;
+                break;
+            }
+            case CH_EXT:
+                if(c == '\n') { _hex = false; _state = _left ? CH_DATA : CH_TRAILER; }
+                break;
+            case CH_CR:                                             // behind the data
+                if(c == '\r') _state = CH_LF;
+                else if(c == '\n') _state = CH_SIZE;
+                else _state = ST_FAILED;
+                break;
+            case CH_LF: _state = c == '\n' ? CH_SIZE : ST_FAILED; break;
+            case CH_TRAILER:                                        // ends with an empty line
+                if(c == '\n') {
+                    if(!_pos) _state = ST_DONE;
+                    _pos = 0;
+                }
+                else if(c != '\r') _pos = 1;
+                break;
+        }
+    }
+    _received += out;
+    return out;
+}
+
+uint8_t HttpParser::_known(const char* name, uint16_t len) {
+    static const struct { const char* name; uint8_t id; } fields[] = {
+        {"content-type", H_CONTENT_TYPE},           {"content-length", H_CONTENT_LENGTH},
+        {"transfer-encoding", H_TRANSFER_ENCODING}, {"content-encoding", H_CONTENT_ENCODING},
+        {"content-disposition", H_CONTENT_DISPOSITION}, {"content-range", H_CONTENT_RANGE},
+        {"accept-ranges", H_ACCEPT_RANGES},         {"location", H_LOCATION},
+        {"connection", H_CONNECTION},               {"www-authenticate", H_WWW_AUTHENTICATE},
+        {"icy-metaint", H_ICY_METAINT},             {"icy-name", H_ICY_NAME},
+        {"icy-description", H_ICY_DESCRIPTION},     {"icy-genre", H_ICY_GENRE},
+        {"icy-url", H_ICY_URL},                     {"icy-logo", H_ICY_LOGO},
+        {"icy-br", H_ICY_BR},
+    };
+    for(const auto& f : fields) if(strlen(f.name) == len && !memcmp(f.name, name, len)) return f.id;
+    return H_OTHER;
+}
+
+bool HttpParser::_token(const char* value, const char* token) {
+    // one of the comma separated items, case insensitive: "gzip, chunked"
+    size_t n = strlen(token);
+    for(const char* p = value; *p;) {
+        while(*p == ' ' || *p == '\t' || *p == ',') p++;
+        const char* e = p;
+        while(*e && *e != ',' && *e != ';') e++;
+        const char* t = e;
+        while(t > p && (t[-1] == ' ' || t[-1] == '\t')) t--;
+        if((size_t)(t - p) == n && !strncasecmp(p, token, n)) return true;
+        while(*e && *e != ',') e++;
+        p = e;
+    }
+    return false;
+}
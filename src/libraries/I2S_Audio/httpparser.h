@@ -0,0 +1,59 @@
+// Incremental HTTP/1.1 response parser, used by Audio, the VS1053 library, the HLS segment engine and netserver.
+// Plain C++ without Arduino dependencies, so it can be fed responses split at any byte on the host.
+//
+// head() takes whatever bytes of the header have arrived and stops behind each complete line: STATUS, FIELD (the
+// name lowercased, known names as field(), the value trimmed) and END after the empty line. Lines are assembled in
+// the buffer given to begin(), a line longer than it is cut. The bytes after END are the start of the body.
+// body() then works on the body bytes as they were read: with chunked transfer it takes the framing out in place
+// (size lines, extensions, CRLF, trailer) and returns the payload left at the front of the buffer, wherever the
+// chunk boundaries fall; with a content-length it counts down to done(). Whatever sits on top of the payload (ICY
+// metadata, TS packets, playlist lines) never sees the framing.
+
+#pragma once
+#include <stdint.h>
+
+class HttpParser {
+  public:
+    enum : int8_t { FAILED = -1, MORE = 0, STATUS, FIELD, END };           // head()
+    enum : uint8_t {                                                        // field()
+        H_OTHER = 0, H_CONTENT_TYPE, H_CONTENT_LENGTH, H_TRANSFER_ENCODING, H_CONTENT_ENCODING, H_CONTENT_DISPOSITION,
+        H_CONTENT_RANGE, H_ACCEPT_RANGES, H_LOCATION, H_CONNECTION, H_WWW_AUTHENTICATE, H_ICY_METAINT, H_ICY_NAME,
+        H_ICY_DESCRIPTION, H_ICY_GENRE, H_ICY_URL, H_ICY_LOGO, H_ICY_BR
+    };
+
+    void     begin(char* line, uint16_t size);      // a new response, its header lines are assembled in line
+    int8_t   head(const char* data, uint32_t len, uint32_t& used);
+    void     framing(bool chunked, int32_t length); // no head(), the header was read by someone else (HTTPClient)
+    uint32_t want(uint32_t size);                   // at most this many of size bytes belong to the body
+    uint32_t body(uint8_t* buf, uint32_t len);
+
+    uint16_t    status() { return _status; }
+    uint8_t     field() { return _field; }
+    const char* line() { return _line; }            // the status line or the field name, '\0' terminated
+    char*       value() { return _line + _val; }    // of the field, in the buffer given to begin()
+    bool        chunked() { return _chunked; }
+    int32_t     length() { return _length; }        // content-length, -1 if there is none
+    bool        close() { return _close; }          // the connection ends with this response
+    uint32_t    left() { return _left; }            // of the content-length or of the current chunk
+    uint32_t    received() { return _received; }    // payload bytes so far
+    bool        done() { return _state == ST_DONE; }
+    bool        failed() { return _state == ST_FAILED; }
+
+  private:
+    enum : uint8_t { ST_LINE, ST_HEADERS, ST_EOF, ST_LENGTH, CH_SIZE, CH_EXT, CH_DATA, CH_CR, CH_LF, CH_TRAILER, ST_DONE, ST_FAILED };
+
+    char*       _line = nullptr;
+    uint16_t    _size = 0, _pos = 0, _val = 0;                // _pos: the line so far, in a trailer whether it has text
+    uint8_t     _state = ST_FAILED, _field = H_OTHER;
+    uint16_t    _status = 0;
+    bool        _chunked = false, _close = false, _hex = false;     // _hex: a digit of the chunk size came
+    int32_t     _length = -1;
+    uint32_t    _left = 0, _received = 0;
+
+    int8_t _statusLine();
+    int8_t _headerLine();
+    int8_t _end();
+    void   _body();
+    static uint8_t _known(const char* name, uint16_t len);
+    static bool    _token(const char* value, const char* token);
+};
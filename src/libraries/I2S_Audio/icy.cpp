@@ -0,0 +1,177 @@
+#include "icy.h"
+#include <string.h>
+#include <strings.h>
+#include <stddef.h>
+
+void Icy::reset() {
+    _title = _artist = _url = _adMs = {};
+    _titleHash = _urlHash = 0;
+}
+
+uint8_t Icy::parse(const char* block, uint16_t len) {
+    // StreamTitle='Oliver Frank - Mega Hitmix';StreamUrl='www.radio-welle-woerthersee.at';
+    // adw_ad='true';durationMilliseconds='10135';adId='34254';insertionType='preroll';
+    const char* nul = (const char*)memchr(block, '\0', len);   // the padding, anything behind it is garbage
+    const char* end = nul ? nul : block + len;
+    const char* p = block;
+    slice_t key, val, title = {}, url = {};
+    bool    hasTitle = false, ad = false;
+    uint8_t news = 0;
+    _title = _artist = _url = _adMs = {};                   // slices of this block only
+    while(_value(p, end, key, val)) {
+        if(_is(key, "StreamTitle")) { title = val; hasTitle = true; }
+        else if(_is(key, "StreamUrl")) url = val;
+        else if(_is(key, "adw_ad")) ad = true;
+        else if(_is(key, "durationMilliseconds")) _adMs = val;
+    }
+    if(!hasTitle) {                                         // ID3 title of a HLS segment (showID3Tag)
+        const char* q = block;
+        while(q < end && *q == ' ') q++;
+        if(end - q >= 6 && !memcmp(q, "Title:", 6)) { title = {q + 6, (uint16_t)(end - q - 6)}; hasTitle = true; }
+    }
+    if(hasTitle && (_find(title, "<?xml").p || _find(title, "xml version=").p)) {
+        // <?xml version="1.0" encoding="utf-8"?><RadioInfo><Table>...<DB_DALET_TITLE_NAME>BOYFRIEND</DB_DALET_TITLE_NAME>
+        // ...<DB_LEAD_ARTIST_NAME>Dove Cameron</DB_LEAD_ARTIST_NAME>...</Table></RadioInfo>
+        _artist = _tag(title, "<DB_LEAD_ARTIST_NAME>", "</DB_LEAD_ARTIST_NAME>");
+        title = _tag(title, "<DB_DALET_TITLE_NAME>", "</DB_DALET_TITLE_NAME>");
+        hasTitle = title.p != NULL;
+    }
+    if(hasTitle) {
+        slice_t spot = _find(title, "song_spot=");           // Artist - text="Title" song_spot="M" MediaBaseId="0" ...
+        if(spot.p) title.len = spot.p - title.p;
+        _trim(title);
+        _trim(_artist);
+        uint32_t h = _hash(_hash(2166136261u, title) ^ 0x1f, _artist);
+        if(!h) h = 1;
+        if(h != _titleHash) { _titleHash = h; news |= TITLE; }
+        _title = title;
+    }
+    _trim(url);
+    if(url.len) {
+        uint32_t h = _hash(2166136261u, url);
+        if(!h) h = 1;
+        if(h != _urlHash) { _urlHash = h; news |= URL; }
+        _url = url;
+    }
+    if(ad && _adMs.len) news |= AD;
+    return news;
+}
+
+uint16_t Icy::title(char* out, uint16_t size) {
+    if(!size) return 0;
+    uint16_t n = 0;
+    if(_copy(_title, !validUtf8(_title.p, _title.len), out, n, size) && _artist.len && _copy({" - ", 3}, false, out, n, size))
+        _copy(_artist, !validUtf8(_artist.p, _artist.len), out, n, size);  // behind a cut title would be no artist
+    out[n] = '\0';
+    return n;
+}
+
+bool Icy::validUtf8(const char* s, uint16_t len) {
+    // not every Latin-1 string is valid UTF-8, so whatever passes this is taken for UTF-8
+    const uint8_t* p = (const uint8_t*)s;
+    const uint8_t* end = p + len;
+    while(p < end) {
+        uint8_t c = *p++;
+        if(c < 0x80) continue;
+        uint8_t n, lo = 0x80, hi = 0xBF;                     // continuation bytes, the first one may be narrower
+        if(c >= 0xC2 && c <= 0xDF) n = 1;
+        else if(c >= 0xE0 && c <= 0xEF) { n = 2; if(c == 0xE0) lo = 0xA0; if(c == 0xED) hi = 0x9F; }
+        else if(c >= 0xF0 && c <= 0xF4) { n = 3; if(c == 0xF0) lo = 0x90; if(c == 0xF4) hi = 0x8F; }
+        else return false;                                  // a continuation byte, an overlong or out of range lead
+        if(end - p < n) return false;
+        if(*p < lo || *p > hi) return false;
+        p++;
+        for(uint8_t i = 1; i < n; i++, p++) if(*p < 0x80 || *p > 0xBF) return false;
+    }
+    return true;
+}
+
+bool Icy::_value(const char*& p, const char* end, slice_t& key, slice_t& val) {
+    // the next key=value pair from p on, false at the end; a quoted value ends at its quote followed by ';', a cut
+    // off one at the end of the block, an unquoted one at ';'
+    while(p < end && (*p == ';' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    if(p >= end) return false;
+    const char* eq = (const char*)memchr(p, '=', end - p);
+    if(!eq) { p = end; return false; }
+    key = {p, (uint16_t)(eq - p)};
+    _trim(key);
+    p = eq + 1;
+    if(p < end && (*p == '\'' || *p == '"')) {
+        char        q = *p++;
+        const char* e = NULL;
+        for(const char* s = p; s + 1 < end && (s = (const char*)memchr(s, q, end - 1 - s)); s++) if(s[1] == ';') { e = s; break; }
+        if(e) { val = {p, (uint16_t)(e - p)}; p = e + 2; return true; }
+        const char* t = end;
+        while(t > p && (t[-1] == ' ' || t[-1] == '\r' || t[-1] == '\n')) t--;
+        if(t > p && t[-1] == q) t--;
+        val = {p, (uint16_t)(t - p)};
+        p = end;
+        return true;
+    }
+    const char* e = (const char*)memchr(p, ';', end - p);
+    if(!e) e = end;
+    val = {p, (uint16_t)(e - p)};
+    p = e;
+    return true;
+}
+
+bool Icy::_is(const slice_t& s, const char* key) {
+    size_t n = strlen(key);
+    return s.len == n && !strncasecmp(s.p, key, n);
+}
+
+Icy::slice_t Icy::_find(const slice_t& s, const char* what) {
+    size_t      n = strlen(what);
+    const char* end = s.p + s.len;
+    for(const char* c = s.p; end - c >= (ptrdiff_t)n && (c = (const char*)memchr(c, what[0], end - c + 1 - n)); c++)
+        if(!memcmp(c, what, n)) return {c, (uint16_t)(end - c)};
+    return {NULL, 0};
+}
+
+Icy::slice_t Icy::_tag(const slice_t& s, const char* open, const char* close) {
+    slice_t a = _find(s, open);
+    if(!a.p) return {NULL, 0};
+    size_t  n = strlen(open);
+    slice_t in = {a.p + n, (uint16_t)(a.len - n)};
+    slice_t b = _find(in, close);
+    if(!b.p) return {NULL, 0};
+    return {in.p, (uint16_t)(b.p - in.p)};
+}
+
+void Icy::_trim(slice_t& s) {
+    while(s.len && (*s.p == ' ' || *s.p == '\t' || *s.p == '\r' || *s.p == '\n')) { s.p++; s.len--; }
+    while(s.len && (s.p[s.len - 1] == ' ' || s.p[s.len - 1] == '\t' || s.p[s.len - 1] == '\r' || s.p[s.len - 1] == '\n')) s.len--;
+}
+
+uint32_t Icy::_hash(uint32_t h, const slice_t& s) {         // FNV-1a
+    for(uint16_t i = 0; i < s.len; i++) { h ^= (uint8_t)s.p[i]; h *= 16777619u; }
+    return h;
+}
+
+bool Icy::_copy(const slice_t& s, bool latin, char* out, uint16_t& n, uint16_t size) {
+    // appends s to out[n], control characters become blanks; a UTF-8 sequence that does not fit is left out whole.
+    // false if s was cut
+    for(uint16_t i = 0; i < s.len;) {
+        uint8_t c = s.p[i];
+        if(c < 0x20) c = ' ';
+        if(c < 0x80) {
+            if(n + 1 >= size) return false;
+            out[n++] = c;
+            i++;
+        }
+        else if(latin) {
+            if(n + 2 >= size) return false;
+            out[n++] = 0xC0 | c >> 6;
+            out[n++] = 0x80 | (c & 0x3F);
+            i++;
+        }
+        else {
+            uint8_t k = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+            if(n + k >= size || i + k > s.len) return false;
+            memcpy(out + n, s.p + i, k);
+            n += k;
+            i += k;
+        }
+    }
+    return true;
+}
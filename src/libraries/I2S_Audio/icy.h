@@ -0,0 +1,44 @@
+// ICY (SHOUTcast) metadata parser, used by Audio::readMetadata and Audio::showstreamtitle.
+// Plain C++ without Arduino dependencies, so it can be fed malformed metadata blocks on the host.
+//
+// parse() works on a metadata block as it was read (up to 4080 bytes, padded with '\0', not terminated) and finds
+// StreamTitle, StreamUrl and the ad markers as slices into it, nothing is copied or converted. A quoted value ends at
+// "';", so apostrophes in titles ("Guns N' Roses") stay. Stations repeat the same block every metaint bytes: a title
+// or URL equal to the last one is not reported again. Only a new title is copied out by title(), converted from
+// Latin-1 if it is no valid UTF-8.
+
+#pragma once
+#include <stdint.h>
+
+class Icy {
+  public:
+    struct slice_t {
+        const char* p;
+        uint16_t    len;
+    };
+    enum : uint8_t { TITLE = 1, URL = 2, AD = 4 };          // what parse() found new
+
+    void     reset();                                       // another stream, every title is new again
+    uint8_t  parse(const char* block, uint16_t len);
+
+    slice_t  rawTitle() { return _title; }                  // as sent, for the log; slices of the last block parsed
+    slice_t  url() { return _url; }
+    slice_t  adMs() { return _adMs; }                       // durationMilliseconds of an ad break, may be empty
+    // the title parse() found ("title - artist" from XML metadata), '\0' terminated UTF-8, cut to fit into size;
+    // returns its length
+    uint16_t title(char* out, uint16_t size);
+
+    static bool validUtf8(const char* s, uint16_t len);
+
+  private:
+    slice_t  _title = {}, _artist = {}, _url = {}, _adMs = {};
+    uint32_t _titleHash = 0, _urlHash = 0;                  // 0 = none yet
+
+    static bool     _value(const char*& p, const char* end, slice_t& key, slice_t& val);
+    static bool     _is(const slice_t& s, const char* key);
+    static slice_t  _find(const slice_t& s, const char* what);
+    static slice_t  _tag(const slice_t& s, const char* open, const char* close);
+    static void     _trim(slice_t& s);
+    static uint32_t _hash(uint32_t h, const slice_t& s);
+    static bool     _copy(const slice_t& s, bool latin, char* out, uint16_t& n, uint16_t size);
+};
@@ -0,0 +1,275 @@
+#include "m3u8.h"
+#include <string.h>
+#include <stdlib.h>
+
+void M3u8::begin(char* arena, uint32_t size) {
+    _arena = arena;
+    _top = arena ? (segment_t*)(((uintptr_t)arena + size) & ~(uintptr_t)7) : NULL;
+    start();
+}
+
+void M3u8::start() {
+    _end = _line = _arena;
+    _lineCut = false;
+    _segs = _vars = 0;
+    _type = NONE;
+    _ext = _streamInf = _disc = false;
+    _targetMs = _discSeq = _ms = 0;
+    _mediaSeq = _idx = 0;
+    _hasSeq = _endlist = false;
+    _extinf = NULL;
+    _cut = _badLines = 0;
+}
+
+void M3u8::feed(const char* data, uint32_t len) {
+    if(!_arena) return;
+    while(len) {
+        const char* nl = (const char*)memchr(data, '\n', len);
+        uint32_t n = nl ? nl - data : len;
+        if(!_lineCut) {
+            if(_room(n + 1)) { memcpy(_end, data, n); _end += n; }   // + its '\0'
+            else _lineCut = true;
+        }
+        if(!nl) return;
+        data += n + 1;
+        len -= n + 1;
+        if(_lineCut) { _badLines++; _end = _line; _lineCut = false; continue; }
+        *_end = '\0';
+        _parseLine();
+    }
+}
+
+uint8_t M3u8::finish() {
+    if(_end != _line || _lineCut) feed("\n", 1);            // the last line had no line feed
+    if(!_ext) { _segs = _vars = 0; return _type = NONE; }
+    _type = (_segs || !_vars) ? MEDIA : MASTER;             // an empty media playlist: a live stream not begun yet
+    return _type;
+}
+
+bool M3u8::_room(uint32_t n) {                              // n bytes behind _end, before the segment table
+    while((intptr_t)(_top - _segs) - (intptr_t)_end < (intptr_t)n) {
+        if(!_segs || _vars) return false;
+        _evict();
+    }
+    return true;
+}
+
+void M3u8::_evict() {
+    // drops the older half of the segments: their strings are the oldest ones, everything behind moves down
+    uint16_t k = (_segs + 1) / 2;
+    segment_t& first = _top[-1];
+    segment_t& last = _top[-(int32_t)k];
+    char* from = (char*)(first.extinf ? first.extinf : first.uri);
+    char* to = (char*)last.uri + strlen(last.uri) + 1;
+    uint32_t shift = to - from;
+    memmove(from, to, _end - to + 1);
+    for(uint16_t i = k; i < _segs; i++) {
+        segment_t& s = _top[-1 - (int32_t)i];
+        s.uri -= shift;
+        if(s.extinf) s.extinf -= shift;
+    }
+    memmove(_top - (_segs - k), _top - _segs, (_segs - k) * sizeof(segment_t));
+    if(_extinf) _extinf -= shift;
+    if(_streamInf && *_v.codecs) _v.codecs -= shift;
+    _line -= shift;
+    _end -= shift;
+    _segs -= k;
+    _cut += k;
+}
+
+void M3u8::_parseLine() {
+    // the line from _line to _end stays (it holds a string needed later) or goes
+    char* p = _line;
+    char* e = _end;
+    bool  keep = false;
+    while(e > p && (e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')) *--e = '\0';
+    while(*p == ' ' || *p == '\t') p++;
+
+    if(!_ext) {
+        if(!strncmp(p, "\xEF\xBB\xBF", 3)) p += 3;          // UTF-8 BOM
+        _ext = !strncmp(p, "#EXTM3U", 7);                   // anything in front of it is no playlist
+    }
+    else if(*p == '#') {
+        if(!strncmp(p, "#EXTINF:", 8)) { _extinf = p; _ms = _duration(p + 8); keep = true; }
+        else if(!strncmp(p, "#EXT-X-MEDIA-SEQUENCE:", 22)) { _mediaSeq = strtoull(p + 22, NULL, 10); _hasSeq = true; }
+        else if(!strncmp(p, "#EXT-X-TARGETDURATION:", 22)) _targetMs = _duration(p + 22);
+        else if(!strncmp(p, "#EXT-X-DISCONTINUITY-SEQUENCE:", 30)) _discSeq = strtoul(p + 30, NULL, 10);
+        else if(!strcmp(p, "#EXT-X-DISCONTINUITY")) { _disc = true; _discSeq++; }
+        else if(!strcmp(p, "#EXT-X-ENDLIST")) _endlist = true;
+        else if(!strncmp(p, "#EXT-X-STREAM-INF:", 18)) { _streamInfo(p + 18); _streamInf = true; keep = true; }
+    }                                                       // other tags and comments (##, #MY-USER-CHUNK-DATA...)
+    else if(*p && _streamInf) {                             // a variant playlist
+        if(_vars < M3U8_VARIANTS) { _v.uri = p; _var[_vars++] = _v; keep = true; }
+        _streamInf = false;
+    }
+    else if(*p) {                                           // a media segment
+        uint32_t pOff = p - _line, eOff = e - _line;
+        if(_room(sizeof(segment_t) + 1)) {                  // may move the strings, this line too
+            p = _line + pOff;
+            e = _line + eOff;
+            segment_t& s = _top[-1 - (int32_t)_segs++];
+            s.seq = _mediaSeq + _idx;
+            s.disc = _discSeq;
+            s.ms = _extinf ? _ms : 0;
+            s.hash = 0;
+            s.discontinuity = _disc;
+            s.fresh = false;
+            s.uri = p;
+            s.extinf = _extinf;
+            keep = true;
+        }
+        else _badLines++;
+        _idx++;
+        _extinf = NULL;
+        _disc = false;
+    }
+    if(keep) _end = e + 1;
+    else _end = _line;
+    _line = _end;
+}
+
+void M3u8::_streamInfo(char* a) {
+    // BANDWIDTH=117500,AVERAGE-BANDWIDTH=117000,CODECS="mp4a.40.2,avc1.4d401f",RESOLUTION=...
+    _v.bandwidth = 0;
+    _v.codecs = "";
+    while(*a) {
+        while(*a == ' ') a++;
+        char* key = a;
+        while(*a && *a != '=' && *a != ',') a++;
+        size_t klen = a - key;
+        if(*a != '=') { if(*a) a++; continue; }
+        char* val = ++a;
+        if(*a == '"') {                                     // quoted, may hold commas
+            val = ++a;
+            while(*a && *a != '"') a++;
+            if(*a) *a++ = '\0';
+        }
+        while(*a && *a != ',') a++;
+        if(*a) *a++ = '\0';
+        if(klen == 9 && !strncmp(key, "BANDWIDTH", 9)) _v.bandwidth = strtoul(val, NULL, 10);
+        else if(klen == 6 && !strncmp(key, "CODECS", 6)) _v.codecs = val;
+    }
+}
+
+uint32_t M3u8::_duration(const char* s) {                   // "10", "3.008", "9.97667," in ms
+    uint32_t ms = 0;
+    while(*s == ' ') s++;
+    for(; *s >= '0' && *s <= '9'; s++) if(ms < 100000000) ms = ms * 10 + (*s - '0');
+    ms = ms < 4000000 ? ms * 1000 : 4000000000u;
+    if(*s == '.') for(uint32_t f = 100; *++s >= '0' && *s <= '9'; f /= 10) ms += (*s - '0') * f;
+    return ms;
+}
+
+/***********************************************************************************************************************
+ *  diff
+ ***********************************************************************************************************************/
+void M3u8::forget() {
+    _nextSeq = 0;
+    _seqKnown = false;
+    memset(_known, 0, sizeof(_known));
+    _kPos = 0;
+    _restarts = 0;
+    _seek = false;
+}
+
+void M3u8::remember(const char* uri) {
+    _remember(hash(uri));
+}
+
+void M3u8::seek(uint64_t seq) {
+    memset(_known, 0, sizeof(_known));
+    _nextSeq = seq;
+    _seqKnown = _seek = true;
+}
+
+uint16_t M3u8::diff() {
+    if(_type != MEDIA || !_segs) return 0;
+    for(uint16_t i = 0; i < _segs; i++) _top[-1 - (int32_t)i].hash = hash(_top[-1 - (int32_t)i].uri);  // not of the cut ones
+    int32_t last = -1;                                      // newest segment taken before
+    for(int32_t i = _segs - 1; i >= 0; i--) if(_isKnown(segment(i).hash)) { last = i; break; }
+    if(last >= 0) _nextSeq = segment(last).seq + 1;         // go on behind it by the name, some servers count wrong
+    else if(!_seqKnown) _nextSeq = segment(0).seq;          // first load, begin with the oldest one
+    else if(_hasSeq && !_seek && segment(_segs - 1).seq + 1 < _nextSeq) {   // all of it older than what we
+        _nextSeq = segment(0).seq;                          // have and new to us: the server started counting again
+        _restarts++;
+    }
+    _seqKnown = true;
+    _seek = false;
+    uint16_t n = 0;
+    for(uint16_t i = 0; i < _segs; i++) {
+        segment_t& s = _top[-1 - (int32_t)i];
+        s.fresh = last >= 0 ? (int32_t)i > last : !(_hasSeq && s.seq < _nextSeq);
+        if(s.fresh) n++;
+    }
+    return n;
+}
+
+uint64_t M3u8::take(const segment_t& s) {
+    uint64_t lost = 0;
+    if(_hasSeq && s.seq > _nextSeq) lost = s.seq - _nextSeq;
+    _remember(s.hash);
+    if(_hasSeq) _nextSeq = s.seq + 1;
+    return lost;
+}
+
+bool M3u8::_isKnown(uint32_t h) {
+    for(uint8_t i = 0; i < M3U8_KNOWN; i++) if(_known[i] == h) return true;
+    return false;
+}
+
+void M3u8::_remember(uint32_t h) {
+    _known[_kPos++ % M3U8_KNOWN] = h;
+}
+
+/***********************************************************************************************************************
+ *  URLs
+ ***********************************************************************************************************************/
+uint32_t M3u8::hash(const char* uri) {                      // FNV-1a of the name, relative and absolute URIs match
+    const char* q = strchr(uri, '?');
+    const char* end = q ? q : uri + strlen(uri);
+    const char* name = uri;
+    for(const char* p = uri; p < end; p++) if(*p == '/') name = p + 1;
+    uint32_t h = 2166136261u;
+    while(*name) { h ^= (uint8_t)*name++; h *= 16777619u; }
+    return h;
+}
+
+bool M3u8::resolve(const char* base, const char* ref, char* out, size_t size) {
+    if(!strncmp(ref, "http://", 7) || !strncmp(ref, "https://", 8)) return strlcpy(out, ref, size) < size;
+    const char* auth = strstr(base, "://");
+    if(!auth) return false;
+    auth += 3;
+    const char* path = strchr(auth, '/');
+    if(!path) path = auth + strlen(auth);
+    size_t n;
+    if(!strncmp(ref, "//", 2)) n = auth - 2 - base;     // same scheme
+    else if(ref[0] == '/') n = path - base;             // same host
+    else {                                              // same directory
+        const char* q = strchr(path, '?');
+        const char* end = q ? q : path + strlen(path);
+        n = path - base;
+        for(const char* p = end; p > path; p--) if(p[-1] == '/') { n = p - base; break; }
+        if(n == (size_t)(path - base)) {                // no path in the base
+            if(n + 1 >= size) return false;
+            memcpy(out, base, n);
+            out[n++] = '/';
+        }
+        else {
+            if(n >= size) return false;
+            memcpy(out, base, n);
+        }
+        while(true) {
+            if(!strncmp(ref, "./", 2)) { ref += 2; continue; }
+            if(strncmp(ref, "../", 3)) break;
+            ref += 3;
+            size_t root = path - base + 1;
+            if(n > root) { n--; while(n > root && out[n - 1] != '/') n--; }
+        }
+        out[n] = '\0';
+        return strlcat(out, ref, size) < size;
+    }
+    if(n >= size) return false;
+    memcpy(out, base, n);
+    out[n] = '\0';
+    return strlcat(out, ref, size) < size;
+}
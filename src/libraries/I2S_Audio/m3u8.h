@@ -0,0 +1,105 @@
+// M3U8 (HLS) playlist parser, used by Audio::parsePlaylist_M3U8 and by the HLS segment engine.
+// Plain C++ without Arduino dependencies, so it can be fed recorded playlists on the host.
+//
+// Everything lives in one arena the owner allocates once, reloading a live playlist allocates nothing. The text
+// is fed in pieces of any size as it comes in and parsed line by line: tags are read into typed fields, only the
+// strings that are needed later (segment URIs, #EXTINF lines, variant URIs and codecs) are kept at the start of
+// the arena, the segment table grows down from its end. A playlist too long for the arena (hours of DVR window)
+// keeps its newest segments: the older half of the table and its strings are dropped when the two meet.
+//
+// diff() finds where a reloaded media playlist goes on from what was taken of the earlier ones: behind the newest
+// segment whose name (the URI behind its last '/') was taken, so servers that count wrong or not at all work too,
+// else by the media sequence number. It only marks the new segments; take() one once it is queued, so a segment
+// that was refused (queue full) is new again on the next reload. Segments the playlist skipped over are counted
+// as lost.
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define M3U8_ARENA_SIZE 32768    // kept strings and the segment table
+#define M3U8_VARIANTS   16       // of a master playlist, more are ignored
+#define M3U8_KNOWN      32       // segment names remembered by diff()
+
+class M3u8 {
+  public:
+    enum : uint8_t { NONE = 0, MASTER, MEDIA };
+
+    struct segment_t {
+        uint64_t    seq;                                    // media sequence number
+        uint32_t    disc;                                   // discontinuity sequence number
+        uint32_t    ms;                                     // #EXTINF duration
+        uint32_t    hash;                                   // of the name, set by diff()
+        bool        discontinuity;                          // #EXT-X-DISCONTINUITY in front of it
+        bool        fresh;                                  // set by diff()
+        const char* uri;
+        const char* extinf;                                 // the whole #EXTINF line, NULL without one
+    };
+    struct variant_t {                                      // #EXT-X-STREAM-INF
+        uint32_t    bandwidth;
+        const char* codecs;                                 // without the quotes, "" if not given
+        const char* uri;
+    };
+
+    void     begin(char* arena, uint32_t size);             // memory of the owner, diff() state is kept
+    void     start();                                       // a playlist (re)load begins, what was parsed is dropped
+    void     feed(const char* data, uint32_t len);          // its text
+    uint8_t  finish();                                      // type of what was fed, NONE if that is no m3u8
+
+    void     forget();                                      // another stream, diff() knows nothing yet
+    void     remember(const char* uri);                     // taken elsewhere, e.g. the segment a stream started with
+    void     seek(uint64_t seq);                            // another variant of the stream goes on at seq, its names are new
+    uint16_t diff();                                        // marks the new segments, returns how many
+    uint64_t take(const segment_t& s);                      // s is queued, returns the segments lost in front of it
+
+    uint8_t          type() { return _type; }
+    uint16_t         segments() { return _segs; }           // oldest first
+    const segment_t& segment(uint16_t i) { return _top[-1 - (int32_t)i]; }
+    uint16_t         variants() { return _vars; }
+    const variant_t& variant(uint16_t i) { return _var[i]; }
+    uint32_t         targetMs() { return _targetMs; }      // #EXT-X-TARGETDURATION, 0 if not given
+    uint64_t         mediaSeq() { return _mediaSeq; }
+    bool             hasSeq() { return _hasSeq; }           // #EXT-X-MEDIA-SEQUENCE was there
+    bool             endlist() { return _endlist; }
+    uint32_t         cut() { return _cut; }                 // oldest segments dropped, the arena was full
+    uint32_t         badLines() { return _badLines; }       // too long for the arena, ignored
+    uint32_t         restarts() { return _restarts; }       // the server started counting again
+
+    // absolute URL of a playlist entry or a redirect relative to base (RFC 3986 5.2, without dot segments in
+    // the base), false if it does not fit; size = strlen(base) + strlen(ref) + 2 always does
+    static bool      resolve(const char* base, const char* ref, char* out, size_t size);
+    static uint32_t  hash(const char* uri);                 // of its name
+
+  private:
+    char*      _arena = NULL;
+    segment_t* _top = NULL;                                 // end of the arena, the segment table grows down from here
+    char*      _end = NULL;                                 // of the kept strings and the line coming in
+    char*      _line = NULL;                                // start of that line
+    bool       _lineCut = false;
+    uint16_t   _segs = 0, _vars = 0;
+    variant_t  _var[M3U8_VARIANTS];
+
+    uint8_t    _type = NONE;
+    bool       _ext = false, _streamInf = false, _disc = false;
+    uint32_t   _targetMs = 0, _discSeq = 0, _ms = 0;
+    uint64_t   _mediaSeq = 0, _idx = 0;
+    bool       _hasSeq = false, _endlist = false;
+    const char* _extinf = NULL;                             // waiting for its URI
+    variant_t  _v;                                          // #EXT-X-STREAM-INF waiting for its URI
+    uint32_t   _cut = 0, _badLines = 0;
+
+    uint64_t   _nextSeq = 0;                                // of the next new segment
+    bool       _seqKnown = false;
+    uint32_t   _known[M3U8_KNOWN] = {0};                    // names of the last segments taken
+    uint8_t    _kPos = 0;
+    uint32_t   _restarts = 0;
+    bool       _seek = false;                               // no restart before the next diff()
+
+    bool       _room(uint32_t n);
+    void       _evict();
+    void       _parseLine();
+    void       _streamInfo(char* attrs);
+    bool       _isKnown(uint32_t h);
+    void       _remember(uint32_t h);
+    static uint32_t _duration(const char* s);
+};
@@ -0,0 +1,82 @@
+// Adaptive prebuffer controller for webstreams, used by Audio::processWebStream / playAudioData.
+// Plain C++ without Arduino dependencies, times are passed in (ms), so it can be driven by recorded traces.
+//
+// start  - audio (ms) to buffer after connecting before decoding starts
+// resume - audio (ms) to buffer after an underrun before decoding resumes
+// Both are learned: they grow after every underrun and shrink slowly after long runs without one,
+// but never below what the measured arrival gaps of the current connection need.
+
+#pragma once
+#include <stdint.h>
+
+class Prebuffer {
+  public:
+    void setLimits(uint16_t minMs, uint16_t maxMs, uint32_t stableMs) { _minMs = minMs; _maxMs = maxMs; _stableMs = stableMs; }
+
+    void begin(uint16_t startMs, uint16_t resumeMs, uint32_t now) {    // new connection, learned values of the station
+        _start = _clamp(startMs);
+        _resume = _clamp(resumeMs < startMs ? startMs : resumeMs);
+        _last = now; _t0 = now; _bytes = 0;
+        _peakGap = 0; _jitter = 0; _avgGap = 0;
+        _stableSince = now; _underruns = 0;
+    }
+
+    void arrival(uint32_t now, uint32_t bytes) {                        // data was read from the socket
+        uint32_t gap = now - _last;
+        _last = now;
+        if(_bytes == 0) { _bytes = bytes; return; }                    // time to first byte is not jitter
+        _bytes += bytes;
+        /* RFC 3550 style mean deviation of the inter-arrival gap, Q4 */
+        int32_t d = (int32_t)(gap << 4) - (int32_t)_avgGap;
+        _avgGap += d / 8;
+        _jitter += ((d < 0 ? -d : d) - (int32_t)_jitter) / 16;
+        /* longest stall, Q8, decays with a time constant of PEAK_TAU ms so one old hiccup is forgotten after a while;
+           in whole ms the decay of a 50 ms arrival would round to nothing below 900 ms */
+        _peakGap -= (uint64_t)_peakGap * (gap < PEAK_TAU ? gap : PEAK_TAU) / PEAK_TAU;
+        if(gap > 0xFFFF) gap = 0xFFFF;
+        if((gap << 8) > _peakGap) _peakGap = gap << 8;
+    }
+
+    void resume(uint32_t now) { _last = now; }                          // reconnected, the outage is not an arrival gap
+
+    uint16_t floorMs() {                                                // what the current link needs
+        uint32_t f = (_peakGap >> 8) + 4 * (_jitter >> 4);
+        return _clamp(f > 0xFFFF ? 0xFFFF : f);
+    }
+    uint16_t startMs()  { uint16_t f = floorMs(); return _start > f ? _start : f; }
+    uint16_t resumeMs() { uint16_t f = floorMs() * 2; if(f > _maxMs) f = _maxMs; return _resume > f ? _resume : f; }
+
+    void underrun(uint32_t now) {                                       // the decoder ran dry while playing
+        _underruns++;
+        _start = _clamp(_start + _start / 2 + 100);
+        _resume = _clamp(_resume + _resume / 2 + 200);
+        _stableSince = now;
+    }
+
+    bool stable(uint32_t now) {                                         // call while playing, true if lowered
+        if(now - _stableSince < _stableMs) return false;
+        _stableSince = now;
+        uint16_t s = _clamp(_start - _start / 8), r = _clamp(_resume - _resume / 8);
+        if(s == _start && r == _resume) return false;
+        _start = s; _resume = r;
+        return true;
+    }
+
+    uint16_t learnedStart()  { return _start; }
+    uint16_t learnedResume() { return _resume; }
+    uint16_t underruns()     { return _underruns; }
+    uint32_t jitterMs()      { return _jitter >> 4; }
+    uint32_t throughput(uint32_t now) { return now - _t0 ? (uint64_t)_bytes * 1000 / (now - _t0) : 0; } // bytes/s
+
+  private:
+    static const uint32_t PEAK_TAU = 45000;
+    uint16_t _minMs = 100, _maxMs = 8000;
+    uint32_t _stableMs = 300000;
+    uint16_t _start = 300, _resume = 1000;
+    uint32_t _last = 0, _t0 = 0, _bytes = 0;
+    uint32_t _peakGap = 0, _jitter = 0, _avgGap = 0;
+    uint32_t _stableSince = 0;
+    uint16_t _underruns = 0;
+
+    uint16_t _clamp(uint32_t v) { return v < _minMs ? _minMs : (v > _maxMs ? _maxMs : v); }
+};
@@ -0,0 +1,90 @@
+// Read-ahead of a local file, used by Audio::processLocalFile of both audio libraries: a ring of blocks that a task
+// fills with large sector aligned reads, the player takes from it. Plain C++ without Arduino dependencies, so a host
+// harness drives it against a simulated block device.
+//
+// One producer (the read-ahead task: space(), filled()) and one consumer (the player: take()), lock free. The first
+// read after reset() ends at a block boundary of the file, every later one is a whole block at a block aligned
+// offset, and a block is a multiple of the sector: the FAT driver reads whole sectors straight into the ring instead
+// of through its one-sector cache, and a latency spike of the card costs one read, not one per loop pass.
+// reset() and any other use of the file run with the producer held off by the owner (Audio's file mutex).
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+class ReadAhead {
+  public:
+    static const uint16_t SECTOR = 512;
+    static const uint8_t  BLOCKS_MAX = 32;
+
+    bool begin(uint8_t* mem, uint32_t size, uint32_t block) {           // block: a multiple of SECTOR
+        _block = block < SECTOR ? SECTOR : block / SECTOR * SECTOR;
+        _n = size / _block > BLOCKS_MAX ? BLOCKS_MAX : size / _block;
+        _mem = _n >= 2 ? mem : nullptr;
+        reset(0, 0);
+        return _mem != nullptr;
+    }
+    void end() {                                                        // the memory goes back to the owner
+        _mem = nullptr; _n = 0;
+        reset(0, 0);
+    }
+    bool ready() const { return _mem != nullptr; }
+
+    void reset(uint32_t pos, uint32_t end) {                            // the producer is held off
+        _head = 0; _tail = 0; _off = 0;
+        _fill = _take = pos;
+        _end = end;
+    }
+
+    /* producer */
+    uint8_t* space(uint32_t* pos, uint32_t* len) {                      // nullptr: the ring is full or the end is read
+        if(!_mem || _head - _tail >= _n || _fill >= _end) return nullptr;
+        uint32_t l = _block - _fill % _block;                           // up to the next block boundary of the file
+        if(l > _end - _fill) l = _end - _fill;
+        *pos = _fill; *len = l;
+        return _mem + (_head % _n) * _block;
+    }
+    void filled(int32_t got) {                                          // bytes read into space(), <= 0: the end is here
+        if(got <= 0) { _end = _fill; return; }
+        _len[_head % _n] = got;
+        _fill += got;
+        _head.fetch_add(1, std::memory_order_release);                  // the block is the consumer's now
+        _reads++;
+    }
+
+    /* consumer */
+    uint32_t take(uint8_t* dst, uint32_t max) {
+        uint32_t n = 0, head = _head.load(std::memory_order_acquire);
+        uint32_t tail = _tail;
+        if(tail == head && _fill < _end && max) _misses++;              // the player was faster than the card
+        while(n < max && tail != head) {
+            uint32_t i = tail % _n, c = _len[i] - _off;
+            if(c > max - n) c = max - n;
+            memcpy(dst + n, _mem + i * _block + _off, c);
+            n += c; _off += c;
+            if(_off == _len[i]) { _off = 0; tail++; _tail.store(tail, std::memory_order_release); }
+        }
+        _take += n;
+        return n;
+    }
+    uint32_t position() const { return _take; }                         // file position of the next byte take() returns
+    uint32_t buffered() const { return _fill - _take; }                 // approximate from the consumer side
+    uint32_t capacity() const { return _n * _block; }
+    bool     low() const { return _fill < _end && buffered() < capacity() / 2; }  // a directory scan waits for the card
+    bool     atEnd() const { return _tail == _head && _fill >= _end; }
+    uint32_t block() const { return _block; }
+
+    uint32_t reads() const { return _reads; }                           // statistics since begin()
+    uint32_t misses() const { return _misses; }
+
+  private:
+    uint8_t*  _mem = nullptr;
+    uint32_t  _block = 4096;
+    uint8_t   _n = 0;
+    uint32_t  _len[BLOCKS_MAX] = {};
+    std::atomic<uint32_t> _head{0}, _tail{0};                           // blocks filled, blocks taken
+    volatile uint32_t _fill = 0, _end = 0;                              // producer: next file position to read, end of file
+    uint32_t  _take = 0, _off = 0;                                      // consumer: file position, offset into the tail block
+    uint32_t  _reads = 0, _misses = 0;
+};
@@ -0,0 +1,61 @@
+// Reconnect controller for webstreams, used by Audio when a playing stream drops (socket closed or stalled)
+// and by the player's retry task. Plain C++ without Arduino dependencies, times are passed in (ms), so it can be
+// driven by a test server.
+//
+// The first attempt is made at once, the following ones wait a capped exponential backoff with decorrelated
+// jitter (each wait is random between the minimum and three times the previous wait), so radios that lost the same
+// server don't come back in step. The outcome of every drop moves a per station health score (0..100).
+
+#pragma once
+#include <stdint.h>
+
+class Reconnect {
+  public:
+    enum : uint8_t { NONE = 0, SEAMLESS = 1, GAP = 2, FAILED = 3, STABLE = 4 };  // outcomes, STABLE = a long run without a drop
+
+    void setLimits(uint32_t minMs, uint32_t maxMs, uint32_t giveUpMs) { _minMs = minMs; _maxMs = maxMs; _giveUpMs = giveUpMs; }
+
+    void begin(uint32_t now, uint32_t seed) {                           // the stream dropped
+        if(seed) _rnd = seed;
+        _t0 = now; _next = now; _wait = _minMs;
+        _attempts = 0; _dry = false; _active = true;
+    }
+
+    bool active() { return _active; }
+    bool due(uint32_t now) { return _active && (int32_t)(now - _next) >= 0; }
+    uint32_t waitMs(uint32_t now) { return due(now) || !_active ? 0 : _next - now; }
+    void attempt() { if(_attempts < 0xFF) _attempts++; }
+
+    bool retry(uint32_t now) {                                          // the attempt failed, false = give up
+        if(now - _t0 >= _giveUpMs) { _active = false; return false; }
+        uint32_t hi = _wait * 3;
+        if(hi > _maxMs) hi = _maxMs;
+        _wait = hi > _minMs ? _minMs + _random() % (hi - _minMs + 1) : _minMs;
+        if(now + _wait - _t0 > _giveUpMs) _wait = _giveUpMs - (now - _t0); // one last try at the deadline
+        _next = now + _wait;
+        return true;
+    }
+
+    void dry() { _dry = true; }                                         // the buffer ran out meanwhile
+    uint8_t done() { _active = false; return _dry ? GAP : SEAMLESS; }   // reconnected
+    void cancel() { _active = false; }
+
+    uint8_t attempts() { return _attempts; }
+    uint32_t elapsed(uint32_t now) { return now - _t0; }
+
+    static uint8_t score(uint8_t health, uint8_t outcome) {             // moves health 1/4 of the way to the outcome's target
+        static const uint8_t target[] = { 100, 70, 40, 0, 100 };
+        if(outcome > STABLE || outcome == NONE) return health;
+        int16_t d = (int16_t)target[outcome] - health;
+        return health + (d + (d > 0 ? 3 : (d < 0 ? -3 : 0))) / 4;
+    }
+
+  private:
+    uint32_t _minMs = 250, _maxMs = 8000, _giveUpMs = 60000;
+    uint32_t _t0 = 0, _next = 0, _wait = 0;
+    uint32_t _rnd = 2463534242u;
+    uint8_t  _attempts = 0;
+    bool     _dry = false, _active = false;
+
+    uint32_t _random() { _rnd ^= _rnd << 13; _rnd ^= _rnd >> 17; _rnd ^= _rnd << 5; return _rnd; }  // xorshift32
+};
@@ -0,0 +1,124 @@
+// Dead stream detection of a playing webstream, used by Audio: silence, a frozen (looping) buffer, a decoder that
+// stopped while data is buffered and an input far below the bitrate while the socket stays up. Plain C++ without
+// Arduino dependencies, times are passed in (ms), so a host harness feeds crafted PCM and byte counts.
+//
+// pcm() runs in the audio task once per decoded block and looks at every STEP-th frame. A block is silent below the
+// threshold (RMS of both channels); a block that is not silent repeats if its hash is one of the last RING ones.
+// Quiet content has blocks above the threshold often enough (speech pauses and fades last seconds, not the silence
+// time), a dead stream (digital zero, dither, comfort noise far down) has none. check() in the loop task reports a
+// reason once and then watches the next interval from scratch; action() is the ladder repeated strikes climb.
+
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+class StreamWatch {
+  public:
+    enum : uint8_t { NONE, SILENT, FROZEN, STUCK, STARVED };            // reasons
+    enum : uint8_t { ALERT = 0, RECONNECT = 1, ALTERNATE = 2, NEXT = 4 }; // actions, the rungs as flags of the ladder
+    static const uint8_t RING = 64;                                     // blocks, 1.5 s of mp3 at 44.1 kHz
+    static const uint8_t STEP = 4;
+
+    static const char* name(uint8_t reason) {
+        static const char* const names[] = {"", "silent", "frozen", "stuck", "starved"};
+        return reason <= STARVED ? names[reason] : "";
+    }
+    static const char* actionName(uint8_t action) {
+        switch(action) {
+            case RECONNECT: return "reconnect";
+            case ALTERNATE: return "alternate";
+            case NEXT:      return "next";
+            default:        return "alert";
+        }
+    }
+
+    // the rung of the strike-th detection (0 = first), ALERT once the ladder is climbed
+    static uint8_t action(uint8_t strike, uint8_t ladder) {
+        for(uint8_t rung = RECONNECT; rung <= NEXT; rung <<= 1) {
+            if(!(ladder & rung)) continue;
+            if(!strike--) return rung;
+        }
+        return ALERT;
+    }
+    static uint8_t rungs(uint8_t ladder) { return (ladder & RECONNECT ? 1 : 0) + (ladder & ALTERNATE ? 1 : 0) + (ladder & NEXT ? 1 : 0); }
+
+    // durations in s, 0 = that check is off
+    void setup(int8_t silenceDb, uint16_t silenceS, uint16_t frozenS, uint16_t stuckS, uint8_t starvedPct, uint16_t starvedS) {
+        float a = 32768.0f * powf(10.0f, (silenceDb > 0 ? 0 : silenceDb) / 20.0f);
+        _thrSq = a * a < 1 ? 1 : (uint32_t)(a * a);
+        _silenceMs = silenceS * 1000u;
+        _frozenMs = frozenS * 1000u;
+        _stuckMs = stuckS * 1000u;
+        _starvedPct = starvedPct > 100 ? 100 : starvedPct;
+        _starvedMs = starvedPct ? starvedS * 1000u : 0;
+    }
+
+    void arm(uint32_t now) {                                            // a new stream, loop task
+        for(uint8_t i = 0; i < RING; i++) _ring[i] = 0;
+        _loudT = _freshT = _pcmT = now;
+        hold(now);
+        _on = true;
+    }
+    void disarm() { _on = false; }
+    bool armed() const { return _on; }
+
+    void hold(uint32_t now) { _decT = _winT = now; _bytes = 0; }        // not playing from the network: start over
+
+    void input(uint32_t bytes) { _bytes += bytes; }                     // loop task, from the socket
+
+    void pcm(const int16_t* lr, uint32_t frames, uint32_t now) {        // audio task, interleaved stereo
+        if(!_on || !frames) return;
+        uint64_t sq = 0;
+        uint32_t h = 2166136261u, n = 0;
+        for(uint32_t f = 0; f < frames; f += STEP, lr += 2 * STEP, n++) {
+            int32_t l = lr[0], r = lr[1];
+            sq += (uint32_t)(l * l) + (uint32_t)(r * r);
+            h = (h ^ (uint16_t)l) * 16777619u;                          // FNV-1a of the samples looked at
+            h = (h ^ (uint16_t)r) * 16777619u;
+        }
+        _pcmT = now;
+        if(sq < (uint64_t)_thrSq * n * 2) { _freshT = now; return; }    // silent, not a repeat: silence is SILENT's
+        _loudT = now;
+        bool seen = false;
+        for(uint8_t i = 0; i < RING && !seen; i++) seen = _ring[i] == h;
+        if(!seen) _freshT = now;
+        _ring[_pos] = h;
+        _pos = _pos + 1 == RING ? 0 : _pos + 1;
+    }
+
+    // loop task; decoding: the audio task is playing (not prebuffering), buffered: bytes in the input buffer,
+    // bytesPerSec: of the stream, 0 = bitrate not known (no STARVED)
+    uint8_t check(uint32_t now, bool decoding, uint32_t buffered, uint32_t bytesPerSec) {
+        if(!_on) return NONE;
+        uint8_t why = NONE;
+        uint32_t idle = now - _later(_pcmT, _decT);
+        if(!decoding) _decT = now;                                      // the PCM checks start over when it resumes
+        else if(idle >= 1000) {                                         // no blocks: the decoder, not the content
+            if(_stuckMs && idle >= _stuckMs && buffered >= (bytesPerSec ? bytesPerSec : 16000)) why = STUCK;
+        }
+        else if(_silenceMs && now - _later(_loudT, _decT) >= _silenceMs) why = SILENT;
+        else if(_frozenMs && now - _later(_freshT, _decT) >= _frozenMs) why = FROZEN;
+        if(!_starvedMs || !bytesPerSec) { _winT = now; _bytes = 0; }
+        else if(now - _winT >= _starvedMs) {
+            uint64_t expect = (uint64_t)bytesPerSec * (now - _winT) / 1000 * _starvedPct / 100;
+            if(!why && _bytes < expect) why = STARVED;
+            _winT = now; _bytes = 0;
+        }
+        if(why) hold(now);
+        return why;
+    }
+
+  private:
+    uint32_t _thrSq = 269;                                              // mean square of a sample, -66 dBFS
+    uint32_t _silenceMs = 0, _frozenMs = 0, _stuckMs = 0, _starvedMs = 0;
+    uint8_t  _starvedPct = 0;
+    volatile bool _on = false;
+    /* audio task */
+    volatile uint32_t _loudT = 0, _freshT = 0, _pcmT = 0;               // last block above the threshold, not a repeat, at all
+    uint32_t _ring[RING] = {};
+    uint8_t  _pos = 0;
+    /* loop task */
+    uint32_t _decT = 0, _winT = 0, _bytes = 0;                          // decoding since, input window since, bytes in it
+
+    static uint32_t _later(uint32_t a, uint32_t b) { return (int32_t)(a - b) > 0 ? a : b; }
+};
@@ -0,0 +1,194 @@
+#include "tsdemux.h"
+#include <string.h>
+
+void TsDemux::reset() {
+    _pmtPid = _audioPid = 0;
+    _streamType = 0;
+    memset(_cc, 0xFF, sizeof(_cc));
+    _inSync = _pesOk = false;
+    _pesSkip = 0;
+    _psiSlot = PIDS;
+    _psiLen = _psiWant = 0;
+    _packets = _ccErrors = _resyncs = _dropped = _badPackets = 0;
+}
+
+uint32_t TsDemux::parse(const uint8_t* buf, uint32_t len, span_t* spans, uint16_t maxSpans, uint16_t* nSpans) {
+    uint32_t pos = 0;
+    *nSpans = 0;
+    while(len - pos >= TS_PACKET_SIZE && *nSpans < maxSpans) {
+        if(!_inSync || buf[pos] != 0x47) {
+            if(_inSync) { _inSync = false; _resyncs++; _pesOk = false; _psiSlot = PIDS; }
+            uint32_t skip;
+            bool found = _sync(buf + pos, len - pos, &skip);
+            _dropped += skip;
+            pos += skip;
+            if(!found) break;                               // the rest comes with the next read
+            _inSync = true;
+            continue;
+        }
+        if(_packet(buf + pos, &spans[*nSpans])) (*nSpans)++;
+        pos += TS_PACKET_SIZE;
+    }
+    return pos;
+}
+
+bool TsDemux::_sync(const uint8_t* buf, uint32_t len, uint32_t* skip) {
+    // a sync byte with another one a packet further on, or the last whole packet in the buffer
+    uint32_t i = 0;
+    for(; i + TS_PACKET_SIZE <= len; i++) {
+        if(buf[i] != 0x47) continue;
+        if(i + TS_PACKET_SIZE == len || buf[i + TS_PACKET_SIZE] == 0x47) { *skip = i; return true; }
+    }
+    *skip = i;
+    return false;
+}
+
+bool TsDemux::_packet(const uint8_t* p, span_t* span) {
+    //  byte 0   sync 0x47
+    //  byte 1   TEI | PUSI | priority | PID 12..8
+    //  byte 2   PID 7..0
+    //  byte 3   scrambling 2 bit | adaptation field control 2 bit | continuity counter 4 bit
+    _packets++;
+    if(p[1] & 0x80) { _badPackets++; return false; }        // transport error indicator
+    uint16_t pid = ((p[1] & 0x1F) << 8) | p[2];
+    if(pid == 0x1FFF) return false;                         // null packet
+    bool    start = p[1] & 0x40;
+    uint8_t afc = (p[3] >> 4) & 0x03;
+    uint8_t off = 4;
+    bool    disc = false;
+    if(afc & 0x02) {                                        // adaptation field
+        uint8_t afl = p[4];
+        if(afl > TS_PACKET_SIZE - 5 || (afc == 0x03 && afl == TS_PACKET_SIZE - 5)) { _badPackets++; return false; }
+        if(afl) disc = p[5] & 0x80;                         // discontinuity indicator, the counter may jump
+        off = 5 + afl;
+    }
+    if(!(afc & 0x01)) return false;                         // no payload, the counter does not count
+    uint8_t slot = pid == 0 ? PID_PAT : (_pmtPid && pid == _pmtPid) ? PID_PMT : (_audioPid && pid == _audioPid) ? PID_AUDIO : PIDS;
+    if(slot == PIDS) return false;                          // video, data, other programs
+    if(!_continuity(slot, p[3] & 0x0F, disc)) return false;
+    if(slot == PID_AUDIO) {
+        _pes(p + off, TS_PACKET_SIZE - off, start, span);
+        return span->len > 0;
+    }
+    _psiData(slot, p + off, TS_PACKET_SIZE - off, start);
+    return false;
+}
+
+bool TsDemux::_continuity(uint8_t slot, uint8_t cc, bool discontinuity) {
+    uint8_t last = _cc[slot];
+    _cc[slot] = cc;
+    if(last == 0xFF || discontinuity || cc == ((last + 1) & 0x0F)) return true;
+    if(cc == last) return false;                            // sent twice, drop the copy
+    _ccErrors++;
+    if(slot == PID_AUDIO) _pesOk = false;                   // wait for the next PES header
+    else if(_psiSlot == slot) _psiSlot = PIDS;
+    return true;
+}
+
+void TsDemux::_psiData(uint8_t slot, const uint8_t* d, uint8_t n, bool start) {
+    if(!start) {
+        if(_psiSlot == slot) _psiFeed(slot, d, n);
+        return;
+    }
+    uint8_t ptr = d[0];                                     // pointer field: where the new section begins
+    d++; n--;
+    if(ptr > n) { _badPackets++; _psiSlot = PIDS; return; }
+    if(_psiSlot == slot && ptr) _psiFeed(slot, d, ptr);     // the rest of the previous one
+    _psiSlot = slot;
+    _psiLen = _psiWant = 0;
+    _psiFeed(slot, d + ptr, n - ptr);
+}
+
+void TsDemux::_psiFeed(uint8_t slot, const uint8_t* d, uint8_t n) {
+    while(n) {
+        if(_psiSlot != slot) {                              // another section behind a complete one, or stuffing
+            if(d[0] == 0xFF) return;
+            _psiSlot = slot;
+            _psiLen = _psiWant = 0;
+        }
+        uint16_t want = _psiWant ? _psiWant : 3;
+        uint16_t k = want - _psiLen < n ? want - _psiLen : n;
+        memcpy(_psi + _psiLen, d, k);
+        _psiLen += k;
+        d += k; n -= k;
+        if(_psiLen < want) return;
+        if(!_psiWant) {                                     // table id and section length are there
+            _psiWant = 3 + (((_psi[1] & 0x0F) << 8) | _psi[2]);
+            if(_psiWant > sizeof(_psi) || _psiWant < 12) { _badPackets++; _psiSlot = PIDS; return; }
+            continue;
+        }
+        _section(slot);
+        _psiSlot = PIDS;
+    }
+}
+
+void TsDemux::_section(uint8_t slot) {
+    //  0 table id | 1..2 section length | 3..4 id | 5 version, current | 6 section | 7 last section | ... | CRC 32
+    if(_crc32(_psi, _psiLen)) { _badPackets++; return; }
+    if(!(_psi[5] & 0x01)) return;                           // not valid yet
+    uint16_t end = _psiLen - 4;
+    if(slot == PID_PAT && _psi[0] == 0x00) {
+        for(uint16_t i = 8; i + 4 <= end; i += 4) {         // program number, PMT PID
+            if(!((_psi[i] << 8) | _psi[i + 1])) continue;   // network information
+            uint16_t pid = ((_psi[i + 2] & 0x1F) << 8) | _psi[i + 3];
+            if(pid != _pmtPid) {
+                _pmtPid = pid;
+                _audioPid = 0;
+                _streamType = 0;
+                _cc[PID_PMT] = _cc[PID_AUDIO] = 0xFF;
+                _pesOk = false;
+            }
+            break;
+        }
+    }
+    else if(slot == PID_PMT && _psi[0] == 0x02) {
+        uint16_t pid = 0;
+        uint8_t  type = 0;
+        uint16_t i = 12 + (((_psi[10] & 0x0F) << 8) | _psi[11]);   // behind the program info
+        while(i + 5 <= end) {                               // stream type, PID, ES info length
+            if(_psi[i] == 0x0F || _psi[i] == 0x11) { type = _psi[i]; pid = ((_psi[i + 1] & 0x1F) << 8) | _psi[i + 2]; break; }
+            i += 5 + (((_psi[i + 3] & 0x0F) << 8) | _psi[i + 4]);
+        }
+        if(pid != _audioPid) {
+            _audioPid = pid;
+            _cc[PID_AUDIO] = 0xFF;
+            _pesOk = false;
+        }
+        _streamType = type;
+    }
+}
+
+void TsDemux::_pes(const uint8_t* d, uint8_t n, bool start, span_t* span) {
+    //  0..2 start code 00 00 01 | 3 stream id | 4..5 length | 6..7 flags | 8 header data length | header data
+    span->len = 0;
+    if(start) {
+        _pesOk = false;
+        _pesSkip = 0;
+        if(n < 9 || d[0] || d[1] || d[2] != 0x01) { _badPackets++; return; }
+        if(d[3] < 0xC0 || d[3] > 0xDF) return;              // not an audio stream
+        uint16_t hdr = 9 + d[8];
+        _pesOk = true;
+        if(hdr >= n) { _pesSkip = hdr - n; return; }
+        d += hdr; n -= hdr;
+    }
+    else {
+        if(!_pesOk) return;
+        if(_pesSkip) {
+            uint8_t k = _pesSkip < n ? _pesSkip : n;
+            _pesSkip -= k;
+            d += k; n -= k;
+            if(!n) return;
+        }
+    }
+    span->data = d;
+    span->len = n;
+}
+
+uint32_t TsDemux::_crc32(const uint8_t* d, uint16_t n) {    // MPEG-2, 0 over a section with its CRC
+    uint32_t crc = 0xFFFFFFFF;
+    while(n--) {
+        crc ^= (uint32_t)*d++ << 24;
+        for(uint8_t b = 0; b < 8; b++) crc = crc & 0x80000000 ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+    return crc;
+}
@@ -0,0 +1,61 @@
+// MPEG transport stream demuxer for m3u8 (HLS) segments, used by Audio::processWebStreamTS.
+// Plain C++ without Arduino dependencies, so it can be fed recorded segments on the host.
+//
+// parse() takes as many whole 188 byte packets as there are in one read and hands out the audio payload as spans
+// into that buffer, nothing is copied. The audio PID comes from the PAT and the PMT of the first program (sections
+// are assembled over packets and CRC checked), not from fixed PIDs. Continuity counters are checked per PID:
+// a repeated packet is dropped, a lost one drops the rest of its PES packet (the decoder would get a frame with a
+// hole) up to the next PES header. Lost sync (a cut segment, garbage between packets) is found again on two sync
+// bytes 188 bytes apart.
+
+#pragma once
+#include <stdint.h>
+
+#define TS_PACKET_SIZE 188
+#define TS_BATCH       32        // packets Audio reads at once
+
+class TsDemux {
+  public:
+    TsDemux() { reset(); }
+
+    struct span_t {
+        const uint8_t* data;
+        uint8_t        len;
+    };
+
+    void reset();                                           // new stream: PAT, PMT and counters are learned again
+    // demuxes whole packets from buf, returns the bytes consumed (a packet cut off at the end is left for the
+    // next call), the audio payload goes to spans (pointers into buf), at most one span per packet
+    uint32_t parse(const uint8_t* buf, uint32_t len, span_t* spans, uint16_t maxSpans, uint16_t* nSpans);
+
+    uint16_t audioPid()   { return _audioPid; }             // 0 = not known yet
+    uint8_t  streamType() { return _streamType; }           // 0x0F AAC ADTS, 0x11 AAC LATM
+    uint32_t packets()    { return _packets; }
+    uint32_t ccErrors()   { return _ccErrors; }             // lost packets (continuity counter jumps)
+    uint32_t resyncs()    { return _resyncs; }              // sync byte lost and found again
+    uint32_t dropped()    { return _dropped; }              // bytes skipped looking for sync
+    uint32_t badPackets() { return _badPackets; }           // transport error flag, bad adaptation field, bad CRC
+
+  private:
+    enum : uint8_t { PID_PAT = 0, PID_PMT, PID_AUDIO, PIDS };
+
+    uint16_t _pmtPid = 0, _audioPid = 0;
+    uint8_t  _streamType = 0;
+    uint8_t  _cc[PIDS];                                     // last continuity counter, 0xFF = none yet
+    bool     _inSync = false;
+    bool     _pesOk = false;                                // in a PES packet that is complete so far
+    uint16_t _pesSkip = 0;                                  // PES header bytes still to skip in the next packet
+    uint8_t  _psiSlot = PIDS;                               // section being assembled, of PID_PAT or PID_PMT
+    uint16_t _psiLen = 0, _psiWant = 0;
+    uint8_t  _psi[1024];                                    // PSI sections are at most 1024 bytes
+    uint32_t _packets = 0, _ccErrors = 0, _resyncs = 0, _dropped = 0, _badPackets = 0;
+
+    bool     _sync(const uint8_t* buf, uint32_t len, uint32_t* skip);
+    bool     _packet(const uint8_t* p, span_t* span);
+    bool     _continuity(uint8_t slot, uint8_t cc, bool discontinuity);
+    void     _psiData(uint8_t slot, const uint8_t* d, uint8_t n, bool start);
+    void     _psiFeed(uint8_t slot, const uint8_t* d, uint8_t n);
+    void     _section(uint8_t slot);
+    void     _pes(const uint8_t* d, uint8_t n, bool start, span_t* span);
+    static uint32_t _crc32(const uint8_t* d, uint16_t n);
+};
@@ -0,0 +1,85 @@
+// Time to first sound of a tune, phase by phase, used by Player and both audio libraries.
+// Plain C++ without Arduino dependencies, times are passed in (ms), so a host harness prints the same breakdown.
+//
+// begin() with the time the play request was queued, then each phase is marked as it is reached. A later connection
+// of the same tune (playlist, redirect) marks its phases again and clears the ones behind them, so the breakdown is
+// the one of the connection that played. Phases that did not happen (TLS of http, DNS of a warm connection, the
+// network of a local file) stay unset. The first write to the output completes the tune.
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+class Ttfs {
+  public:
+    enum : uint8_t { QUEUE, LOAD, CALL, DNS, CONNECT, TLS, HEADERS, FIRST_BYTE, PREBUFFER, DECODE, OUTPUT, PHASES };
+    static const uint16_t NONE = 0xFFFF;
+
+    static const char* name(uint8_t phase) {
+        static const char* const names[PHASES] = {"queue", "load", "call", "dns", "connect", "tls", "headers", "firstbyte",
+                                                  "prebuffer", "decode", "output"};
+        return phase < PHASES ? names[phase] : "";
+    }
+
+    void begin(uint32_t t0) { _t0 = t0; for(uint8_t i = 0; i < PHASES; i++) _at[i] = NONE; _active = true; }
+    void cancel() { _active = false; }
+    bool active() const { return _active; }
+
+    bool mark(uint8_t phase, uint32_t now) {                            // true if this completed the tune
+        if(!_active || phase >= PHASES) return false;
+        uint32_t ms = now - _t0;
+        _at[phase] = ms < NONE ? ms : NONE - 1;
+        for(uint8_t i = phase + 1; i < PHASES; i++) _at[i] = NONE;
+        if(phase == OUTPUT) _active = false;
+        return phase == OUTPUT;
+    }
+    bool once(uint8_t phase, uint32_t now) { return _active && phase < PHASES && _at[phase] == NONE && mark(phase, now); }
+
+    uint16_t at(uint8_t phase) const { return phase < PHASES ? _at[phase] : NONE; }   // since begin()
+    uint16_t total() const { return _at[OUTPUT]; }
+    uint16_t spent(uint8_t phase) const {                               // since the phase reached before it
+        if(phase >= PHASES || _at[phase] == NONE) return NONE;
+        for(uint8_t i = phase; i-- > 0;) if(_at[i] != NONE) return _at[phase] - _at[i];
+        return _at[phase];
+    }
+
+    uint16_t format(char* out, uint16_t size) const {                   // "1234 ms: queue 2, load 15, ..., tls -, ..."
+        uint16_t n = 0;
+        if(!size) return 0;
+        out[0] = '\0';
+        if(total() == NONE) n = _put(out, n, size, "- ms:");
+        else n = _put(out, n, size, "%u ms:", total());
+        for(uint8_t i = 0; i < PHASES; i++) {
+            uint16_t s = spent(i);
+            if(s == NONE) n = _put(out, n, size, "%s %s -", i ? "," : "", name(i));
+            else n = _put(out, n, size, "%s %s %u", i ? "," : "", name(i), s);
+        }
+        return n;
+    }
+
+    uint16_t json(char* out, uint16_t size) const {                     // "ms":1234,"queue":2,...,"tls":null,...
+        uint16_t n = 0;
+        if(!size) return 0;
+        out[0] = '\0';
+        if(total() == NONE) n = _put(out, n, size, "\"ms\":null");
+        else n = _put(out, n, size, "\"ms\":%u", total());
+        for(uint8_t i = 0; i < PHASES; i++) {
+            uint16_t s = spent(i);
+            if(s == NONE) n = _put(out, n, size, ",\"%s\":null", name(i));
+            else n = _put(out, n, size, ",\"%s\":%u", name(i), s);
+        }
+        return n;
+    }
+
+  private:
+    uint32_t _t0 = 0;
+    uint16_t _at[PHASES] = {NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE};
+    bool     _active = false;
+
+    template <typename... A> static uint16_t _put(char* out, uint16_t n, uint16_t size, const char* fmt, A... a) {
+        if(n >= size - 1) return n;                                     // full, cut off
+        int r = snprintf(out + n, size - n, fmt, a...);
+        if(r < 0) return n;
+        return n + r < size - 1 ? n + r : size - 1;
+    }
+};
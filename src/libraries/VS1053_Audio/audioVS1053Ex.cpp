@@ -180,6 +180,7 @@ Audio::Audio(uint8_t _cs_pin, uint8_t _dcs_pin, uint8_t _dreq_pin, SPIClass *spi
 
     mutex_playAudioData = xSemaphoreCreateMutex();
     mutex_audioTask     = xSemaphoreCreateMutex();
+    mutex_file          = xSemaphoreCreateMutex();
 
 //    spi_VS1053 = new SPIClass(spi);								// Wolle
     spi_VS1053 = spi; 											// easy
@@ -222,8 +223,11 @@ Audio::~Audio(){
     x_ps_free(&m_speechtxt);
 
     stopAudioTask();
+    readAheadStop(true);
+    if(m_raTask) vTaskDelete(m_raTask);
     vSemaphoreDelete(mutex_playAudioData);
     vSemaphoreDelete(mutex_audioTask);
+    vSemaphoreDelete(mutex_file);
 }
 //###################################################################
 void Audio::initInBuff() {
@@ -549,6 +553,7 @@ uint32_t Audio::stopSong(){
         }
         // if(_client->connected()) _client->stop();
     }
+    readAheadStop(true);                // the ring is internal RAM a webstream's TLS needs
     if(audiofile) {
         // added this before putting 'm_f_localfile = false' in stopSong(); should never occur....
         AUDIO_INFO("Closing audio file \"%s\"", audiofile.name());
@@ -831,6 +836,7 @@ size_t Audio::sendBytes(uint8_t* data, size_t len){
         bytesDecoded += chunk_length;
     }
     data_mode_off();
+    if(bytesDecoded && m_ttfs.once(Ttfs::OUTPUT, millis()) && audio_ttfs) audio_ttfs(m_ttfs);   // the chip decodes itself
     return bytesDecoded;
 }
 //##################################################################
@@ -1091,7 +1097,12 @@ void Audio::processLocalFile() {
     }
     availableBytes = InBuff.writeSpace();
 
-    int32_t bytesAddedToBuffer = audiofile.read(InBuff.getWritePtr(), availableBytes);
+    int32_t bytesAddedToBuffer;
+    if(m_f_readAhead) {
+        bytesAddedToBuffer = m_ra.take(InBuff.getWritePtr(), availableBytes);
+        if(bytesAddedToBuffer > 0) xTaskNotifyGive(m_raTask); // a block may be free for the next read
+    }
+    else bytesAddedToBuffer = audiofile.read(InBuff.getWritePtr(), availableBytes);
     if(bytesAddedToBuffer > 0) {InBuff.bytesWritten(bytesAddedToBuffer);}
 
     if(!m_f_stream) {
@@ -1115,7 +1126,9 @@ void Audio::processLocalFile() {
         }
         else {
             m_f_stream = true;
+            m_ttfs.once(Ttfs::PREBUFFER, millis());
             AUDIO_INFO("stream ready");
+            readAheadStart(audiofile.position()); // the header is read, from here on the file is read in blocks
             }
     }
 
@@ -1125,6 +1138,7 @@ void Audio::processLocalFile() {
     }
 
     if(m_resumeFilePos >= 0) {
+        readAheadStop();                                  // the resume position is looked for in the file
         if(m_resumeFilePos <  (int32_t)m_audioDataStart) m_resumeFilePos = m_audioDataStart;
         if(m_resumeFilePos >= (int32_t)m_audioDataStart + m_audioDataSize) {goto exit;}
         m_haveNewFilePos = m_resumeFilePos;
@@ -1140,6 +1154,7 @@ void Audio::processLocalFile() {
             while(m_f_audioTaskIsDecoding) vTaskDelay(1); // We can't reset the InBuffer while the decoding is in progress
             audiofile.seek(m_resumeFilePos);
             InBuff.resetBuffer();
+            readAheadStart(m_resumeFilePos);
             m_sumBytesDecoded = m_haveNewFilePos = m_resumeFilePos;
             m_resumeFilePos = -1;
 //            if(m_codec == CODEC_MP3) MP3Decoder_ClearBuffer();
@@ -1148,10 +1163,12 @@ void Audio::processLocalFile() {
 
     // end of file reached? - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_eof){ // m_f_eof and m_f_ID3v1TagFound will be set in playAudioData()
+        readAheadStop();
         if(m_f_loop){ // file loop
             m_sumBytesDecoded = m_haveNewFilePos = m_audioDataStart;
             audiofile.seek(m_audioDataStart);
             InBuff.resetBuffer();
+            readAheadStart(m_audioDataStart);
             AUDIO_INFO("file loop");
             m_f_eof = false;
             return;
@@ -1189,33 +1206,76 @@ log_w("");
    }
 }
 //##################################################################
+void Audio::readAheadStart(uint32_t pos) { // the player's task, audiofile is at pos
+#if SD_READAHEAD_KB > 0
+    if(!m_raMem) {
+        if(heap_caps_get_free_size(MALLOC_CAP_DMA) >= SD_READAHEAD_KB * 1024 + I2S_DMA_MIN_HEAP)
+            m_raMem = (uint8_t*)heap_caps_malloc(SD_READAHEAD_KB * 1024, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if(!m_raMem || !m_ra.begin(m_raMem, SD_READAHEAD_KB * 1024, SD_READAHEAD_BLOCK)) {
+            log_w("no memory for the read-ahead, the file is read directly");
+            return;
+        }
+    }
+    if(!m_ra.ready()) return;
+    if(!m_raTask) xTaskCreatePinnedToCore(readAheadTask, "ReadAhead", 3072, this, SD_READAHEAD_PRIORITY, &m_raTask, SD_READAHEAD_CORE_ID);
+    if(!m_raTask) return;
+    xSemaphoreTake(mutex_file, portMAX_DELAY);
+    m_ra.reset(pos, audiofile.size());
+    m_f_readAhead = true;
+    xSemaphoreGive(mutex_file);
+    xTaskNotifyGive(m_raTask);
+#endif
+}
+//##################################################################
+void Audio::readAheadStop(bool release) { // when it returns the task is out of the file, audiofile is the caller's again
+    if(m_f_readAhead) {
+        xSemaphoreTake(mutex_file, portMAX_DELAY);
+        m_f_readAhead = false;
+        xSemaphoreGive(mutex_file);
+    }
+    if(release && m_raMem) {m_ra.end(); heap_caps_free(m_raMem); m_raMem = NULL;} // begin() again at the next start
+}
+//##################################################################
+bool Audio::readAheadFill() { // one block from the card into the ring, false: nothing to do
+    bool done = false;
+    xSemaphoreTake(mutex_file, portMAX_DELAY);
+    uint32_t pos, len;
+    uint8_t* dst = m_f_readAhead ? m_ra.space(&pos, &len) : NULL;
+    if(dst) {
+        if(audiofile.position() != pos) audiofile.seek(pos);
+        m_ra.filled(audiofile.read(dst, len));
+        done = true;
+    }
+    xSemaphoreGive(mutex_file);
+    return done;
+}
+//##################################################################
+void Audio::readAheadTask(void* param) {
+    Audio* audio = static_cast<Audio*>(param);
+    for(;;) {
+        if(!audio->readAheadFill()) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50)); // the player took a block or a new file began
+    }
+}
+//##################################################################
 void Audio::processWebStream() {
 
     if(m_dataMode != AUDIO_DATA) return; // guard
 
     const uint16_t  maxFrameSize = InBuff.getMaxBlockSize();    // every mp3/aac frame is not bigger
-    static uint32_t chunkSize;                                  // chunkcount read from stream
 
     // first call, set some values to default  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_firstCall) { 						// runs only ont time per connection, prepare for start
         m_f_firstCall = false;
         m_f_stream = false;
-        chunkSize = 0;
         m_metacount = m_metaint;
-        readMetadata(0, true); 					// reset all static vars
+        readMetadata(true); 					// reset all static vars
     }
 
-    uint32_t availableBytes = _client->available(); 		// available from stream
+    uint32_t availableBytes = bodyAvailable(); 		// available from stream, chunked framing included (readBody takes it out)
 
-    // chunked data transfer - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_f_chunked && availableBytes){
-        uint8_t readedBytes = 0;
-        if(!chunkSize) chunkSize = chunkedDataTransfer(&readedBytes);
-        availableBytes = min(availableBytes, chunkSize);
-    }
     // we have metadata  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_metadata && availableBytes){
-        if(m_metacount == 0) {chunkSize -= readMetadata(availableBytes); return;}
+        if(m_metacount == 0) {readMetadata(); return;}
         availableBytes = min(availableBytes, m_metacount);
     }
 
@@ -1227,11 +1287,12 @@ void Audio::processWebStream() {
     // buffer fill routine - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(availableBytes) {
         availableBytes = min(availableBytes, (uint32_t)InBuff.writeSpace());
-        int32_t bytesAddedToBuffer = _client->read(InBuff.getWritePtr(), availableBytes);
+        int32_t bytesAddedToBuffer = readBody(InBuff.getWritePtr(), availableBytes);
+        if(bytesAddedToBuffer < 0) {stopSong(); return;}
 
         if(bytesAddedToBuffer > 0) {
             if(m_f_metadata) m_metacount  -= bytesAddedToBuffer;
-            if(m_f_chunked)   chunkSize    -= bytesAddedToBuffer;
+            if(audio_process_stream) audio_process_stream(InBuff.getWritePtr(), bytesAddedToBuffer);
             InBuff.bytesWritten(bytesAddedToBuffer);
         }
     }
@@ -1246,6 +1307,7 @@ void Audio::processWebStream() {
         }
         AUDIO_INFO("stream ready");
         m_f_stream = true; 							// ready to play the audio data
+        m_ttfs.once(Ttfs::PREBUFFER, millis());
 
     }
 }
@@ -1257,21 +1319,17 @@ void Audio::processWebStreamTS() {
     static bool     f_firstPacket;
     static bool     f_chunkFinished;
     static bool     f_nextRound;
-    static uint32_t byteCounter;                                // count received data
     static uint8_t  ts_packet[188];                             // m3u8 transport stream is 188 bytes long
     uint8_t         ts_packetStart = 0;
     uint8_t         ts_packetLength = 0;
     static uint8_t  ts_packetPtr = 0;
     const uint8_t   ts_packetsize = 188;
-    static size_t   chunkSize = 0;
 
     // first call, set some values to default - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_firstCall) { 						// runs only ont time per connection, prepare for start
         f_firstPacket = true;
         f_chunkFinished = false;
         f_nextRound = false;
-        byteCounter = 0;
-        chunkSize = 0;
         m_t0 = millis();
         ts_packetPtr = 0;
         m_controlCounter = 0;
@@ -1281,24 +1339,20 @@ void Audio::processWebStreamTS() {
     if(m_dataMode != AUDIO_DATA) return;        	// guard
 
 nextRound:
-    availableBytes = _client->available();
+    availableBytes = bodyAvailable();
     if(availableBytes){
 
-        /* If the m3u8 stream uses 'chunked data transfer' no content length is supplied. Then the chunk size determines the audio data to be processed.
-           However, the chunk size in some streams is limited to 32768 bytes, although the chunk can be larger. Then the chunk size is
-           calculated again. The data used to calculate (here readedBytes) the chunk size is not part of it.
-        */
-        uint8_t readedBytes = 0;
-        uint32_t minAvBytes = 0;
-        if(m_f_chunked && chunkSize == byteCounter) {chunkSize += chunkedDataTransfer(&readedBytes); goto exit;}
-        if(chunkSize) minAvBytes = min3(availableBytes, ts_packetsize - ts_packetPtr, chunkSize - byteCounter);
-        else          minAvBytes = min(availableBytes, (uint32_t)(ts_packetsize - ts_packetPtr));
-
-        int res = _client->read(ts_packet + ts_packetPtr, minAvBytes);
+        // readBody stops at the end of the segment and takes the chunked framing out, wherever it falls in the packet
+        uint32_t minAvBytes = min(availableBytes, (uint32_t)(ts_packetsize - ts_packetPtr));
+
+        int res = readBody(ts_packet + ts_packetPtr, minAvBytes);
+        if(res < 0) {stopSong(); return;}
         if(res > 0){
             ts_packetPtr += res;
-            byteCounter += res;
-            if(ts_packetPtr < ts_packetsize)  return; // not enough data yet, the process must be repeated if the packet size (188 bytes) is not reached
+            if(ts_packetPtr < ts_packetsize) {   // not enough data yet, the process must be repeated if the packet size (188 bytes) is not reached
+                if(m_http.done()) {f_chunkFinished = true; ts_packetPtr = 0;} // a packet cut off at the end of the segment
+                return;
+            }
             ts_packetPtr = 0;
             if(f_firstPacket){  				// search for ID3 Header in the first packet
                 f_firstPacket = false;
@@ -1330,15 +1384,10 @@ nextRound:
                     InBuff.bytesWritten(ts_packetLength -ws);
                 }
             }
-            if(byteCounter == m_contentlength  || byteCounter == chunkSize){
-                f_chunkFinished = true;
-                f_nextRound = false;
-                byteCounter = 0;
-                int av = _client->available();
-                if(av == 7) for(int i = 0; i < av; i++) _client->read(); // waste last chunksize: 0x0D 0x0A 0x30 0x0D 0x0A 0x0D 0x0A (==0, end of chunked data transfer)
-            }
-            if(m_contentlength && byteCounter > m_contentlength) {log_e("byteCounter overflow, byteCounter: %d, contentlength: %d", byteCounter, m_contentlength); return;}
-            if(chunkSize       && byteCounter > chunkSize)       {log_e("byteCounter overflow, byteCounter: %d, chunkSize: %d",     byteCounter, chunkSize); return;}
+        }
+        if(m_http.done()){ 						// end of the segment, the last chunk may come without payload
+            f_chunkFinished = true;
+            f_nextRound = false;
         }
     }
     if(f_chunkFinished) {
@@ -1363,6 +1412,7 @@ nextRound:
     if(true) { 										// statement has no effect
         if(InBuff.bufferFilled() > 60000 && !m_f_stream) {		  	// waiting for buffer filled
             m_f_stream = true; 								// ready to play the audio data
+            m_ttfs.once(Ttfs::PREBUFFER, millis());
             uint16_t filltime = millis() - m_t0;
             AUDIO_INFO("stream ready");
             AUDIO_INFO("buffer filled in %d ms", filltime);
@@ -1381,8 +1431,6 @@ void Audio::processWebStreamHLS() {
     uint32_t        availableBytes; 				// available bytes in stream
     static bool     firstBytes;
     static bool     f_chunkFinished;
-    static uint32_t byteCounter; 				// count received data
-    static size_t   chunkSize = 0;
     static uint16_t ID3WritePtr;
     static uint16_t ID3ReadPtr;
     static uint8_t* ID3Buff;
@@ -1392,8 +1440,6 @@ void Audio::processWebStreamHLS() {
         m_f_firstCall = false;
         m_f_m3u8data = true;
         f_chunkFinished = false;
-        byteCounter = 0;
-        chunkSize = 0;
         ID3WritePtr = 0;
         ID3ReadPtr = 0;
         m_t0 = millis();
@@ -1405,15 +1451,13 @@ void Audio::processWebStreamHLS() {
 
     if(m_dataMode != AUDIO_DATA) return;        // guard
 
-    availableBytes = _client->available();
+    availableBytes = bodyAvailable();
     if(availableBytes){ 						// an ID3 header could come here
-        uint8_t readedBytes = 0;
-
-        if(m_f_chunked && !chunkSize) {chunkSize = chunkedDataTransfer(&readedBytes); byteCounter += readedBytes;}
-
         if(firstBytes){
             if(ID3WritePtr < ID3BuffSize){
-                ID3WritePtr += _client->readBytes(&ID3Buff[ID3WritePtr], ID3BuffSize - ID3WritePtr);
+                int32_t res = readBody(&ID3Buff[ID3WritePtr], ID3BuffSize - ID3WritePtr);
+                if(res < 0) {stopSong(); return;}
+                ID3WritePtr += res;
                 return;
             }
             if(m_controlCounter < 100){
@@ -1436,25 +1480,15 @@ void Audio::processWebStreamHLS() {
                 InBuff.bytesWritten(ID3BuffSize - (ID3ReadPtr + ws));
             }
             x_ps_free(&ID3Buff);
-            byteCounter += ID3BuffSize;
             ID3Buff = NULL;
             firstBytes = false;
         }
 
-        size_t bytesWasWritten = 0;
-        if(InBuff.writeSpace() >= availableBytes){
-//            if(availableBytes > 1024) availableBytes = 1024; 					// 1K throttle
-            bytesWasWritten = _client->read(InBuff.getWritePtr(), availableBytes);
-        }
-        else{ bytesWasWritten = _client->read(InBuff.getWritePtr(), InBuff.writeSpace()); }
+        int32_t bytesWasWritten = readBody(InBuff.getWritePtr(), min(availableBytes, (uint32_t)InBuff.writeSpace()));
+        if(bytesWasWritten < 0) {stopSong(); return;}
         InBuff.bytesWritten(bytesWasWritten);
 
-        byteCounter += bytesWasWritten;
-
-        if(byteCounter == m_contentlength || byteCounter == chunkSize){
-            f_chunkFinished = true;
-            byteCounter = 0;
-        }
+        if(m_http.done()) f_chunkFinished = true; 		// end of the segment
     }
 
     if(f_chunkFinished) {
@@ -1474,6 +1508,7 @@ void Audio::processWebStreamHLS() {
 
     if(InBuff.bufferFilled() > maxFrameSize && !m_f_stream) { 			// waiting for buffer filled
         m_f_stream = true; 									// ready to play the audio data
+        m_ttfs.once(Ttfs::PREBUFFER, millis());
         uint16_t filltime = millis() - m_t0;
         AUDIO_INFO("stream ready");
         if(m_f_Log) AUDIO_INFO("buffer filled in %d ms", filltime);
@@ -1485,7 +1520,6 @@ void Audio::processWebFile(){
     if(!m_lastHost) {log_e("m_lastHost is NULL"); return;}   		// guard
     const uint32_t  maxFrameSize = InBuff.getMaxBlockSize();    // every mp3/aac frame is not bigger
  //   static uint32_t byteCounter;                                // count received data
-    static uint32_t chunkSize;                                  // chunkcount read from stream
     static size_t   audioDataCount;                             // counts the decoded audiodata only
     static uint32_t byteCounter;                             // count received data
 
@@ -1494,7 +1528,6 @@ void Audio::processWebFile(){
         m_f_firstCall = false;
         m_t0 = millis();
         byteCounter = 0;
-        chunkSize = 0;
         audioDataCount = 0;
         m_f_stream = false;
         m_audioDataSize = m_contentlength;
@@ -1503,19 +1536,9 @@ void Audio::processWebFile(){
 
 //    if(!m_contentlength && !m_f_tts) {log_e("webfile without contentlength!"); stopSong(); return;} 		// guard
 
-    uint32_t availableBytes = _client->available(); 					// available from stream
+    uint32_t availableBytes = bodyAvailable(); 					// available from stream
 
-    // chunked data tramsfer - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_f_chunked && availableBytes) {
-        uint8_t readedBytes = 0;
-        if(m_f_chunked && chunkSize == byteCounter) {
-            chunkSize += chunkedDataTransfer(&readedBytes);
-            m_contentlength += chunkSize;
-        }
-        availableBytes = min(availableBytes, chunkSize - byteCounter);
-    }
-
-    if(!m_contentlength && !chunkSize) {
+    if(!m_contentlength && !m_f_chunked) {
         log_e("webfile is not chunked or is without contentlength!");
         stopSong();
         return;
@@ -1524,19 +1547,20 @@ void Audio::processWebFile(){
     // if the buffer is often almost empty issue a warning - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_stream) {if(streamDetection(availableBytes)) return;}
     availableBytes = min(availableBytes, (uint32_t)InBuff.writeSpace());
-    int32_t bytesAddedToBuffer = _client->read(InBuff.getWritePtr(), availableBytes);
+    int32_t bytesAddedToBuffer = readBody(InBuff.getWritePtr(), availableBytes);
+    if(bytesAddedToBuffer < 0) {stopSong(); return;}
 
     if(bytesAddedToBuffer > 0) {
         m_webFilePos += bytesAddedToBuffer;
         byteCounter += bytesAddedToBuffer;
-        if(m_f_chunked) m_chunkcount -= bytesAddedToBuffer;
         if(m_controlCounter == 100) audioDataCount += bytesAddedToBuffer;
         InBuff.bytesWritten(bytesAddedToBuffer);
     }
+    if(m_f_chunked) m_contentlength = byteCounter + m_http.left(); 	// as far as the chunk sizes tell, all of it once done
 
     // // if we have a webfile, read the file header first - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter != 100) {
-        if(InBuff.bufferFilled() > maxFrameSize || (InBuff.bufferFilled() == m_contentlength)) { // at least one complete frame or the file is smaller
+        if(InBuff.bufferFilled() > maxFrameSize || (m_contentlength && InBuff.bufferFilled() == m_contentlength)) { // at least one complete frame or the file is smaller
             int32_t bytesRead = readAudioHeader(InBuff.getMaxAvailableBytes());
             if(bytesRead > 0) InBuff.bytesWasRead(bytesRead);
         }
@@ -1554,6 +1578,7 @@ void Audio::processWebFile(){
 
     if(!m_f_stream && m_controlCounter == 100) {
         m_f_stream = true; // ready to play the audio data
+        m_ttfs.once(Ttfs::PREBUFFER, millis());
         uint16_t filltime = millis() - m_t0;
         AUDIO_INFO("Webfile: stream ready, buffer filled in %d ms", filltime);
         return;
@@ -1656,69 +1681,60 @@ exit:
 bool Audio::readPlayListData() {
 
     if(m_dataMode != AUDIO_PLAYLISTINIT) return false;
-    if(_client->available() == 0) return false;
+    if(bodyAvailable() == 0) return false;
 
-    uint32_t chunksize = 0;
-    uint8_t readedBytes = 0;
-    if(m_f_chunked) chunksize = chunkedDataTransfer(&readedBytes);
-
-    // reads the content of the playlist and stores it in the vector m_contentlength
-    // m_contentlength is a table of pointers to the lines
+    // reads the content of the playlist and stores it in the vector m_playlistContent
+    // m_playlistContent is a table of pointers to the lines
     char pl[512] = {0}; // playlistLine
-    uint32_t ctl  = 0;
+    uint8_t block[256]; // as readBody() delivers it, without the chunked framing
+    uint16_t pos = 0;
     int lines = 0;
+    uint32_t ctime = millis();
+    uint32_t timeout = 2000; // ms
     // delete all memory in m_playlistContent
     if(m_playlistFormat == FORMAT_M3U8 && !psramFound()) { log_e("m3u8 playlists requires PSRAM enabled!"); }
     vector_clear_and_shrink(m_playlistContent);
-    while(true){  // outer while
-
-        uint32_t ctime = millis();
-        uint32_t timeout = 2000; // ms
-
-        while(true) { // inner while
-            uint16_t pos = 0;
-            while(_client->available()){ // super inner while :-))
-                pl[pos] = _client->read();
-                ctl++;
-                if(pl[pos] == '\n') {pl[pos] = '\0'; pos++; break;}
-            //    if(pl[pos] == '&' ) {pl[pos] = '\0'; pos++; break;}
-                if(pl[pos] == '\r') {pl[pos] = '\0'; pos++; continue;;}
-                pos++;
-                if(pos == 510){ pos--; continue;}
-                if(pos == 509) {pl[pos] = '\0';}
-                if(ctl == chunksize) {pl[pos] = '\0'; break;}
-                if(ctl == m_contentlength) {pl[pos] = '\0'; break;}
+    while(true){
+        int32_t n = readBody(block, sizeof(block));
+        bool end = false;
+        if(n < 0) goto exit;
+        if(n == 0){
+            // termination conditions: the end of the body (content-length or the last chunk) or, without both,
+            // the closed connection
+            end = m_http.done() || (!_client->connected() && !bodyAvailable());
+            if(!end){
+                if(millis() - ctime > timeout) {
+                    log_e("timeout");
+                    for(int i = 0; i<m_playlistContent.size(); i++) log_e("pl%i = %s", i, m_playlistContent[i]);
+                    goto exit;
+                }
+                vTaskDelay(1);
+                continue;
             }
-            //log_w("pl %s, ctl %i, chunksize %i, m_contentlength %i", pl, ctl, chunksize, m_contentlength);
-            if(ctl == chunksize) break;
-            if(ctl == m_contentlength) break;
-            if(pos) {pl[pos] = '\0'; break;}
-
-            if(ctime + timeout < millis()) {
-                log_e("timeout");
-                for(int i = 0; i<m_playlistContent.size(); i++) log_e("pl%i = %s", i, m_playlistContent[i]);
-                goto exit;
-           }
-        } // inner while
-
-        if(startsWith(pl, "<!DOCTYPE")) {AUDIO_ERROR("url is a webpage!"); goto exit;}
-        if(startsWith(pl, "<html"))     {AUDIO_ERROR("url is a webpage!"); goto exit;}
- 
-        if(strlen(pl) > 0) m_playlistContent.push_back(x_ps_strdup(pl));
-        if(!m_f_psramFound && m_playlistContent.size() == 101){
-            AUDIO_INFO("the number of lines in playlist > 100, for bigger playlist use PSRAM!");
-            break;
+            block[0] = '\n'; // the last line may come without
+            n = 1;
         }
-        if(m_playlistContent.size() && m_playlistContent.size() % 1000 == 0) { AUDIO_INFO("current playlist line: %lu", (long unsigned)m_playlistContent.size()); }
-        // termination conditions
-        // 1. The http response header returns a value for contentLength -> read chars until contentLength is reached
-        // 2. no contentLength, but Transfer-Encoding:chunked -> compute chunksize and read until chunksize is reached
-        // 3. no chunksize and no contentlengt, but Connection: close -> read all available chars
-        if(ctl == m_contentlength){while(_client->available()) _client->read(); break;} // read '\n\n' if exists
-        if(ctl == chunksize)      {while(_client->available()) _client->read(); break;}
-        if(!_client->connected() && _client->available() == 0) break;
+        else ctime = millis();
 
-    } // outer while
+        for(int32_t i = 0; i < n; i++){
+            if(block[i] == '\r') continue;
+            if(block[i] != '\n') { if(pos < 509) pl[pos++] = block[i]; continue; }
+            pl[pos] = '\0';
+            pos = 0;
+
+            if(startsWith(pl, "<!DOCTYPE")) {AUDIO_ERROR("url is a webpage!"); goto exit;}
+            if(startsWith(pl, "<html"))     {AUDIO_ERROR("url is a webpage!"); goto exit;}
+
+            if(strlen(pl) > 0) m_playlistContent.push_back(x_ps_strdup(pl));
+            if(!m_f_psramFound && m_playlistContent.size() == 101){
+                AUDIO_INFO("the number of lines in playlist > 100, for bigger playlist use PSRAM!");
+                end = true;
+                break;
+            }
+            if(m_playlistContent.size() && m_playlistContent.size() % 1000 == 0) { AUDIO_INFO("current playlist line: %lu", (long unsigned)m_playlistContent.size()); }
+        }
+        if(end) break;
+    }
     lines = m_playlistContent.size();
     for (int i = 0; i < lines ; i++) { // print all string in first vector of 'arr'
     //    log_w("pl=%i \"%s\"", i, m_playlistContent[i]);
@@ -3564,205 +3580,147 @@ bool Audio::parseHttpResponseHeader() { 		// this is the response to a GET / req
     }
     f_time = false;
 
-    char rhl[512] = {0}; 					// responseHeaderline
+    // m_http takes the header as it arrives, read in blocks, and stops behind every line; the bytes read behind the
+    // header wait in m_rest (readBody)
     bool ct_seen = false;
+    m_http.begin(m_rhl, sizeof(m_rhl));
+    m_restPos = m_restLen = 0;
 
     while(true) { 							// outer while
-        uint16_t pos = 0;
         if((millis() - ctime) > timeout) {
             log_e("timeout");
             m_f_timeout = true;
             goto exit;
         }
-        while(_client->available()) {
-            uint8_t b = _client->read();
-            if(b == '\n') {
-                if(!pos) { 						// empty line received, is the last line of this responseHeader
-                    if(ct_seen) goto lastToDo;
-                    else goto exit;
-                }
-                break;
-            }
-            if(b == '\r') rhl[pos] = 0;
-            if(b < 0x20) continue;
-            rhl[pos] = b;
-            pos++;
-            if(pos == 511) { pos = 510; continue; }
-            if(pos == 510) { rhl[pos] = '\0';
-                if(m_f_Log) log_i("responseHeaderline overflow");
-            }
-        } // inner while
-
-        if(!pos) { vTaskDelay(5); continue; }
-
-        int16_t posColon = indexOf(rhl, ":", 0); 	// lowercase all letters up to the colon
-        if(posColon >= 0) {
-            for(int i = 0; i < posColon; i++) { rhl[i] = toLowerCase(rhl[i]); }
-        }
-
-        if(startsWith(rhl, "HTTP/")) { 			// HTTP status error code
-            char statusCode[5];
-            statusCode[0] = rhl[9];
-            statusCode[1] = rhl[10];
-            statusCode[2] = rhl[11];
-            statusCode[3] = '\0';
-            int sc = atoi(statusCode);
-            if(sc > 310) { 					// e.g. HTTP/1.1 301 Moved Permanently
-                if(audio_showstreamtitle) audio_showstreamtitle(rhl);
-                AUDIO_ERROR(" %s", rhl);
+        if(m_restPos == m_restLen) {
+            int av = _client->available();
+            int r = av > 0 ? _client->read(m_rest, min(av, (int)sizeof(m_rest))) : 0;
+            if(r <= 0) { vTaskDelay(5); continue; }
+            m_restPos = 0;
+            m_restLen = r;
+        }
+        uint32_t used;
+        int8_t   ev = m_http.head((const char*)m_rest + m_restPos, m_restLen - m_restPos, used);
+        m_restPos += used;
+        if(ev == HttpParser::MORE) continue;
+        if(ev == HttpParser::FAILED) { AUDIO_INFO("no HTTP response from %s", m_lastHost); goto exit; }
+        if(ev == HttpParser::END) { 			// empty line received, is the last line of this responseHeader
+            m_ttfs.mark(Ttfs::HEADERS, millis());
+            if(ct_seen) goto lastToDo;
+            else goto exit;
+        }
+        if(ev == HttpParser::STATUS) { 		// HTTP status error code
+            if(m_http.status() > 310) { 			// e.g. HTTP/1.1 404 Not Found
+                if(audio_showstreamtitle) audio_showstreamtitle(m_http.line());
+                AUDIO_ERROR(" %s", m_http.line());
                 goto exit;
             }
+            continue;
         }
 
-        else if(startsWith(rhl, "content-type:")) { 				// content-type: text/html; charset=UTF-8
-            // log_w("cT: %s", rhl);
-            int idx = indexOf(rhl + 13, ";");
-            if(idx > 0) rhl[13 + idx] = '\0';
-            if(parseContentType(rhl + 13)) ct_seen = true;
-            else{
-                AUDIO_ERROR("unknown contentType %s", rhl + 13);
-                goto exit;
+        char* val = m_http.value(); 				// the name is lowercased and known ones are m_http.field()
+        switch(m_http.field()) {
+            case HttpParser::H_CONTENT_TYPE: { 		// content-type: text/html; charset=UTF-8
+                int idx = indexOf(val, ";");
+                if(idx > 0) val[idx] = '\0';
+                if(parseContentType(val)) ct_seen = true;
+                else{
+                    AUDIO_ERROR("unknown contentType %s", val);
+                    goto exit;
+                }
+                break;
             }
-        }
-
-        else if(startsWith(rhl, "location:")) {
-            int pos = indexOf(rhl, "http", 0);
-            if(pos >= 0) {
-                const char* c_host = (rhl + pos);
-                if(strcmp(c_host, m_lastHost) != 0) { // prevent a loop
-                    int pos_slash = indexOf(c_host, "/", 9);
-                    if(pos_slash > 9) {
-                        if(!strncmp(c_host, m_lastHost, pos_slash)) {
-                            AUDIO_INFO("redirect to new extension at existing host \"%s\"", c_host);
-                            if(m_playlistFormat == FORMAT_M3U8) {
-                                x_ps_free(&m_lastHost);
-                                m_lastHost = x_ps_strdup(c_host);
-                                m_f_m3u8data = true;
-                            }
-                            httpPrint(c_host);
-                            while(_client->available()) _client->read(); 	// empty client buffer
-                            return true;
-                        }
+            case HttpParser::H_LOCATION: {
+                int pos = indexOf(val, "http", 0);
+                if(pos < 0) break;
+                const char* c_host = (val + pos);
+                if(strcmp(c_host, m_lastHost) == 0) break; 	// prevent a loop
+                int pos_slash = indexOf(c_host, "/", 9);
+                if(pos_slash > 9 && !strncmp(c_host, m_lastHost, pos_slash)) {
+                    AUDIO_INFO("redirect to new extension at existing host \"%s\"", c_host);
+                    if(m_playlistFormat == FORMAT_M3U8) {
+                        x_ps_free(&m_lastHost);
+                        m_lastHost = x_ps_strdup(c_host);
+                        m_f_m3u8data = true;
                     }
-                    AUDIO_INFO("redirect to new host \"%s\"", c_host);
-                    connecttohost(c_host);
+                    httpPrint(c_host);
+                    while(_client->available()) _client->read(); 	// empty client buffer
                     return true;
                 }
+                AUDIO_INFO("redirect to new host \"%s\"", c_host);
+                connecttohost(c_host);
+                return true;
             }
-        }
-
-        else if(startsWith(rhl, "content-encoding:")) {
-            if(indexOf(rhl, "gzip")) {
-                AUDIO_INFO("can't extract gzip");
-                goto exit;
-            }
-        }
-
-        else if(startsWith(rhl, "content-disposition:")) {
-            int pos1, pos2; // pos3;
-            // e.g we have this headerline:  content-disposition: attachment; filename=stream.asx
-            // filename is: "stream.asx"
-            pos1 = indexOf(rhl, "filename=", 0);
-            if(pos1 > 0) {
-                pos1 += 9;
-                if(rhl[pos1] == '\"') pos1++; 				// remove '\"' around filename if present
-                pos2 = strlen(rhl);
-                if(rhl[pos2 - 1] == '\"') rhl[pos2 - 1] = '\0';
-            }
-            AUDIO_INFO("Filename is %s", rhl + pos1);
-        }
-
-        else if(startsWith(rhl, "connection:")) {
-            if(indexOf(rhl, "close", 0) >= 0) { ; /* do nothing */ }
-        }
-
-        else if(startsWith(rhl, "icy-genre:")) {
-            ; // do nothing Ambient, Rock, etc
-        }
-
-        else if(startsWith(rhl, "icy-logo:")) {
-            char* c_icylogo = (rhl + 9); 					// Get logo URL
-            trim(c_icylogo);
-            if(strlen(c_icylogo) > 0) {
-                if(m_f_Log) AUDIO_INFO("icy-logo: %s", c_icylogo);
-                if(audio_icylogo) audio_icylogo(c_icylogo);
-            }
-        }
-
-        else if(startsWith(rhl, "icy-br:")) {
-            const char* c_bitRate = (rhl + 7);
-            int32_t     br = atoi(c_bitRate); 				// Found bitrate tag, read the bitrate in Kbit
-            br = br * 1000;
-       h_bitRate = br;
-//            setBitrate(br);
-//            sprintf(m_chbuf, "%lu", (long unsigned int)getBitRate());
-            sprintf(m_chbuf, "%lu", (long unsigned int)h_bitRate);
-            if(audio_bitrate) audio_bitrate(m_chbuf);
-        }
-
-        else if(startsWith(rhl, "icy-metaint:")) {
-            const char* c_metaint = (rhl + 12);
-            int32_t     i_metaint = atoi(c_metaint);
-            m_metaint = i_metaint;
-            if(m_metaint) m_f_metadata = true; 			// Multimediastream
-        }
-
-        else if(startsWith(rhl, "icy-name:")) {
-            char* c_icyname = (rhl + 9); 					// Get station name
-            trim(c_icyname);
-            if(strlen(c_icyname) > 0) {
-                if(m_f_Log) AUDIO_INFO("icy-name: %s", c_icyname);
-                if(audio_showstation) audio_showstation(c_icyname);
-            }
-        }
-
-        else if(startsWith(rhl, "content-length:")) {
-            const char* c_cl = (rhl + 15);
-            int32_t     i_cl = atoi(c_cl);
-            m_contentlength = i_cl;
-            m_streamType = ST_WEBFILE; 					// Stream comes from a fileserver
-            if(m_f_Log) AUDIO_INFO("content-length: %lu", (long unsigned int)m_contentlength);
-        }
-
-        else if(startsWith(rhl, "icy-description:")) {
-            const char* c_idesc = (rhl + 16);
-            while(c_idesc[0] == ' ') c_idesc++;
-            latinToUTF8(rhl, sizeof(rhl)); 					// if already UTF-8 do nothing, otherwise convert to UTF-8
-            if(strlen(c_idesc) > 0 && specialIndexOf((uint8_t*)c_idesc, "24bit", 0) > 0) {
-                AUDIO_INFO("icy-description: %s has to be 8 or 16", c_idesc);
-                stopSong();
+            case HttpParser::H_CONTENT_ENCODING:
+                if(indexOf(val, "gzip", 0) >= 0) {
+                    AUDIO_INFO("can't extract gzip");
+                    goto exit;
+                }
+                break;
+            case HttpParser::H_CONTENT_DISPOSITION: { 	// e.g content-disposition: attachment; filename=stream.asx
+                int pos = indexOf(val, "filename=", 0);
+                if(pos < 0) break;
+                char* fn = val + pos + 9;
+                if(fn[0] == '\"') fn++; 				// remove '\"' around filename if present
+                int len = strlen(fn);
+                if(len && fn[len - 1] == '\"') fn[len - 1] = '\0';
+                AUDIO_INFO("Filename is %s", fn);
+                break;
             }
-            if(audio_icydescription) audio_icydescription(c_idesc);
-        }
-
-        else if(startsWith(rhl, "transfer-encoding:")) {
-            if(endsWith(rhl, "chunked") || endsWith(rhl, "Chunked")) { 	// Station provides chunked transfer
-                m_f_chunked = true;
-                AUDIO_INFO("chunked data transfer");
-                m_chunkcount = 0; 								// Expect chunkcount in DATA
+            case HttpParser::H_ICY_LOGO: 				// Get logo URL
+                if(strlen(val) > 0) {
+                    if(m_f_Log) AUDIO_INFO("icy-logo: %s", val);
+                    if(audio_icylogo) audio_icylogo(val);
+                }
+                break;
+            case HttpParser::H_ICY_BR: {
+                int32_t br = atoi(val); 				// Found bitrate tag, read the bitrate in Kbit
+                br = br * 1000;
+                h_bitRate = br;
+                sprintf(m_chbuf, "%lu", (long unsigned int)h_bitRate);
+                if(audio_bitrate) audio_bitrate(m_chbuf);
+                break;
             }
+            case HttpParser::H_ICY_METAINT:
+                m_metaint = atoi(val);
+                if(m_metaint) m_f_metadata = true; 			// Multimediastream
+                break;
+            case HttpParser::H_ICY_NAME: 				// Get station name
+                if(strlen(val) > 0) {
+                    if(m_f_Log) AUDIO_INFO("icy-name: %s", val);
+                    if(audio_showstation) audio_showstation(val);
+                }
+                break;
+            case HttpParser::H_CONTENT_LENGTH:
+                m_contentlength = atoi(val);
+                m_streamType = ST_WEBFILE; 					// Stream comes from a fileserver
+                if(m_f_Log) AUDIO_INFO("content-length: %lu", (long unsigned int)m_contentlength);
+                break;
+            case HttpParser::H_ICY_DESCRIPTION:
+                latinToUTF8(val, sizeof(m_rhl) - (val - m_rhl)); 	// if already UTF-8 do nothing, otherwise convert to UTF-8
+                if(strlen(val) > 0 && specialIndexOf((uint8_t*)val, "24bit", 0) > 0) {
+                    AUDIO_INFO("icy-description: %s has to be 8 or 16", val);
+                    stopSong();
+                }
+                if(audio_icydescription) audio_icydescription(val);
+                break;
+            case HttpParser::H_TRANSFER_ENCODING:
+                if(m_http.chunked() && !m_f_chunked) { 		// Station provides chunked transfer
+                    m_f_chunked = true;
+                    AUDIO_INFO("chunked data transfer");
+                }
+                break;
+            case HttpParser::H_ACCEPT_RANGES:
+                if(endsWith(val, "bytes")) m_f_acceptRanges = true;
+                break;
+            case HttpParser::H_ICY_URL:
+                if(audio_icyurl) audio_icyurl(val);
+                break;
+            case HttpParser::H_WWW_AUTHENTICATE:
+                AUDIO_INFO("authentification failed, wrong credentials?");
+                goto exit;
+            default: break; 						// connection, icy-genre, content-range and the like
         }
-
-        else if(startsWith(rhl, "accept-ranges:")) {
-            if(endsWith(rhl, "bytes")) m_f_acceptRanges = true;
-        //    log_w("%s", rhl);
-        }
-
-        else if(startsWith(rhl, "content-range:")) {
-        //    log_w("%s", rhl);
-        }
-
-        else if(startsWith(rhl, "icy-url:")) {
-            char* icyurl = (rhl + 8);
-            trim(icyurl);
-            if(audio_icyurl) audio_icyurl(icyurl);
-        }
-
-        else if(startsWith(rhl, "www-authenticate:")) {
-            AUDIO_INFO("authentification failed, wrong credentials?");
-            goto exit;
-        }
-        else { ; }
     } // outer while
 
 exit: // termination condition
@@ -4005,7 +3963,6 @@ void Audio::setDefaults(){
     m_bitRate=0; 				// Bitrate still unknown
     h_bitRate = 0; 				// Bitrate from header still unknown
     m_bytesNotDecoded = 0; 		// counts all not decodable bytes
-    m_chunkcount = 0; 			// for chunked streams
     m_contentlength = 0; 			// If Content-Length is known, count it
     m_metaint=0; 				// No metaint yet
     m_LFcount=0; 				// For detection end of header
@@ -4056,6 +4013,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
     char*    h_host        = NULL;
 
     xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    m_ttfs.mark(Ttfs::CALL, millis());
 
     // optional basic authorization
     if(user && pwd) authLen = strlen(user) + strlen(pwd);
@@ -4135,6 +4093,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
 
     if(res) {
         uint32_t dt = millis() - timestamp;
+        m_ttfs.mark(m_f_ssl ? Ttfs::TLS : Ttfs::CONNECT, millis());   // resolve, connect and handshake in one
         x_ps_free(&m_lastHost);
         m_lastHost = x_ps_strdup(c_host);
         AUDIO_INFO("%s has been established in %lu ms, free Heap: %lu bytes", m_f_ssl ? "SSL" : "Connection", (long unsigned int)dt, (long unsigned int)ESP.getFreeHeap());
@@ -4464,6 +4423,7 @@ bool Audio::connecttoSD(const char* sdfile, int32_t resumeFilePos) {
 bool Audio::connecttoFS(fs::FS &fs, const char* path, int32_t fileStartPos) {
 
     xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    m_ttfs.mark(Ttfs::CALL, millis());
     bool res = false;
     int16_t dotPos;
     char* audioPath = NULL;
@@ -4831,6 +4791,7 @@ uint32_t Audio::getFileSize(){ 				// returns the size of webfile or local file
 uint32_t Audio::getFilePos(){
     if(m_dataMode == AUDIO_LOCALFILE){
         if(!audiofile) return 0;
+        if(m_f_readAhead) return m_ra.position(); // what went into InBuff, the file is further ahead
         return audiofile.position();
     }
     if(m_streamType == ST_WEBFILE){
@@ -5236,47 +5197,70 @@ bool Audio::ts_parsePacket(uint8_t* packet, uint8_t* packetStart, uint8_t* packe
 //##################################################################
 //    W E B S T R E A M  -  H E L P   F U N C T I O N S
 //##################################################################
-uint16_t Audio::readMetadata(uint16_t maxBytes, bool first) {
-
+int32_t Audio::readBody(uint8_t* buf, uint32_t size) {
+    // the body of the response as it arrives, without the chunked framing (m_http takes it out in place); first come
+    // the bytes that were read with the end of the header. Returns the payload bytes, 0 if only framing came, -1 if
+    // the framing is broken
+    if(m_http.failed()) return -1;
+    size = m_http.want(size); 					// not into the next response on a keep-alive connection
+    uint32_t n = 0;
+    if(m_restPos < m_restLen) {
+        n = min(size, (uint32_t)(m_restLen - m_restPos));
+        memcpy(buf, m_rest + m_restPos, n);
+        m_restPos += n;
+    }
+    if(n < size) {
+        int av = _client->available();
+        if(av > 0) {
+            int r = _client->read(buf + n, min(size - n, (uint32_t)av));
+            if(r > 0) n += r;
+        }
+    }
+    n = m_http.body(buf, n);
+    if(n) m_ttfs.once(Ttfs::FIRST_BYTE, millis());
+    if(m_http.failed()) { log_e("broken chunked transfer"); return n ? n : -1; }
+    return n;
+}
+//##################################################################
+uint32_t Audio::bodyAvailable() {   // bytes to read, with the framing; none once the body is through
+    if(m_http.done()) return 0;
+    int av = _client->available();
+    return (m_restLen - m_restPos) + (av > 0 ? av : 0);
+}
+//##################################################################
+void Audio::readMetadata(bool first) {
+    // the metadata is read on top of readBody(): a chunk boundary anywhere in it (the length byte as well) is gone
+    // before it gets here
     static uint16_t pos_ml = 0;                          // determines the current position in metaline
     static uint16_t metalen = 0;
-    uint16_t res = 0;
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(first){
         pos_ml = 0;
         metalen = 0;
-        return 0;
+        return;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(!maxBytes) return 0;  				// guard
-
     if(!metalen) {
-        int b = _client->read();   			// First byte of metadata?
-        metalen = b * 16 ; 				// New count for metadata including length byte, max 4096
+        uint8_t b;
+        int32_t r;
+        while(!(r = readBody(&b, 1)) && bodyAvailable()) {;} 	// framing may come first
+        if(r != 1) return;
+        if(!b) {m_metacount = m_metaint; return;} 		// metalen is 0
+        metalen = b * 16 ; 				// New count for metadata including length byte, max 4080
         pos_ml = 0;
         m_chbuf[pos_ml] = 0; 			// Prepare for new line
-        res = 1;
     }
-    if(!metalen) {m_metacount = m_metaint; return res;} 	// metalen is 0
-    if(metalen < m_chbufSize){
-        uint16_t a = _client->readBytes(&m_chbuf[pos_ml], min((uint16_t)(metalen - pos_ml), (uint16_t)(maxBytes -1)));
-        res += a;
-        pos_ml += a;
-    }
-    else{ 							// metadata doesn't fit in m_chbuf
-        uint8_t c = 0;
-        int8_t i = 0;
-        while(pos_ml != metalen){
-            i = _client->read(&c, 1); 		// fake read
-            if(i != -1) {pos_ml++; res++;}
-            else {return res;}
+    while(pos_ml < metalen) {
+        int32_t a;
+        if(metalen < m_chbufSize) a = readBody((uint8_t*)&m_chbuf[pos_ml], metalen - pos_ml);
+        else { 							// metadata doesn't fit in m_chbuf, read over
+            uint8_t c[64];
+            a = readBody(c, min((uint16_t)(metalen - pos_ml), (uint16_t)sizeof(c)));
         }
-        m_metacount = m_metaint;
-        metalen = 0;
-        pos_ml = 0;
-        return res;
+        if(a < 0 || (!a && !bodyAvailable())) return; 	// the rest has not arrived yet
+        pos_ml += a;
     }
-    if(pos_ml == metalen) {
+    if(metalen < m_chbufSize) {
         m_chbuf[pos_ml] = '\0';
         if(strlen(m_chbuf)) {                             // Any info present?
             // metaline contains artist and song name.  For example:
@@ -5291,38 +5275,10 @@ uint16_t Audio::readMetadata(uint16_t maxBytes, bool first) {
             }
             showstreamtitle(m_chbuf);   // Show artist and title if present in metadata
         }
-        m_metacount = m_metaint;
-        metalen = 0;
-        pos_ml = 0;
-    }
-    return res;
-}
-//##################################################################
-size_t Audio::chunkedDataTransfer(uint8_t* bytes){
-    uint8_t byteCounter = 0;
-    size_t chunksize = 0;
-    int b = 0;
-    uint32_t ctime = millis();
-    uint32_t timeout = 2000; 			// ms
-    while(true){
-        if(ctime + timeout < millis()) {
-            log_e("timeout");
-            stopSong();
-            return 0;
-        }
-        b = _client->read();
-        byteCounter++;
-        if(b < 0) continue;  				// -1 no data available
-        if(b == '\n') break;
-        if(b < '0') continue;
-        // We have received a hexadecimal character.  Decode it and add to the result.
-        b = toupper(b) - '0';                       // Be sure we have uppercase
-        if(b > 9) b = b - 7;                        // Translate A..F to 10..15
-        chunksize = (chunksize << 4) + b;
     }
-    if(m_f_Log) log_i("chunksize %d", chunksize);
-    *bytes = byteCounter;
-    return chunksize;
+    m_metacount = m_metaint;
+    metalen = 0;
+    pos_ml = 0;
 }
 //##################################################################
 bool Audio::readID3V1Tag(){
@@ -6163,7 +6119,7 @@ void Audio::startAudioTask() {
         "PeriodicTask",         /* Name of the task */
         AUDIO_STACK_SIZE,       /* Stack size in words */
         this,                   /* Task input parameter */
-        2,                      /* Priority of the task */
+        AUDIO_TASK_PRIORITY,    /* Priority of the task */
         xAudioStack,            /* Task stack */
         &xAudioTaskBuffer,      /* Memory for the task's control block */
         m_audioTaskCoreId       /* Core where the task should run */
@@ -46,6 +46,9 @@
 using namespace std;
 
 #include "vs1053b-patches-flac.h"
+#include "../I2S_Audio/httpparser.h"
+#include "../I2S_Audio/ttfs.h"
+#include "../I2S_Audio/readahead.h"
 
 #define VS1053VOLM 128				// 128 or 96 only
 #define VS1053VOL(v) (VS1053VOLM==128?log10(((float)v+1)) * 50.54571334 + 128:log10(((float)v+1)) * 64.54571334 + 96)
@@ -64,6 +67,8 @@ extern __attribute__((weak)) void audio_icyurl(const char*);
 extern __attribute__((weak)) void audio_icydescription(const char*);
 extern __attribute__((weak)) void audio_lasthost(const char*);
 extern __attribute__((weak)) void audio_eof_stream(const char*); // The webstream comes to an end
+extern __attribute__((weak)) void audio_process_stream(const uint8_t* data, size_t len); // raw webstream data, without metadata
+extern __attribute__((weak)) void audio_ttfs(const Ttfs& t);   // a tune reached the first write to the VS1053, phase by phase
 
 extern __attribute__((weak)) void audio_oggimage(File& file, std::vector<uint32_t> v); //OGG blockpicture
 extern __attribute__((weak)) void audio_id3lyrics(File& file, const size_t pos, const size_t size); //ID3 metadata lyrics
@@ -240,6 +245,8 @@ public:
 //	    uint32_t   inBufferSize();   	// returns the size of the inputbuffer in bytes
     void setBufferSize(size_t mbs); // sets the size of the inputbuffer in bytes
     int getCodec() {return m_codec;}
+    Ttfs& ttfs() {return m_ttfs;}                 // time to first sound of the current tune, begun by the caller
+    bool readAheadLow() {return m_f_readAhead && m_ra.low();} // a directory scan should leave the card to the player
     const char *getCodecname() {return codecname[m_codec];}
     const char *getVersion() {return audioI2SVers;}
 
@@ -263,6 +270,7 @@ private:
 
     SemaphoreHandle_t     mutex_playAudioData;
     SemaphoreHandle_t     mutex_audioTask;
+    SemaphoreHandle_t     mutex_file;   // audiofile between the read-ahead task and the rest
     TaskHandle_t          m_audioTaskHandle = nullptr;
 
     std::vector<char*>    m_playlistContent; // m3u8 playlist buffer
@@ -380,7 +388,15 @@ private:
     bool            m_f_psramFound = false;         // set in constructor, result of psramInit()
     bool            m_f_timeout = false;            //
     int              m_LFcount;                      // Detection of end of header
-    uint32_t        m_chunkcount = 0 ;              // Counter for chunked transfer
+    HttpParser      m_http;                         // response header and chunked framing
+    Ttfs            m_ttfs;                         // phases of the current tune up to the first write to the chip
+    ReadAhead       m_ra;                           // blocks of the local file the read-ahead task read ahead of the player
+    uint8_t*        m_raMem = NULL;
+    TaskHandle_t    m_raTask = NULL;
+    volatile bool   m_f_readAhead = false;          // processLocalFile() takes from m_ra, the task owns the file position
+    char            m_rhl[512];                     // responseHeaderline, assembled by m_http
+    uint8_t         m_rest[256];                    // read behind the header, comes first in readBody()
+    uint16_t        m_restPos = 0, m_restLen = 0;
     uint32_t        m_contentlength = 0;
     uint32_t        m_bytesNotDecoded = 0;          // pictures or something else that comes with the stream
     uint32_t        m_PlayingStartTime = 0;         // Stores the milliseconds after the start of the audio
@@ -467,8 +483,9 @@ private:
   bool           m_f_audioTaskIsRunning = false;
 
   //+++ W E B S T R E A M  -  H E L P   F U N C T I O N S +++
-  uint16_t readMetadata(uint16_t b, bool first = false);
-  size_t   chunkedDataTransfer(uint8_t* bytes);
+  void     readMetadata(bool first = false);
+  int32_t  readBody(uint8_t* buf, uint32_t size);
+  uint32_t bodyAvailable();
   bool     readID3V1Tag();
   boolean  streamDetection(uint32_t bytesAvail);
   void     seek_m4a_stsz();
@@ -525,6 +542,10 @@ protected:
     bool     httpPrint(const char* host);
     bool     httpRange(const char* host, uint32_t range);
     void     processLocalFile();
+    void     readAheadStart(uint32_t pos);
+    void     readAheadStop(bool release = false);
+    bool     readAheadFill();
+    static void readAheadTask(void* param);
     void     processWebStream();
     void     processWebStreamTS();
     void     processWebStreamHLS();
@@ -18,6 +18,13 @@ SET_LOOP_TASK_STACK_SIZE(LOOP_TASK_STACK_SIZE * 1024);
 #include "core/optionschecker.h"
 #include "core/rgbled.h"
 #include "core/battery.h"
+#include "core/recorder.h"
+#include "core/relay.h"
+#include "core/pcmtap.h"
+#include "core/prefetch.h"
+#include "core/dnscache.h"
+#include "core/titlelog.h"
+#include "core/ttfslog.h"
 #include "esp_sleep.h"
 #ifdef USE_NEXTION
   #include "displays/nextion.h"
@@ -66,12 +73,16 @@ void setup() {
   if (rgbled_is_initialized()) {
     if (player.isRunning()) rgbled_playing(); else rgbled_stopped();
   }
+  #if DNS_CACHE_SIZE>0
+    dnscache.begin();
+  #endif
   network.begin();
   if (network.status != CONNECTED && network.status!=SDREADY) {
     netserver.begin();
     initControls();
     display.putRequest(DSP_START);
     while(!display.ready()) delay(10);
+    player.startTask();
     return;
   }
   if (SDC_CS!=255) {
@@ -92,6 +103,7 @@ void setup() {
   #endif
   if (config.getMode()==PM_SDCARD) player.initHeaders(config.station.url);
   player.lockOutput=false;
+  player.startTask();
   if (config.store.smartstart) {  // If smart start is enabled
     //delay(99);
     uint16_t stn = config.lastStation();
@@ -118,9 +130,11 @@ void loop() {
     battery_dim_loop();
   #endif
 
-  if (network.status == CONNECTED || network.status==SDREADY) {
-    player.loop();
-  }
+  #if !PLAYER_TASK
+    if (network.status == CONNECTED || network.status==SDREADY) {
+      player.loop();
+    }
+  #endif
   loopControls();
   netserver.loop();
 }
@@ -0,0 +1,144 @@
+#ifndef AUDIOCHAIN_H
+#define AUDIOCHAIN_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Block processing stages of plugins, run by the audio task between the night mode and the volume (I2S only).
+ * Plain C++ without Arduino dependencies, so a host harness can drive a chain of stages with PCM.
+ */
+
+struct audioFormat_t {
+  uint32_t sampleRate;    // 0 = any
+  uint8_t  channels;      // interleaved samples per frame, 0 = any
+  uint8_t  bits;          // per sample, 0 = any
+};
+
+class AudioChain;
+
+/**
+ * AudioStage Class
+ *
+ * Inherit from AudioStage, override process() (and on_format() if the stage depends on the sample rate) and
+ * register the stage with Plugin::registerStage() from the constructor of the plugin.
+ * - order: stages run in ascending order, stages of the same order by name.
+ * - latency: frames the stage delays the audio by, summed up in AudioChain::latency().
+ * - format: what the stage can process; it is skipped for other formats.
+ * A disabled stage is not in the list the audio task walks, it costs nothing.
+ */
+class AudioStage {
+public:
+  AudioStage(const char *name, int16_t order, uint16_t latency = 0, audioFormat_t format = {0, 2, 16})
+    : _name(name), _order(order), _latency(latency), _format(format) {}
+  virtual ~AudioStage() {}
+
+  /**
+   * Processes count frames in place.
+   * Location: audio task, Audio::playChunk()
+   */
+  virtual void process(int16_t *frames, uint16_t count) = 0;
+
+  /**
+   * Called before the first block of a new format and before the first block after the stage was enabled,
+   * the place to compute coefficients and clear the state.
+   * Location: audio task, Audio::playChunk()
+   */
+  virtual void on_format(const audioFormat_t &format) {}
+
+  void enable(bool on);                         // from any task, taken at the next block
+  bool enabled() const { return _enabled; }
+  bool running() const { return _running; }     // enabled and the format fits
+  const char *name() const { return _name; }
+  int16_t order() const { return _order; }
+  uint16_t latency() const { return _latency; }
+  const audioFormat_t &format() const { return _format; }
+
+  bool accepts(const audioFormat_t &f) const {
+    return (!_format.sampleRate || _format.sampleRate == f.sampleRate) &&
+           (!_format.channels || _format.channels == f.channels) && (!_format.bits || _format.bits == f.bits);
+  }
+
+private:
+  friend class AudioChain;
+  const char   *_name;
+  int16_t       _order;
+  uint16_t      _latency;
+  audioFormat_t _format;
+  volatile bool _enabled = false;
+  bool          _running = false;
+  AudioChain   *_chain = nullptr;
+};
+
+class AudioChain {
+public:
+  static const uint8_t STAGES_MAX = 8;
+
+  /* at startup, before the audio task runs */
+  bool add(AudioStage *stage) {
+    if (!stage || stage->_chain || _count >= STAGES_MAX) return false;
+    uint8_t i = _count;
+    while (i > 0 && _before(stage, _stages[i - 1])) { _stages[i] = _stages[i - 1]; i--; }
+    _stages[i] = stage;
+    _count++;
+    stage->_chain = this;
+    _dirty = true;
+    return true;
+  }
+
+  void changed() { _dirty = true; }
+
+  /* audio task, once per block */
+  void process(int16_t *frames, uint16_t count, const audioFormat_t &format) {
+    if (format.sampleRate != _fmt.sampleRate || format.channels != _fmt.channels || format.bits != _fmt.bits) {
+      _fmt = format;
+      _fresh = true;
+      _dirty = true;
+    }
+    if (_dirty) _rebuild();
+    for (uint8_t i = 0; i < _active; i++) _run[i]->process(frames, count);
+  }
+
+  uint8_t count() const { return _count; }
+  AudioStage *get(uint8_t index) const { return index < _count ? _stages[index] : nullptr; }
+  uint8_t running() const { return _active; }
+  uint32_t latency() const { return _latency; }  // frames of the running stages
+
+private:
+  AudioStage   *_stages[STAGES_MAX] = {};       // all, in order
+  AudioStage   *_run[STAGES_MAX] = {};          // the running ones, walked by the audio task
+  uint8_t       _count = 0, _active = 0;
+  uint32_t      _latency = 0;
+  audioFormat_t _fmt = {0, 0, 0};
+  volatile bool _dirty = false;
+  bool          _fresh = false;
+
+  static bool _before(const AudioStage *a, const AudioStage *b) {
+    if (a->_order != b->_order) return a->_order < b->_order;
+    return strcmp(a->_name, b->_name) < 0;
+  }
+
+  void _rebuild() {
+    _dirty = false;
+    _active = 0;
+    _latency = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+      AudioStage *s = _stages[i];
+      bool run = s->_enabled && s->accepts(_fmt);
+      if (run && (!s->_running || _fresh)) s->on_format(_fmt);
+      s->_running = run;
+      if (!run) continue;
+      _run[_active++] = s;
+      _latency += s->_latency;
+    }
+    _fresh = false;
+  }
+};
+
+inline void AudioStage::enable(bool on) {
+  if (_enabled == on) return;
+  _enabled = on;
+  if (_chain) _chain->changed();
+}
+
+#endif // AUDIOCHAIN_H
@@ -9,6 +9,10 @@ void Plugin::registerPlugin() {
   pm.add(this);
 }
 
+void Plugin::registerStage(AudioStage* stage) {
+  if (!pm.audio.add(stage)) log_e("audio stage %s not added", stage ? stage->name() : "");
+}
+
 void pluginsManager::add(Plugin* plugin) {
   plugins.push_back(plugin);
 }
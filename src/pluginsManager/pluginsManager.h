@@ -5,6 +5,7 @@
 #include <vector>
 #include <functional>
 #include "../core/common.h"
+#include "audiochain.h"
 
 class pluginsManager;
 
@@ -112,6 +113,12 @@ protected:
    * Registers the plugin with the plugin manager.
    */
   void registerPlugin();
+
+  /**
+   * Adds a block processing stage to the audio chain (I2S only), see src/pluginsManager/audiochain.h.
+   * Call it from the constructor; the stage starts disabled, stage->enable(true) runs it.
+   */
+  void registerStage(AudioStage* stage);
 };
 
 class pluginsManager {
@@ -139,6 +146,12 @@ public:
   inline void on_display_player() { call_event(&Plugin::on_display_player); }
   inline void on_ticker() { call_event(&Plugin::on_ticker); }
   inline void on_btn_click(controlEvt_e &btnid) { call_event(&Plugin::on_btn_click, btnid); }
+  /**
+   * Runs the stages on stereo 16 bit frames.
+   * Location: audio_process_block(), yoRadio/src/core/audiohandlers.h
+   */
+  inline void process_audio(int16_t* frames, uint16_t count, uint32_t sampleRate) { audio.process(frames, count, {sampleRate, 2, 16}); }
+  AudioChain audio;
 private:
   std::vector<Plugin*> plugins;
 };
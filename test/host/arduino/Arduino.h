@@ -0,0 +1,50 @@
+// The part of the Arduino core and FreeRTOS the host tests of core modules need: a clock the test sets, mutexes
+// that do nothing (one thread), and tasks that only run when the test calls hostRunTasks().
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <arpa/inet.h>
+#include <functional>
+#include <vector>
+
+extern uint32_t hostMillis;
+static inline uint32_t millis() { return hostMillis; }
+static inline uint32_t esp_random() { return (uint32_t)rand() * 2654435761u; }
+
+#define constrain(v, lo, hi) ((v) < (lo) ? (lo) : ((v) > (hi) ? (hi) : (v)))
+template <class A, class B> static inline auto min(A a, B b) { return a < b ? a : b; }
+
+class IPAddress {
+  public:
+    IPAddress(uint32_t a = 0) : _a(a) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _a(a | b << 8 | c << 16 | (uint32_t)d << 24) {}
+    operator uint32_t() const { return _a; }
+    bool fromString(const char* s) { in_addr a; if(inet_pton(AF_INET, s, &a) != 1) return false; _a = a.s_addr; return true; }
+  private:
+    uint32_t _a;                                        // network order, as on the ESP32
+};
+
+typedef void* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
+#define portMAX_DELAY 0xFFFFFFFF
+static inline SemaphoreHandle_t xSemaphoreCreateMutex() { static int m; return &m; }
+static inline int xSemaphoreTake(SemaphoreHandle_t, uint32_t) { return 1; }
+static inline int xSemaphoreGive(SemaphoreHandle_t) { return 1; }
+
+struct hostTask_t { void (*fn)(void*); void* param; };
+extern std::vector<hostTask_t> hostTasks;
+static inline int xTaskCreate(void (*fn)(void*), const char*, uint32_t, void* param, int, TaskHandle_t* handle) {
+    hostTasks.push_back({fn, param});
+    if(handle) *handle = (TaskHandle_t)fn;
+    return 1;
+}
+static inline void vTaskDelete(TaskHandle_t) {}       // the last call of a task: it returns right after
+static inline int hostRunTasks() {                      // runs the tasks created so far (and theirs) to their end
+    int n = 0;
+    while(!hostTasks.empty()) { hostTask_t t = hostTasks.front(); hostTasks.erase(hostTasks.begin()); t.fn(t.param); n++; }
+    return n;
+}
@@ -0,0 +1,24 @@
+// Preferences over a map that lives as long as the test: what one instance writes the next one reads.
+#pragma once
+#include "Arduino.h"
+#include <map>
+#include <string>
+
+extern std::map<std::string, std::string> hostNvs;
+
+class Preferences {
+  public:
+    bool begin(const char* ns, bool) { _ns = ns; return true; }
+    void end() {}
+    size_t getBytesLength(const char* key) { auto i = hostNvs.find(_ns + "/" + key); return i == hostNvs.end() ? 0 : i->second.size(); }
+    size_t getBytes(const char* key, void* buf, size_t len) {
+        auto i = hostNvs.find(_ns + "/" + key);
+        if(i == hostNvs.end()) return 0;
+        size_t n = i->second.size() < len ? i->second.size() : len;
+        memcpy(buf, i->second.data(), n);
+        return n;
+    }
+    size_t putBytes(const char* key, const void* buf, size_t len) { hostNvs[_ns + "/" + key].assign((const char*)buf, len); return len; }
+  private:
+    std::string _ns;
+};
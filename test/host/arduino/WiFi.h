@@ -0,0 +1,9 @@
+// No network: the tests resolve through DnsCache::setResolver().
+#pragma once
+#include "Arduino.h"
+
+struct hostWiFi_t {
+    IPAddress dnsIP(uint8_t) { return IPAddress(); }
+    bool hostByName(const char*, IPAddress&) { return false; }
+};
+extern hostWiFi_t WiFi;
@@ -0,0 +1,9 @@
+// State behind the Arduino stubs.
+#include "Arduino.h"
+#include "Preferences.h"
+#include "WiFi.h"
+
+uint32_t hostMillis = 1000;
+std::vector<hostTask_t> hostTasks;
+std::map<std::string, std::string> hostNvs;
+hostWiFi_t WiFi;
@@ -0,0 +1,53 @@
+// Cost of Compressor::process() per sample in the blocks playChunk hands over, with music like levels that keep
+// both the compressor and the limiter busy. Cycles are the time stamp counter on x86, ns elsewhere.
+#include "check.h"
+#include "compressor.h"
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#endif
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+    const uint32_t rate = 44100, block = 1152;
+    std::vector<int16_t> src(rate * 2 * 2);
+    for(size_t f = 0; f < src.size() / 2; f++) {
+        double env = 0.2 + 0.8 * fabs(sin(2 * M_PI * 0.7 * f / rate));
+        src[f * 2] = src[f * 2 + 1] = (int16_t)(env * (20000 * sin(2 * M_PI * 220 * f / rate) + (rand() % 8000 - 4000)));
+    }
+    for(uint8_t look : {1, 2, 5}) {
+        Compressor c;
+        c.setParams(-24, 4, 5, 250, 12);
+        c.setLimiter(-1, look);
+        c.setRate(rate);
+        c.enable(true);
+        std::vector<int16_t> buf(block * 2);
+        size_t frames = src.size() / 2, at = 0;
+        double t = 0;
+        uint64_t cy = 0;
+        for(int r = 0; r < rounds; r++) {
+            std::copy(src.begin() + at * 2, src.begin() + (at + block) * 2, buf.begin());
+            at = at + 2 * block > frames ? 0 : at + block;
+            double t0 = nowUs();
+#ifdef CYCLES
+            uint64_t c0 = CYCLES();
+#endif
+            c.process(buf.data(), block);
+#ifdef CYCLES
+            cy += CYCLES() - c0;
+#endif
+            t += nowUs() - t0;
+        }
+        double samples = (double)rounds * block * 2;
+        printf("look-ahead %u ms: %6.2f ns per sample", look, t * 1000 / samples);
+#ifdef CYCLES
+        printf(", %5.1f cycles per sample", cy / samples);
+#endif
+        printf(", %.2f %% of real time, %.1f dB reduction, %u clipped\n", t / rounds / (block * 1e6 / rate) * 100,
+               c.reductionDb10() / 10.0, c.clipped());
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+// M3u8 reload cost: a live playlist and a long DVR window reloaded with the window moving on by one segment,
+// as the HLS engine does it; time and heap allocations (malloc and new) per reload, which should be none.
+#include "check.h"
+#include "m3u8.h"
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+static size_t _allocs = 0;
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void* malloc(size_t n) { _allocs++; return __libc_malloc(n); }
+extern "C" void* calloc(size_t k, size_t n) { _allocs++; return __libc_calloc(k, n); }
+extern "C" void* realloc(void* p, size_t n) { _allocs++; return __libc_realloc(p, n); }
+
+static std::string playlist(uint64_t first, int count) {
+    std::string s = "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-TARGETDURATION:10\n#EXT-X-MEDIA-SEQUENCE:" + std::to_string(first) + "\n";
+    for(int i = 0; i < count; i++) {
+        std::string n = std::to_string(first + i);
+        s += "#EXTINF:9.984,title=\"Artist - Song " + n + "\"\n#EXT-X-PROGRAM-DATE-TIME:2024-01-01T00:00:00.000Z\n"
+             "https://cdn.example.com/hls/live/radio/aac_128/segment_" + n + ".aac?session=0123456789abcdef\n";
+    }
+    return s;
+}
+
+static void run(const char* name, int count, int reloads, uint32_t piece) {
+    std::vector<std::string> texts;                         // made up front, so the heap is only used by M3u8
+    for(int r = 0; r <= reloads; r++) texts.push_back(playlist(1000 + r, count));
+    static char arena[M3U8_ARENA_SIZE];
+    M3u8 m;
+    m.begin(arena, sizeof(arena));
+    size_t bytes = 0, fresh = 0, allocs = _allocs;
+    double t0 = nowUs();
+    for(const std::string& t : texts) {
+        m.start();
+        for(size_t pos = 0; pos < t.size(); pos += piece) m.feed(t.data() + pos, t.size() - pos < piece ? t.size() - pos : piece);
+        m.finish();
+        fresh += m.diff();
+        for(uint16_t i = 0; i < m.segments(); i++) if(m.segment(i).fresh) m.take(m.segment(i));
+        bytes += t.size();
+    }
+    double us = (nowUs() - t0) / texts.size();
+    allocs = _allocs - allocs;
+    printf("%-6s %4d segments, %6zu bytes: %8.2f us per reload, %6.1f MB/s, %u kept (%u cut), %.2f new, %.2f allocations per reload\n",
+           name, count, texts[0].size(), us, bytes / (us * texts.size()), m.segments(), m.cut(), (double)fresh / texts.size(),
+           (double)allocs / texts.size());
+}
+
+int main(int argc, char** argv) {
+    int reloads = argc > 1 ? atoi(argv[1]) : 2000;
+    run("live", 6, reloads, 1436);                          // TCP segment sized reads
+    run("live", 30, reloads, 1436);
+    run("dvr", 1000, reloads / 10, 1436);                   // more than the arena holds
+    return 0;
+}
@@ -0,0 +1,27 @@
+// Time of one SpectrumFft::run() plus bands() per size, the work the spectrum task does SPECTRUM_FPS times a second.
+#include "check.h"
+#include "spectrumfft.h"
+#include <math.h>
+#include <vector>
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20000;
+    for(uint16_t n : {256, 512, 1024}) {
+        SpectrumFft fft;
+        fft.begin(n);
+        std::vector<int16_t> ring(n);
+        for(uint16_t i = 0; i < n; i++) ring[i] = (int16_t)(12000 * sin(2 * M_PI * 31.3 * i / n) + (rand() % 2000 - 1000));
+        volatile uint8_t levels[SpectrumFft::BANDS_MAX];
+        double t0 = nowUs(), tf = 0;
+        for(int r = 0; r < rounds; r++) {
+            double t = nowUs();
+            fft.run(ring.data(), r & (n - 1));
+            tf += nowUs() - t;
+            fft.bands(levels, 32, 44100);
+        }
+        double all = (nowUs() - t0) / rounds;
+        printf("%4u points: FFT %6.2f us, FFT + 32 bands %6.2f us, %5.1f ns per point\n", n, tf / rounds, all, all * 1000 / n);
+        fft.end();
+    }
+    return 0;
+}
@@ -0,0 +1,31 @@
+// TsDemux throughput: a 2 MB segment in reads of TS_BATCH packets as Audio::processWebStreamTS does them.
+#include "check.h"
+#include "tsgen.h"
+#include "tsdemux.h"
+#include <stdlib.h>
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 50;
+    TsGen g;
+    g.pat();
+    g.pmt();
+    while(g.ts.size() < 2 << 20) g.pes(1500 + rand() % 600);
+    const size_t batch = TS_PACKET_SIZE * TS_BATCH;
+    TsDemux::span_t spans[TS_BATCH];
+    uint64_t bytes = 0;
+    double t0 = nowUs();
+    for(int r = 0; r < rounds; r++) {
+        TsDemux ts;
+        for(size_t pos = 0; pos < g.ts.size(); pos += batch) {
+            size_t len = g.ts.size() - pos < batch ? g.ts.size() - pos : batch;
+            uint16_t n;
+            ts.parse(g.ts.data() + pos, len, spans, TS_BATCH, &n);
+            for(uint16_t i = 0; i < n; i++) bytes += spans[i].len;
+        }
+    }
+    double us = nowUs() - t0;
+    double packets = (double)g.ts.size() / TS_PACKET_SIZE * rounds;
+    printf("%.0f packets: %.1f MB/s of TS, %.1f ns per packet, %.2f us per batch of %d, %.1f MB of audio\n", packets,
+           g.ts.size() * (double)rounds / us, us * 1000 / packets, us * TS_BATCH / packets, TS_BATCH, bytes / 1e6);
+    return 0;
+}
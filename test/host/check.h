@@ -0,0 +1,20 @@
+// Minimal checks for the host tests: CHECK() counts failures, done() reports and returns the exit code.
+#pragma once
+#include <stdio.h>
+#include <chrono>
+
+static int _checks = 0, _failed = 0;
+
+#define CHECK(cond, ...) do {                                                   \
+    _checks++;                                                                  \
+    if(!(cond)) { _failed++; printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } \
+} while(0)
+
+static inline int done(const char* name) {
+    printf("%s: %d checks, %d failed\n", name, _checks, _failed);
+    return _failed ? 1 : 0;
+}
+
+static inline double nowUs() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,16 @@
+// What the ESP32 newlib has and an older host libc does not, forced in with -include for the modules that use it.
+#pragma once
+#include <string.h>
+
+#if defined(__GLIBC__) && !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38))
+static inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t n = strlen(src);
+    if(size) { size_t k = n < size - 1 ? n : size - 1; memcpy(dst, src, k); dst[k] = '\0'; }
+    return n;
+}
+static inline size_t strlcat(char* dst, const char* src, size_t size) {
+    size_t d = strnlen(dst, size);
+    if(d == size) return size + strlen(src);
+    return d + strlcpy(dst + d, src, size - d);
+}
+#endif
@@ -0,0 +1,91 @@
+// Driver for the fuzz targets (LLVMFuzzerTestOneInput), so they build with plain g++ too:
+//   fuzz_x [-runs=N] [-seed=S] corpus_dir_or_file...
+// runs every corpus file, then N random mutations of them (bit flips, inserts, deletes, repeats, splices).
+// Built with clang -fsanitize=fuzzer (-DLIBFUZZER) the target is a libFuzzer one and this main() is left out.
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <random>
+#include <dirent.h>
+#include <sys/stat.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// a property of the module under test that does not hold: report and crash, as libFuzzer wants it
+#define FUZZ_CHECK(cond, ...) do {                                              \
+    if(!(cond)) { fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); abort(); } \
+} while(0)
+
+#ifndef LIBFUZZER
+static void _fuzzLoad(const std::string& path, std::vector<std::vector<uint8_t>>& corpus) {
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0) { fprintf(stderr, "%s: not found\n", path.c_str()); exit(2); }
+    if(S_ISDIR(st.st_mode)) {
+        DIR* d = opendir(path.c_str());
+        std::vector<std::string> names;
+        while(struct dirent* e = readdir(d)) if(e->d_name[0] != '.') names.push_back(e->d_name);
+        closedir(d);
+        std::sort(names.begin(), names.end());
+        for(auto& n : names) _fuzzLoad(path + "/" + n, corpus);
+        return;
+    }
+    FILE* f = fopen(path.c_str(), "rb");
+    std::vector<uint8_t> data(st.st_size);
+    if(!f || fread(data.data(), 1, data.size(), f) != data.size()) { fprintf(stderr, "%s: can't read\n", path.c_str()); exit(2); }
+    fclose(f);
+    corpus.push_back(data);
+}
+
+static void _fuzzMutate(std::vector<uint8_t>& d, const std::vector<std::vector<uint8_t>>& corpus, std::mt19937& rng) {
+    int ops = 1 + rng() % 8;
+    while(ops--) {
+        size_t at = d.empty() ? 0 : rng() % d.size();
+        switch(rng() % 7) {
+            case 0: if(!d.empty()) d[at] ^= 1 << (rng() % 8); break;
+            case 1: if(!d.empty()) d[at] = rng(); break;
+            case 2: d.insert(d.begin() + at, (uint8_t)"\r\n:#,;/=\"\0 0123456789"[rng() % 21]); break;
+            case 3: if(!d.empty()) d.erase(d.begin() + at, d.begin() + at + std::min<size_t>(d.size() - at, 1 + rng() % 16)); break;
+            case 4: if(!d.empty()) {                        // repeat a piece
+                size_t n = std::min<size_t>(d.size() - at, 1 + rng() % 64);
+                std::vector<uint8_t> piece(d.begin() + at, d.begin() + at + n);
+                d.insert(d.begin() + rng() % (d.size() + 1), piece.begin(), piece.end());
+                break;
+            }
+            case 5: {                                       // splice in a piece of another input
+                const std::vector<uint8_t>& o = corpus[rng() % corpus.size()];
+                if(o.empty()) break;
+                size_t from = rng() % o.size(), n = std::min<size_t>(o.size() - from, 1 + rng() % 128);
+                d.insert(d.begin() + at, o.begin() + from, o.begin() + from + n);
+                break;
+            }
+            case 6: if(d.size() > 1) d.resize(at); break;  // cut off
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    long runs = 10000;
+    unsigned seed = 1;
+    std::vector<std::vector<uint8_t>> corpus;
+    for(int i = 1; i < argc; i++) {
+        if(!strncmp(argv[i], "-runs=", 6)) runs = atol(argv[i] + 6);
+        else if(!strncmp(argv[i], "-seed=", 6)) seed = strtoul(argv[i] + 6, NULL, 10);
+        else _fuzzLoad(argv[i], corpus);
+    }
+    if(corpus.empty()) corpus.push_back({});
+    for(auto& c : corpus) LLVMFuzzerTestOneInput(c.data(), c.size());
+    std::mt19937 rng(seed);
+    for(long r = 0; r < runs; r++) {
+        std::vector<uint8_t> d = corpus[rng() % corpus.size()];
+        _fuzzMutate(d, corpus, rng);
+        LLVMFuzzerTestOneInput(d.data(), d.size());
+    }
+    printf("%s: %zu corpus inputs, %ld mutations, seed %u\n", argv[0], corpus.size(), runs, seed);
+    return 0;
+}
+#endif
@@ -0,0 +1,104 @@
+// HttpParser fuzz target. Any bytes as a response: parsed in one piece and in small pieces it must give the same
+// events, header lines and body, with every line inside the buffer given to begin() and body() never returning
+// more than it got. The same bytes as the payload of a well formed chunked or content-length response (chunk
+// sizes, extensions, trailer and what follows drawn from them) must come out of body() unchanged.
+#include "fuzz.h"
+#include "httpparser.h"
+
+struct result_t {
+    std::string          head;                              // events and lines as they came
+    std::vector<uint8_t> body;
+    uint16_t             status;
+    int32_t              length;
+    bool                 chunked, close, done, failed;
+    uint32_t             received;
+    bool operator==(const result_t& o) const {
+        return head == o.head && body == o.body && status == o.status && length == o.length && chunked == o.chunked &&
+               close == o.close && done == o.done && failed == o.failed && received == o.received;
+    }
+};
+
+static result_t parse(const uint8_t* data, size_t size, size_t piece, uint16_t lineSize) {
+    std::vector<char> line(lineSize + 1, 'X');              // one guard byte behind the buffer
+    HttpParser p;
+    p.begin(line.data(), lineSize);
+    result_t r;
+    bool inBody = false, stop = false;
+    for(size_t pos = 0; pos < size && !stop; pos += piece) {
+        std::vector<uint8_t> buf(data + pos, data + pos + (size - pos < piece ? size - pos : piece));
+        uint32_t off = 0;
+        while(!inBody && off < buf.size()) {
+            uint32_t used;
+            int8_t ev = p.head((const char*)buf.data() + off, buf.size() - off, used);
+            FUZZ_CHECK(used <= buf.size() - off, "head() used %u of %zu", used, buf.size() - off);
+            off += used;
+            FUZZ_CHECK(line[lineSize] == 'X', "line buffer overrun");
+            if(ev == HttpParser::FAILED) { r.head += "FAILED\n"; stop = true; break; }
+            if(ev == HttpParser::MORE) { if(!used) break; continue; }
+            FUZZ_CHECK(strlen(p.line()) < lineSize, "line() not terminated in its buffer");
+            FUZZ_CHECK(p.value() >= line.data() && p.value() < line.data() + lineSize && strlen(p.value()) < lineSize, "value() outside");
+            if(ev == HttpParser::STATUS) r.head += "STATUS " + std::to_string(p.status()) + "\n";
+            if(ev == HttpParser::FIELD) r.head += std::string(p.line()) + ":" + p.value() + " (" + std::to_string(p.field()) + ")\n";
+            if(ev == HttpParser::END) { r.head += "END\n"; inBody = true; }
+        }
+        if(!inBody || stop) continue;
+        uint32_t k = p.want(buf.size() - off);
+        FUZZ_CHECK(k <= buf.size() - off, "want() %u of %zu", k, buf.size() - off);
+        uint32_t n = p.body(buf.data() + off, k);
+        FUZZ_CHECK(n <= k, "body() %u of %u", n, k);
+        r.body.insert(r.body.end(), buf.begin() + off, buf.begin() + off + n);
+        if(p.done() || p.failed() || k < buf.size() - off) stop = true;   // the rest is another response
+    }
+    r.status = p.status(); r.length = p.length(); r.chunked = p.chunked(); r.close = p.close();
+    r.done = p.done(); r.failed = p.failed(); r.received = p.received();
+    FUZZ_CHECK(r.received == r.body.size(), "received() %u, body %zu", r.received, r.body.size());
+    return r;
+}
+
+// the data as the payload of a response that is framed right
+static void roundTrip(const uint8_t* data, size_t size, uint32_t h) {
+    std::mt19937 rng(h);
+    bool chunked = rng() % 4;
+    std::string s = rng() % 2 ? "HTTP/1.1 200 OK\r\n" : "ICY 200 OK\r\n";
+    if(rng() % 3 == 0) s = "HTTP/1.1 100 Continue\r\n\r\n" + s;
+    s += "Content-Type: audio/mpeg\r\nicy-metaint: 16000\r\n";
+    if(chunked) s += rng() % 2 ? "Transfer-Encoding: chunked\r\n" : "transfer-encoding:  gzip , Chunked \r\n";
+    else s += "Content-Length: " + std::to_string(size) + "\r\n";
+    s += "\r\n";
+    if(chunked) {
+        for(size_t pos = 0; pos < size;) {
+            size_t n = std::min<size_t>(size - pos, 1 + rng() % 300);
+            char hex[16];
+            snprintf(hex, sizeof(hex), rng() % 2 ? "%zx" : "%zX", n);
+            s += (rng() % 5 ? "" : "000") + std::string(hex);
+            if(rng() % 4 == 0) s += ";name=\"value\"";
+            s += rng() % 5 ? "\r\n" : "\n";
+            s.append((const char*)data + pos, n);
+            s += "\r\n";
+            pos += n;
+        }
+        s += "0\r\n";
+        if(rng() % 2) s += "X-Trailer: 1\r\n";
+        s += "\r\n";
+    }
+    else s.append((const char*)data, size);
+    s += "HTTP/1.1 200 OK\r\n";                             // the next response on a keep-alive connection
+    for(size_t piece : {s.size(), (size_t)1 + rng() % 64}) {
+        result_t r = parse((const uint8_t*)s.data(), s.size(), piece, 256);
+        FUZZ_CHECK(r.done && !r.failed && r.status == 200, "framed response not done (piece %zu)", piece);
+        FUZZ_CHECK(r.body.size() == size && (!size || !memcmp(r.body.data(), data, size)), "payload %zu of %zu bytes (piece %zu)", r.body.size(), size, piece);
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    uint32_t h = 2166136261u;                               // the parameters come from the data, the corpus stays plain text
+    for(size_t i = 0; i < size; i++) { h ^= data[i]; h *= 16777619u; }
+    uint16_t lineSize = 16 + h % 300;
+    result_t whole = parse(data, size, size ? size : 1, lineSize);
+    for(size_t piece : {(size_t)1, (size_t)2 + (h >> 9) % 61}) {
+        result_t split = parse(data, size, piece, lineSize);
+        FUZZ_CHECK(split == whole, "pieces of %zu differ from one piece", piece);
+    }
+    roundTrip(data, size, h);
+    return 0;
+}
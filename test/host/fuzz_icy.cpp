@@ -0,0 +1,83 @@
+// Icy fuzz target. Any bytes as a metadata block: the slices parse() finds lie inside the block, title() gives
+// terminated valid UTF-8 without control characters inside any size of buffer, the same block again is nothing
+// new, '\0' padding and what lies behind it change nothing. The same bytes made into the title of a well formed
+// block (without "';" and '\0') must come out of rawTitle() unchanged, up to the blanks trimmed at both ends.
+#include "fuzz.h"
+#include "icy.h"
+
+static void inside(const Icy::slice_t& s, const char* block, size_t len, const char* what) {
+    if(!s.p) { FUZZ_CHECK(s.len == 0, "%s: no pointer, length %u", what, s.len); return; }
+    FUZZ_CHECK(s.p >= block && s.p + s.len <= block + len, "%s outside the block", what);
+}
+
+static std::string title(Icy& icy, uint16_t size) {
+    std::vector<char> out(size + 1, 'X');                   // one guard byte behind the buffer
+    uint16_t n = icy.title(out.data(), size);
+    FUZZ_CHECK(out[size] == 'X', "title() wrote behind %u bytes", size);
+    if(!size) { FUZZ_CHECK(n == 0, "title() into nothing: %u", n); return ""; }
+    FUZZ_CHECK(n < size && out[n] == '\0' && strlen(out.data()) == n, "title() %u into %u not terminated", n, size);
+    FUZZ_CHECK(Icy::validUtf8(out.data(), n), "title() not UTF-8");
+    for(uint16_t i = 0; i < n; i++) FUZZ_CHECK((uint8_t)out[i] >= 0x20, "control character in title()");
+    return std::string(out.data(), n);
+}
+
+static uint8_t parse(Icy& icy, const std::vector<char>& block) {
+    const char* p = block.empty() ? "" : block.data();     // Audio never passes NULL
+    uint8_t news = icy.parse(p, block.size());
+    inside(icy.rawTitle(), p, block.size(), "rawTitle()");
+    inside(icy.url(), p, block.size(), "url()");
+    inside(icy.adMs(), p, block.size(), "adMs()");
+    return news;
+}
+
+static std::string trim(const std::string& s) {
+    size_t a = s.find_first_not_of(" \t\r\n"), b = s.find_last_not_of(" \t\r\n");
+    return a == std::string::npos ? "" : s.substr(a, b - a + 1);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if(size > 4080) size = 4080;                            // 255 * 16, the longest block there is
+    uint32_t h = 2166136261u;
+    for(size_t i = 0; i < size; i++) { h ^= data[i]; h *= 16777619u; }
+    std::vector<char> block(data, data + size);             // exactly the block, so ASan sees any read behind it
+
+    Icy icy;
+    uint8_t news = parse(icy, block);
+    std::string whole = title(icy, 512);
+    for(uint16_t n : {(uint16_t)0, (uint16_t)1, (uint16_t)2, (uint16_t)(3 + h % 40)}) {
+        std::string cut = title(icy, n);
+        FUZZ_CHECK(n < 2 || !memcmp(whole.data(), cut.data(), cut.size()), "title() into %u is not a start of the whole", n);
+    }
+    FUZZ_CHECK(!(parse(icy, block) & (Icy::TITLE | Icy::URL)), "the same block again is new");
+    icy.reset();
+    FUZZ_CHECK(parse(icy, block) == news, "after reset() another result");
+
+    // padded to a multiple of 16 with '\0' and garbage behind it: as if it ended at the first '\0'
+    size_t nul = std::find(block.begin(), block.end(), '\0') - block.begin();
+    std::vector<char> plain(block.begin(), block.begin() + nul), padded = plain;
+    padded.resize((nul / 16 + 1) * 16, '\0');
+    padded.push_back((char)(h >> 8)); padded.push_back('\'');
+    Icy a, b;
+    FUZZ_CHECK(parse(a, plain) == parse(b, padded) && title(a, 512) == title(b, 512), "the padding changed the result");
+
+    // the bytes as the title of a well formed block
+    std::string t;
+    for(size_t i = 0; i < size; i++) {
+        char c = data[i];
+        if(c == '\0' || (c == ';' && !t.empty() && t.back() == '\'')) continue;
+        t += c;
+    }
+    std::string s = "StreamTitle='" + t + "';StreamUrl='http://radio.example.com';";
+    if(t.find("song_spot=") != std::string::npos || t.find("xml version=") != std::string::npos || t.find("<?xml") != std::string::npos) return 0;
+    std::vector<char> wf(s.begin(), s.end());
+    Icy w;
+    uint8_t got = parse(w, wf);
+    Icy::slice_t raw = w.rawTitle();
+    std::string want = trim(t);
+    FUZZ_CHECK(raw.p && std::string(raw.p, raw.len) == want, "rawTitle() of a well formed block");
+    FUZZ_CHECK((got & Icy::TITLE) && (got & Icy::URL), "a well formed block is not new");
+    std::string out = title(w, 4096);
+    if(Icy::validUtf8(want.data(), want.size()) && std::none_of(want.begin(), want.end(), [](char c) { return (uint8_t)c < 0x20; }))
+        FUZZ_CHECK(out == want, "title() of a well formed UTF-8 block");
+    return 0;
+}
@@ -0,0 +1,53 @@
+// M3u8 fuzz target: any text fed in any pieces into a small arena (so old segments are cut) must leave every
+// kept string inside the arena, resolve() must fit its documented size, and a reload of the same playlist
+// must find nothing new.
+#include "fuzz.h"
+#include "m3u8.h"
+
+static char _arena[3072];
+
+static void inArena(const char* s, const char* what) {
+    FUZZ_CHECK(s >= _arena && s < _arena + sizeof(_arena), "%s outside the arena", what);
+    FUZZ_CHECK(memchr(s, 0, _arena + sizeof(_arena) - s), "%s not terminated", what);
+}
+
+static uint8_t load(M3u8& m, const uint8_t* data, size_t size, size_t piece) {
+    m.start();
+    for(size_t pos = 0; pos < size; pos += piece) m.feed((const char*)data + pos, size - pos < piece ? size - pos : piece);
+    return m.finish();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if(!size) return 0;
+    size_t piece = 1 + data[0] % 97;                        // how the text comes in
+    data++; size--;
+    M3u8 m;
+    m.begin(_arena, sizeof(_arena));
+    uint8_t type = load(m, data, size, piece);
+    FUZZ_CHECK(type == m.type() && type <= M3u8::MEDIA, "type %u", type);
+    FUZZ_CHECK(m.variants() <= M3U8_VARIANTS, "%u variants", m.variants());
+    const char* base = "http://example.com/live/sub/index.m3u8?token=1";
+    char out[8192];
+    for(uint16_t i = 0; i < m.variants(); i++) {
+        const M3u8::variant_t& v = m.variant(i);
+        inArena(v.uri, "variant uri");
+        if(*v.codecs) inArena(v.codecs, "codecs");
+        size_t n = strlen(base) + strlen(v.uri) + 2;
+        if(n <= sizeof(out)) FUZZ_CHECK(M3u8::resolve(base, v.uri, out, n) && strlen(out) < n, "resolve %s", v.uri);
+    }
+    for(uint16_t i = 0; i < m.segments(); i++) {
+        const M3u8::segment_t& s = m.segment(i);
+        inArena(s.uri, "segment uri");
+        if(s.extinf) inArena(s.extinf, "extinf");
+        size_t n = strlen(base) + strlen(s.uri) + 2;
+        if(n <= sizeof(out)) FUZZ_CHECK(M3u8::resolve(base, s.uri, out, n) && strlen(out) < n, "resolve %s", s.uri);
+    }
+    if(type != M3u8::MEDIA || !m.segments()) return 0;
+    uint16_t fresh = m.diff();
+    FUZZ_CHECK(fresh <= m.segments(), "first load: %u of %u new", fresh, m.segments());
+    for(uint16_t i = 0; i < m.segments(); i++) m.take(m.segment(i));
+    load(m, data, size, piece % 13 + 1);                    // the same again, in other pieces
+    fresh = m.diff();
+    FUZZ_CHECK(fresh == 0, "reload: %u new", fresh);
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Abr: the throughput estimate (no zero start bias, quick to fall, slow to rise, short downloads ignored) and the
+// variant choice with its hysteresis: up only well below the estimate, with the buffer full and the hold time
+// over; down at once when the current variant no longer fits, one step when the buffer runs low.
+#include "check.h"
+#include "abr.h"
+
+static const uint32_t BW[] = { 64000, 128000, 256000, 512000 };
+static const uint32_t TARGET = 6000;                        // ms, #EXT-X-TARGETDURATION
+
+static void segment(Abr& a, uint32_t bps, uint32_t ms = 2000) { a.sample((uint64_t)bps * ms / 8000, ms); }
+
+static bool near(uint32_t v, uint32_t want) { return v > want - want / 100 && v < want + want / 100; }
+
+// an estimate of bps (up to the byte rounding): one sample after begin()
+static Abr at(uint32_t bps, uint32_t now = 0) {
+    Abr a;
+    a.begin(now);
+    segment(a, bps);
+    return a;
+}
+
+int main() {
+    // the estimate
+    {
+        Abr a;
+        a.begin(0);
+        CHECK(a.estimate() == 0, "estimate before any sample %u", a.estimate());
+        a.sample(15999, 100);
+        CHECK(a.estimate() == 0, "a short download counted: %u", a.estimate());
+        segment(a, 1000000, 500);
+        CHECK(near(a.estimate(), 1000000), "one sample: %u", a.estimate());
+        for(int i = 0; i < 10; i++) segment(a, 1000000);
+        CHECK(near(a.estimate(), 1000000), "steady: %u", a.estimate());
+
+        for(int i = 0; i < 3; i++) segment(a, 250000);     // a drop shows within three segments
+        uint32_t e = a.estimate();
+        CHECK(e < 450000, "after a drop to 250 kbit/s: %u", e);
+
+        Abr b = at(250000);
+        for(int i = 0; i < 10; i++) segment(b, 250000);
+        for(int i = 0; i < 3; i++) segment(b, 1000000);     // a rise only once it lasts
+        e = b.estimate();
+        CHECK(e > 300000 && e < 650000, "three segments after a rise to 1 Mbit/s: %u", e);
+        for(int i = 0; i < 30; i++) segment(b, 1000000);
+        CHECK(near(b.estimate(), 1000000), "a minute later: %u", b.estimate());
+    }
+
+    // no estimate or one variant: it stays
+    {
+        Abr a;
+        a.begin(0);
+        CHECK(a.choose(BW, 4, 2, TARGET, TARGET, 100000) == 2, "no estimate");
+        a = at(10000000);
+        CHECK(a.choose(BW, 1, 0, TARGET, TARGET, 100000) == 0, "one variant");
+    }
+
+    // up: to the best variant of at most 70 % of the estimate, only with a full buffer after the hold time
+    {
+        uint32_t hold = 4 * TARGET;
+        Abr a = at(1000000, 0);                             // 512k <= 700k
+        CHECK(a.choose(BW, 4, 0, TARGET, TARGET, hold - 1) == 0, "up within the hold time");
+        CHECK(a.choose(BW, 4, 0, TARGET - 1, TARGET, hold) == 0, "up with less than a segment buffered");
+        CHECK(a.choose(BW, 4, 0, TARGET, TARGET, hold) == 3, "up to the best fit, not one step");
+        CHECK(a.choose(BW, 4, 3, TARGET, TARGET, hold) == 3, "at the top");
+
+        Abr b = at(400000, 0);                              // 256k <= 280k < 512k
+        CHECK(b.choose(BW, 4, 0, 2 * TARGET, TARGET, hold) == 2, "up to the fit below 70 %%");
+        CHECK(b.choose(BW, 4, 2, 2 * TARGET, TARGET, 2 * hold) == 2, "no further");
+        Abr c = at(365000, 0);                              // 256k is 70.1 %: no
+        CHECK(c.choose(BW, 4, 0, 2 * TARGET, TARGET, hold) == 1, "256k at 70.1 %% of the estimate");
+        Abr d = at(365720, 0);                              // 256k is 69.999 %
+        CHECK(d.choose(BW, 4, 0, 2 * TARGET, TARGET, hold) == 2, "256k at 70.0 %% of the estimate");
+    }
+
+    // down: at once to the fit when the current one needs over 90 %, the hold time does not apply
+    {
+        Abr a = at(500000, 0);                              // 512k > 450k
+        CHECK(a.choose(BW, 4, 3, 2 * TARGET, TARGET, 1) == 2, "down from 512k at 500 kbit/s");
+        Abr b = at(100000, 0);                              // only 64k fits
+        CHECK(b.choose(BW, 4, 3, 2 * TARGET, TARGET, 1) == 0, "down past several variants");
+        Abr c = at(569000, 0);                              // 512k = 89.98 %: stays
+        CHECK(c.choose(BW, 4, 3, 2 * TARGET, TARGET, 1) == 3, "512k at 90 %% of the estimate");
+    }
+
+    // hysteresis: between 70 and 90 % both neighbours stay where they are
+    {
+        Abr a = at(650000, 0);                              // 512k = 79 %
+        uint32_t now = 100000;
+        CHECK(a.choose(BW, 4, 3, 2 * TARGET, TARGET, now) == 3, "512k at 79 %% dropped");
+        CHECK(a.choose(BW, 4, 2, 2 * TARGET, TARGET, now) == 2, "256k went up at 79 %%");
+    }
+
+    // a low buffer: one step down even if the current one still fits, never up
+    {
+        Abr a = at(650000, 0);
+        CHECK(a.choose(BW, 4, 3, TARGET / 2 - 1, TARGET, 1) == 2, "low buffer: one step down");
+        CHECK(a.choose(BW, 4, 1, TARGET / 2 - 1, TARGET, 100000) == 1, "low buffer: up");
+        CHECK(a.choose(BW, 4, 0, TARGET / 2 - 1, TARGET, 100000) == 0, "low buffer at the bottom");
+    }
+
+    // a switch down starts the hold time again
+    {
+        Abr a = at(300000, 0);
+        uint32_t now = 50000;
+        CHECK(a.choose(BW, 4, 3, 2 * TARGET, TARGET, now) == 1, "down to 128k");
+        for(int i = 0; i < 40; i++) segment(a, 2000000);    // the link is back
+        CHECK(a.choose(BW, 4, 1, 2 * TARGET, TARGET, now + 4 * TARGET - 1) == 1, "up right after the switch down");
+        CHECK(a.choose(BW, 4, 1, 2 * TARGET, TARGET, now + 4 * TARGET) == 3, "up after the hold time");
+    }
+    return done("abr");
+}
@@ -0,0 +1,143 @@
+// AudioChain: PCM through a chain of stages in blocks, as Audio::playChunk drives it. Order by order and name,
+// formats a stage does not take, on_format() calls, latency, enabling from another task while the audio runs.
+#include "check.h"
+#include "audiochain.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string trace;                       // stages in the order they ran, for the last block
+
+class Gain : public AudioStage {
+public:
+    Gain(const char* name, int16_t order, int num, int den, audioFormat_t f = {0, 2, 16}) : AudioStage(name, order, 0, f), _num(num), _den(den) {}
+    void process(int16_t* lr, uint16_t count) override {
+        trace += name(); trace += ' ';
+        for(uint32_t i = 0; i < count * 2u; i++) lr[i] = lr[i] * _num / _den;
+    }
+    void on_format(const audioFormat_t& f) override { formats++; rate = f.sampleRate; }
+    int formats = 0;
+    uint32_t rate = 0;
+private:
+    int _num, _den;
+};
+
+// delays by its latency in frames
+class Delay : public AudioStage {
+public:
+    Delay(uint16_t frames) : AudioStage("delay", 10, frames), _dl(frames * 2) {}
+    void process(int16_t* lr, uint16_t count) override {
+        trace += "delay ";
+        for(uint32_t i = 0; i < count * 2u; i++) { int16_t o = _dl[_pos]; _dl[_pos] = lr[i]; lr[i] = o; _pos = (_pos + 1) % _dl.size(); }
+    }
+    void on_format(const audioFormat_t&) override { std::fill(_dl.begin(), _dl.end(), 0); _pos = 0; }
+private:
+    std::vector<int16_t> _dl;
+    size_t _pos = 0;
+};
+
+static std::vector<int16_t> pcm(uint32_t frames) {
+    std::vector<int16_t> v(frames * 2);
+    for(uint32_t i = 0; i < v.size(); i++) v[i] = (int16_t)((i * 2654435761u >> 16) % 8001) - 4000;
+    return v;
+}
+
+// in blocks of block frames, the last one shorter
+static void run(AudioChain& c, std::vector<int16_t>& v, uint16_t block, audioFormat_t f = {44100, 2, 16}) {
+    for(uint32_t at = 0; at < v.size() / 2; at += block) {
+        trace.clear();
+        c.process(v.data() + at * 2, v.size() / 2 - at < block ? v.size() / 2 - at : block, f);
+    }
+}
+
+int main() {
+    // order: by order, then by name, whatever the order of add()
+    {
+        AudioChain c;
+        Gain b("b", 5, 1, 1), a("a", 5, 1, 1), z("z", -3, 1, 1), m("m", 20, 1, 1);
+        for(Gain* g : {&m, &b, &z, &a}) { CHECK(c.add(g), "add %s", g->name()); g->enable(true); }
+        CHECK(!c.add(&a), "added twice");
+        std::vector<int16_t> v = pcm(100);
+        run(c, v, 100);
+        CHECK(trace == "z a b m ", "order: %s", trace.c_str());
+        CHECK(c.count() == 4 && c.get(0) == &z && c.get(3) == &m && !c.get(4), "get()");
+    }
+
+    // the chain is the stages one after the other, over any block size
+    for(uint16_t block : {1, 7, 576, 1152, 4096}) {
+        AudioChain c;
+        Gain half("half", 0, 1, 2), triple("triple", 1, 3, 1);
+        Delay d(37);
+        c.add(&triple); c.add(&d); c.add(&half);
+        half.enable(true); triple.enable(true); d.enable(true);
+        std::vector<int16_t> in = pcm(5000), v = in;
+        run(c, v, block);
+        bool same = true;
+        for(uint32_t i = 0; i < v.size(); i++) {
+            int16_t want = i < 37 * 2 ? 0 : (int16_t)(in[i - 37 * 2] / 2 * 3 / 1);
+            if(v[i] != want) { same = false; break; }
+        }
+        CHECK(same, "blocks of %u: half, triple, delay of 37", block);
+        CHECK(c.running() == 3 && c.latency() == 37, "blocks of %u: latency %u", block, c.latency());
+    }
+
+    // formats: a 48 kHz only stage and a mono one are skipped at 44.1 kHz stereo, on_format() once per format
+    {
+        AudioChain c;
+        Gain any("any", 0, 1, 1), r48("r48", 1, 2, 1, {48000, 2, 16}), mono("mono", 2, 5, 1, {0, 1, 16});
+        c.add(&any); c.add(&r48); c.add(&mono);
+        any.enable(true); r48.enable(true); mono.enable(true);
+        std::vector<int16_t> in = pcm(2000), v = in;
+        run(c, v, 500);
+        CHECK(v == in && trace == "any " && c.running() == 1, "44.1 kHz: %s", trace.c_str());
+        CHECK(any.formats == 1 && any.rate == 44100 && r48.formats == 0 && mono.formats == 0, "on_format: %d %d %d", any.formats, r48.formats, mono.formats);
+        CHECK(r48.enabled() && !r48.running(), "r48 enabled, not running");
+        v = in;
+        run(c, v, 500, {48000, 2, 16});
+        CHECK(v[10] == in[10] * 2 && trace == "any r48 ", "48 kHz: %s", trace.c_str());
+        CHECK(any.formats == 2 && any.rate == 48000 && r48.formats == 1, "on_format at 48 kHz: %d %d", any.formats, r48.formats);
+        run(c, v, 500, {48000, 2, 16});
+        CHECK(any.formats == 2 && r48.formats == 1, "same format: no on_format");
+        // disabled and enabled again: on_format() for that stage only
+        r48.enable(false);
+        run(c, v, 500, {48000, 2, 16});
+        CHECK(trace == "any " && !r48.running(), "r48 off: %s", trace.c_str());
+        r48.enable(true);
+        run(c, v, 500, {48000, 2, 16});
+        CHECK(r48.formats == 2 && any.formats == 2, "enabled again: on_format %d %d", any.formats, r48.formats);
+    }
+
+    // full: STAGES_MAX
+    {
+        AudioChain c;
+        std::vector<Gain*> g;
+        for(int i = 0; i <= AudioChain::STAGES_MAX; i++) g.push_back(new Gain("g", i, 1, 1));
+        int added = 0;
+        for(Gain* s : g) added += c.add(s);
+        CHECK(added == AudioChain::STAGES_MAX && !c.add(nullptr), "full at %d", added);
+        for(Gain* s : g) delete s;
+    }
+
+    // enable() from another task while the audio task runs: every block is processed by the stage or not at all
+    {
+        AudioChain c;
+        Gain dbl("double", 0, 2, 1);
+        c.add(&dbl);
+        std::atomic<bool> stop(false);
+        std::atomic<int> toggles(0);
+        std::thread ui([&] { bool on = false; while(!stop) { on = !on; dbl.enable(on); toggles++; std::this_thread::yield(); } });
+        int torn = 0, on = 0, b = 0;
+        for(double t0 = nowUs(); nowUs() - t0 < 100000 || toggles < 1000; b++) {
+            int16_t blk[64 * 2];
+            for(int i = 0; i < 128; i++) blk[i] = 100;
+            c.process(blk, 64, {44100, 2, 16});
+            for(int i = 1; i < 128; i++) if(blk[i] != blk[0]) { torn++; break; }
+            on += blk[0] == 200;
+        }
+        stop = true;
+        ui.join();
+        CHECK(!torn && on > 0 && on < b, "toggled %d times: %d torn, %d of %d doubled", (int)toggles, torn, on, b);
+    }
+    return done("audiochain");
+}
@@ -0,0 +1,138 @@
+// Compressor: its log2/exp2 tables, the static gain curve, attack and release times, the limiter ceiling with the
+// worst input there is, its latency, and a bit exact bypass.
+#include "check.h"
+#include "compressor.h"
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+static const uint32_t RATE = 48000;
+
+// a square wave at half the rate, its peak is its amplitude in every compressor step
+static std::vector<int16_t> square(double dbfs, uint32_t frames) {
+    std::vector<int16_t> v(frames * 2);
+    int16_t a = (int16_t)lround(32767 * pow(10, dbfs / 20));
+    for(uint32_t f = 0; f < frames; f++) v[f * 2] = v[f * 2 + 1] = f & 1 ? -a : a;
+    return v;
+}
+
+static double peakDb(const int16_t* lr, uint32_t frames) {
+    int m = 0;
+    for(uint32_t i = 0; i < frames * 2; i++) m = abs(lr[i]) > m ? abs(lr[i]) : m;
+    return m ? 20 * log10(m / 32767.0) : -200;
+}
+
+// in blocks as playChunk hands them over
+static void run(Compressor& c, std::vector<int16_t>& v, uint32_t block = 576) {
+    for(uint32_t f = 0; f < v.size() / 2; f += block) c.process(v.data() + f * 2, v.size() / 2 - f < block ? v.size() / 2 - f : block);
+}
+
+static Compressor* make(int8_t thr, uint8_t ratio, uint8_t atk, uint16_t rel, uint8_t makeup, int8_t ceil, uint8_t look) {
+    Compressor* c = new Compressor;
+    c->setParams(thr, ratio, atk, rel, makeup);
+    c->setLimiter(ceil, look);
+    c->setRate(RATE);
+    c->enable(true);
+    return c;
+}
+
+int main() {
+    // tables: log2 to 2/256, exp2 to 0.1 % down to 1/16
+    int bad = 0;
+    for(uint32_t x = 1; x < 0x10000000; x += x / 97 + 1)
+        if(fabs(Compressor::log2q8(x) - 256 * log2(x)) > 2) bad++;
+    CHECK(!bad, "log2q8: %d off", bad);
+    bad = 0;
+    for(int32_t x = -16 * 256; x < 14 * 256; x += 7)
+        if(fabs(Compressor::exp2q8(x) / (65536 * exp2(x / 256.0)) - 1) > 0.001 && Compressor::exp2q8(x) > 4096) bad++;
+    CHECK(!bad, "exp2q8: %d off", bad);
+
+    // static curve: -24 dBFS, 4:1, no makeup, the limiter out of the way
+    for(double in : {-40.0, -24.0, -18.0, -12.0, -6.0, 0.0}) {
+        Compressor* c = make(-24, 4, 5, 100, 0, 0, 2);
+        std::vector<int16_t> v = square(in, RATE * 2);
+        run(*c, v);
+        double out = peakDb(v.data() + RATE * 2, RATE / 10);        // after 1 s
+        double want = in > -24 ? -24 + (in + 24) / 4 : in;
+        CHECK(fabs(out - want) < 0.3, "%.0f dBFS in: %.2f out, want %.2f", in, out, want);
+        CHECK(fabs(c->reductionDb10() / 10.0 - (in - want)) < 0.3, "%.0f dBFS in: reports %.1f dB", in, c->reductionDb10() / 10.0);
+        delete c;
+    }
+    // ratio 2:1 with 6 dB makeup
+    {
+        Compressor* c = make(-30, 2, 5, 100, 6, 0, 2);
+        std::vector<int16_t> v = square(-10, RATE);
+        run(*c, v);
+        double out = peakDb(v.data() + RATE, RATE / 10);
+        CHECK(fabs(out - (-20 + 6)) < 0.3, "2:1 + 6 dB: %.2f", out);
+        delete c;
+    }
+
+    // attack and release: a step of 24 dB over the threshold, 18 dB of reduction at 4:1
+    {
+        const uint8_t atk = 10;
+        const uint16_t rel = 200;
+        Compressor* c = make(-30, 4, atk, rel, 0, 0, 2);
+        std::vector<int16_t> v = square(-40, RATE / 2);
+        std::vector<int16_t> loud = square(-6, RATE);
+        v.insert(v.end(), loud.begin(), loud.end());
+        std::vector<int16_t> quiet = square(-40, RATE);
+        v.insert(v.end(), quiet.begin(), quiet.end());
+        run(*c, v);
+        auto red = [&](uint32_t at, double in) { return in - peakDb(v.data() + at * 2, 16); };
+        uint32_t step = RATE / 2, down = step + RATE;
+        double a1 = red(step + RATE * atk / 1000, -6), a5 = red(step + RATE * atk * 5 / 1000, -6);
+        CHECK(a1 > 18 * 0.5 && a1 < 18 * 0.75, "one attack time: %.1f dB of 18", a1);
+        CHECK(a5 > 17.5, "five attack times: %.1f dB", a5);
+        double r1 = red(down + RATE * rel / 1000, -40), r5 = red(down + RATE * rel * 5 / 1000 - 16, -40);
+        CHECK(r1 > 18 * 0.25 && r1 < 18 * 0.5, "one release time: %.1f dB left", r1);
+        CHECK(r5 < 0.5, "five release times: %.1f dB left", r5);
+        // gain ramps, no step larger than the ramp of one SUB block once the loud input is out
+        int jump = 0;
+        for(uint32_t f = step + c->latency() + 1; f < down; f++) if(abs(abs(v[f * 2]) - abs(v[f * 2 - 2])) > abs(v[f * 2]) / 8) jump++;
+        CHECK(!jump, "gain steps: %d", jump);
+        delete c;
+    }
+
+    // limiter: full scale noise with bursts and single peaks after 18 dB makeup, nothing passes the ceiling
+    for(int8_t ceil : {-1, -3, -6}) {
+        Compressor* c = make(-12, 2, 1, 50, 18, ceil, 2);
+        srand(ceil + 100);
+        std::vector<int16_t> v(RATE * 4);
+        for(size_t i = 0; i < v.size(); i++) {
+            int amp = (i / 4800) % 3 == 0 ? 32767 : (i / 4800) % 3 == 1 ? 300 : 3000;
+            v[i] = (int16_t)(rand() % (2 * amp + 1) - amp);
+            if(rand() % 5000 == 0) v[i] = rand() & 1 ? 32767 : -32768;
+        }
+        run(*c, v, 333);
+        int32_t lim = (int32_t)(32768 * pow(10, ceil / 20.0));
+        int over = 0;
+        for(int16_t s : v) if(abs(s) > lim) over++;
+        CHECK(!over && c->clipped() == 0, "ceiling %d dB: %d over, %u clipped", ceil, over, c->clipped());
+        CHECK(peakDb(v.data(), v.size() / 2) > ceil - 0.5, "ceiling %d dB: reached", ceil);
+        delete c;
+    }
+
+    // the limiter delays by its look-ahead: an impulse at frame 1000 comes out latency() frames later
+    {
+        Compressor* c = make(0, 1, 5, 100, 0, 0, 2);
+        std::vector<int16_t> v(4000 * 2);
+        v[2000] = v[2001] = 10000;
+        run(*c, v, 256);
+        uint32_t at = 0;
+        for(uint32_t f = 0; f < 4000; f++) if(v[f * 2]) { at = f; break; }
+        CHECK(c->latency() == RATE * 2 / 1000 - 1 && at == 1000u + c->latency(), "latency %u, impulse at %u", c->latency(), at);
+        delete c;
+    }
+
+    // off: untouched
+    {
+        Compressor* c = make(-40, 20, 1, 50, 18, -6, 2);
+        c->enable(false);
+        std::vector<int16_t> v = square(0, 4096), w = v;
+        run(*c, v);
+        CHECK(v == w, "bypass");
+        delete c;
+    }
+    return done("compressor");
+}
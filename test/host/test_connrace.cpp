@@ -0,0 +1,213 @@
+// ConnRace against scripted local listeners: a healthy server, a slow one, one that hangs after the accept, one
+// that resets the connection, an error status, a refused port; staggering, the TLS rule and the remembered winner.
+#include "check.h"
+#include "connrace.h"
+#include <arpa/inet.h>
+#include <poll.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+static uint32_t ms() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// every name is the loopback, the candidates differ by port
+static uint8_t loopback(const char*, uint32_t* ips, uint8_t, bool) { ips[0] = htonl(INADDR_LOOPBACK); return 1; }
+
+class Server {
+  public:
+    enum { OK, SLOW, HANG, RESET, NOTFOUND };
+    Server(int mode, int delayMs = 0) : _mode(mode), _delay(delayMs) {
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in sa = {};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(_fd, (sockaddr*)&sa, sizeof(sa));
+        socklen_t l = sizeof(sa);
+        getsockname(_fd, (sockaddr*)&sa, &l);
+        port = ntohs(sa.sin_port);
+        listen(_fd, 8);
+        _t = std::thread([this] { _run(); });
+    }
+    ~Server() { _stop = true; _t.join(); close(_fd); }
+    uint16_t port;
+    std::atomic<int> accepted{0};
+    std::string url(const char* scheme = "http") { return std::string(scheme) + "://s" + std::to_string(port) + ":" + std::to_string(port) + "/live"; }
+
+  private:
+    int _fd, _mode, _delay;
+    std::atomic<bool> _stop{false};
+    std::thread _t;
+
+    void _run() {
+        while(!_stop) {
+            pollfd p = {_fd, POLLIN, 0};
+            if(poll(&p, 1, 10) <= 0) continue;
+            int c = accept(_fd, NULL, NULL);
+            if(c < 0) continue;
+            accepted++;
+            char req[512];
+            pollfd q = {c, POLLIN, 0};
+            if(poll(&q, 1, 1000) > 0) recv(c, req, sizeof(req), 0);          // the request first, as a server would
+            if(_mode == RESET) {
+                linger lg = {1, 0};
+                setsockopt(c, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+                close(c);
+                continue;
+            }
+            for(int t = 0; !_stop && (_mode == HANG || t < _delay); t += 10) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const char* r = _mode == NOTFOUND ? "HTTP/1.1 404 Not Found\r\n\r\n" : "ICY 200 OK\r\nicy-name: test\r\n\r\n";
+            if(!_stop) send(c, r, strlen(r), MSG_NOSIGNAL);
+            for(int t = 0; !_stop && t < 300; t += 10) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            close(c);
+        }
+    }
+};
+
+static uint16_t refusedPort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa = {};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (sockaddr*)&sa, sizeof(sa));
+    socklen_t l = sizeof(sa);
+    getsockname(fd, (sockaddr*)&sa, &l);
+    close(fd);
+    return ntohs(sa.sin_port);
+}
+
+static const char* HEADERS = "Icy-MetaData:1\r\n\r\n";
+
+// start() and poll() as connectLoop() does; the winner or -1, and how long it took
+static int8_t race(ConnRace& r, uint32_t key, uint16_t stagger, uint32_t connectMs, uint32_t responseMs, uint32_t* took) {
+    uint32_t t0 = ms();
+    r.start(key, HEADERS, stagger, connectMs, responseMs, ms);
+    int8_t v;
+    while((v = r.poll(5)) == 0);
+    *took = ms() - t0;
+    return v > 0 ? r.winner() : -1;
+}
+
+int main() {
+    uint32_t took;
+    // healthy: wins with its status line, which stays in the socket for the player
+    {
+        Server s(Server::OK);
+        ConnRace r;
+        CHECK(r.add(s.url().c_str(), loopback) == 1, "add");
+        int8_t w = race(r, 1, 200, 1000, 1000, &took);
+        CHECK(w == 0 && took < 500, "healthy: winner %d in %u ms", w, took);
+        int fd = r.release(w);
+        char buf[64] = {};
+        int n = recv(fd, buf, sizeof(buf) - 1, 0);
+        CHECK(n > 0 && strncmp(buf, "ICY 200 OK", 10) == 0, "response left in the socket: %s", buf);
+        close(fd);
+    }
+
+    // slow: answers after 300 ms, inside the response time it wins; a fast one staggered behind it wins first
+    {
+        Server slow(Server::SLOW, 300);
+        ConnRace r;
+        r.add(slow.url().c_str(), loopback);
+        int8_t w = race(r, 2, 200, 1000, 1000, &took);
+        CHECK(w == 0 && took >= 290 && took < 800, "slow alone: winner %d in %u ms", w, took);
+        r.clear();
+        Server slow2(Server::SLOW, 600), fast(Server::OK);
+        r.add(slow2.url().c_str(), loopback);
+        r.add(fast.url().c_str(), loopback);
+        w = race(r, 3, 100, 1000, 2000, &took);
+        CHECK(w == 1 && took >= 90 && took < 500, "slow vs fast: winner %d (%s) in %u ms", w, w >= 0 ? r.url(w) : "", took);
+    }
+
+    // hung: accepts and never answers; alone it fails after the response time, with a healthy one behind it the
+    // healthy one wins after the stagger
+    {
+        Server hung(Server::HANG);
+        ConnRace r;
+        r.add(hung.url().c_str(), loopback);
+        int8_t w = race(r, 4, 200, 1000, 400, &took);
+        CHECK(w < 0 && took >= 390 && took < 900, "hung alone: %d after %u ms", w, took);
+        r.clear();
+        Server ok(Server::OK);
+        r.add(hung.url().c_str(), loopback);
+        r.add(ok.url().c_str(), loopback);
+        w = race(r, 5, 150, 1000, 3000, &took);
+        CHECK(w == 1 && took >= 140 && took < 600, "hung, then healthy: winner %d in %u ms", w, took);
+    }
+
+    // reset after the request: fails at once, the next candidate starts without waiting for its stagger
+    {
+        Server rst(Server::RESET), ok(Server::OK);
+        ConnRace r;
+        r.add(rst.url().c_str(), loopback);
+        r.add(ok.url().c_str(), loopback);
+        int8_t w = race(r, 6, 5000, 1000, 3000, &took);
+        CHECK(w == 1 && took < 1000 && rst.accepted == 1, "reset, then healthy: winner %d in %u ms", w, took);
+        r.clear();
+        r.add(rst.url().c_str(), loopback);
+        w = race(r, 7, 100, 1000, 3000, &took);
+        CHECK(w < 0 && took < 1000, "reset alone: %d after %u ms", w, took);
+    }
+
+    // an error status and a refused port fail, the other candidate wins
+    {
+        Server nf(Server::NOTFOUND), ok(Server::OK);
+        ConnRace r;
+        std::string refused = "http://r:" + std::to_string(refusedPort()) + "/";
+        r.add(refused.c_str(), loopback);
+        r.add(nf.url().c_str(), loopback);
+        r.add(ok.url().c_str(), loopback);
+        int8_t w = race(r, 8, 3000, 1000, 3000, &took);
+        CHECK(w == 2 && took < 1000, "refused, 404, healthy: winner %d in %u ms", w, took);
+        r.clear();
+        r.add(refused.c_str(), loopback);
+        r.add(nf.url().c_str(), loopback);
+        CHECK(race(r, 9, 50, 1000, 3000, &took) < 0, "refused and 404: no winner");
+    }
+
+    // https: the TCP connect wins, nothing is sent (TLS comes after), even to a server that would hang
+    {
+        Server hung(Server::HANG);
+        ConnRace r;
+        r.add(hung.url("https").c_str(), loopback);
+        int8_t w = race(r, 10, 100, 1000, 300, &took);
+        CHECK(w == 0 && r.tls(0) && took < 200, "https: winner %d in %u ms", w, took);
+        int fd = r.release(w);
+        char c;
+        CHECK(fd >= 0 && recv(fd, &c, 1, MSG_DONTWAIT) < 0 && errno == EAGAIN, "https: socket handed over untouched");
+        close(fd);
+    }
+
+    // the winner of a key goes first in its next race, last once it is avoided
+    {
+        Server a(Server::OK), b(Server::OK);
+        ConnRace r;
+        r.add(a.url().c_str(), loopback);
+        r.add(b.url().c_str(), loopback);
+        r.start(11, HEADERS, 100, 1000, 1000, ms);
+        CHECK(!strcmp(r.url(0), a.url().c_str()), "first in the first race");
+        r.clear();
+        // b wins the next race because a fails: b is remembered
+        Server nf(Server::NOTFOUND);
+        r.add(nf.url().c_str(), loopback);
+        r.add(b.url().c_str(), loopback);
+        int8_t w = race(r, 12, 100, 1000, 1000, &took);
+        CHECK(w == 1, "b wins");
+        r.clear();
+        r.add(a.url().c_str(), loopback);
+        r.add(b.url().c_str(), loopback);
+        r.start(12, HEADERS, 100, 1000, 1000, ms);
+        CHECK(!strcmp(r.url(0), b.url().c_str()), "the last winner goes first");
+        r.clear();
+        ConnRace::avoid(12);
+        r.add(b.url().c_str(), loopback);
+        r.add(a.url().c_str(), loopback);
+        r.start(12, HEADERS, 100, 1000, 1000, ms);
+        CHECK(!strcmp(r.url(1), b.url().c_str()), "an avoided winner goes last");
+    }
+    return done("connrace");
+}
@@ -0,0 +1,68 @@
+// DmaTune: the learned latency follows the underrun margin, and the DMA queue is only made again when that
+// latency moves, not when a station changes between 44.1 and 48 kHz.
+#include "check.h"
+#include "dmatune.h"
+
+// windows of 10 s with writes every 10 ms at a queue level of frac (of the capacity), underruns in the first
+static void play(DmaTune& t, uint32_t& now, uint32_t& under, int windows, float frac, bool underrun) {
+    uint32_t cap = (uint32_t)t.desc() * t.frames();
+    t.level(cap, under, now);                               // arms it
+    for(int w = 0; w < windows; w++) {
+        if(underrun) under++;
+        for(int i = 0; i < 1001; i++) { now += 10; t.level((uint32_t)(cap * frac), under, now); }
+    }
+}
+
+int main() {
+    DmaTune t;
+    t.setLimits(40, 250, 60000);
+    t.setStart(186);
+    uint16_t desc = 0, frames = 0;
+    CHECK(t.size(44100, desc, frames), "first queue");
+    t.begin(44100, desc, frames);
+    uint16_t ms = t.latencyMs();
+    CHECK(ms > 186 * 9 / 10 && ms < 186 * 11 / 10, "start latency %u ms", ms);
+    CHECK(desc >= DmaTune::DESC_MIN && desc <= DmaTune::DESC_MAX && frames % 8 == 0, "%u x %u", desc, frames);
+
+    // 44.1 <-> 48 kHz with nothing learned keeps the queue
+    for(int i = 0; i < 4; i++) {
+        uint32_t rate = i % 2 ? 44100 : 48000;
+        uint16_t d = desc, f = frames;
+        CHECK(!t.size(rate, d, f) && d == desc && f == frames, "%u Hz: kept %u x %u", rate, d, f);
+        t.begin(rate, d, f);
+    }
+
+    // a steady margin lowers it by 1/8, that is a new queue; the other rate keeps what it learned and the queue
+    uint32_t now = 0, under = 0;
+    t.begin(48000, desc, frames);
+    uint16_t was = t.targetMs();
+    play(t, now, under, 6, 0.9f, false);
+    CHECK(t.targetMs() == was - was / 8, "lowered to %u from %u", t.targetMs(), was);
+    uint16_t d = desc, f = frames;
+    CHECK(t.size(48000, d, f), "learned latency moved: new queue");
+    t.begin(48000, d, f);
+    uint16_t low = t.latencyMs();
+    CHECK(low < ms, "latency %u below %u", low, ms);
+    uint16_t d2 = d, f2 = f;
+    CHECK(!t.size(44100, d2, f2), "44.1 kHz after learning at 48: kept");
+
+    // an underrun raises it by half
+    was = t.targetMs();
+    play(t, now, under, 1, 0.5f, true);
+    CHECK(t.targetMs() == was + was / 2, "raised to %u from %u", t.targetMs(), was);
+    CHECK(t.size(48000, d, f), "raised: new queue");
+    t.begin(48000, d, f);
+    CHECK(t.underruns() == 1, "underruns %u", t.underruns());
+
+    // a thin margin without underrun raises it by a quarter, pauses are not measured
+    was = t.targetMs();
+    t.pause();
+    play(t, now, under, 1, 0.2f, false);
+    CHECK(t.targetMs() == (was + was / 4 < 250 ? was + was / 4 : 250), "thin margin: %u from %u", t.targetMs(), was);
+    CHECK(t.marginMs() <= t.latencyMs() / 4, "margin %u", t.marginMs());
+
+    // limits
+    for(int i = 0; i < 10; i++) { t.size(48000, d, f); t.begin(48000, d, f); play(t, now, under, 1, 0.5f, true); }
+    CHECK(t.targetMs() == 250, "max %u", t.targetMs());
+    return done("dmatune");
+}
@@ -0,0 +1,171 @@
+// DnsCache through setResolver() on a clock the test sets: TTLs and their limits, stale answers served while the
+// background task asks again, failed refreshes, negative entries, lookups that do not wait, the answers kept in
+// NVS; and parse() on crafted DNS messages: the question of the answer must be the one asked.
+#include "check.h"
+#include "dnscache.h"
+#include <Preferences.h>
+#include <string>
+#include <vector>
+
+// what the upstream resolver says next, and how often it was asked
+static struct { std::vector<uint32_t> ips; uint32_t ttl = 300; int calls = 0; } up;
+static uint8_t upstream(const char*, uint32_t* ips, uint8_t max, uint32_t* ttl) {
+    up.calls++;
+    uint8_t n = 0;
+    for(uint32_t ip : up.ips) if(n < max) ips[n++] = ip;
+    if(n) *ttl = up.ttl;
+    return n;
+}
+
+static uint32_t ip4(uint8_t d) { return IPAddress(10, 0, 0, d); }
+
+// the query _query() sends for host, and an answer to it
+static std::vector<uint8_t> query(const char* host, uint16_t id) {
+    std::vector<uint8_t> q = {(uint8_t)(id >> 8), (uint8_t)id, 0x01, 0, 0, 1, 0, 0, 0, 0, 0, 0};
+    for(const char* l = host; *l;) {
+        const char* dot = strchr(l, '.');
+        size_t n = dot ? (size_t)(dot - l) : strlen(l);
+        q.push_back(n);
+        q.insert(q.end(), l, l + n);
+        l += n + (dot ? 1 : 0);
+    }
+    q.insert(q.end(), {0, 0, 1, 0, 1});
+    return q;
+}
+static std::vector<uint8_t> answer(std::vector<uint8_t> q, std::vector<std::pair<uint32_t, uint32_t>> a, bool cname = false) {
+    q[2] = 0x81; q[3] = 0x80;
+    q[7] = a.size() + (cname ? 1 : 0);
+    if(cname) q.insert(q.end(), {0xC0, 12, 0, 5, 0, 1, 0, 0, 0, 20, 0, 2, 0xC0, 12});   // TTL 20, a pointer as its target
+    for(auto& r : a) {
+        q.insert(q.end(), {0xC0, 12, 0, 1, 0, 1, (uint8_t)(r.second >> 24), (uint8_t)(r.second >> 16), (uint8_t)(r.second >> 8), (uint8_t)r.second, 0, 4});
+        uint8_t b[4];
+        memcpy(b, &r.first, 4);
+        q.insert(q.end(), b, b + 4);
+    }
+    return q;
+}
+
+int main() {
+    // parse()
+    {
+        std::vector<uint8_t> q = query("stream.example.com", 0x1234);
+        std::vector<uint8_t> a = answer(q, {{ip4(1), 300}, {ip4(2), 120}});
+        uint32_t ips[4] = {}, ttl = 0;
+        int8_t n = DnsCache::parse(a.data(), a.size(), q.data(), q.size(), ips, 4, &ttl);
+        CHECK(n == 2 && ips[0] == ip4(1) && ips[1] == ip4(2) && ttl == 120, "two A records: %d, ttl %u", n, ttl);
+        a = answer(q, {{ip4(3), 300}}, true);
+        n = DnsCache::parse(a.data(), a.size(), q.data(), q.size(), ips, 4, &ttl);
+        CHECK(n == 1 && ips[0] == ip4(3) && ttl == 20, "behind a CNAME: %d, ttl %u", n, ttl);
+        n = DnsCache::parse(a.data(), a.size(), q.data(), q.size(), ips, 0, &ttl);
+        CHECK(n == 0, "max 0: %d", n);
+
+        std::vector<uint8_t> other = answer(query("evil.example.com", 0x1234), {{ip4(66), 86400}});
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == -1, "another name, the same ID: ignored");
+        other = answer(query("stream.example.org", 0x1234), {{ip4(66), 86400}});
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == -1, "a name of the same length: ignored");
+        other = answer(query("stream.example.com", 0x4321), {{ip4(66), 86400}});
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == -1, "another ID: ignored");
+        other = a; other[other.size() - 4 - 12 - 14 - 3] = 28;   // QTYPE AAAA
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == -1, "another type: ignored");
+        other = answer(query("STREAM.Example.COM", 0x1234), {{ip4(4), 300}});
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == 1 && ips[0] == ip4(4), "the name in other case (0x20)");
+        other = a; other[2] &= 0x7F;
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == -1, "a query, not a response: ignored");
+        other = a; other[3] |= 3;
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == 0, "NXDOMAIN: no address");
+        other = a; other[2] |= 2;
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == 0, "truncated: no address");
+        other.assign(a.begin(), a.begin() + 12); other[2] |= 2; other[5] = 0;
+        CHECK(DnsCache::parse(other.data(), other.size(), q.data(), q.size(), ips, 4, &ttl) == 0, "truncated without its question");
+        // cut anywhere and garbled: never more than is there, never a crash
+        int bad = 0;
+        for(size_t cut = 0; cut <= a.size(); cut++) {
+            int8_t r = DnsCache::parse(a.data(), cut, q.data(), q.size(), ips, 4, &ttl);
+            if(r > 1) bad++;
+        }
+        for(int i = 0; i < 20000; i++) {
+            std::vector<uint8_t> g = a;
+            for(int k = 0; k < 3; k++) g[q.size() + rand() % (g.size() - q.size())] = rand();
+            if(DnsCache::parse(g.data(), g.size(), q.data(), q.size(), ips, 4, &ttl) > 4) bad++;
+        }
+        CHECK(!bad, "cut and garbled: %d", bad);
+    }
+
+    DnsCache c;
+    c.begin();
+    c.setResolver(upstream);
+    uint32_t ips[4];
+
+    // a miss asks upstream, the answer is kept for its TTL
+    up.ips = {ip4(1), ip4(2)}; up.ttl = 300;
+    CHECK(c.resolve("a.example", ips, 4) == 2 && ips[1] == ip4(2) && up.calls == 1, "miss: %d calls", up.calls);
+    CHECK(hostRunTasks() == 1 && !hostNvs.empty(), "a new answer is saved");
+    hostMillis += 299 * 1000;
+    CHECK(c.resolve("A.EXAMPLE", ips, 4) == 2 && up.calls == 1 && c.hits() == 1, "hit within the TTL, any case");
+
+    // expired: the old answer at once, asked again in the background, the new one from then on
+    up.ips = {ip4(3)};
+    hostMillis += 2000;
+    CHECK(c.resolve("a.example", ips, 4) == 2 && ips[0] == ip4(1) && up.calls == 1 && c.staleHits() == 1, "stale served without waiting");
+    CHECK(c.resolve("a.example", ips, 4) == 2 && c.staleHits() == 2 && hostTasks.size() == 1, "one refresh queued");
+    CHECK(hostRunTasks() == 1 && up.calls == 2 && c.refreshes() == 1, "refreshed in the background: %d calls", up.calls);
+    CHECK(c.resolve("a.example", ips, 4) == 1 && ips[0] == ip4(3) && c.hits() == 2, "the new answer is a hit");
+
+    // a failed refresh keeps the stale answer up to DNS_CACHE_STALE_S, then it is gone
+    hostMillis += 301 * 1000;
+    up.ips.clear();
+    CHECK(c.resolve("a.example", ips, 4) == 1 && ips[0] == ip4(3), "stale");
+    hostRunTasks();
+    CHECK(c.resolve("a.example", ips, 4) == 1 && ips[0] == ip4(3) && c.failures() == 1, "failed refresh: still the stale answer");
+    hostRunTasks();
+    hostMillis += DNS_CACHE_STALE_S * 1000u;
+    int calls = up.calls;
+    CHECK(c.resolve("a.example", ips, 4) == 0 && up.calls == calls + 1, "too old: asked again, waited for");
+
+    // TTLs are kept within DNS_CACHE_MIN_TTL and DNS_CACHE_MAX_TTL
+    up.ips = {ip4(5)}; up.ttl = 5;
+    c.resolve("short.example", ips, 4);
+    hostRunTasks();
+    calls = up.calls;
+    hostMillis += (DNS_CACHE_MIN_TTL - 1) * 1000;
+    c.resolve("short.example", ips, 4);
+    CHECK(up.calls == calls && hostTasks.empty(), "TTL 5 s kept %u s", DNS_CACHE_MIN_TTL);
+    up.ttl = 10 * DNS_CACHE_MAX_TTL;
+    c.resolve("long.example", ips, 4);
+    hostRunTasks();
+    hostMillis += DNS_CACHE_MAX_TTL * 1000u + 1000;
+    c.resolve("long.example", ips, 4);
+    CHECK(hostTasks.size() == 1, "a TTL above %u s expires at it", DNS_CACHE_MAX_TTL);
+    hostRunTasks();
+
+    // a name that does not resolve is remembered for DNS_CACHE_NEG_TTL
+    up.ips.clear();
+    calls = up.calls;
+    CHECK(c.resolve("gone.example", ips, 4) == 0 && c.resolve("gone.example", ips, 4) == 0 && up.calls == calls + 1, "negative entry");
+    hostMillis += DNS_CACHE_NEG_TTL * 1000 + 1;
+    CHECK(c.resolve("gone.example", ips, 4) == 0 && up.calls == calls + 2, "asked again after %u s", DNS_CACHE_NEG_TTL);
+
+    // wait = false: a miss returns at once and is pending until the background task answered it
+    up.ips = {ip4(7)}; up.ttl = 300;
+    calls = up.calls;
+    CHECK(c.resolve("async.example", ips, 4, false) == 0 && up.calls == calls && c.pending("async.example"), "no wait: pending");
+    hostRunTasks();
+    CHECK(!c.pending("async.example") && c.resolve("async.example", ips, 4, false) == 1 && ips[0] == ip4(7), "no wait: answered");
+
+    // literals never reach the resolver
+    calls = up.calls;
+    CHECK(c.resolve("192.168.1.9", ips, 4) == 1 && ips[0] == (uint32_t)IPAddress(192, 168, 1, 9) && up.calls == calls, "literal");
+
+    // the busiest answers go to NVS and come back stale after a reboot, so the first lookup does not wait
+    for(int i = 0; i < 5; i++) c.resolve("async.example", ips, 4);
+    hostRunTasks();
+    DnsCache boot;
+    boot.begin();
+    boot.setResolver(upstream);
+    up.ips = {ip4(8)};
+    calls = up.calls;
+    CHECK(boot.resolve("async.example", ips, 4) == 1 && ips[0] == ip4(7) && up.calls == calls && boot.staleHits() == 1, "after a reboot: stale");
+    hostRunTasks();
+    CHECK(boot.resolve("async.example", ips, 4) == 1 && ips[0] == ip4(8), "after a reboot: refreshed");
+    return done("dnscache");
+}
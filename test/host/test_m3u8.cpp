@@ -0,0 +1,100 @@
+// M3u8::diff and take as the HLS engine uses them on reloads of a live playlist: the window rolls over, the
+// engine falls behind and segments are lost, the queue refuses one, the server counts wrong or starts again,
+// another variant goes on at a sequence number. Counted are the new segments and the ones lost in front of them.
+#include "check.h"
+#include "m3u8.h"
+#include <string>
+
+static char arena[M3U8_ARENA_SIZE];
+
+// a live window of count segments from seq on, named by name (seq unless the server names them otherwise)
+static std::string playlist(uint64_t seq, int count, uint64_t name, bool withSeq = true, const char* prefix = "seg") {
+    std::string s = "#EXTM3U\n#EXT-X-TARGETDURATION:6\n";
+    if(withSeq) s += "#EXT-X-MEDIA-SEQUENCE:" + std::to_string(seq) + "\n";
+    for(int i = 0; i < count; i++) s += "#EXTINF:6.0,\nhttps://cdn.example.com/live/" + std::string(prefix) + std::to_string(name + i) + ".aac\n";
+    return s;
+}
+
+struct Reload { uint16_t fresh = 0, taken = 0; uint64_t lost = 0, first = 0; };
+
+// a reload: diff(), then take() up to room of the new segments, oldest first
+static Reload reload(M3u8& m, const std::string& text, uint16_t room = 0xFFFF) {
+    Reload r;
+    m.start();
+    for(size_t pos = 0; pos < text.size(); pos += 97) m.feed(text.data() + pos, text.size() - pos < 97 ? text.size() - pos : 97);
+    CHECK(m.finish() == M3u8::MEDIA, "not a media playlist");
+    r.fresh = m.diff();
+    for(uint16_t i = 0; i < m.segments() && r.taken < room; i++) {
+        if(!m.segment(i).fresh) continue;
+        if(!r.taken) r.first = m.segment(i).seq;
+        r.lost += m.take(m.segment(i));
+        r.taken++;
+    }
+    return r;
+}
+
+int main() {
+    M3u8 m;
+    m.begin(arena, sizeof(arena));
+
+    // first load: all of the window is new, from the oldest
+    Reload r = reload(m, playlist(100, 6, 100));
+    CHECK(r.fresh == 6 && r.first == 100 && r.lost == 0, "first load: %u new from %llu, %llu lost", r.fresh, (unsigned long long)r.first, (unsigned long long)r.lost);
+
+    // rollover by two, and a reload with nothing new
+    r = reload(m, playlist(102, 6, 102));
+    CHECK(r.fresh == 2 && r.first == 106 && r.lost == 0, "rollover: %u new from %llu, %llu lost", r.fresh, (unsigned long long)r.first, (unsigned long long)r.lost);
+    r = reload(m, playlist(102, 6, 102));
+    CHECK(r.fresh == 0, "the same window again: %u new", r.fresh);
+
+    // the engine fell behind: 108..111 rolled out of the window before a reload saw them
+    r = reload(m, playlist(112, 6, 112));
+    CHECK(r.fresh == 6 && r.first == 112 && r.lost == 4, "behind: %u new from %llu, %llu lost", r.fresh, (unsigned long long)r.first, (unsigned long long)r.lost);
+
+    // the queue takes one of two new ones, the other is new again on the next reload and not lost
+    r = reload(m, playlist(114, 6, 114), 1);
+    CHECK(r.fresh == 2 && r.taken == 1 && r.first == 118, "queue full: %u new, %u taken", r.fresh, r.taken);
+    r = reload(m, playlist(114, 6, 114));
+    CHECK(r.fresh == 1 && r.first == 119 && r.lost == 0, "refused one: %u new from %llu, %llu lost", r.fresh, (unsigned long long)r.first, (unsigned long long)r.lost);
+    // refused and then rolled on past it: lost once, when the next one is taken
+    r = reload(m, playlist(120, 6, 120), 0);
+    r = reload(m, playlist(123, 6, 123));
+    CHECK(r.first == 123 && r.lost == 3, "refused and rolled on: from %llu, %llu lost", (unsigned long long)r.first, (unsigned long long)r.lost);
+
+    // a server that counts wrong: the media sequence stands still, the names roll; diff goes by the names
+    m.forget();
+    reload(m, playlist(0, 6, 500));
+    r = reload(m, playlist(0, 6, 502));
+    CHECK(r.fresh == 2 && r.lost == 0, "wrong count: %u new, %llu lost", r.fresh, (unsigned long long)r.lost);
+
+    // the server starts counting again with new names: a restart, not 1000 lost
+    m.forget();
+    reload(m, playlist(1000, 6, 1000));
+    r = reload(m, playlist(0, 6, 0, true, "new"));
+    CHECK(r.fresh == 6 && r.first == 0 && r.lost == 0 && m.restarts() == 1, "restart: %u new from %llu, %llu lost, %u restarts",
+          r.fresh, (unsigned long long)r.first, (unsigned long long)r.lost, m.restarts());
+
+    // another variant of the stream goes on at a sequence number, its names are all new
+    m.forget();
+    reload(m, playlist(200, 6, 200));
+    m.seek(206);
+    r = reload(m, playlist(202, 6, 202, true, "hi"));
+    CHECK(r.fresh == 2 && r.first == 206 && r.lost == 0 && m.restarts() == 0, "variant switch: %u new from %llu, %llu lost",
+          r.fresh, (unsigned long long)r.first, (unsigned long long)r.lost);
+
+    // the segment a stream started with is not fetched again
+    m.forget();
+    m.remember("https://other.example.com/live/seg303.aac");
+    r = reload(m, playlist(300, 6, 300));
+    CHECK(r.fresh == 2 && r.first == 304, "after the remembered one: %u new from %llu", r.fresh, (unsigned long long)r.first);
+
+    // without #EXT-X-MEDIA-SEQUENCE nothing can be counted as lost, the names still work
+    m.forget();
+    reload(m, playlist(0, 6, 400, false));
+    r = reload(m, playlist(0, 6, 410, false));
+    CHECK(r.fresh == 6 && r.lost == 0, "no sequence numbers: %u new, %llu lost", r.fresh, (unsigned long long)r.lost);
+    r = reload(m, playlist(0, 6, 412, false));
+    CHECK(r.fresh == 2 && r.lost == 0, "no sequence numbers, rollover: %u new", r.fresh);
+
+    return done("m3u8");
+}
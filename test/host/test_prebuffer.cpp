@@ -0,0 +1,130 @@
+// Prebuffer: the thresholds it picks for recorded kinds of arrival (smooth, bursty, stalling, jittery), the learning
+// steps, and a replay through a player that shows a bursty or stalling link stops underrunning once it is measured.
+#include "check.h"
+#include "prebuffer.h"
+#include <vector>
+
+static const uint32_t BPS = 16;                             // 128 kbps, bytes per ms
+
+struct Arrival { uint32_t t, bytes; };
+
+// packets of bytes every gap ms, every stallEvery-th gap is stallMs, gaps alternate by +-wobble
+static std::vector<Arrival> trace(uint32_t ms, uint32_t gap, uint32_t wobble, uint32_t stallEvery, uint32_t stallMs) {
+    std::vector<Arrival> v;
+    uint32_t t = 0, n = 0, sent = 0;
+    while(t < ms) {
+        uint32_t g = stallEvery && n % stallEvery == stallEvery - 1 ? stallMs : (n % 2 ? gap + wobble : gap - wobble);
+        t += g; n++;
+        uint32_t bytes = t * BPS - sent;                    // the server keeps up with the bitrate on average
+        v.push_back({t, bytes});
+        sent += bytes;
+    }
+    return v;
+}
+
+static Prebuffer make() {
+    Prebuffer p;
+    p.setLimits(100, 8000, 300000);
+    p.begin(300, 1000, 0);
+    return p;
+}
+
+static void feed(Prebuffer& p, const std::vector<Arrival>& v, uint32_t from = 0, uint32_t upTo = UINT32_MAX) {
+    for(auto& a : v) { if(a.t > upTo) break; if(a.t > from) p.arrival(a.t, a.bytes); }
+}
+
+// a player: starts at startMs() buffered, an empty buffer is an underrun, then it waits for resumeMs()
+struct Replay { uint16_t underruns = 0; uint32_t lastUnderrun = 0; };
+static Replay replay(Prebuffer& p, const std::vector<Arrival>& v) {
+    Replay r;
+    uint32_t buffered = 0, t = 0;                           // ms of audio
+    bool playing = false, started = false;
+    for(auto& a : v) {
+        for(; t < a.t; t++) {
+            if(playing && buffered) buffered--;
+            else if(playing) { playing = false; p.underrun(t); r.underruns++; r.lastUnderrun = t; }
+            else if(started ? buffered >= p.resumeMs() : buffered >= p.startMs()) playing = started = true;
+            if(playing) p.stable(t);
+        }
+        p.arrival(a.t, a.bytes);
+        buffered += a.bytes / BPS;
+    }
+    return r;
+}
+
+int main() {
+    // smooth: 1460 bytes every ~91 ms, the learned values stand, the link asks for little
+    {
+        Prebuffer p = make();
+        feed(p, trace(60000, 91, 0, 0, 0));
+        CHECK(p.floorMs() < 200, "smooth floor %u", p.floorMs());
+        CHECK(p.startMs() == 300 && p.resumeMs() == 1000, "smooth %u / %u", p.startMs(), p.resumeMs());
+        CHECK(p.jitterMs() <= 1, "smooth jitter %u", p.jitterMs());
+        CHECK(p.throughput(60000) / 1000 == BPS, "throughput %u bytes/s", p.throughput(60000));
+    }
+    // bursty: a second of audio once a second, the floor covers the gap and resume twice it
+    {
+        Prebuffer p = make();
+        auto v = trace(300000, 1000, 0, 0, 0);
+        feed(p, v, 0, 10000);                                  // the deviation has not settled yet
+        CHECK(p.floorMs() > 1000 && p.startMs() == p.floorMs(), "bursty floor %u, start %u", p.floorMs(), p.startMs());
+        CHECK(p.resumeMs() == (2 * p.floorMs() > 8000 ? 8000 : 2 * p.floorMs()), "bursty resume %u", p.resumeMs());
+        feed(p, v, 10000);
+        CHECK(p.floorMs() >= 1000 && p.floorMs() < 1100, "bursty floor settled at %u", p.floorMs());
+        CHECK(p.startMs() == p.floorMs() && p.resumeMs() == 2 * p.floorMs(), "bursty %u / %u", p.startMs(), p.resumeMs());
+    }
+    // jittery: gaps of 20 and 180 ms, the floor is the peak plus four mean deviations
+    {
+        Prebuffer p = make();
+        feed(p, trace(30000, 100, 80, 0, 0));
+        CHECK(p.jitterMs() >= 60 && p.jitterMs() <= 100, "jitter %u", p.jitterMs());
+        CHECK(p.floorMs() >= 180 + 4 * 60 && p.floorMs() <= 180 + 4 * 100, "jittery floor %u", p.floorMs());
+    }
+    // stalling: a 3 s stall lifts the floor at once, smooth arrival every 50 ms makes it decay with PEAK_TAU to nothing
+    {
+        Prebuffer p = make();
+        auto v = trace(33000, 50, 0, 600, 3000);            // the stall ends at 32.95 s
+        for(uint32_t t = v.back().t + 50; t <= 120000; t += 50) v.push_back({t, 50 * BPS});
+        feed(p, v, 0, 33000);
+        CHECK(p.floorMs() >= 3000, "after the stall %u", p.floorMs());
+        CHECK(p.resumeMs() == (2 * p.floorMs() > 8000 ? 8000 : 2 * p.floorMs()), "resume after the stall %u", p.resumeMs());
+        feed(p, v, 33000);
+        CHECK(p.floorMs() < 3000 / 5 && p.floorMs() > 3000 / 10, "90 s later (2 tau) %u", p.floorMs());
+        for(uint32_t t = 120050; t <= 300000; t += 50) p.arrival(t, 50 * BPS);
+        CHECK(p.floorMs() < 100 + 5 && p.startMs() == 300, "4 min later %u / %u", p.floorMs(), p.startMs());
+        Prebuffer q = make();
+        q.arrival(0, 1000); q.resume(60000); q.arrival(60050, 1000);
+        CHECK(q.floorMs() < 200, "a reconnect is not a stall: %u", q.floorMs());
+    }
+    // learning: an underrun grows both by half plus a step, a stable run lowers them by an eighth, within the limits
+    {
+        Prebuffer p = make();
+        p.underrun(1000);
+        CHECK(p.learnedStart() == 550 && p.learnedResume() == 1700, "grown %u / %u", p.learnedStart(), p.learnedResume());
+        CHECK(!p.stable(1000 + 299999), "lowered before the stable time");
+        CHECK(p.stable(1000 + 300000), "not lowered after it");
+        CHECK(p.learnedStart() == 550 - 550 / 8 && p.learnedResume() == 1700 - 1700 / 8, "lowered %u / %u", p.learnedStart(), p.learnedResume());
+        for(int i = 0; i < 10; i++) p.underrun(0);
+        CHECK(p.learnedStart() == 8000 && p.learnedResume() == 8000, "max %u / %u", p.learnedStart(), p.learnedResume());
+        p.begin(50, 20, 0);
+        CHECK(p.learnedStart() == 100 && p.learnedResume() == 100, "min %u / %u", p.learnedStart(), p.learnedResume());
+        CHECK(!p.stable(300000), "nothing to lower at the minimum");
+        p.begin(500, 200, 0);
+        CHECK(p.learnedResume() == 500, "resume below start: %u", p.learnedResume());
+    }
+    // replays: the first bursts cost an underrun or two, then the thresholds hold
+    {
+        Prebuffer p = make();
+        Replay r = replay(p, trace(300000, 1000, 150, 0, 0));
+        CHECK(r.underruns >= 1 && r.underruns <= 2, "bursty replay: %u underruns", r.underruns);
+        CHECK(r.lastUnderrun < 10000, "bursty replay: underrun at %u ms", r.lastUnderrun);
+        Prebuffer q = make();
+        r = replay(q, trace(300000, 50, 10, 1000, 2500));   // a 2.5 s stall every 50 s
+        CHECK(r.underruns >= 1 && r.underruns <= 2, "stalling replay: %u underruns", r.underruns);
+        CHECK(r.lastUnderrun < 110000, "stalling replay: underrun at %u ms", r.lastUnderrun);
+        Prebuffer s = make();
+        r = replay(s, trace(300000, 91, 20, 0, 0));       // and a stable run lowers the learned start
+        CHECK(r.underruns == 0 && s.learnedStart() < 300, "smooth replay: %u underruns, start %u", r.underruns, s.learnedStart());
+    }
+    return done("prebuffer");
+}
@@ -0,0 +1,135 @@
+// ReadAhead: a simulated card with latency spikes fills the ring while the player takes a 320 kbps stream out of it.
+// The reads stay block aligned, the bytes come out in order, a spike shorter than the ring is not heard and one
+// longer is; end() leaves nothing behind that take() or space() could reach. Then the same with real threads.
+#include "check.h"
+#include "readahead.h"
+#include <thread>
+#include <vector>
+
+static uint8_t byteAt(uint32_t pos) { return (uint8_t)(pos * 31 + (pos >> 9)); }
+
+// a card: every read takes busyMs, every spikeEvery-th one spikeMs
+struct Card {
+    uint32_t size, busyMs, spikeMs, spikeEvery;
+    uint32_t reads = 0, misaligned = 0;
+    int32_t read(uint32_t pos, uint8_t* dst, uint32_t len, uint32_t block, bool first) {
+        if(pos >= size) return 0;
+        if(len > size - pos) len = size - pos;
+        if(first ? (pos + len) % block && pos + len != size : pos % block || (len != block && pos + len != size)) misaligned++;
+        for(uint32_t i = 0; i < len; i++) dst[i] = byteAt(pos + i);
+        reads++;
+        return len;
+    }
+    uint32_t latency() const { return spikeEvery && reads % spikeEvery == spikeEvery - 1 ? spikeMs : busyMs; }
+};
+
+struct Run { uint32_t bytes = 0, wrong = 0, short_ = 0, ms = 0; };
+
+// virtual milliseconds: the producer starts a read when the card is idle, it lands latency() ms later; from the
+// moment the ring is full the player takes bytesPerMs every ms
+static Run play(ReadAhead& ra, Card& card, uint32_t start, uint32_t bytesPerMs) {
+    Run r;
+    ra.reset(start, card.size);
+    uint32_t busyUntil = 0, pos = 0, len = 0;
+    uint8_t* dst = nullptr;
+    bool first = true, playing = false;
+    uint32_t want = start;
+    uint8_t buf[256];
+    for(uint32_t now = 0; now < 600000 && !ra.atEnd(); now++) {
+        if(dst && now >= busyUntil) {
+            ra.filled(card.read(pos, dst, len, ra.block(), first));
+            first = false; dst = nullptr;
+        }
+        if(!dst && (dst = ra.space(&pos, &len)) != nullptr) busyUntil = now + card.latency();
+        if(!playing) playing = !dst || ra.buffered() >= ra.capacity() - ra.block();
+        if(!playing) continue;
+        uint32_t got = ra.take(buf, bytesPerMs);
+        if(got < bytesPerMs && !ra.atEnd()) r.short_++;
+        for(uint32_t i = 0; i < got; i++, want++) if(buf[i] != byteAt(want)) r.wrong++;
+        r.bytes += got;
+        r.ms = now;
+    }
+    return r;
+}
+
+int main() {
+    static uint8_t mem[32 * 1024];
+    ReadAhead ra;
+    CHECK(!ra.begin(mem, 4096, 4096), "one block is no ring");
+    CHECK(!ra.ready() && !ra.space(nullptr, nullptr), "not ready");
+    CHECK(ra.begin(mem, sizeof(mem), 4000) && ra.block() == 3584, "block rounded down to the sector: %u", ra.block());
+    CHECK(ra.begin(mem, sizeof(mem), 4096) && ra.capacity() == sizeof(mem), "capacity %u", ra.capacity());
+
+    // 320 kbps is 40 bytes/ms; 2 ms a block, a 250 ms spike every 16 reads
+    const uint32_t rate = 40;
+    Card card{3 * 1000 * 1000 + 123, 2, 250, 16};
+    Run r = play(ra, card, 0, rate);
+    CHECK(r.bytes == card.size && r.wrong == 0, "%u of %u bytes, %u wrong", r.bytes, card.size, r.wrong);
+    CHECK(card.misaligned == 0, "%u reads off the block", card.misaligned);
+    CHECK(card.reads == (card.size + 4095) / 4096, "%u reads", card.reads);
+    CHECK(r.short_ == 0 && ra.misses() == 0, "250 ms spikes heard: %u short takes, %u misses", r.short_, ra.misses());
+    CHECK(ra.position() == card.size, "position %u", ra.position());
+
+    // from a position inside a block (a resume): the first read ends at the block boundary, then whole blocks
+    Card resume{card.size, 2, 250, 16};
+    uint32_t from = 1000 * 1000 + 777;
+    r = play(ra, resume, from, rate);
+    CHECK(r.bytes == card.size - from && r.wrong == 0, "resume: %u bytes, %u wrong", r.bytes, r.wrong);
+    CHECK(resume.misaligned == 0, "resume: %u reads off the block", resume.misaligned);
+
+    // the ring holds capacity / rate = 819 ms: a 700 ms spike is ridden out, a 1200 ms one is not
+    Card slow{1000 * 1000, 2, 700, 40};
+    r = play(ra, slow, 0, rate);
+    CHECK(r.wrong == 0 && r.short_ == 0, "700 ms spike: %u short takes", r.short_);
+    Card stall{1000 * 1000, 2, 1200, 40};
+    r = play(ra, stall, 0, rate);
+    CHECK(r.wrong == 0 && r.bytes == stall.size, "1200 ms spike: %u bytes, %u wrong", r.bytes, r.wrong);
+    CHECK(r.short_ > 0, "1200 ms spike not heard");
+
+    // a read that comes back empty ends the file early
+    ra.reset(0, 100000);
+    uint32_t pos, len;
+    CHECK(ra.space(&pos, &len) && pos == 0 && len == 4096, "space %u+%u", pos, len);
+    ra.filled(0);
+    CHECK(ra.atEnd() && !ra.space(&pos, &len), "empty read: at the end");
+
+    // end(): the memory is the owner's again, nothing reaches it, begin() starts over
+    ra.reset(0, 100000);
+    uint8_t* p = ra.space(&pos, &len);
+    memset(p, 1, len);
+    ra.filled(len);
+    ra.end();
+    uint8_t out[64];
+    CHECK(!ra.ready() && !ra.space(&pos, &len) && ra.take(out, sizeof(out)) == 0, "end(): ring still reachable");
+    CHECK(ra.buffered() == 0 && ra.position() == 0, "end(): %u buffered at %u", ra.buffered(), ra.position());
+    CHECK(ra.begin(mem, sizeof(mem), 4096) && ra.ready() && ra.buffered() == 0, "begin() after end()");
+
+    // real threads, the producer stalls now and then, the consumer takes odd sizes
+    const uint32_t size = 4 * 1000 * 1000 + 321;
+    ra.reset(0, size);
+    std::thread producer([&] {
+        Card c{size, 0, 0, 0};
+        bool first = true;
+        uint32_t pos, len, to = 0;
+        while(to < size) {
+            uint8_t* dst = ra.space(&pos, &len);
+            if(!dst) { std::this_thread::yield(); continue; }
+            if(c.reads % 97 == 96) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            ra.filled(c.read(pos, dst, len, ra.block(), first));
+            first = false;
+            to = pos + len;
+        }
+        CHECK(c.misaligned == 0, "threads: %u reads off the block", c.misaligned);
+    });
+    uint32_t want = 0, wrong = 0;
+    std::vector<uint8_t> buf(5000);
+    for(uint32_t i = 0; want < size; i++) {
+        uint32_t got = ra.take(buf.data(), 1 + i * 7919 % buf.size());
+        for(uint32_t k = 0; k < got; k++, want++) if(buf[k] != byteAt(want)) wrong++;
+        if(!got) std::this_thread::yield();
+    }
+    producer.join();
+    CHECK(want == size && wrong == 0 && ra.atEnd(), "threads: %u of %u bytes, %u wrong", want, size, wrong);
+
+    return done("readahead");
+}
@@ -0,0 +1,99 @@
+// Reconnect: the first attempt goes at once, the waits after it stay within the decorrelated jitter bounds and the
+// cap, radios with other seeds spread out, the last try lands on the give-up deadline, and the health score moves
+// a quarter of the way to each outcome's target.
+#include "check.h"
+#include "reconnect.h"
+#include <set>
+#include <vector>
+
+// a drop that never comes back: the times of all attempts until the give-up
+static std::vector<uint32_t> schedule(Reconnect& r, uint32_t t0, uint32_t seed, uint32_t* waitsOut = nullptr) {
+    std::vector<uint32_t> at;
+    r.begin(t0, seed);
+    uint32_t now = t0, prev = 250, bad = 0;
+    while(r.active()) {
+        if(!r.due(now)) { now += r.waitMs(now); continue; }
+        r.attempt();
+        at.push_back(now);
+        if(!r.retry(now)) break;
+        uint32_t w = r.waitMs(now), hi = prev * 3 > 8000 ? 8000 : prev * 3;
+        bool last = now + w - t0 == 60000;
+        if(!last && (w < 250 || w > hi)) bad++;
+        prev = w;
+    }
+    if(waitsOut) *waitsOut = bad;
+    return at;
+}
+
+int main() {
+    Reconnect r;
+    r.setLimits(250, 8000, 60000);
+
+    // the first attempt is made at once
+    r.begin(1000, 7);
+    CHECK(r.active() && r.due(1000) && r.waitMs(1000) == 0, "first attempt not at once");
+
+    // the waits: between the minimum and three times the previous one, never above the cap; they reach it
+    uint32_t bad = 0;
+    std::vector<uint32_t> at = schedule(r, 1000, 12345, &bad);
+    CHECK(bad == 0, "%u waits out of their bounds", bad);
+    CHECK(!r.active() && at.size() >= 10, "%zu attempts", at.size());
+    uint32_t maxWait = 0;
+    for(size_t i = 1; i < at.size(); i++) if(at[i] - at[i - 1] > maxWait) maxWait = at[i] - at[i - 1];
+    CHECK(maxWait > 4000 && maxWait <= 8000, "longest wait %u ms", maxWait);
+    CHECK(r.attempts() == at.size(), "attempts %u of %zu", r.attempts(), at.size());
+
+    // give up: the last try is on the deadline, nothing after it
+    CHECK(at.back() == 1000 + 60000, "last attempt at %u", at.back());
+    CHECK(!r.due(at.back() + 100000) && r.waitMs(at.back()) == 0, "due after the give-up");
+
+    // jitter: the same seed gives the same schedule, other seeds spread out
+    CHECK(schedule(r, 1000, 12345) == at, "the same seed, another schedule");
+    std::set<uint32_t> second;                              // when each of 50 radios makes its third attempt after a common drop
+    std::set<std::vector<uint32_t>> all;
+    for(uint32_t seed = 1; seed <= 50; seed++) {
+        std::vector<uint32_t> s = schedule(r, 1000, seed * 2654435761u);
+        if(s.size() > 2) second.insert(s[2]);
+        all.insert(s);
+    }
+    CHECK(all.size() == 50, "%zu distinct schedules of 50", all.size());
+    CHECK(second.size() >= 40, "third attempts on only %zu distinct times", second.size());
+
+    // across the millis() wrap
+    std::vector<uint32_t> wrapped = schedule(r, 0xFFFFF000u, 12345);
+    CHECK(wrapped.size() == at.size() && wrapped.back() == 0xFFFFF000u + 60000, "wrap: %zu attempts, last %u", wrapped.size(), wrapped.back());
+
+    // a short give-up time ends with the try at the deadline after a shortened wait
+    Reconnect s;
+    s.setLimits(1000, 8000, 1500);
+    s.begin(0, 3);
+    s.attempt();
+    CHECK(s.retry(0) && s.waitMs(0) >= 1000 && s.waitMs(0) <= 1500, "wait %u", s.waitMs(0));
+    CHECK(s.retry(1200) && s.waitMs(1200) == 300, "the last wait %u, up to the deadline", s.waitMs(1200));
+    CHECK(!s.retry(1500) && !s.active(), "no give up at the deadline");
+
+    // outcomes
+    r.begin(0, 0);
+    CHECK(r.done() == Reconnect::SEAMLESS && !r.active(), "seamless");
+    r.begin(0, 0);
+    r.dry();
+    CHECK(r.done() == Reconnect::GAP, "gap");
+    r.begin(0, 0);
+    r.cancel();
+    CHECK(!r.active() && !r.due(0), "cancel");
+
+    // health: a quarter of the way, rounded away from the current value, until it is there
+    CHECK(Reconnect::score(100, Reconnect::FAILED) == 75, "%u", Reconnect::score(100, Reconnect::FAILED));
+    CHECK(Reconnect::score(100, Reconnect::GAP) == 85, "%u", Reconnect::score(100, Reconnect::GAP));
+    CHECK(Reconnect::score(60, Reconnect::SEAMLESS) == 63, "%u", Reconnect::score(60, Reconnect::SEAMLESS));
+    CHECK(Reconnect::score(42, Reconnect::NONE) == 42 && Reconnect::score(42, 9) == 42, "no outcome moves it");
+    static const uint8_t target[] = { 0, 70, 40, 0, 100 };
+    for(uint8_t o = Reconnect::SEAMLESS; o <= Reconnect::STABLE; o++) {
+        uint8_t h = o == Reconnect::STABLE ? 0 : 100;
+        int steps = 0;
+        while(h != target[o] && steps < 100) { h = Reconnect::score(h, o); steps++; }
+        CHECK(h == target[o] && steps <= 20, "outcome %u: %u after %d steps", o, h, steps);
+        CHECK(Reconnect::score(h, o) == h, "outcome %u: moved at its target", o);
+    }
+    return done("reconnect");
+}
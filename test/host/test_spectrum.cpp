@@ -0,0 +1,75 @@
+// SpectrumFft against a double precision DFT: 256, 512 and 1024 points, sines in and between bins, the band levels.
+#include "check.h"
+#include "spectrumfft.h"
+#include <math.h>
+#include <vector>
+
+static void sine(std::vector<int16_t>& ring, double cycles, double amp) {
+    for(size_t i = 0; i < ring.size(); i++) ring[i] = (int16_t)lround(amp * sin(2 * M_PI * cycles * i / ring.size()));
+}
+
+// |X[k]|^2 of the Hann windowed ring, scaled by 1/n like the fixed point FFT
+static double dftPower(const std::vector<int16_t>& ring, uint16_t k) {
+    size_t n = ring.size();
+    double re = 0, im = 0;
+    for(size_t i = 0; i < n; i++) {
+        double w = i < n / 2 ? 0.5 * (1 - cos(2 * M_PI * i / (n - 1))) : 0.5 * (1 - cos(2 * M_PI * (n - 1 - i) / (n - 1)));
+        re += ring[i] * w * cos(2 * M_PI * k * i / n);
+        im -= ring[i] * w * sin(2 * M_PI * k * i / n);
+    }
+    return (re * re + im * im) / ((double)n * n);
+}
+
+int main() {
+    const uint16_t sizes[] = {256, 512, 1024};
+    CHECK(!SpectrumFft::valid(128) && !SpectrumFft::valid(2048) && !SpectrumFft::valid(500), "only 256, 512 and 1024");
+    for(uint16_t n : sizes) {
+        SpectrumFft fft;
+        CHECK(fft.begin(n), "begin(%u)", n);
+        std::vector<int16_t> ring(n);
+        const double bins[] = {3, 17, 40.5, n / 4.0 + 1, n / 2.0 - 9};
+        for(double b : bins) {
+            sine(ring, b, 16000);
+            fft.run(ring.data(), 0);
+            const int16_t* x = fft.bins();
+            uint16_t peak = 0;
+            double pmax = -1;
+            for(uint16_t k = 1; k < n / 2; k++) {
+                double p = (double)x[2 * k] * x[2 * k] + (double)x[2 * k + 1] * x[2 * k + 1];
+                if(p > pmax) { pmax = p; peak = k; }
+            }
+            CHECK(fabs(peak - b) <= 0.5, "n %u: sine at bin %.1f peaks at %u", n, b, peak);
+            double ref = dftPower(ring, peak);
+            CHECK(fabs(10 * log10((pmax + 1) / (ref + 1))) < 1.0, "n %u bin %.1f: %.0f vs DFT %.0f", n, b, pmax, ref);
+        }
+        // a rotated ring is the same signal
+        sine(ring, 17, 16000);
+        std::vector<int16_t> rot(n);
+        for(uint16_t i = 0; i < n; i++) rot[(i + 100) % n] = ring[i];
+        fft.run(rot.data(), 100);
+        double mag = sqrt((double)fft.bins()[34] * fft.bins()[34] + (double)fft.bins()[35] * fft.bins()[35]);
+        CHECK(fabs(mag - sqrt(dftPower(ring, 17))) < 64, "n %u: ring position, %.0f", n, mag);
+
+        // bands: a full scale sine tops its band, silence is 0, the neighbours far down
+        volatile uint8_t levels[SpectrumFft::BANDS_MAX];
+        sine(ring, 1000.0 * n / 44100, 32000);
+        fft.run(ring.data(), 0);
+        fft.bands(levels, 16, 44100);
+        uint8_t top = 0, topBand = 0;
+        for(uint8_t b = 0; b < 16; b++) if(levels[b] > top) { top = levels[b]; topBand = b; }
+        CHECK(top > 200, "n %u: 1 kHz full scale level %u", n, top);
+        double lo = 50 * pow(16000 / 50.0, topBand / 16.0), hi = 50 * pow(16000 / 50.0, (topBand + 1) / 16.0);
+        // at 256 points the low bands are a bin each and push the edges above them up
+        if(n >= 512) CHECK(lo <= 1000 * 1.1 && hi >= 1000 / 1.1, "n %u: 1 kHz in band %u (%.0f-%.0f Hz)", n, topBand, lo, hi);
+        CHECK(levels[0] < 60 && levels[15] < 60, "n %u: far bands %u %u", n, levels[0], levels[15]);
+        for(auto& s : ring) s = 0;
+        fft.run(ring.data(), 0);
+        fft.bands(levels, 64, 48000);
+        bool quiet = true;
+        for(uint8_t b = 0; b < 64; b++) quiet &= levels[b] == 0;
+        CHECK(quiet, "n %u: silence", n);
+        fft.end();
+    }
+    CHECK(SpectrumFft::log2q4(1) == 0 && SpectrumFft::log2q4(1 << 20) == 20 << 4 && SpectrumFft::log2q4(3) == (1 << 4 | 8), "log2q4");
+    return done("spectrum");
+}
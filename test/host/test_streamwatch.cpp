@@ -0,0 +1,136 @@
+// StreamWatch with crafted PCM and byte counts: music, quiet speech with pauses, digital zero, dither, a looping
+// buffer, a decoder that stopped with data buffered, a starved socket, and the action ladder.
+#include "check.h"
+#include "streamwatch.h"
+#include <math.h>
+#include <stdlib.h>
+#include <functional>
+#include <vector>
+
+static const uint32_t RATE = 44100, BLOCK = 1152;             // an mp3 frame, 26 ms
+
+// level in dBFS of the block starting at frame f, -200 = digital zero
+typedef std::function<double(uint32_t f)> level_t;
+
+struct Sim {
+    StreamWatch w;
+    uint32_t now = 1000, frame = 0;
+    std::vector<int16_t> blk = std::vector<int16_t>(BLOCK * 2);
+    Sim() {
+        w.setup(-66, 20, 10, 5, 50, 20);
+        w.arm(now);
+    }
+    // noise at the level, decoded blocks as they are played, check() every 100 ms; the first reason and when
+    uint8_t play(uint32_t seconds, level_t level, uint32_t bytesPerSec = 16000, uint32_t arrivePct = 100, uint32_t* at = nullptr) {
+        uint32_t end = now + seconds * 1000, nextBlk = now, nextChk = now;
+        while(now < end) {
+            if(now >= nextBlk) {
+                double db = level(frame);
+                double a = db <= -200 ? 0 : 32767 * pow(10, db / 20) * 1.7;   // uniform noise: RMS a / 1.7
+                for(uint32_t i = 0; i < BLOCK * 2; i++) blk[i] = a ? (int16_t)lround((rand() / (double)RAND_MAX * 2 - 1) * a) : 0;
+                w.pcm(blk.data(), BLOCK, now);
+                frame += BLOCK;
+                nextBlk += BLOCK * 1000 / RATE;
+            }
+            if(now >= nextChk) {
+                w.input(bytesPerSec / 10 * arrivePct / 100);
+                uint8_t why = w.check(now, true, 64000, bytesPerSec);
+                if(why) { if(at) *at = now; return why; }
+                nextChk += 100;
+            }
+            now++;
+        }
+        return StreamWatch::NONE;
+    }
+};
+
+int main() {
+    srand(7);
+    // music and loud speech go on for minutes
+    {
+        Sim s;
+        CHECK(s.play(120, [](uint32_t) { return -20.0; }) == StreamWatch::NONE, "music");
+    }
+    // quiet speech: a second at -50 dBFS every 8 s, digital zero between
+    {
+        Sim s;
+        CHECK(s.play(120, [](uint32_t f) { return f / RATE % 8 == 0 ? -50.0 : -200.0; }) == StreamWatch::NONE, "speech with pauses");
+    }
+    // digital zero, dither of one LSB and comfort noise at -75 dBFS: silent after WATCH_SILENCE_S
+    for(double db : {-200.0, -90.0, -75.0}) {
+        Sim s;
+        uint32_t at = 0, t0 = s.now;
+        uint8_t why = s.play(60, [db](uint32_t) { return db; }, 16000, 100, &at);
+        CHECK(why == StreamWatch::SILENT && at - t0 >= 20000 && at - t0 < 20300, "%.0f dBFS: %s after %u ms", db, StreamWatch::name(why), at - t0);
+    }
+    // a stream that stops into silence: detected from its end, once, then watched from scratch
+    {
+        Sim s;
+        uint32_t at = 0, t0 = s.now;
+        CHECK(s.play(90, [](uint32_t f) { return f < RATE * 30 ? -20.0 : -200.0; }, 16000, 100, &at) == StreamWatch::SILENT, "music, then silence");
+        CHECK(at - t0 >= 49800 && at - t0 < 50300, "silent 20 s after the music: %u ms", at - t0);
+        uint32_t again = 0;
+        t0 = s.now;
+        CHECK(s.play(30, [](uint32_t) { return -200.0; }, 16000, 100, &again) == StreamWatch::SILENT && again - t0 >= 19900, "next report after %u ms", again - t0);
+    }
+
+    // a buffer that loops: the same 40 blocks over and over
+    {
+        Sim s;
+        std::vector<std::vector<int16_t>> loop(40, std::vector<int16_t>(BLOCK * 2));
+        for(auto& b : loop) for(auto& v : b) v = (int16_t)(rand() % 20000 - 10000);
+        uint32_t t0 = s.now, why = 0;
+        for(uint32_t i = 0; !why && i < 2000; i++) {
+            s.w.pcm(loop[i % 40].data(), BLOCK, s.now);
+            s.now += 26;
+            if(i % 4 == 0) why = s.w.check(s.now, true, 64000, 0);
+        }
+        CHECK(why == StreamWatch::FROZEN && s.now - t0 >= 10000 && s.now - t0 < 11100, "loop of 40 blocks: %s after %u ms", StreamWatch::name(why), s.now - t0);
+    }
+
+    // the decoder stopped: no blocks while a second is buffered is STUCK, with an empty buffer it is not
+    {
+        StreamWatch w;
+        w.setup(-66, 20, 10, 5, 0, 0);
+        uint32_t now = 0;
+        w.arm(now);
+        uint8_t why = 0;
+        for(now = 0; !why && now < 20000; now += 100) why = w.check(now, true, 100, 16000);
+        CHECK(why == StreamWatch::NONE, "nothing buffered: %s", StreamWatch::name(why));
+        w.arm(now);
+        uint32_t t0 = now;
+        for(; !why && now < t0 + 20000; now += 100) why = w.check(now, true, 32000, 16000);
+        CHECK(why == StreamWatch::STUCK && now - t0 >= 5000 && now - t0 <= 5200, "buffered: %s after %u ms", StreamWatch::name(why), now - t0);
+        // prebuffering is not decoding
+        w.arm(now);
+        why = 0;
+        for(t0 = now; now < t0 + 20000; now += 100) why |= w.check(now, false, 32000, 16000);
+        CHECK(why == StreamWatch::NONE, "prebuffering: %s", StreamWatch::name(why));
+    }
+
+    // starved: 30 % of the bitrate arrives while the buffer still plays music; 80 % is fine
+    {
+        Sim s;
+        uint32_t at = 0, t0 = s.now;
+        CHECK(s.play(60, [](uint32_t) { return -20.0; }, 16000, 30, &at) == StreamWatch::STARVED && at - t0 >= 20000 && at - t0 < 20200, "30 %% arrives: after %u ms", at - t0);
+        Sim ok;
+        CHECK(ok.play(60, [](uint32_t) { return -20.0; }, 16000, 80) == StreamWatch::NONE, "80 %% arrives");
+        Sim unknown;
+        CHECK(unknown.play(60, [](uint32_t) { return -20.0; }, 0, 0) == StreamWatch::NONE, "bitrate not known");
+    }
+
+    // off when disarmed
+    {
+        Sim s;
+        s.w.disarm();
+        CHECK(s.play(60, [](uint32_t) { return -200.0; }) == StreamWatch::NONE, "disarmed");
+    }
+
+    // the ladder: the default (1) reconnects once and then only alerts; NEXT and ALTERNATE are opt-in rungs
+    CHECK(StreamWatch::action(0, 1) == StreamWatch::RECONNECT && StreamWatch::action(1, 1) == StreamWatch::ALERT, "ladder 1");
+    CHECK(StreamWatch::action(0, 0) == StreamWatch::ALERT && StreamWatch::rungs(0) == 0, "ladder 0");
+    CHECK(StreamWatch::action(0, 7) == StreamWatch::RECONNECT && StreamWatch::action(1, 7) == StreamWatch::ALTERNATE &&
+          StreamWatch::action(2, 7) == StreamWatch::NEXT && StreamWatch::action(3, 7) == StreamWatch::ALERT && StreamWatch::rungs(7) == 3, "ladder 7");
+    CHECK(StreamWatch::action(0, 4) == StreamWatch::NEXT && StreamWatch::action(1, 5) == StreamWatch::NEXT, "ladder 4 and 5");
+    return done("streamwatch");
+}
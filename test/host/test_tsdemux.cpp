@@ -0,0 +1,166 @@
+// TsDemux conformance: PAT/PMT discovery, payload over read boundaries, repeated and lost packets, lost sync,
+// bad CRCs and error flags, long PES headers, the discontinuity indicator.
+#include "check.h"
+#include "tsgen.h"
+#include "tsdemux.h"
+#include <algorithm>
+#include <vector>
+
+// as Audio feeds it: reads of chunk bytes, whatever parse() leaves waits for the next read
+static std::vector<uint8_t> demux(TsDemux& ts, const std::vector<uint8_t>& in, size_t chunk) {
+    std::vector<uint8_t> out, buf;
+    TsDemux::span_t spans[TS_BATCH];
+    for(size_t pos = 0; pos < in.size(); pos += chunk) {
+        buf.insert(buf.end(), in.begin() + pos, in.begin() + (pos + chunk < in.size() ? pos + chunk : in.size()));
+        uint32_t used;
+        uint16_t n;
+        size_t at = 0;
+        do {
+            used = ts.parse(buf.data() + at, buf.size() - at, spans, TS_BATCH, &n);
+            for(uint16_t i = 0; i < n; i++) out.insert(out.end(), spans[i].data, spans[i].data + spans[i].len);
+            at += used;
+        } while(used);
+        buf.erase(buf.begin(), buf.begin() + at);
+    }
+    return out;
+}
+
+static TsGen stream(int pes, size_t len) {
+    TsGen g;
+    g.pat();
+    g.pmt();
+    for(int i = 0; i < pes; i++) g.pes(len + i * 37 % 500);
+    return g;
+}
+
+int main() {
+    // clean stream, whole and in reads that cut packets
+    TsGen g = stream(40, 900);
+    for(size_t chunk : {g.ts.size(), (size_t)1000, (size_t)188 * TS_BATCH, (size_t)61}) {
+        TsDemux ts;
+        std::vector<uint8_t> out = demux(ts, g.ts, chunk);
+        CHECK(out == g.audio, "reads of %zu: %zu of %zu bytes", chunk, out.size(), g.audio.size());
+        CHECK(ts.audioPid() == TsGen::AUDIO_PID && ts.streamType() == 0x0F, "reads of %zu: pid %x type %x", chunk, ts.audioPid(), ts.streamType());
+        CHECK(ts.ccErrors() == 0 && ts.resyncs() == 0 && ts.badPackets() == 0 && ts.dropped() == 0, "reads of %zu: clean", chunk);
+        CHECK(ts.packets() == g.ts.size() / 188, "reads of %zu: %u packets", chunk, ts.packets());
+    }
+
+    // AAC LATM is audio too
+    {
+        TsGen l;
+        l.pat(); l.pmt(0x11); l.pes(500);
+        TsDemux ts;
+        CHECK(demux(ts, l.ts, l.ts.size()) == l.audio && ts.streamType() == 0x11, "LATM");
+    }
+
+    // a packet sent twice is dropped
+    {
+        TsGen d;
+        d.pat(); d.pmt();
+        std::vector<size_t> at;
+        d.pes(1000, 0, &at);
+        std::vector<uint8_t> in = d.ts;
+        in.insert(in.begin() + at[2] + 188, d.ts.begin() + at[2], d.ts.begin() + at[2] + 188);
+        TsDemux ts;
+        CHECK(demux(ts, in, 500) == d.audio && ts.ccErrors() == 0, "repeated packet");
+    }
+
+    // a lost packet drops the rest of its PES packet, the next one plays
+    {
+        TsGen d;
+        d.pat(); d.pmt();
+        d.pes(600);
+        size_t first = d.audio.size();
+        std::vector<size_t> at;
+        d.pes(600, 0, &at);
+        size_t second = d.audio.size();
+        d.pes(600);
+        std::vector<uint8_t> in = d.ts;
+        in.erase(in.begin() + at[1], in.begin() + at[1] + 188);
+        std::vector<uint8_t> want(d.audio.begin(), d.audio.begin() + first + 184 - 14);
+        want.insert(want.end(), d.audio.begin() + second, d.audio.end());
+        TsDemux ts;
+        CHECK(demux(ts, in, 1000) == want && ts.ccErrors() == 1, "lost packet: ccErrors %u", ts.ccErrors());
+    }
+
+    // a counter jump with the discontinuity indicator is no error
+    {
+        TsGen d;
+        d.pat(); d.pmt();
+        d.pes(400);
+        d.cc[TsGen::AUDIO_PID] += 5;
+        d.pes(400, 0, nullptr, true);
+        TsDemux ts;
+        CHECK(demux(ts, d.ts, d.ts.size()) == d.audio && ts.ccErrors() == 0, "discontinuity: ccErrors %u", ts.ccErrors());
+    }
+
+    // garbage between packets and a cut packet: sync is found again, nothing else is lost
+    {
+        TsGen d;
+        d.pat(); d.pmt();
+        std::vector<size_t> at;
+        d.pes(800);
+        d.pes(800, 0, &at);
+        std::vector<uint8_t> in = d.ts;
+        in.insert(in.begin() + at[0], 50, 0x00);
+        TsDemux ts;
+        CHECK(demux(ts, in, 700) == d.audio, "garbage between packets");
+        CHECK(ts.resyncs() == 1 && ts.dropped() == 50, "garbage: resyncs %u dropped %u", ts.resyncs(), ts.dropped());
+
+        in = d.ts;
+        in.erase(in.begin() + at[0] + 100, in.begin() + at[0] + 188);   // half of the PES start is gone
+        TsDemux cut;
+        std::vector<uint8_t> out = demux(cut, in, 700);
+        CHECK(cut.resyncs() == 1 && out.size() < d.audio.size(), "cut packet: resyncs %u, %zu bytes", cut.resyncs(), out.size());
+    }
+
+    // a PAT with a bad CRC is ignored until a good one comes
+    {
+        TsGen d;
+        d.pat(true); d.pmt();
+        d.pes(300);
+        size_t lost = d.audio.size();
+        d.pat(); d.pmt();
+        d.pes(300);
+        TsDemux ts;
+        std::vector<uint8_t> out = demux(ts, d.ts, d.ts.size());
+        CHECK(out.size() == d.audio.size() - lost && std::equal(out.begin(), out.end(), d.audio.begin() + lost), "bad CRC");
+        CHECK(ts.badPackets() == 1, "bad CRC: badPackets %u", ts.badPackets());
+    }
+
+    // transport error indicator, null packets and other PIDs
+    {
+        TsGen d;
+        d.pat(); d.pmt();
+        d.pes(300);
+        uint8_t payload[184] = {};
+        d.packet(0x1FFF, false, payload, sizeof(payload));
+        d.packet(0x100, true, payload, sizeof(payload));
+        size_t bad = d.ts.size();
+        d.packet(0x200, false, payload, sizeof(payload));
+        d.ts[bad + 1] |= 0x80;
+        d.pes(300);
+        TsDemux ts;
+        CHECK(demux(ts, d.ts, d.ts.size()) == d.audio && ts.badPackets() == 1, "error flag: badPackets %u", ts.badPackets());
+    }
+
+    // a PES header longer than its packet goes on in the next one
+    {
+        TsGen d;
+        d.pat(); d.pmt();
+        d.pes(700, 180);
+        d.pes(700, 100);
+        TsDemux ts;
+        CHECK(demux(ts, d.ts, 1000) == d.audio, "long PES header");
+    }
+
+    // reset(): PIDs and counters are learned again
+    {
+        TsDemux ts;
+        demux(ts, g.ts, g.ts.size());
+        ts.reset();
+        CHECK(ts.audioPid() == 0 && ts.packets() == 0, "reset");
+        CHECK(demux(ts, g.ts, 4000) == g.audio, "after reset");
+    }
+    return done("tsdemux");
+}
@@ -0,0 +1,90 @@
+// Ttfs: known tunes marked phase by phase (https, http on a warm connection, a redirect, a local file) and the
+// breakdown format() and json() give of them; once(), cancel(), the end of a tune, a cut off buffer, the clamp
+// and the millis() wrap.
+#include "check.h"
+#include "ttfs.h"
+#include <string.h>
+#include <string>
+
+static std::string fmt(const Ttfs& t, uint16_t size = 512) { char b[512]; t.format(b, size); return b; }
+static std::string json(const Ttfs& t, uint16_t size = 512) { char b[512]; t.json(b, size); return b; }
+
+int main() {
+    Ttfs t;
+    CHECK(!t.active() && !t.mark(Ttfs::OUTPUT, 5), "marked before begin()");
+
+    // an https station from the queue to the first write to the output
+    t.begin(1000);
+    static const uint32_t https[Ttfs::PHASES] = {1002, 1017, 1020, 1050, 1110, 1400, 1480, 1490, 1800, 1810, 1834};
+    for(uint8_t i = 0; i < Ttfs::OUTPUT; i++) CHECK(!t.mark(i, https[i]), "%s completed the tune", Ttfs::name(i));
+    CHECK(t.mark(Ttfs::OUTPUT, https[Ttfs::OUTPUT]) && !t.active(), "output did not complete it");
+    CHECK(t.total() == 834 && t.at(Ttfs::TLS) == 400 && t.spent(Ttfs::TLS) == 290, "total %u, tls at %u for %u", t.total(), t.at(Ttfs::TLS), t.spent(Ttfs::TLS));
+    CHECK(fmt(t) == "834 ms: queue 2, load 15, call 3, dns 30, connect 60, tls 290, headers 80, firstbyte 10, prebuffer 310, decode 10, output 24",
+          "format: %s", fmt(t).c_str());
+    CHECK(json(t) == "\"ms\":834,\"queue\":2,\"load\":15,\"call\":3,\"dns\":30,\"connect\":60,\"tls\":290,\"headers\":80,\"firstbyte\":10,"
+                     "\"prebuffer\":310,\"decode\":10,\"output\":24", "json: %s", json(t).c_str());
+    CHECK(!t.mark(Ttfs::DECODE, 2000) && t.spent(Ttfs::DECODE) == 10, "marked after the tune was complete");
+
+    // http on a warm connection: no dns, no tls, the headers count from the connect
+    t.begin(0);
+    t.mark(Ttfs::QUEUE, 1); t.mark(Ttfs::LOAD, 5); t.mark(Ttfs::CALL, 6); t.mark(Ttfs::CONNECT, 20);
+    t.mark(Ttfs::HEADERS, 70); t.mark(Ttfs::FIRST_BYTE, 71); t.mark(Ttfs::PREBUFFER, 400); t.mark(Ttfs::DECODE, 402);
+    CHECK(fmt(t) == "- ms: queue 1, load 4, call 1, dns -, connect 14, tls -, headers 50, firstbyte 1, prebuffer 329, decode 2, output -",
+          "incomplete: %s", fmt(t).c_str());
+    CHECK(json(t).find("\"ms\":null,") == 0 && json(t).find("\"dns\":null,\"connect\":14,\"tls\":null,\"headers\":50") != std::string::npos,
+          "incomplete json: %s", json(t).c_str());
+    t.mark(Ttfs::OUTPUT, 450);
+    CHECK(t.total() == 450 && t.spent(Ttfs::OUTPUT) == 48, "output %u after %u", t.total(), t.spent(Ttfs::OUTPUT));
+
+    // a redirect: the second connection marks its phases again and clears what the first one had behind them
+    t.begin(0);
+    t.mark(Ttfs::QUEUE, 1); t.mark(Ttfs::LOAD, 3); t.mark(Ttfs::CALL, 4); t.mark(Ttfs::DNS, 30); t.mark(Ttfs::CONNECT, 60);
+    t.mark(Ttfs::HEADERS, 100);                             // 302
+    t.mark(Ttfs::DNS, 140); t.mark(Ttfs::CONNECT, 170); t.mark(Ttfs::TLS, 500);
+    CHECK(t.at(Ttfs::HEADERS) == Ttfs::NONE && t.spent(Ttfs::DNS) == 136, "the first connection stayed: headers %u, dns %u",
+          t.at(Ttfs::HEADERS), t.spent(Ttfs::DNS));
+    t.mark(Ttfs::HEADERS, 560); t.mark(Ttfs::FIRST_BYTE, 565); t.mark(Ttfs::PREBUFFER, 900); t.mark(Ttfs::DECODE, 905); t.mark(Ttfs::OUTPUT, 930);
+    CHECK(fmt(t) == "930 ms: queue 1, load 2, call 1, dns 136, connect 30, tls 330, headers 60, firstbyte 5, prebuffer 335, decode 5, output 25",
+          "redirect: %s", fmt(t).c_str());
+
+    // a local file: no network phases; once() keeps the first time
+    t.begin(0);
+    t.mark(Ttfs::QUEUE, 0); t.mark(Ttfs::LOAD, 2); t.mark(Ttfs::CALL, 3);
+    CHECK(t.once(Ttfs::PREBUFFER, 40) == false && !t.once(Ttfs::PREBUFFER, 90) && t.at(Ttfs::PREBUFFER) == 40, "once() moved it");
+    t.once(Ttfs::DECODE, 60);
+    CHECK(t.once(Ttfs::OUTPUT, 61) && !t.once(Ttfs::OUTPUT, 99) && t.total() == 61, "once() of the output");
+    CHECK(fmt(t) == "61 ms: queue 0, load 2, call 1, dns -, connect -, tls -, headers -, firstbyte -, prebuffer 37, decode 20, output 1",
+          "local file: %s", fmt(t).c_str());
+
+    // cancel(): a tune given up, nothing more is marked
+    t.begin(0);
+    t.mark(Ttfs::QUEUE, 1);
+    t.cancel();
+    CHECK(!t.active() && !t.mark(Ttfs::LOAD, 5) && t.at(Ttfs::LOAD) == Ttfs::NONE, "marked after cancel()");
+    CHECK(!t.mark(Ttfs::PHASES, 5) && Ttfs::name(Ttfs::PHASES)[0] == '\0' && t.at(Ttfs::PHASES) == Ttfs::NONE, "out of range");
+
+    // cut off: terminated inside the buffer, a start of the whole
+    t.begin(1000);
+    for(uint8_t i = 0; i < Ttfs::PHASES; i++) t.mark(i, https[i]);
+    std::string whole = fmt(t), wholeJ = json(t);
+    for(uint16_t size : {1, 2, 7, 40, 100}) {
+        char b[128];
+        memset(b, 'X', sizeof(b));
+        uint16_t n = t.format(b, size);
+        CHECK(n < size && b[n] == '\0' && b[size] == 'X' && whole.compare(0, n, b) == 0, "format into %u: %u", size, n);
+        n = t.json(b, size);
+        CHECK(n < size && b[n] == '\0' && b[size] == 'X' && wholeJ.compare(0, n, b) == 0, "json into %u: %u", size, n);
+    }
+    CHECK(t.format(nullptr, 0) == 0 && t.json(nullptr, 0) == 0, "into nothing");
+
+    // over a minute is clamped below NONE, the millis() wrap is no jump
+    t.begin(0);
+    t.mark(Ttfs::QUEUE, 70000);
+    CHECK(t.at(Ttfs::QUEUE) == Ttfs::NONE - 1, "clamp %u", t.at(Ttfs::QUEUE));
+    t.begin(0xFFFFFF00u);
+    t.mark(Ttfs::QUEUE, 0x100);
+    CHECK(t.at(Ttfs::QUEUE) == 512, "wrap %u", t.at(Ttfs::QUEUE));
+
+    printf("%s\n", whole.c_str());                          // the breakdown as the harness runs print it
+    return done("ttfs");
+}
@@ -0,0 +1,82 @@
+// Transport stream writer for the TsDemux tests: PAT, PMT and audio PES packets with a known payload.
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+class TsGen {
+  public:
+    static const uint16_t PMT_PID = 0x1000, AUDIO_PID = 0x101;
+
+    std::vector<uint8_t> ts;                                // the stream
+    std::vector<uint8_t> audio;                             // the audio payload it carries, in order
+    uint8_t cc[0x2000] = {};
+
+    static uint32_t crc32(const uint8_t* d, size_t n) {
+        uint32_t crc = 0xFFFFFFFF;
+        while(n--) {
+            crc ^= (uint32_t)*d++ << 24;
+            for(int b = 0; b < 8; b++) crc = crc & 0x80000000 ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+        return crc;
+    }
+
+    // one packet, a short payload is padded with adaptation field stuffing (len <= 182 with disc)
+    void packet(uint16_t pid, bool start, const uint8_t* payload, size_t len, bool disc = false) {
+        uint8_t p[188];
+        memset(p, 0xFF, sizeof(p));
+        p[0] = 0x47;
+        p[1] = (start ? 0x40 : 0) | (pid >> 8);
+        p[2] = pid & 0xFF;
+        uint8_t off = 4;
+        if(len < 184 || disc) {
+            uint8_t afl = 183 - len;
+            p[3] = 0x30;
+            p[4] = afl;
+            if(afl) p[5] = disc ? 0x80 : 0x00;
+            off = 5 + afl;
+        }
+        else p[3] = 0x10;
+        p[3] |= cc[pid]++ & 0x0F;
+        memcpy(p + off, payload, len);
+        ts.insert(ts.end(), p, p + 188);
+    }
+
+    void section(uint16_t pid, std::vector<uint8_t> s, bool badCrc = false) {
+        uint32_t crc = crc32(s.data(), s.size()) ^ (badCrc ? 1 : 0);
+        for(int i = 3; i >= 0; i--) s.push_back(crc >> (i * 8));
+        s.insert(s.begin(), 0);                             // pointer field
+        packet(pid, true, s.data(), s.size());
+    }
+
+    void pat(bool badCrc = false) {
+        section(0, {0x00, 0xB0, 13, 0x00, 0x01, 0xC1, 0x00, 0x00, 0x00, 0x01, (uint8_t)(0xE0 | PMT_PID >> 8), PMT_PID & 0xFF}, badCrc);
+    }
+
+    // a video stream first, then the audio one
+    void pmt(uint8_t type = 0x0F) {
+        section(PMT_PID, {0x02, 0xB0, 23, 0x00, 0x01, 0xC1, 0x00, 0x00, 0xE1, 0x00, 0xF0, 0x00,
+                          0x1B, 0xE1, 0x00, 0xF0, 0x00,
+                          type, (uint8_t)(0xE0 | AUDIO_PID >> 8), AUDIO_PID & 0xFF, 0xF0, 0x00});
+    }
+
+    // one PES packet of len audio bytes (a counting pattern) over as many TS packets as it takes;
+    // extra: bytes of PES header data besides the PTS (a long header runs into the next packet),
+    // disc: the first packet carries the discontinuity indicator
+    void pes(size_t len, uint8_t extra = 0, std::vector<size_t>* packetStarts = nullptr, bool disc = false) {
+        std::vector<uint8_t> d = {0x00, 0x00, 0x01, 0xC0, 0x00, 0x00, 0x80, 0x80, (uint8_t)(5 + extra), 0x21, 0x00, 0x01, 0x00, 0x01};
+        d.insert(d.end(), extra, 0xFF);
+        size_t hdr = d.size();
+        for(size_t i = 0; i < len; i++) d.push_back((uint8_t)(_next++ * 7 + 3));
+        for(size_t pos = 0, n; pos < d.size(); pos += n) {
+            size_t room = disc && pos == 0 ? 182 : 184;        // the flag needs an adaptation field
+            n = d.size() - pos < room ? d.size() - pos : room;
+            if(packetStarts) packetStarts->push_back(ts.size());
+            packet(AUDIO_PID, pos == 0, d.data() + pos, n, disc && pos == 0);
+        }
+        audio.insert(audio.end(), d.begin() + hdr, d.end());
+    }
+
+  private:
+    uint32_t _next = 0;
+};